@@ -0,0 +1,139 @@
+/**
+ *
+ **/
+
+#include "ParallelTasks.h"
+#include "CartaLib/IImage.h"
+
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Algorithms
+{
+namespace
+{
+/// the thread limit; not positive for one thread per core
+std::atomic < int > threadLimit( 0 );
+
+/// the number of threads running tasks, callers included
+std::atomic < int > threadsBusy( 0 );
+}
+
+void
+ParallelTasks::setThreadCountMax( int count )
+{
+    threadLimit = count;
+}
+
+int
+ParallelTasks::threadCountMax()
+{
+    int count = threadLimit;
+    if ( count <= 0 ) {
+        count = QThread::idealThreadCount();
+    }
+    return std::max( count, 1 );
+}
+
+int
+ParallelTasks::workerCountMax( int taskCount )
+{
+    return std::max( 1, std::min( taskCount, threadCountMax() ) );
+}
+
+void
+ParallelTasks::run( int taskCount, const std::function < void (int, int) > & task )
+{
+    if ( taskCount <= 0 ) {
+        return;
+    }
+
+    // the calling thread always works; helpers only take up threads that are free
+    int wanted = workerCountMax( taskCount ) - 1;
+    int busy = ++threadsBusy;
+    int helperCount = 0;
+    while ( wanted > 0 ) {
+        int available = std::min( wanted, threadCountMax() - busy );
+        if ( available <= 0 ) {
+            break;
+        }
+        if ( threadsBusy.compare_exchange_weak( busy, busy + available ) ) {
+            helperCount = available;
+            break;
+        }
+    }
+
+    std::atomic < int > nextTask( 0 );
+    auto work = [&] ( int worker ) {
+        while ( true ) {
+            // helpers give their thread back, one at a time, while callers that came
+            // later keep the process over the limit; the calling thread finishes the
+            // remaining tasks
+            if ( worker > 0 ) {
+                int busy = threadsBusy;
+                while ( busy > threadCountMax() ) {
+                    if ( threadsBusy.compare_exchange_weak( busy, busy - 1 ) ) {
+                        return;
+                    }
+                }
+            }
+            int i = nextTask++;
+            if ( i >= taskCount ) {
+                break;
+            }
+            task( i, worker );
+        }
+        if ( worker > 0 ) {
+            threadsBusy--;
+        }
+    };
+    std::vector < std::thread > threads;
+    for ( int i = 1 ; i <= helperCount ; i++ ) {
+        threads.push_back( std::thread( work, i ) );
+    }
+    work( 0 );
+    for ( std::thread & thread : threads ) {
+        thread.join();
+    }
+    threadsBusy--;
+}
+
+void
+ParallelTasks::run( int taskCount, std::shared_ptr < Image::ImageInterface > image,
+                    const std::function < void (int, Image::ImageInterface *) > & task )
+{
+    // an image without independent handles that has to be read by one thread at a
+    // time is read by the calling thread alone, which may already hold its lock
+    if ( image-> accessMutex() ) {
+        for ( int i = 0 ; i < taskCount ; i++ ) {
+            task( i, image.get() );
+        }
+        return;
+    }
+
+    // each worker opens its handle the first time it runs a task
+    std::vector < std::shared_ptr < Image::ImageInterface > > handles( workerCountMax( taskCount ) );
+    run( taskCount, [&] ( int i, int worker ) {
+             std::shared_ptr < Image::ImageInterface > & handle = handles[worker];
+             if ( ! handle ) {
+                 if ( worker > 0 ) {
+                     handle = image-> cloneForThread();
+                 }
+                 if ( ! handle ) {
+                     handle = image;
+                 }
+             }
+             task( i, handle.get() );
+         } );
+}
+}
+}
+}
@@ -0,0 +1,70 @@
+/**
+ * Runs the tasks of a computation on several threads, within a limit on the number
+ * of threads shared by all the computations of the process.
+ **/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Image
+{
+class ImageInterface;
+}
+
+namespace Algorithms
+{
+class ParallelTasks
+{
+public:
+
+    /// set the largest number of threads computations may use at once
+    /// \param count the number of threads; one per core if it is not positive
+    static void
+    setThreadCountMax( int count );
+
+    /// \return the largest number of threads computations may use at once
+    static int
+    threadCountMax();
+
+    /// \return the largest number of workers run() may use for the tasks, so
+    /// callers can set up per-worker state before calling it
+    /// \param taskCount the number of tasks
+    static int
+    workerCountMax( int taskCount );
+
+    /// run tasks on the calling thread and on helper threads; the calling thread
+    /// counts against the thread limit while it runs the tasks, and helper threads
+    /// are only started while the limit allows and stop taking tasks while later
+    /// callers keep the process over it, so computations running at the same time
+    /// share the cores instead of each starting a thread per core
+    /// \param taskCount the number of tasks
+    /// \param task the work of a task, given its index and the index of the worker
+    /// running it, from 0 (the calling thread) to workerCountMax( taskCount ) - 1;
+    /// a worker runs one task at a time
+    static void
+    run( int taskCount, const std::function < void (int, int) > & task );
+
+    /// run tasks that read an image; the calling thread reads the image itself and
+    /// helper threads read their own handles to it (see ImageInterface::cloneForThread);
+    /// images with an access lock (ImageInterface::accessMutex) are read by the
+    /// calling thread alone
+    /// \param taskCount the number of tasks
+    /// \param image the image the tasks read
+    /// \param task the work of a task, given its index and the image to read
+    static void
+    run( int taskCount, std::shared_ptr < Image::ImageInterface > image,
+         const std::function < void (int, Image::ImageInterface *) > & task );
+
+private:
+
+    ParallelTasks();
+};
+}
+}
+}
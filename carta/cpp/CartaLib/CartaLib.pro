@@ -22,6 +22,10 @@ SOURCES += \
     Hooks/HistogramResult.cpp \
     Hooks/ProfileHook.cpp \
     Hooks/ImageStatisticsHook.cpp \
+    Hooks/MomentsHook.cpp \
+    Hooks/FitCubeHook.cpp \
+    Hooks/StatisticsBatchHook.cpp \
+    Hooks/ProfileBatchHook.cpp \
     Hooks/LoadRegion.cpp \
     Hooks/Plot2DResult.cpp \
     Hooks/ProfileResult.cpp \
@@ -45,6 +49,7 @@ SOURCES += \
     IWcsGridRenderService.cpp \
     ContourSet.cpp \
     Algorithms/LineCombiner.cpp \
+    Algorithms/ParallelTasks.cpp \
     IImageRenderService.cpp \
     IRemoteVGView.cpp \
     IPCache.cpp \
@@ -58,6 +63,7 @@ SOURCES += \
     Regions/Ellipse.cpp \
     Regions/Point.cpp \
     Regions/Rectangle.cpp \
+    Regions/RegionMask.cpp \
     IntensityUnitConverter.cpp
 
 HEADERS += \
@@ -75,6 +81,10 @@ HEADERS += \
     Hooks/ProfileHook.h \
     Hooks/HookIDs.h \
     Hooks/ImageStatisticsHook.h \
+    Hooks/MomentsHook.h \
+    Hooks/FitCubeHook.h \
+    Hooks/StatisticsBatchHook.h \
+    Hooks/ProfileBatchHook.h \
     Hooks/LoadRegion.h \
     Hooks/Plot2DResult.h \
     Hooks/ProfileResult.h \
@@ -105,6 +115,7 @@ HEADERS += \
     IContourGeneratorService.h \
     ContourSet.h \
     Algorithms/LineCombiner.h \
+    Algorithms/ParallelTasks.h \
     Hooks/GetInitialFileList.h \
     Hooks/Initialize.h \
     IImageRenderService.h \
@@ -120,6 +131,7 @@ HEADERS += \
     Regions/Ellipse.h \
     Regions/Point.h \
     Regions/Rectangle.h \
+    Regions/RegionMask.h \
     IPCache.h \
     IntensityUnitConverter.h
 
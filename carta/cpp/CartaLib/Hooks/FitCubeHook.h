@@ -0,0 +1,114 @@
+/**
+ * Hook for fitting Gaussians to every spectrum of an image cube.
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/IPlugin.h"
+#include <QString>
+#include <memory>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Image {
+class ImageInterface;
+}
+namespace Regions {
+class RegionBase;
+}
+namespace Hooks
+{
+
+class FitCubeHook : public BaseHook
+{
+    CARTA_HOOK_BOILER1( FitCubeHook );
+
+public:
+
+    /// A map of one of the fitted parameters.
+    struct FitMap {
+        /// short name of the map, for example 'center' or 'center_2'
+        QString m_name;
+        std::shared_ptr<Image::ImageInterface> m_image;
+    };
+
+    //The amplitude, center and width maps of each Gaussian followed by a map of
+    //the rms residual of the fits; empty if the cube could not be fitted.
+    typedef std::vector<FitMap> ResultType;
+
+    /**
+     * @brief Params
+     */
+     struct Params {
+
+            /**
+             * Constructor.
+             * @param dataSource - the cube.
+             * @param regionInfo - only spectra inside the region are fitted; nullptr for the whole image.
+             * @param gaussCount - the number of Gaussians fitted to each spectrum.
+             * @param polyTerms - the number of terms of the polynomial baseline fitted
+             *      with the Gaussians (the degree of the polynomial plus one).
+             * @param spectralAxis - the index of the spectral axis of the cube.
+             * @param channelMin - the first channel fitted, or -1 to start at the first channel.
+             * @param channelMax - the last channel fitted, or -1 to end at the last channel.
+             * @param frames - the frame to use on each axis other than the two spatial axes and
+             *      the spectral axis (for example the Stokes axis).
+             * @param spectralValues - the spectral coordinate of every channel of the cube.
+             * @param spectralUnit - the unit of the spectral coordinates.
+             * @param average - whether the mean spectrum of the region (or of the image) is
+             *      fitted once, rather than every spectrum on its own.
+             */
+            Params( std::shared_ptr<Image::ImageInterface> dataSource,
+                    std::shared_ptr<Regions::RegionBase> regionInfo,
+                    int gaussCount, int polyTerms, int spectralAxis,
+                    int channelMin, int channelMax, std::vector<int> frames,
+                    std::vector<double> spectralValues, QString spectralUnit,
+                    bool average ){
+                m_dataSource = dataSource;
+                m_regionInfo = regionInfo;
+                m_gaussCount = gaussCount;
+                m_polyTerms = polyTerms;
+                m_spectralAxis = spectralAxis;
+                m_channelMin = channelMin;
+                m_channelMax = channelMax;
+                m_frames = frames;
+                m_spectralValues = spectralValues;
+                m_spectralUnit = spectralUnit;
+                m_average = average;
+            }
+
+            std::shared_ptr<Image::ImageInterface> m_dataSource;
+            std::shared_ptr<Regions::RegionBase> m_regionInfo;
+            int m_gaussCount;
+            int m_polyTerms;
+            int m_spectralAxis;
+            int m_channelMin;
+            int m_channelMax;
+            std::vector<int> m_frames;
+            std::vector<double> m_spectralValues;
+            QString m_spectralUnit;
+            bool m_average;
+        };
+
+    /**
+     * @brief PreRender
+     * @param pptr
+     *
+     * @todo make hook constructors protected, so that only hook helper can create them
+     */
+    FitCubeHook( Params * pptr ) : BaseHook( staticId ), paramsPtr( pptr )
+    {
+        CARTA_ASSERT( is < Me > () );
+    }
+
+    ResultType result;
+    Params * paramsPtr;
+};
+}
+}
+}
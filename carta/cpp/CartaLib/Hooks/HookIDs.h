@@ -33,6 +33,10 @@ enum class UniqueHookIDs {
     ImageStatisticsHook_ID,
     GetPersistentCache_ID,
     GetProfileExtractor_ID,
+    MomentsHook_ID,
+    FitCubeHook_ID,
+    StatisticsBatchHook_ID,
+    ProfileBatchHook_ID,
 
     /// region related stuff, still to be considered experimental
     CoordSystemHook_ID,
@@ -0,0 +1,6 @@
+/**
+ *
+ **/
+
+
+#include "MomentsHook.h"
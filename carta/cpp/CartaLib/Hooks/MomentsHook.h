@@ -0,0 +1,122 @@
+/**
+ * Hook for computing moment maps of an image cube.
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/IPlugin.h"
+#include <QString>
+#include <memory>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Image {
+class ImageInterface;
+}
+namespace Regions {
+class RegionBase;
+}
+namespace Hooks
+{
+
+class MomentsHook : public BaseHook
+{
+    CARTA_HOOK_BOILER1( MomentsHook );
+
+public:
+
+    /// Maps that can be derived from the spectra of a cube.
+    enum class MomentType {
+        INTEGRATED,          ///< moment 0, the spectrum integrated over the spectral coordinate
+        WEIGHTED_COORD,      ///< moment 1, the intensity weighted mean spectral coordinate
+        WEIGHTED_DISPERSION, ///< moment 2, the intensity weighted dispersion of the spectral coordinate
+        MAXIMUM,             ///< the peak of the spectrum
+        MEDIAN               ///< the median of the spectrum
+    };
+
+    /// A computed moment map.
+    struct Moment {
+        MomentType m_type;
+        /// short name of the map, for example 'integrated'
+        QString m_name;
+        std::shared_ptr<Image::ImageInterface> m_image;
+    };
+
+    //One map for each requested moment, in the order they were requested; empty
+    //if the moments could not be computed.
+    typedef std::vector<Moment> ResultType;
+
+    /**
+     * @brief Params
+     */
+     struct Params {
+
+            /**
+             * Constructor.
+             * @param dataSource - the cube.
+             * @param regionInfo - only pixels inside the region are used; nullptr for the whole image.
+             * @param moments - the maps to compute.
+             * @param spectralAxis - the index of the spectral axis of the cube.
+             * @param channelMin - the first channel used, or -1 to start at the first channel.
+             * @param channelMax - the last channel used, or -1 to end at the last channel.
+             * @param frames - the frame to use on each axis other than the two spatial axes and
+             *      the spectral axis (for example the Stokes axis).
+             * @param spectralValues - the spectral coordinate of every channel of the cube.
+             * @param spectralUnit - the unit of the spectral coordinates.
+             * @param includeMin - pixels below this intensity are not used.
+             * @param includeMax - pixels above this intensity are not used.
+             */
+            Params( std::shared_ptr<Image::ImageInterface> dataSource,
+                    std::shared_ptr<Regions::RegionBase> regionInfo,
+                    std::vector<MomentType> moments, int spectralAxis,
+                    int channelMin, int channelMax, std::vector<int> frames,
+                    std::vector<double> spectralValues, QString spectralUnit,
+                    double includeMin, double includeMax ){
+                m_dataSource = dataSource;
+                m_regionInfo = regionInfo;
+                m_moments = moments;
+                m_spectralAxis = spectralAxis;
+                m_channelMin = channelMin;
+                m_channelMax = channelMax;
+                m_frames = frames;
+                m_spectralValues = spectralValues;
+                m_spectralUnit = spectralUnit;
+                m_includeMin = includeMin;
+                m_includeMax = includeMax;
+            }
+
+            std::shared_ptr<Image::ImageInterface> m_dataSource;
+            std::shared_ptr<Regions::RegionBase> m_regionInfo;
+            std::vector<MomentType> m_moments;
+            int m_spectralAxis;
+            int m_channelMin;
+            int m_channelMax;
+            std::vector<int> m_frames;
+            std::vector<double> m_spectralValues;
+            QString m_spectralUnit;
+            double m_includeMin;
+            double m_includeMax;
+        };
+
+    /**
+     * @brief PreRender
+     * @param pptr
+     *
+     * @todo make hook constructors protected, so that only hook helper can create them
+     */
+    MomentsHook( Params * pptr ) : BaseHook( staticId ), paramsPtr( pptr )
+    {
+        CARTA_ASSERT( is < Me > () );
+    }
+
+    ResultType result;
+    Params * paramsPtr;
+};
+}
+}
+}
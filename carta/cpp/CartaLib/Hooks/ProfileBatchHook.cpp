@@ -0,0 +1,6 @@
+/**
+ *
+ **/
+
+
+#include "ProfileBatchHook.h"
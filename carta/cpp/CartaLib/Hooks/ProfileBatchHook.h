@@ -0,0 +1,87 @@
+/**
+ * Hook for computing the spectral profiles of many regions of an image at once.
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/IPlugin.h"
+#include "CartaLib/ProfileInfo.h"
+#include <memory>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Image {
+class ImageInterface;
+}
+namespace Regions {
+class RegionBase;
+}
+namespace Hooks
+{
+
+class ProfileBatchHook : public BaseHook
+{
+    CARTA_HOOK_BOILER1( ProfileBatchHook );
+
+public:
+
+    //A column for each region with the value of its profile in every channel; NaN
+    //in the channels where the region does not cover any valid pixels.  The list
+    //is empty if the profiles could not be computed.
+    typedef std::vector< std::vector<double> > ResultType;
+
+    /**
+     * @brief Params
+     */
+     struct Params {
+
+            /**
+             * Constructor.
+             * @param dataSource - the image.
+             * @param regionInfos - the regions, in pixel coordinates of the image.
+             * @param spectralAxis - the index of the axis the profiles run along.
+             * @param slice - the frame of every axis of the image; those of the two
+             *      spatial axes and of the spectral axis are not used.
+             * @param aggregateType - how the pixels of a region are combined in
+             *      each channel.
+             */
+            Params( std::shared_ptr<Image::ImageInterface> dataSource,
+                    std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > regionInfos,
+                    int spectralAxis, std::vector<int> slice,
+                    Carta::Lib::ProfileInfo::AggregateType aggregateType ){
+                m_dataSource = dataSource;
+                m_regionInfos = regionInfos;
+                m_spectralAxis = spectralAxis;
+                m_slice = slice;
+                m_aggregateType = aggregateType;
+            }
+
+            std::shared_ptr<Image::ImageInterface> m_dataSource;
+            std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > m_regionInfos;
+            int m_spectralAxis;
+            std::vector<int> m_slice;
+            Carta::Lib::ProfileInfo::AggregateType m_aggregateType;
+        };
+
+    /**
+     * @brief PreRender
+     * @param pptr
+     *
+     * @todo make hook constructors protected, so that only hook helper can create them
+     */
+    ProfileBatchHook( Params * pptr ) : BaseHook( staticId ), paramsPtr( pptr )
+    {
+        CARTA_ASSERT( is < Me > () );
+    }
+
+    ResultType result;
+    Params * paramsPtr;
+};
+}
+}
+}
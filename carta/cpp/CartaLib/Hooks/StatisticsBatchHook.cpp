@@ -0,0 +1,6 @@
+/**
+ *
+ **/
+
+
+#include "StatisticsBatchHook.h"
@@ -0,0 +1,80 @@
+/**
+ * Hook for computing the statistics of many regions of an image plane at once.
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/IPlugin.h"
+#include "CartaLib/StatInfo.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Image {
+class ImageInterface;
+}
+namespace Regions {
+class RegionBase;
+}
+namespace Hooks
+{
+
+class StatisticsBatchHook : public BaseHook
+{
+    CARTA_HOOK_BOILER1( StatisticsBatchHook );
+
+public:
+
+    //A column for each numeric region statistic (Sum, Mean, RMS, and so on).  Row i
+    //of every column belongs to region i; it is NaN if the region does not cover
+    //any valid pixels.
+    typedef std::map< Carta::Lib::StatInfo::StatType, std::vector<double> > ResultType;
+
+    /**
+     * @brief Params
+     */
+     struct Params {
+
+            /**
+             * Constructor.
+             * @param dataSource - the image.
+             * @param regionInfos - the regions, in pixel coordinates of the image.
+             * @param slice - the frame of every axis of the image; those of the two
+             *      spatial axes are not used.
+             */
+            Params( std::shared_ptr<Image::ImageInterface> dataSource,
+                    std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > regionInfos,
+                    std::vector<int> slice ){
+                m_dataSource = dataSource;
+                m_regionInfos = regionInfos;
+                m_slice = slice;
+            }
+
+            std::shared_ptr<Image::ImageInterface> m_dataSource;
+            std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > m_regionInfos;
+            std::vector<int> m_slice;
+        };
+
+    /**
+     * @brief PreRender
+     * @param pptr
+     *
+     * @todo make hook constructors protected, so that only hook helper can create them
+     */
+    StatisticsBatchHook( Params * pptr ) : BaseHook( staticId ), paramsPtr( pptr )
+    {
+        CARTA_ASSERT( is < Me > () );
+    }
+
+    ResultType result;
+    Params * paramsPtr;
+};
+}
+}
+}
@@ -4,4 +4,46 @@
 
 
 #include "ICoordinateFormatter.h"
+#include <algorithm>
 
+/// per-point fallback shared by toWorldMany() and toPixelMany()
+template < typename Func >
+static bool
+convertEach( int nAxes, const CoordinateFormatterInterface::VD & input,
+             CoordinateFormatterInterface::VD & output, std::vector < bool > & failures,
+             Func convert )
+{
+    CARTA_ASSERT( nAxes > 0 );
+    size_t nPoints = input.size() / nAxes;
+    output.assign( nPoints * nAxes, 0.0 );
+    failures.assign( nPoints, false );
+    bool allValid = true;
+    CoordinateFormatterInterface::VD in( nAxes ), out;
+    for ( size_t i = 0 ; i < nPoints ; i++ ) {
+        std::copy( input.begin() + i * nAxes, input.begin() + ( i + 1 ) * nAxes, in.begin() );
+        if ( ! convert( in, out ) ) {
+            failures[i] = true;
+            allValid = false;
+            continue;
+        }
+        size_t count = std::min( out.size(), size_t( nAxes ) );
+        std::copy( out.begin(), out.begin() + count, output.begin() + i * nAxes );
+    }
+    return allValid;
+}
+
+bool
+CoordinateFormatterInterface::toWorldMany( const VD & pixels, VD & world,
+                                           std::vector < bool > & failures ) const
+{
+    return convertEach( nAxes(), pixels, world, failures,
+                        [this] ( const VD & in, VD & out ) { return toWorld( in, out ); } );
+}
+
+bool
+CoordinateFormatterInterface::toPixelMany( const VD & world, VD & pixels,
+                                           std::vector < bool > & failures ) const
+{
+    return convertEach( nAxes(), world, pixels, failures,
+                        [this] ( const VD & in, VD & out ) { return toPixel( in, out ); } );
+}
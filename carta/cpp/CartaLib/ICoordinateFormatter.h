@@ -87,6 +87,19 @@ public:
     /// convert world coordinates to pixel coordinates
     virtual bool toPixel(const VD& world, VD& pixel) const = 0;
 
+    /// convert many pixel coordinates to world coordinates in one call
+    /// \param pixels nAxes() values per point, stored one point after another
+    /// \param world resulting world coordinates, nAxes() values per point
+    /// \param failures set to true for every point that could not be converted
+    /// \return false if any of the points could not be converted
+    /// \note the default implementation calls toWorld() for every point,
+    /// implementations are expected to do better than that
+    virtual bool toWorldMany(const VD& pixels, VD& world, std::vector<bool>& failures) const;
+
+    /// convert many world coordinates to pixel coordinates in one call
+    /// (the reverse of toWorldMany, with the same data layout)
+    virtual bool toPixelMany(const VD& world, VD& pixels, std::vector<bool>& failures) const;
+
     /// virtual destructor
     virtual ~CoordinateFormatterInterface() {}
 
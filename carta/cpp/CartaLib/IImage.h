@@ -31,6 +31,8 @@
 #include <cstdint>
 #include <memory>
 
+class QMutex;
+
 namespace Carta
 {
 namespace Lib
@@ -412,6 +414,21 @@ public:
     /// the image
     virtual Image::MetaDataInterface::SharedPtr
     metaData() = 0;
+
+    /// return a new, independent handle to the same image, which can be read from
+    /// another thread while this instance is in use (e.g. by reopening the file)
+    /// returns nullptr if no independent handle can be made, e.g. for images that
+    /// live in memory; callers then read this instance from all threads, holding
+    /// accessMutex() if there is one
+    virtual std::shared_ptr<Image::ImageInterface>
+    cloneForThread() { return nullptr; }
+
+    /// return the lock that has to be held while this instance is read, for images
+    /// that have no independent handles and cannot be read from several threads at
+    /// once; the lock is recursive and reads through getDataSlice() take it themselves
+    /// returns nullptr if the image needs no lock
+    virtual QMutex *
+    accessMutex() { return nullptr; }
 };
 } // namespace Image
 }
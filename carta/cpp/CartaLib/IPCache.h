@@ -7,6 +7,7 @@
 #include <QByteArray>
 #include <QString>
 #include <memory>
+#include <vector>
 
 namespace Carta
 {
@@ -47,6 +48,25 @@ public:
               const QByteArray & val,
               const QByteArray & error ) = 0;
 
+    /// an entry for setEntries()
+    struct Entry
+    {
+        QByteArray key;
+        QByteArray val;
+        QByteArray error;
+    };
+
+    /// set the values of several entries
+    /// the default sets them one at a time; implementations should write
+    /// them together where the storage allows it
+    virtual void
+    setEntries( const std::vector < Entry > & entries )
+    {
+        for ( const Entry & entry : entries ) {
+            setEntry( entry.key, entry.val, entry.error );
+        }
+    }
+
     /// Release the shared_ptr before the program quits.
     /// There may be a better way to prevent the segementation fault
     /// comes from the ~SqLitePCache when CARTA shuts down.
@@ -74,9 +74,15 @@ public:
         drgb[2] = 1.0 - drgb[2];
     }
 
+    bool
+    inverted() const
+    {
+        return m_inverted;
+    }
+
 private:
 
-    bool m_inverted;
+    bool m_inverted = false;
 };
 
 enum class ScaleType
@@ -136,6 +142,18 @@ public:
         if( m_gamma < 0) { m_gamma = 0; }
     }
 
+    double
+    gamma() const
+    {
+        return m_gamma;
+    }
+
+    ScaleType
+    type() const
+    {
+        return m_scaleType;
+    }
+
     virtual void
     convert( double & val ) override
     {
@@ -231,8 +249,8 @@ private:
 /// it should support all of the GUI actions of a colormap dialog, e.g.:
 /// - invert, reverse, colormap, log/gamma/cycles, manual clip
 ///
-/// \todo this is getting extremely inefficient, I think it's time to
-/// hand-optimize it without the stages
+/// convertqMany() runs a hand-optimized version of the stages, specialized for the
+/// current settings, so prefer it over convertq() for anything but a few values
 ///
 class CustomizablePixelPipeline : public IClippedPixelPipeline
 {
@@ -306,6 +324,7 @@ public:
     setColormap( IColormapNamed::SharedPtr colormap )
     {
         m_cmapName = colormap-> name();
+        m_colormap = colormap;
         m_pipe-> setStage3( colormap );
     }
 
@@ -336,6 +355,42 @@ public:
         result = qRgb( red, green, blue);
     }
 
+    /// converts the whole buffer with a kernel specialized for the current scale
+    /// type, gamma, reverse and invert settings, which gives the same results as
+    /// convertq() without going through the stages for every value
+    virtual void
+    convertqMany( const double * vals, size_t count, QRgb * results, QRgb nanColor ) override
+    {
+        if ( ! m_colormap ) {
+            IClippedPixelPipeline::convertqMany( vals, count, results, nanColor );
+            return;
+        }
+        Kernel kernel = nullptr;
+        switch ( m_scaleStage-> type() )
+        {
+        case ScaleType::Linear :
+            kernel = _kernelForGamma < ScaleType::Linear > ();
+            break;
+        case ScaleType::Polynomial3 :
+            kernel = _kernelForGamma < ScaleType::Polynomial3 > ();
+            break;
+        case ScaleType::Polynomial4 :
+            kernel = _kernelForGamma < ScaleType::Polynomial4 > ();
+            break;
+        case ScaleType::Sqr :
+            kernel = _kernelForGamma < ScaleType::Sqr > ();
+            break;
+        case ScaleType::Sqrt :
+            kernel = _kernelForGamma < ScaleType::Sqrt > ();
+            break;
+        case ScaleType::Log :
+            kernel = _kernelForGamma < ScaleType::Log > ();
+            break;
+        }
+        CARTA_ASSERT_X( kernel, "Invalid scale type" );
+        ( this->* kernel )( vals, count, results, nanColor );
+    } // convertqMany
+
     virtual void
     getClips( double & min, double & max ) override
     {
@@ -358,10 +413,121 @@ public:
 
 private:
 
+    typedef void (CustomizablePixelPipeline::* Kernel)( const double *, size_t, QRgb *, QRgb );
+
+    template < ScaleType Scale >
+    Kernel
+    _kernelForGamma()
+    {
+        if ( m_scaleStage-> gamma() == 1.0 ) {
+            return _kernelForReverse < Scale, true > ();
+        }
+        return _kernelForReverse < Scale, false > ();
+    }
+
+    template < ScaleType Scale, bool UnitGamma >
+    Kernel
+    _kernelForReverse()
+    {
+        if ( m_reverseFlag ) {
+            return _kernelForInvert < Scale, UnitGamma, true > ();
+        }
+        return _kernelForInvert < Scale, UnitGamma, false > ();
+    }
+
+    template < ScaleType Scale, bool UnitGamma, bool Reverse >
+    Kernel
+    _kernelForInvert()
+    {
+        if ( m_invertFlag ) {
+            return & CustomizablePixelPipeline::_kernel < Scale, UnitGamma, Reverse, true >;
+        }
+        return & CustomizablePixelPipeline::_kernel < Scale, UnitGamma, Reverse, false >;
+    }
+
+    /// the stages of the pipeline fused together, the arithmetic is kept exactly as in
+    /// the individual stages so that the results are identical to convertq()
+    template < ScaleType Scale, bool UnitGamma, bool Reverse, bool Invert >
+    void
+    _kernel( const double * vals, size_t count, QRgb * results, QRgb nanColor )
+    {
+        const double min = m_clipMin;
+        const double max = m_clipMax;
+        const double range = max - min;
+        const double minMaxSum = min + max;
+        const double a = m_scaleStage-> param();
+        const double logDenominator = std::log( a + 1 );
+        const double gamma = m_scaleStage-> gamma();
+        const NormRgb maxRgb = m_maxRgb;
+        IColormap & colormap = * m_colormap;
+
+        for ( size_t i = 0 ; i < count ; i++ ) {
+            if ( Q_UNLIKELY( std::isnan( vals[i] ) ) ) {
+                results[i] = nanColor;
+                continue;
+            }
+
+            // stage 0: clamp
+            double val = Carta::Lib::clamp( vals[i], min, max );
+
+            // stage 1: scale
+            double n = ( val - min ) / range;
+            switch ( Scale )
+            {
+            case ScaleType::Linear :
+                break;
+            case ScaleType::Sqr :
+                n = n * n;
+                break;
+            case ScaleType::Sqrt :
+                n = std::sqrt( n );
+                break;
+            case ScaleType::Log :
+                n = std::log( a * n + 1 ) / logDenominator;
+                break;
+            case ScaleType::Polynomial3 :
+            case ScaleType::Polynomial4 :
+                n = std::pow( n, a );
+                break;
+            }
+            if ( ! UnitGamma ) {
+                n = std::pow( n, gamma );
+            }
+            val = n * range + min;
+
+            // stage 1: reverse
+            if ( Reverse ) {
+                val = minMaxSum - val;
+            }
+
+            // stage 2: normalize
+            val = ( val - min ) / range;
+
+            // stage 3: colormap
+            NormRgb drgb;
+            colormap.convert( val, drgb );
+
+            // stage 4: invert
+            if ( Invert ) {
+                drgb[0] = 1.0 - drgb[0];
+                drgb[1] = 1.0 - drgb[1];
+                drgb[2] = 1.0 - drgb[2];
+            }
+
+            // stage 5 and rgb max
+            QRgb result = qRgb( drgb[0] * 255, drgb[1] * 255, drgb[2] * 255 );
+            auto red = std::round( qRed( result ) * maxRgb[0] );
+            auto green = std::round( qGreen( result ) * maxRgb[1] );
+            auto blue = std::round( qBlue( result ) * maxRgb[2] );
+            results[i] = qRgb( red, green, blue );
+        }
+    } // _kernel
+
     Composite::UniquePtr m_pipe = nullptr;
     ScaleStage::SharedPtr m_scaleStage = nullptr;
     ReversableStage1::SharedPtr m_reversible = nullptr;
     InvertibleStage4::SharedPtr m_invertible = nullptr;
+    IColormap::SharedPtr m_colormap = nullptr;
     double m_clipMin = 0, m_clipMax = 1;
     NormRgb m_maxRgb {{ 1.0, 1.0, 1.0}};
 
@@ -166,6 +166,23 @@ public:
     virtual void
     convertq( double val, QRgb & result ) = 0;
 
+    /// do the conversion double -> 8 bit RGB for a buffer of values, nans are
+    /// converted to nanColor
+    /// \note the default implementation calls convertq() for every value, pipelines
+    /// can override this with something faster
+    virtual void
+    convertqMany( const double * vals, size_t count, QRgb * results, QRgb nanColor )
+    {
+        for ( size_t i = 0 ; i < count ; i++ ) {
+            if ( Q_LIKELY( ! std::isnan( vals[i] ) ) ) {
+                convertq( vals[i], results[i] );
+            }
+            else {
+                results[i] = nanColor;
+            }
+        }
+    }
+
     /// returns the input clip range
     /// \note this is not strictly necessary for minimalist interface, but we do use
     /// this just about everywhere where we need IPixelPipeline for caching, so I stuck
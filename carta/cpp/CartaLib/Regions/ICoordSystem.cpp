@@ -57,6 +57,48 @@ BasicCoordinateSystemInfo::BasicCoordinateSystemInfo( int dims, WcsType type, Wc
     m_wcsSubType = subType;
 }
 
+/// per-point fallback shared by src2dstMany() and dst2srcMany()
+template < typename Func >
+static bool
+convertEach( int srcDim, int dstDim, const std::vector < double > & pts,
+             std::vector < double > & result, std::vector < bool > & failures, Func convert )
+{
+    CARTA_ASSERT( srcDim > 0 && dstDim > 0 );
+    size_t nPoints = pts.size() / srcDim;
+    result.assign( nPoints * dstDim, 0.0 );
+    failures.assign( nPoints, false );
+    bool allValid = true;
+    PointN in( srcDim ), out;
+    for ( size_t i = 0 ; i < nPoints ; i++ ) {
+        std::copy( pts.begin() + i * srcDim, pts.begin() + ( i + 1 ) * srcDim, in.begin() );
+        if ( ! convert( in, out ) || int ( out.size() ) < dstDim ) {
+            failures[i] = true;
+            allValid = false;
+            continue;
+        }
+        std::copy( out.begin(), out.begin() + dstDim, result.begin() + i * dstDim );
+    }
+    return allValid;
+}
+
+bool
+ICoordSystemConverter::src2dstMany( const std::vector < double > & pts,
+                                    std::vector < double > & result,
+                                    std::vector < bool > & failures )
+{
+    return convertEach( srcCS().ndim(), dstCS().ndim(), pts, result, failures,
+                        [this] ( const PointN & in, PointN & out ) { return src2dst( in, out ); } );
+}
+
+bool
+ICoordSystemConverter::dst2srcMany( const std::vector < double > & pts,
+                                    std::vector < double > & result,
+                                    std::vector < bool > & failures )
+{
+    return convertEach( dstCS().ndim(), srcCS().ndim(), pts, result, failures,
+                        [this] ( const PointN & in, PointN & out ) { return dst2src( in, out ); } );
+}
+
 ICoordSystemConverter::UniquePtr
 makePixelIdentityConverter( int ndim )
 {
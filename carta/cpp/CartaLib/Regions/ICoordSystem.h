@@ -4,6 +4,8 @@
 
 #include "CartaLib/CartaLib.h"
 #include <QString>
+#include <algorithm>
+#include <vector>
 
 #pragma once
 
@@ -171,6 +173,22 @@ public:
     virtual bool
     dst2src( const PointN & pt, PointN & result ) = 0;
 
+    /// convert many points from source to destination coordinate system in one call
+    /// \param pts input points, srcCS().ndim() values per point, one point after another
+    /// \param result resulting points, dstCS().ndim() values per point
+    /// \param failures set to true for every point that could not be converted
+    /// \return false if any of the points could not be converted
+    /// \note the default implementation calls src2dst() for every point
+    virtual bool
+    src2dstMany( const std::vector < double > & pts, std::vector < double > & result,
+                 std::vector < bool > & failures );
+
+    /// convert many points from destination to source coordinate system in one call
+    /// (the reverse of src2dstMany, with the same data layout)
+    virtual bool
+    dst2srcMany( const std::vector < double > & pts, std::vector < double > & result,
+                 std::vector < bool > & failures );
+
     /// return a map of axes in src to dst
     /// for example, a standard RA,DEC,FREQ,STOKES polarization cube would return
     /// [ 0, 1, 2, 3]
@@ -214,6 +232,22 @@ public:
         return true;
     }
 
+    virtual bool
+    src2dstMany( const std::vector < double > & pts, std::vector < double > & result,
+                 std::vector < bool > & failures ) override
+    {
+        result = pts;
+        failures.assign( pts.size() / std::max( m_srcCS.ndim(), 1 ), false );
+        return true;
+    }
+
+    virtual bool
+    dst2srcMany( const std::vector < double > & pts, std::vector < double > & result,
+                 std::vector < bool > & failures ) override
+    {
+        return src2dstMany( pts, result, failures );
+    }
+
     virtual const CompositeCoordinateSystem &
     srcCS() override
     {
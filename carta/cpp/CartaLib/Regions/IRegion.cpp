@@ -3,6 +3,9 @@
  **/
 
 #include "IRegion.h"
+#include "Ellipse.h"
+#include "Point.h"
+#include "Rectangle.h"
 
 #include <QFile>
 #include <QJsonDocument>
@@ -49,6 +52,15 @@ fromJson( QJsonObject json, RegionBase * parent )
         else if ( type == Polygon::TypeName ) {
             r = new Polygon( parent );
         }
+        else if ( type == Rectangle::TypeName ) {
+            r = new Rectangle( parent );
+        }
+        else if ( type == Ellipse::TypeName ) {
+            r = new Ellipse( parent );
+        }
+        else if ( type == Point::TypeName ) {
+            r = new Point( parent );
+        }
         else {
             qCritical() << "Unknown json region type" << type;
         }
@@ -58,6 +58,7 @@ QJsonObject Point::toJson() const {
 	QJsonObject doc = RegionBase::toJson();
 	doc[POINT_X] = m_point.x();
 	doc[POINT_Y] = m_point.y();
+	doc[REGION_TYPE] = TypeName;
 	return doc;
 }
 
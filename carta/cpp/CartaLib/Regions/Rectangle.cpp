@@ -57,6 +57,7 @@ QJsonObject Rectangle::toJson() const {
 	QPointF centerPt = m_rectf.center();
 	doc[POINT_X] = centerPt.x();
 	doc[POINT_Y] = centerPt.y();
+	doc[REGION_TYPE] = TypeName;
 	return doc;
 }
 
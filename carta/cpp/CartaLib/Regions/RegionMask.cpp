@@ -0,0 +1,415 @@
+#include "RegionMask.h"
+#include "IRegion.h"
+#include "Ellipse.h"
+#include "Point.h"
+#include "Rectangle.h"
+
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtCore/qmath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+
+namespace Carta {
+namespace Lib {
+namespace Regions {
+
+namespace {
+//Number of masks kept in the cache.
+const int CACHE_SIZE = 64;
+
+//Number of samples along each axis of an edge pixel of a fractional mask.
+const int SUBSAMPLES = 4;
+
+//The most recently used masks, most recent first.
+struct MaskCache {
+    QMutex mutex;
+    std::list< std::pair<QString, RegionMask::ConstSharedPtr> > entries;
+};
+MaskCache maskCache;
+}
+
+
+RegionMask::ConstSharedPtr RegionMask::get( const RegionBase* region, int width, int height,
+        bool fractional ){
+    if ( !region ){
+        return std::make_shared<const RegionMask>( region, width, height, fractional );
+    }
+    QString key = QString( QJsonDocument( region->toJson() ).toJson( QJsonDocument::Compact ) ) +
+            ":" + QString::number( width ) + "x" + QString::number( height ) +
+            ( fractional ? ":fractional" : "" );
+    {
+        QMutexLocker locker( &maskCache.mutex );
+        auto& entries = maskCache.entries;
+        for ( auto it = entries.begin(); it != entries.end(); ++it ){
+            if ( it->first == key ){
+                entries.splice( entries.begin(), entries, it );
+                return entries.front().second;
+            }
+        }
+    }
+
+    //Rasterize outside the lock so other regions can be looked up meanwhile.
+    RegionMask::ConstSharedPtr mask =
+            std::make_shared<const RegionMask>( region, width, height, fractional );
+    QMutexLocker locker( &maskCache.mutex );
+    auto& entries = maskCache.entries;
+    entries.emplace_front( key, mask );
+    if ( static_cast<int>( entries.size() ) > CACHE_SIZE ){
+        entries.pop_back();
+    }
+    return mask;
+}
+
+
+RegionMask::RegionMask( const RegionBase* region, int width, int height, bool fractional ):
+    m_width( width ),
+    m_height( height ),
+    m_fractional( fractional ){
+    if ( !region || width <= 0 || height <= 0 ){
+        return;
+    }
+    _rasterize( region, width, height, m_runs );
+    _merge( m_runs );
+    if ( fractional && region->typeName() != Point::TypeName ){
+        _weigh( region );
+    }
+}
+
+
+void RegionMask::_addRun( int y, int x0, int x1, int width, std::vector<Run>& runs ){
+    x0 = std::max( x0, 0 );
+    x1 = std::min( x1, width - 1 );
+    if ( x0 <= x1 ){
+        runs.push_back( { y, x0, x1, 1 } );
+    }
+}
+
+
+double RegionMask::area() const {
+    double total = 0;
+    for ( const Run& run : m_runs ){
+        total += ( run.x1 - run.x0 + 1 ) * static_cast<double>( run.weight );
+    }
+    return total;
+}
+
+
+QRect RegionMask::boundingBox() const {
+    QRect box;
+    if ( m_runs.empty() ){
+        return box;
+    }
+    int minX = m_runs[0].x0;
+    int maxX = m_runs[0].x1;
+    for ( const Run& run : m_runs ){
+        minX = std::min( minX, run.x0 );
+        maxX = std::max( maxX, run.x1 );
+    }
+    return QRect( QPoint( minX, m_runs.front().y ), QPoint( maxX, m_runs.back().y ) );
+}
+
+
+bool RegionMask::isEmpty() const {
+    return m_runs.empty();
+}
+
+
+bool RegionMask::isFractional() const {
+    return m_fractional;
+}
+
+
+bool RegionMask::_isInside( const RegionBase* region, double x, double y ){
+    QString regionType = region->typeName();
+    if ( region->canHaveChildren() ){
+        for ( const RegionBase* kid : region->children() ){
+            if ( _isInside( kid, x, y ) ){
+                return true;
+            }
+        }
+        return false;
+    }
+    QRectF box = region->outlineBox();
+    if ( regionType == Rectangle::TypeName ){
+        return box.left() <= x && x <= box.right() && box.top() <= y && y <= box.bottom();
+    }
+    if ( regionType == Ellipse::TypeName ){
+        double radiusX = box.width() / 2;
+        double radiusY = box.height() / 2;
+        if ( radiusX <= 0 || radiusY <= 0 ){
+            return false;
+        }
+        double dx = ( x - box.center().x() ) / radiusX;
+        double dy = ( y - box.center().y() ) / radiusY;
+        return dx * dx + dy * dy <= 1;
+    }
+    RegionPointV point( region->csId() + 1, QPointF( x, y ) );
+    return region->isPointInside( point );
+}
+
+
+void RegionMask::_merge( std::vector<Run>& runs ){
+    std::sort( runs.begin(), runs.end(), []( const Run& a, const Run& b ){
+        return a.y < b.y || ( a.y == b.y && a.x0 < b.x0 );
+    });
+    size_t count = 0;
+    for ( const Run& run : runs ){
+        if ( count > 0 && runs[count-1].y == run.y && run.x0 <= runs[count-1].x1 + 1 ){
+            runs[count-1].x1 = std::max( runs[count-1].x1, run.x1 );
+        }
+        else {
+            runs[count++] = run;
+        }
+    }
+    runs.resize( count );
+}
+
+
+qint64 RegionMask::pixelCount() const {
+    qint64 count = 0;
+    for ( const Run& run : m_runs ){
+        count += run.x1 - run.x0 + 1;
+    }
+    return count;
+}
+
+
+void RegionMask::_rasterize( const RegionBase* region, int width, int height,
+        std::vector<Run>& runs ){
+    if ( region->canHaveChildren() ){
+        for ( const RegionBase* kid : region->children() ){
+            _rasterize( kid, width, height, runs );
+        }
+        return;
+    }
+    QString regionType = region->typeName();
+    QRectF box = region->outlineBox();
+    if ( regionType == Point::TypeName ){
+        //Just the pixel nearest to the point.
+        QPointF center = box.center();
+        int y = qRound( center.y() );
+        if ( y >= 0 && y < height ){
+            _addRun( y, qRound( center.x() ), qRound( center.x() ), width, runs );
+        }
+    }
+    else if ( regionType == Rectangle::TypeName ){
+        //Corners are pixel centers; both are included.
+        if ( box.width() > 0 || box.height() > 0 ){
+            int minY = std::max( qRound( box.top() ), 0 );
+            int maxY = std::min( qRound( box.bottom() ), height - 1 );
+            for ( int y = minY; y <= maxY; y++ ){
+                _addRun( y, qRound( box.left() ), qRound( box.right() ), width, runs );
+            }
+        }
+    }
+    else if ( regionType == Ellipse::TypeName || regionType == Circle::TypeName ){
+        //The ellipse inscribed in the outline box.
+        QPointF center = box.center();
+        double radiusX = box.width() / 2;
+        double radiusY = box.height() / 2;
+        if ( radiusX > 0 && radiusY > 0 ){
+            int minY = std::max( qCeil( box.top() ), 0 );
+            int maxY = std::min( qFloor( box.bottom() ), height - 1 );
+            for ( int y = minY; y <= maxY; y++ ){
+                double dy = ( y - center.y() ) / radiusY;
+                double halfWidth = radiusX * std::sqrt( std::max( 1 - dy * dy, 0.0 ) );
+                _addRun( y, qCeil( center.x() - halfWidth ), qFloor( center.x() + halfWidth ),
+                        width, runs );
+            }
+        }
+    }
+    else if ( regionType == Polygon::TypeName ){
+        const Polygon* polygonRegion = dynamic_cast<const Polygon*>( region );
+        QPolygonF polygon = polygonRegion->qpolyf();
+        int cornerCount = polygon.size();
+        if ( cornerCount >= 3 ){
+            int minY = std::max( qCeil( box.top() ), 0 );
+            int maxY = std::min( qFloor( box.bottom() ), height - 1 );
+            //Scan line fill through the pixel centers, with the winding rule
+            //Polygon::isPointInside uses.
+            std::vector< std::pair<double,int> > crossings;
+            for ( int y = minY; y <= maxY; y++ ){
+                crossings.clear();
+                for ( int i = 0, j = cornerCount - 1; i < cornerCount; j = i++ ){
+                    const QPointF& a = polygon[i];
+                    const QPointF& b = polygon[j];
+                    if ( ( a.y() > y ) != ( b.y() > y ) ){
+                        double x = a.x() + ( y - a.y() ) * ( b.x() - a.x() ) / ( b.y() - a.y() );
+                        crossings.push_back( { x, a.y() > b.y() ? 1 : -1 } );
+                    }
+                }
+                std::sort( crossings.begin(), crossings.end() );
+                int winding = 0;
+                double start = 0;
+                for ( const auto& crossing : crossings ){
+                    if ( winding == 0 ){
+                        start = crossing.first;
+                    }
+                    winding += crossing.second;
+                    if ( winding == 0 ){
+                        _addRun( y, qCeil( start ), qFloor( crossing.first ), width, runs );
+                    }
+                }
+            }
+        }
+    }
+    else {
+        //Any other region: test the pixels in its outline box one at a time.
+        int minX = std::max( qCeil( box.left() ), 0 );
+        int maxX = std::min( qFloor( box.right() ), width - 1 );
+        int minY = std::max( qCeil( box.top() ), 0 );
+        int maxY = std::min( qFloor( box.bottom() ), height - 1 );
+        RegionPointV point( region->csId() + 1 );
+        for ( int y = minY; y <= maxY; y++ ){
+            int runStart = -1;
+            for ( int x = minX; x <= maxX + 1; x++ ){
+                bool inside = false;
+                if ( x <= maxX ){
+                    std::fill( point.begin(), point.end(), QPointF( x, y ) );
+                    inside = region->isPointInsideUnion( point );
+                }
+                if ( inside && runStart < 0 ){
+                    runStart = x;
+                }
+                else if ( !inside && runStart >= 0 ){
+                    _addRun( y, runStart, x - 1, width, runs );
+                    runStart = -1;
+                }
+            }
+        }
+    }
+}
+
+
+const std::vector<RegionMask::Run>& RegionMask::runs() const {
+    return m_runs;
+}
+
+
+std::vector<char> RegionMask::toBitmap( const QRect& box ) const {
+    std::vector<char> bitmap( static_cast<size_t>( std::max( box.width(), 0 ) ) *
+            std::max( box.height(), 0 ), 0 );
+    for ( const Run& run : m_runs ){
+        if ( run.y < box.top() || run.y > box.bottom() ){
+            continue;
+        }
+        int x0 = std::max( run.x0, box.left() );
+        int x1 = std::min( run.x1, box.right() );
+        if ( x0 <= x1 ){
+            char* row = bitmap.data() + static_cast<size_t>( run.y - box.top() ) * box.width();
+            std::fill( row + x0 - box.left(), row + x1 - box.left() + 1, 1 );
+        }
+    }
+    return bitmap;
+}
+
+
+std::vector<float> RegionMask::toWeights( const QRect& box ) const {
+    std::vector<float> weights( static_cast<size_t>( std::max( box.width(), 0 ) ) *
+            std::max( box.height(), 0 ), 0 );
+    for ( const Run& run : m_runs ){
+        if ( run.y < box.top() || run.y > box.bottom() ){
+            continue;
+        }
+        int x0 = std::max( run.x0, box.left() );
+        int x1 = std::min( run.x1, box.right() );
+        if ( x0 <= x1 ){
+            float* row = weights.data() + static_cast<size_t>( run.y - box.top() ) * box.width();
+            std::fill( row + x0 - box.left(), row + x1 - box.left() + 1, run.weight );
+        }
+    }
+    return weights;
+}
+
+
+void RegionMask::_weigh( const RegionBase* region ){
+    //Only pixels next to a pixel on the other side of the edge can be partly
+    //inside; they are sampled on a grid.  The box also takes in regions too small
+    //to cover any pixel centers.
+    QRectF outline = region->outlineBox();
+    QRect box = boundingBox().adjusted( -1, -1, 1, 1 ) |
+            QRect( QPoint( qFloor( outline.left() ), qFloor( outline.top() ) ),
+                    QPoint( qCeil( outline.right() ), qCeil( outline.bottom() ) ) );
+    box &= QRect( 0, 0, m_width, m_height );
+    std::vector<Run> weighted;
+    if ( box.isEmpty() ){
+        m_runs.swap( weighted );
+        return;
+    }
+    int boxWidth = box.width();
+    std::vector<char> rows[3];
+    auto fillRow = [&]( int y, std::vector<char>& row ){
+        row.assign( boxWidth + 2, 0 );
+        if ( y < box.top() || y > box.bottom() ){
+            return;
+        }
+        auto first = std::lower_bound( m_runs.begin(), m_runs.end(), y,
+                []( const Run& run, int rowIndex ){ return run.y < rowIndex; } );
+        for ( auto it = first; it != m_runs.end() && it->y == y; ++it ){
+            int x0 = std::max( it->x0, box.left() );
+            int x1 = std::min( it->x1, box.right() );
+            if ( x0 <= x1 ){
+                std::fill( row.begin() + x0 - box.left() + 1, row.begin() + x1 - box.left() + 2, 1 );
+            }
+        }
+    };
+    fillRow( box.top() - 1, rows[0] );
+    fillRow( box.top(), rows[1] );
+    const double STEP = 1.0 / SUBSAMPLES;
+    for ( int y = box.top(); y <= box.bottom(); y++ ){
+        fillRow( y + 1, rows[2] );
+        int runStart = -1;
+        float runWeight = 0;
+        for ( int i = 0; i <= boxWidth; i++ ){
+            float weight = 0;
+            if ( i < boxWidth ){
+                const char* center = rows[1].data() + i + 1;
+                bool inside = *center;
+                bool edge = false;
+                for ( int k = -1; k <= 1 && !edge; k++ ){
+                    edge = rows[0][i + 1 + k] != inside || rows[1][i + 1 + k] != inside ||
+                            rows[2][i + 1 + k] != inside;
+                }
+                if ( edge ){
+                    int x = box.left() + i;
+                    int hits = 0;
+                    for ( int sy = 0; sy < SUBSAMPLES; sy++ ){
+                        for ( int sx = 0; sx < SUBSAMPLES; sx++ ){
+                            if ( _isInside( region, x - 0.5 + ( sx + 0.5 ) * STEP,
+                                    y - 0.5 + ( sy + 0.5 ) * STEP ) ){
+                                hits++;
+                            }
+                        }
+                    }
+                    weight = static_cast<float>( hits ) / ( SUBSAMPLES * SUBSAMPLES );
+                }
+                else {
+                    weight = inside ? 1 : 0;
+                }
+            }
+            if ( runStart >= 0 && weight != runWeight ){
+                weighted.push_back( { y, box.left() + runStart, box.left() + i - 1, runWeight } );
+                runStart = -1;
+            }
+            if ( runStart < 0 && weight > 0 ){
+                runStart = i;
+                runWeight = weight;
+            }
+        }
+        rows[0].swap( rows[1] );
+        rows[1].swap( rows[2] );
+    }
+    m_runs.swap( weighted );
+}
+
+
+RegionMask::~RegionMask(){
+}
+
+}
+}
+}
@@ -0,0 +1,139 @@
+/**
+ * The pixels of an image plane covered by a region, stored as runs along the rows.
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include <QRect>
+#include <QString>
+#include <memory>
+#include <vector>
+
+namespace Carta {
+namespace Lib {
+namespace Regions {
+
+class RegionBase;
+
+class RegionMask {
+
+    CLASS_BOILERPLATE( RegionMask );
+
+public:
+
+    /// A run of pixels along the x axis of the plane, x0 to x1 inclusive, each of
+    /// which the region covers by the same fraction.
+    struct Run {
+        int y;
+        int x0;
+        int x1;
+        float weight;
+    };
+
+    /**
+     * Returns the mask of a region on a plane of the given size.  Masks are cached
+     * by the geometry of the region and the size of the plane, so asking again for
+     * the mask of a region that has not changed does not rasterize it again.
+     * @param region - a region in pixel coordinates; may be a union of regions.
+     * @param width - the number of pixels along the x axis of the plane.
+     * @param height - the number of pixels along the y axis of the plane.
+     * @param fractional - true if the pixels on the edge of the region should be
+     *      weighted by the part of their area inside the region; false if a pixel is
+     *      either inside the region, when its center is, or not.
+     * @return - the mask of the region.
+     */
+    static RegionMask::ConstSharedPtr get( const RegionBase* region, int width, int height,
+            bool fractional = false );
+
+    /**
+     * Constructor; rasterizes the region without looking in the cache.
+     * @param region - a region in pixel coordinates; may be a union of regions.
+     * @param width - the number of pixels along the x axis of the plane.
+     * @param height - the number of pixels along the y axis of the plane.
+     * @param fractional - true if the pixels on the edge of the region should be
+     *      weighted by the part of their area inside the region.
+     */
+    RegionMask( const RegionBase* region, int width, int height, bool fractional = false );
+
+    /**
+     * Returns the runs of pixels covered by the region.
+     * @return - runs that do not overlap, ordered by row and then by x; the weight
+     *      of every run is 1 unless the mask is fractional.
+     */
+    const std::vector<Run>& runs() const;
+
+    /**
+     * Returns the smallest box holding all the pixels of the mask.
+     * @return - the box of the mask; empty if the region does not cover any pixels.
+     */
+    QRect boundingBox() const;
+
+    /**
+     * Returns the number of pixels the region covers, however little.
+     * @return - the number of pixels in the runs.
+     */
+    qint64 pixelCount() const;
+
+    /**
+     * Returns the area of the region in pixels.
+     * @return - the sum of the weights of the pixels in the runs.
+     */
+    double area() const;
+
+    /**
+     * Returns whether the region covers any pixels of the plane.
+     * @return - true if there are no pixels in the mask; false otherwise.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns whether the pixels on the edge of the region are weighted.
+     * @return - true if the mask is fractional; false otherwise.
+     */
+    bool isFractional() const;
+
+    /**
+     * Returns the pixels of the mask in a box of the plane, row after row.
+     * @param box - a box of the plane.
+     * @return - 1 for each pixel of the box covered by the region, 0 otherwise.
+     */
+    std::vector<char> toBitmap( const QRect& box ) const;
+
+    /**
+     * Returns the weights of the pixels of the mask in a box of the plane, row
+     * after row.
+     * @param box - a box of the plane.
+     * @return - the weight of each pixel of the box; 0 for pixels outside the region.
+     */
+    std::vector<float> toWeights( const QRect& box ) const;
+
+    virtual ~RegionMask();
+
+private:
+
+    //Appends the runs of pixels whose centers are inside the region.
+    static void _rasterize( const RegionBase* region, int width, int height,
+            std::vector<Run>& runs );
+
+    //Returns whether a point is inside the region by the rules _rasterize uses.
+    static bool _isInside( const RegionBase* region, double x, double y );
+
+    //Sorts the runs and joins those that overlap or touch.
+    static void _merge( std::vector<Run>& runs );
+
+    //Clips a run to the plane and appends it.
+    static void _addRun( int y, int x0, int x1, int width, std::vector<Run>& runs );
+
+    //Replaces the runs by runs weighted by the area of their pixels inside the region.
+    void _weigh( const RegionBase* region );
+
+    std::vector<Run> m_runs;
+    int m_width;
+    int m_height;
+    bool m_fractional;
+};
+
+}
+}
+}
@@ -1,6 +1,7 @@
 #include "StatInfo.h"
 #include "CartaLib/CartaLib.h"
 #include <QDebug>
+#include <limits>
 
 namespace Carta {
 namespace Lib {
@@ -55,6 +56,7 @@ StatInfo::StatInfo( StatType statType ){
     m_statType = statType;
     m_label = toString( statType);
     m_imageStat = true;
+    m_numericValue = std::numeric_limits<double>::quiet_NaN();
     if ( m_regionStatTypes.contains( m_statType) ){
         m_imageStat = false;
     }
@@ -68,6 +70,10 @@ QString StatInfo::getValue() const {
     return m_value;
 }
 
+double StatInfo::getNumericValue() const {
+    return m_numericValue;
+}
+
 StatInfo::StatType StatInfo::getType() const {
     return m_statType;
 }
@@ -88,6 +94,10 @@ void StatInfo::setValue( const QString& value ){
     m_value = value;
 }
 
+void StatInfo::setNumericValue( double value ){
+    m_numericValue = value;
+}
+
 
 
 QString StatInfo::toString( StatType statType){
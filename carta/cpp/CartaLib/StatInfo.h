@@ -61,6 +61,13 @@ public:
      */
     QString getValue() const;
 
+    /**
+     * Return the value of the statistic as a number.
+     * @return - the computed statistic value at full precision or NaN if the
+     *      statistic is not a single number.
+     */
+    double getNumericValue() const;
+
     /**
      * Return the type of statistic (region,image, etc).
      * @return - the statistic type.
@@ -93,6 +100,13 @@ public:
      */
     void setValue( const QString& value );
 
+    /**
+     * Set a computed numeric value for the statistic; the displayed value is set
+     * separately with setValue.
+     * @param value - a computed statistic value.
+     */
+    void setNumericValue( double value );
+
     /**
      * Return a string representation of the statistic type.
      * @return - a string representation of the type of statistic.
@@ -120,6 +134,7 @@ private:
     StatType m_statType;
     QString m_label;
     QString m_value;
+    double m_numericValue;
     bool m_imageStat;
     static QList<StatType> m_regionStatTypes;
     static QList<StatType> m_imageStatTypes;
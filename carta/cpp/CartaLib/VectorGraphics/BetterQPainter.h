@@ -54,8 +54,17 @@ public:
         /// a documented way (and presumably preferred way) to do this would be via
         /// save/restore mechanism, could we do that?
         auto device = m_qPainter.device();
+        // keep the window of the painter, which may have been set to draw only
+        // part of the graphics (e.g. one tile of a large image)
+        bool viewTransformEnabled = m_qPainter.viewTransformEnabled();
+        QRect window = m_qPainter.window();
+        QRect viewport = m_qPainter.viewport();
         m_qPainter.end();
         m_qPainter.begin(device);
+        if ( viewTransformEnabled ) {
+            m_qPainter.setWindow( window );
+            m_qPainter.setViewport( viewport );
+        }
 
         m_fonts.clear();
         m_indexedPens.clear();
@@ -0,0 +1,126 @@
+/**
+ * Tests of the spatial index over the boxes of regions.
+ **/
+
+#include "catch.h"
+#include "core/Data/Region/RegionIndex.h"
+#include <QPointF>
+#include <QRectF>
+#include <vector>
+
+using Carta::Data::Region;
+using Carta::Data::RegionIndex;
+
+namespace {
+
+typedef std::vector<Region*> Regions;
+
+//The index only compares region pointers, so the regions of the tests are
+//addresses that are never dereferenced.
+Region* fakeRegion( int i ){
+    static int ids[64];
+    return reinterpret_cast<Region*>( &ids[i] );
+}
+
+}
+
+TEST_CASE( "Region index finds the regions under points and rectangles", "[regionindex]" ) {
+
+    //Cells of 10 by 10 pixels.
+    RegionIndex index( 10 );
+    Region* a = fakeRegion( 0 );
+    Region* b = fakeRegion( 1 );
+    Region* c = fakeRegion( 2 );
+
+    SECTION( "Insert" ) {
+        index.insert( b, QRectF( 3, 3, 10, 10 ) );
+        index.insert( a, QRectF( 0, 0, 5, 5 ) );
+        index.insert( c, QRectF( 50, 50, 2, 2 ) );
+        //Regions come back in the order they were added.
+        REQUIRE( index.getRegions( QPointF( 4, 4 ) ) == Regions( { b, a } ) );
+        REQUIRE( index.getRegions( QPointF( 12, 12 ) ) == Regions( { b } ) );
+        REQUIRE( index.getRegions( QPointF( 51, 51 ) ) == Regions( { c } ) );
+        REQUIRE( index.getRegions( QPointF( 30, 30 ) ).empty() );
+        //Box edges count as inside.
+        REQUIRE( index.getRegions( QPointF( 13, 13 ) ) == Regions( { b } ) );
+        REQUIRE( index.getRegions( QRectF( 4, 4, 50, 50 ) ) == Regions( { b, a, c } ) );
+        REQUIRE( index.getRegions( QRectF( 20, 20, 5, 5 ) ).empty() );
+    }
+
+    SECTION( "Boxes that are points" ) {
+        index.insert( a, QRectF( 7, 7, 0, 0 ) );
+        REQUIRE( index.getRegions( QPointF( 7, 7 ) ) == Regions( { a } ) );
+        REQUIRE( index.getRegions( QRectF( 5, 5, 2, 2 ) ) == Regions( { a } ) );
+    }
+
+    SECTION( "Move" ) {
+        index.insert( a, QRectF( 0, 0, 5, 5 ) );
+        index.insert( b, QRectF( 3, 3, 10, 10 ) );
+        index.insert( c, QRectF( 50, 50, 2, 2 ) );
+        index.insert( a, QRectF( 40, 40, 5, 5 ) );
+        REQUIRE( index.getRegions( QPointF( 4, 4 ) ) == Regions( { b } ) );
+        REQUIRE( index.getRegions( QPointF( 42, 42 ) ) == Regions( { a } ) );
+        //A moved region keeps its place in the order.
+        REQUIRE( index.getRegions( QRectF( 35, 35, 20, 20 ) ) == Regions( { a, c } ) );
+        //Boxes given with negative sizes are normalized.
+        index.insert( c, QRectF( 70, 70, -10, -10 ) );
+        REQUIRE( index.getRegions( QPointF( 65, 65 ) ) == Regions( { c } ) );
+        REQUIRE( index.getRegions( QPointF( 51, 51 ) ).empty() );
+    }
+
+    SECTION( "Remove" ) {
+        index.insert( a, QRectF( 0, 0, 5, 5 ) );
+        index.insert( b, QRectF( 3, 3, 10, 10 ) );
+        index.remove( b );
+        REQUIRE( index.getRegions( QPointF( 4, 4 ) ) == Regions( { a } ) );
+        REQUIRE( index.getRegions( QPointF( 12, 12 ) ).empty() );
+        //Removing a region that is not in the index does nothing.
+        index.remove( b );
+        index.remove( c );
+        REQUIRE( index.getRegions( QPointF( 4, 4 ) ) == Regions( { a } ) );
+        index.clear();
+        REQUIRE( index.getRegions( QPointF( 4, 4 ) ).empty() );
+    }
+
+    SECTION( "Large boxes" ) {
+        //441 cells, more than are stored cell by cell.
+        index.insert( a, QRectF( 0, 0, 200, 200 ) );
+        index.insert( b, QRectF( 150, 150, 5, 5 ) );
+        REQUIRE( index.getRegions( QPointF( 150, 150 ) ) == Regions( { a, b } ) );
+        REQUIRE( index.getRegions( QPointF( 250, 250 ) ).empty() );
+        REQUIRE( index.getRegions( QRectF( 100, 100, 1, 1 ) ) == Regions( { a } ) );
+        //Moving the region to a small box takes it off the list of large boxes.
+        index.insert( a, QRectF( 0, 0, 5, 5 ) );
+        REQUIRE( index.getRegions( QPointF( 150, 150 ) ) == Regions( { b } ) );
+        REQUIRE( index.getRegions( QPointF( 2, 2 ) ) == Regions( { a } ) );
+        //And moving it back puts it on the list again.
+        index.insert( a, QRectF( -100, -100, 300, 300 ) );
+        REQUIRE( index.getRegions( QPointF( -50, 150 ) ) == Regions( { a } ) );
+        index.remove( a );
+        REQUIRE( index.getRegions( QPointF( 150, 150 ) ) == Regions( { b } ) );
+    }
+
+    SECTION( "Each region is reported once" ) {
+        //A region covering 4 by 4 cells.
+        index.insert( a, QRectF( 0, 0, 35, 35 ) );
+        //Regions far away, so the rectangles below are looked up cell by cell
+        //rather than by checking every region.
+        for ( int i = 1; i < 20; i++ ){
+            index.insert( fakeRegion( i ), QRectF( 1000 + 20 * i, 1000, 5, 5 ) );
+        }
+        //Rectangles covering 9 cells, starting on and after the first cell of the region.
+        REQUIRE( index.getRegions( QRectF( 5, 5, 20, 20 ) ) == Regions( { a } ) );
+        REQUIRE( index.getRegions( QRectF( 15, 15, 20, 20 ) ) == Regions( { a } ) );
+        //A rectangle covering more cells than there are regions.
+        REQUIRE( index.getRegions( QRectF( -100, -100, 500, 500 ) ) == Regions( { a } ) );
+    }
+
+    SECTION( "Sort" ) {
+        index.insert( b, QRectF( 0, 0, 5, 5 ) );
+        index.insert( a, QRectF( 0, 0, 5, 5 ) );
+        //Regions that are not in the index go last.
+        Regions regions( { c, a, b } );
+        index.sort( regions );
+        REQUIRE( regions == Regions( { b, a, c } ) );
+    }
+}
@@ -0,0 +1,126 @@
+/**
+ * Compares the masks of regions with the pixels whose centers the regions
+ * report as inside.
+ **/
+
+#include "catch.h"
+#include "CartaLib/Regions/Ellipse.h"
+#include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/Regions/Rectangle.h"
+#include "CartaLib/Regions/RegionMask.h"
+#include <QPolygonF>
+#include <vector>
+
+using namespace Carta::Lib::Regions;
+
+namespace {
+
+//Size of the plane the regions are rasterized on.
+const int WIDTH = 24;
+const int HEIGHT = 20;
+
+//Returns the runs of the pixels of the plane whose centers are inside the region.
+std::vector<RegionMask::Run> insideRuns( const RegionBase& region ){
+    std::vector<RegionMask::Run> runs;
+    RegionPointV point( region.csId() + 1 );
+    for ( int y = 0; y < HEIGHT; y++ ){
+        int runStart = -1;
+        for ( int x = 0; x <= WIDTH; x++ ){
+            bool inside = false;
+            if ( x < WIDTH ){
+                point[region.csId()] = QPointF( x, y );
+                inside = region.isPointInside( point );
+            }
+            if ( inside && runStart < 0 ){
+                runStart = x;
+            }
+            else if ( !inside && runStart >= 0 ){
+                runs.push_back( { y, runStart, x - 1, 1 } );
+                runStart = -1;
+            }
+        }
+    }
+    return runs;
+}
+
+//Checks the runs, size and area of the mask of a region against isPointInside().
+void checkMask( const RegionBase& region ){
+    std::vector<RegionMask::Run> expected = insideRuns( region );
+    RegionMask mask( &region, WIDTH, HEIGHT );
+    const std::vector<RegionMask::Run>& runs = mask.runs();
+    REQUIRE( runs.size() == expected.size() );
+    qint64 pixelCount = 0;
+    for ( size_t i = 0; i < expected.size(); i++ ){
+        INFO( "run " << i << " in row " << expected[i].y );
+        REQUIRE( runs[i].y == expected[i].y );
+        REQUIRE( runs[i].x0 == expected[i].x0 );
+        REQUIRE( runs[i].x1 == expected[i].x1 );
+        REQUIRE( runs[i].weight == 1 );
+        pixelCount += expected[i].x1 - expected[i].x0 + 1;
+    }
+    REQUIRE( mask.pixelCount() == pixelCount );
+    REQUIRE( mask.area() == pixelCount );
+    REQUIRE( mask.isEmpty() == expected.empty() );
+}
+
+}
+
+TEST_CASE( "Region masks match isPointInside", "[regionmask]" ) {
+
+    SECTION( "Rectangles" ) {
+        //Corners on pixel centers, inside and across the edge of the plane.
+        Rectangle rect;
+        rect.setRectangle( QRectF( 2, 3, 9, 5 ) );
+        checkMask( rect );
+        rect.setRectangle( QRectF( -3, -2, 8, 6 ) );
+        checkMask( rect );
+        rect.setRectangle( QRectF( 20, 15, 10, 10 ) );
+        checkMask( rect );
+    }
+
+    SECTION( "Ellipses" ) {
+        Ellipse wide( QPointF( 10.3, 8.6 ), 6.2, 3.7, 0 );
+        checkMask( wide );
+        Ellipse tall( QPointF( 12.4, 9.3 ), 4.6, 5.3, 0 );
+        checkMask( tall );
+        Ellipse clipped( QPointF( -1.4, 5.3 ), 4.2, 3.1, 0 );
+        checkMask( clipped );
+    }
+
+    SECTION( "Concave polygon" ) {
+        //An arrow head pointing up, with a notch between its two lower corners.
+        Polygon polygon;
+        QPolygonF corners;
+        corners << QPointF( 2.3, 1.6 ) << QPointF( 17.7, 2.2 ) << QPointF( 17.4, 15.8 )
+                << QPointF( 9.2, 7.9 ) << QPointF( 2.6, 15.3 );
+        polygon.setqpolyf( corners );
+        checkMask( polygon );
+    }
+
+    SECTION( "Union" ) {
+        //Overlapping parts, so runs of different parts have to be joined.
+        Union regionUnion;
+        Rectangle* rect = new Rectangle( &regionUnion );
+        rect->setRectangle( QRectF( 1, 1, 6, 4 ) );
+        Ellipse* ellipse = new Ellipse( &regionUnion );
+        ellipse->setCenter( QPointF( 12.4, 9.3 ) );
+        ellipse->setRadiusMajor( 4.6 );
+        ellipse->setRadiusMinor( 5.3 );
+        Polygon* triangle = new Polygon( &regionUnion );
+        QPolygonF corners;
+        corners << QPointF( 3.3, 2.4 ) << QPointF( 9.6, 3.1 ) << QPointF( 5.2, 11.7 );
+        triangle->setqpolyf( corners );
+        checkMask( regionUnion );
+    }
+
+    SECTION( "Fractional area" ) {
+        //Each row covers a quarter of one pixel, three whole pixels and three
+        //quarters of another.
+        Rectangle rect;
+        rect.setRectangle( QRectF( 2.75, 3.5, 4, 3 ) );
+        RegionMask mask( &rect, WIDTH, HEIGHT, true );
+        REQUIRE( mask.isFractional() );
+        REQUIRE( mask.area() == Approx( 12 ) );
+        REQUIRE( mask.pixelCount() == 15 );
+    }
+}
@@ -11,7 +11,9 @@ SOURCES += \
     SliceTester.cpp \
     StateTester.cpp \
     pixelPipelineTest.cpp \
-    LineCombinerTest.cpp
+    LineCombinerTest.cpp \
+    RegionMaskTest.cpp \
+    RegionIndexTest.cpp
 
 #CONFIG += precompile_header
 #PRECOMPILED_HEADER = catch.h
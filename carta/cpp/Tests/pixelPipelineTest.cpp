@@ -2,6 +2,8 @@
 #include "CartaLib/PixelPipeline/CustomizablePixelPipeline.h"
 #include "core/GrayColormap.h"
 #include <QColor>
+#include <limits>
+#include <vector>
 
 using namespace Carta;
 
@@ -31,4 +33,41 @@ TEST_CASE( "Cached Pixel Pipeline testing", "[pp]" ) {
         REQUIRE( ok);
     }
 
+    SECTION( "Buffer conversion matches single values") {
+        Core::GrayColormap::SharedPtr grayCmap = std::make_shared<Core::GrayColormap>();
+        Lib::PixelPipeline::CustomizablePixelPipeline pp;
+        pp.setColormap( grayCmap);
+        pp.setMinMax( -2, 2);
+        pp.setRgbMax( {{ 1.0, 0.5, 0.25 }});
+        std::vector<double> vals;
+        for( double x = -3 ; x < 3 ; x += 0.01) {
+            vals.push_back( x);
+        }
+        vals.push_back( std::numeric_limits<double>::quiet_NaN());
+        const QRgb nanColor = qRgb( 255, 0, 0);
+
+        auto scales = { Lib::PixelPipeline::ScaleType::Linear, Lib::PixelPipeline::ScaleType::Sqr,
+                        Lib::PixelPipeline::ScaleType::Sqrt, Lib::PixelPipeline::ScaleType::Log,
+                        Lib::PixelPipeline::ScaleType::Polynomial3,
+                        Lib::PixelPipeline::ScaleType::Polynomial4 };
+        for( auto scale : scales) {
+            for( double gamma : { 1.0, 0.5 }) {
+                for( int flags = 0 ; flags < 4 ; flags ++) {
+                    pp.setScale( scale);
+                    pp.setGamma( gamma);
+                    pp.setReverse( flags & 1);
+                    pp.setInvert( flags & 2);
+                    std::vector<QRgb> results( vals.size());
+                    pp.convertqMany( vals.data(), vals.size(), results.data(), nanColor);
+                    for( size_t i = 0 ; i + 1 < vals.size() ; i ++) {
+                        QRgb expected;
+                        pp.convertq( vals[i], expected);
+                        REQUIRE( results[i] == expected);
+                    }
+                    REQUIRE( results.back() == nanColor);
+                }
+            }
+        }
+    }
+
 }
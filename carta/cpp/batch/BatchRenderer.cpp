@@ -0,0 +1,334 @@
+#include "BatchRenderer.h"
+#include "core/Globals.h"
+#include "core/GrayColormap.h"
+#include "core/ImageRenderService.h"
+#include "core/Algorithms/percentileAlgorithms.h"
+#include "core/Data/Compute/ComputePool.h"
+#include "core/Data/Image/FramePrefetcher.h"
+#include "core/Data/Util.h"
+#include "CartaLib/Hooks/ColormapsScalar.h"
+#include "CartaLib/Hooks/LoadAstroImage.h"
+
+#include <QColor>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace {
+//Renders of the same file handed to one job; more renders are split over several jobs,
+//each opening the file for itself.
+const int RENDERS_PER_JOB = 16;
+
+//Plugins are not required to load images from several threads at once.
+QMutex loadMutex;
+}
+
+
+BatchRenderer::BatchRenderer():
+    m_failed( 0 ),
+    m_done( 0 ){
+    Carta::Lib::PixelPipeline::IColormapNamed::SharedPtr gray =
+            std::make_shared<Carta::Core::GrayColormap>();
+    m_colormaps.insert( gray->name(), gray );
+    auto hh = Globals::instance()-> pluginManager()-> prepare < Carta::Lib::Hooks::
+                                                              ColormapsScalarHook > ();
+    auto lam = [this] ( const Carta::Lib::Hooks::ColormapsScalarHook::ResultType &cmaps ) {
+        for ( Carta::Lib::PixelPipeline::IColormapNamed::SharedPtr cmap : cmaps ){
+            m_colormaps.insert( cmap->name(), cmap );
+        }
+    };
+    hh.forEach( lam );
+}
+
+
+QString BatchRenderer::_parseRender( const QJsonObject& json, const QString& baseDir,
+        Render& render ){
+    QDir dir( baseDir );
+    render.file = json["file"].toString();
+    render.output = json["output"].toString();
+    if ( render.file.isEmpty() || render.output.isEmpty() ){
+        return "a render needs a file and an output";
+    }
+    render.file = QDir::cleanPath( dir.absoluteFilePath( render.file ) );
+    render.output = QDir::cleanPath( dir.absoluteFilePath( render.output ) );
+    render.channel = json["channel"].toInt( render.channel );
+    render.stokes = json["stokes"].toInt( render.stokes );
+    render.colormap = json["colormap"].toString( render.colormap );
+    render.invert = json["invert"].toBool( render.invert );
+    render.reverse = json["reverse"].toBool( render.reverse );
+    render.gamma = json["gamma"].toDouble( render.gamma );
+    render.clip = json["clip"].toDouble( render.clip );
+    render.clipMin = json["clipMin"].toDouble( render.clipMin );
+    render.clipMax = json["clipMax"].toDouble( render.clipMax );
+    render.width = json["width"].toInt( render.width );
+    render.height = json["height"].toInt( render.height );
+    if ( render.channel < 0 || render.stokes < 0 ){
+        return "invalid frame";
+    }
+    if ( render.clip <= 0 || render.clip > 1 ){
+        return "the clip should be a fraction between 0 and 1";
+    }
+    if ( render.width < 0 || render.height < 0 ){
+        return "invalid size";
+    }
+
+    //The names of the scales used by the viewer.
+    if ( json.contains( "scale" ) ){
+        QString scale = json["scale"].toString().toLower();
+        if ( scale == "linear" ){
+            render.scale = Carta::Lib::PixelPipeline::ScaleType::Linear;
+        }
+        else if ( scale == "square root" ){
+            render.scale = Carta::Lib::PixelPipeline::ScaleType::Sqrt;
+        }
+        else if ( scale == "square" ){
+            render.scale = Carta::Lib::PixelPipeline::ScaleType::Sqr;
+        }
+        else if ( scale == "logarithm" ){
+            render.scale = Carta::Lib::PixelPipeline::ScaleType::Log;
+        }
+        else if ( scale == "polynomial3" ){
+            render.scale = Carta::Lib::PixelPipeline::ScaleType::Polynomial3;
+        }
+        else if ( scale == "polynomial4" ){
+            render.scale = Carta::Lib::PixelPipeline::ScaleType::Polynomial4;
+        }
+        else {
+            return "unknown scale " + scale;
+        }
+    }
+    if ( json.contains( "nanColor" ) ){
+        QColor nanColor( json["nanColor"].toString() );
+        if ( !nanColor.isValid() ){
+            return "invalid nan color";
+        }
+        render.defaultNan = false;
+        render.nanColor = nanColor.rgb();
+    }
+    if ( json.contains( "aspectMode" ) ){
+        QString aspectMode = json["aspectMode"].toString().toLower();
+        if ( aspectMode == "keep" ){
+            render.aspectMode = Qt::KeepAspectRatio;
+        }
+        else if ( aspectMode == "expand" ){
+            render.aspectMode = Qt::KeepAspectRatioByExpanding;
+        }
+        else if ( aspectMode == "ignore" ){
+            render.aspectMode = Qt::IgnoreAspectRatio;
+        }
+        else {
+            return "unknown aspect mode " + aspectMode;
+        }
+    }
+    return "";
+}
+
+
+QString BatchRenderer::readManifest( const QString& manifestPath ){
+    QFile manifestFile( manifestPath );
+    if ( !manifestFile.open( QIODevice::ReadOnly ) ){
+        return "could not open " + manifestPath;
+    }
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson( manifestFile.readAll(), &parseError );
+    if ( parseError.error != QJsonParseError::NoError || !doc.isObject() ){
+        return "could not parse " + manifestPath + ": " + parseError.errorString();
+    }
+    QJsonObject manifest = doc.object();
+    QJsonObject defaults = manifest["defaults"].toObject();
+    QJsonArray renders = manifest["renders"].toArray();
+    QString baseDir = QFileInfo( manifestPath ).absolutePath();
+    std::vector<Render> parsed;
+    parsed.reserve( renders.size() );
+    for ( int i = 0; i < renders.size(); i++ ){
+        QJsonObject json = defaults;
+        QJsonObject entry = renders[i].toObject();
+        for ( auto it = entry.begin(); it != entry.end(); it++ ){
+            json.insert( it.key(), it.value() );
+        }
+        Render render;
+        QString error = _parseRender( json, baseDir, render );
+        if ( !error.isEmpty() ){
+            return manifestPath + ", render " + QString::number( i ) + ": " + error;
+        }
+        if ( !m_colormaps.contains( render.colormap ) ){
+            return manifestPath + ", render " + QString::number( i ) +
+                    ": unknown colormap " + render.colormap;
+        }
+        parsed.push_back( render );
+    }
+    m_renders.insert( m_renders.end(), parsed.begin(), parsed.end() );
+    return "";
+}
+
+
+QString BatchRenderer::_render( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+        const Render& render ) const {
+    //Take the frame for the render; the first two axes are the display axes.
+    const std::vector<int>& dims = image->dims();
+    int dimCount = dims.size();
+    if ( dimCount < 2 ){
+        return "the image has fewer than two axes";
+    }
+    int spectralIndex = Carta::Data::Util::getAxisIndex( image, Carta::Lib::AxisInfo::KnownType::SPECTRAL );
+    int stokesIndex = Carta::Data::Util::getAxisIndex( image, Carta::Lib::AxisInfo::KnownType::STOKES );
+    SliceND slice;
+    for ( int i = 0; i < dimCount; i++ ){
+        if ( i >= 2 ){
+            int frameIndex = 0;
+            if ( i == spectralIndex ){
+                frameIndex = render.channel;
+            }
+            else if ( i == stokesIndex ){
+                frameIndex = render.stokes;
+            }
+            if ( frameIndex >= dims[i] ){
+                return "frame " + QString::number( frameIndex ) + " is outside the image";
+            }
+            slice.start( frameIndex );
+            slice.end( frameIndex + 1 );
+        }
+        if ( i < dimCount - 1 ){
+            slice.next();
+        }
+    }
+    std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> view( image->getDataSlice( slice ) );
+    if ( !view ){
+        return "could not read the frame";
+    }
+    //Keep the frame in memory, since it is read once for the clips and once for the colors.
+    Carta::Data::PlaneView plane( view.get() );
+    view.reset();
+
+    double clipMin = render.clipMin;
+    double clipMax = render.clipMax;
+    if ( std::isnan( clipMin ) || std::isnan( clipMax ) ){
+        double minPercentile = ( 1 - render.clip ) / 2;
+        double maxPercentile = 1 - minPercentile;
+        std::vector<double> values;
+        Carta::Lib::NdArray::Double doubleView( &plane, false );
+        doubleView.forEach( [&values]( const double& val ){
+            if ( std::isfinite( val ) ){
+                values.push_back( val );
+            }
+        });
+        if ( values.empty() ){
+            return "the frame has no finite pixels to clip";
+        }
+        std::map<double, double> clips = Carta::Core::Algorithms::selectPercentiles(
+                values, { minPercentile, maxPercentile } );
+        clipMin = clips[minPercentile];
+        clipMax = clips[maxPercentile];
+    }
+
+    Carta::Lib::PixelPipeline::CustomizablePixelPipeline pipeline;
+    pipeline.setColormap( m_colormaps[render.colormap] );
+    pipeline.setInvert( render.invert );
+    pipeline.setReverse( render.reverse );
+    pipeline.setScale( render.scale );
+    pipeline.setGamma( render.gamma );
+    pipeline.setMinMax( clipMin, clipMax );
+    QRgb nanColor = render.nanColor;
+    if ( render.defaultNan ){
+        if ( std::isnan( clipMin ) && std::isnan( clipMax ) ){
+            nanColor = qRgb( 0, 0, 0 );
+        }
+        else {
+            pipeline.convertq( clipMin, nanColor );
+        }
+    }
+
+    QImage frameImage;
+    Carta::Core::ImageRenderService::Service::renderFrame( &plane, pipeline, nanColor, frameImage );
+    QImage outputImage = frameImage;
+    if ( render.width > 0 && render.height > 0 ){
+        outputImage = frameImage.scaled( render.width, render.height, render.aspectMode,
+                Qt::SmoothTransformation );
+    }
+    else if ( render.width > 0 ){
+        outputImage = frameImage.scaledToWidth( render.width, Qt::SmoothTransformation );
+    }
+    else if ( render.height > 0 ){
+        outputImage = frameImage.scaledToHeight( render.height, Qt::SmoothTransformation );
+    }
+
+    QDir().mkpath( QFileInfo( render.output ).absolutePath() );
+    if ( !outputImage.save( render.output ) ){
+        return "could not save " + render.output;
+    }
+    return "";
+}
+
+
+void BatchRenderer::_renderFile( const QString& file, const std::vector<Render>& renders ){
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image;
+    {
+        QMutexLocker locker( &loadMutex );
+        auto res = Globals::instance()-> pluginManager()
+                -> prepare <Carta::Lib::Hooks::LoadAstroImage>( file ).first();
+        if ( !res.isNull() ){
+            image = res.val();
+        }
+    }
+    for ( const Render& render : renders ){
+        QString error = "could not load " + file;
+        if ( image ){
+            try {
+                error = _render( image, render );
+            }
+            catch( const std::exception& ex ){
+                error = ex.what();
+            }
+        }
+        if ( !error.isEmpty() ){
+            m_failed++;
+            qCritical() << "Render of" << file << "to" << render.output << "failed:" << error;
+        }
+        m_done++;
+    }
+}
+
+
+int BatchRenderer::run(){
+    m_failed = 0;
+    m_done = 0;
+
+    //Renders of the same file go to the same jobs, so the file is opened as few times
+    //as possible.
+    QMap<QString, std::vector<Render> > renderMap;
+    for ( const Render& render : m_renders ){
+        renderMap[render.file].push_back( render );
+    }
+    for ( auto it = renderMap.begin(); it != renderMap.end(); it++ ){
+        const std::vector<Render>& fileRenders = it.value();
+        int renderCount = fileRenders.size();
+        for ( int i = 0; i < renderCount; i += RENDERS_PER_JOB ){
+            std::vector<Render> jobRenders( fileRenders.begin() + i,
+                    fileRenders.begin() + std::min( i + RENDERS_PER_JOB, renderCount ) );
+            QString file = it.key();
+            auto work = [this, file, jobRenders](){
+                _renderFile( file, jobRenders );
+            };
+            Carta::Data::ComputePool::start(
+                    new Carta::Data::ComputeJob( work, Carta::Data::ComputeJob::makeCancelFlag() ) );
+        }
+    }
+    Carta::Data::ComputePool::pool()->waitForDone();
+    qDebug() << "Rendered" << ( m_done - m_failed ) << "of" << m_renders.size() << "images";
+    return m_failed;
+}
+
+
+BatchRenderer::~BatchRenderer(){
+}
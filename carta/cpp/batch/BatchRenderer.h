@@ -0,0 +1,94 @@
+/***
+ * Renders previews of the images listed in a manifest with the core pixel pipeline,
+ * without a connector or the state tree, spreading the work over the compute pool.
+ */
+
+#pragma once
+
+#include "CartaLib/IImage.h"
+#include "CartaLib/PixelPipeline/CustomizablePixelPipeline.h"
+
+#include <QJsonObject>
+#include <QMap>
+#include <QRgb>
+#include <QString>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+class BatchRenderer {
+
+public:
+
+    /// One image to render, as described by an entry of the manifest.
+    struct Render {
+        /// image file to read.
+        QString file;
+        /// where to save the rendered image; the format follows the extension.
+        QString output;
+        /// frame along the spectral and Stokes axes.
+        int channel = 0;
+        int stokes = 0;
+        QString colormap = "Gray";
+        bool invert = false;
+        bool reverse = false;
+        Carta::Lib::PixelPipeline::ScaleType scale = Carta::Lib::PixelPipeline::ScaleType::Linear;
+        double gamma = 1;
+        /// fraction of the pixels between the clips, as in the viewer.
+        double clip = 0.995;
+        /// explicit clip values; used instead of clip when both are set.
+        double clipMin = std::numeric_limits<double>::quiet_NaN();
+        double clipMax = std::numeric_limits<double>::quiet_NaN();
+        /// color of nan pixels; the bottom of the colormap if not set.
+        bool defaultNan = true;
+        QRgb nanColor = 0;
+        /// size of the output in pixels; 0 to follow the image.
+        int width = 0;
+        int height = 0;
+        Qt::AspectRatioMode aspectMode = Qt::KeepAspectRatio;
+    };
+
+    /**
+     * Constructor; collects the colormaps of the core and the plugins, so it has to be
+     * called after the plugins have been loaded.
+     */
+    BatchRenderer();
+
+    /**
+     * Add the renders listed in a manifest. The manifest is a json object with a list of
+     * "renders"; keys of an optional "defaults" object apply to every render that does
+     * not set them. Relative paths are taken relative to the manifest.
+     * @param manifestPath - the location of the manifest.
+     * @return - an error message; empty if the manifest was read.
+     */
+    QString readManifest( const QString& manifestPath );
+
+    /**
+     * Render everything that was read from the manifests, returning once all renders
+     * are done.
+     * @return - the number of renders that failed.
+     */
+    int run();
+
+    virtual ~BatchRenderer();
+
+private:
+
+    static QString _parseRender( const QJsonObject& json, const QString& baseDir, Render& render );
+
+    //Renders one image and saves it; returns an error message or an empty string.
+    QString _render( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+            const Render& render ) const;
+
+    //Loads the file and renders it for each of the renders; runs on a pool thread.
+    void _renderFile( const QString& file, const std::vector<Render>& renders );
+
+    QMap<QString, Carta::Lib::PixelPipeline::IColormapNamed::SharedPtr> m_colormaps;
+    std::vector<Render> m_renders;
+    std::atomic<int> m_failed;
+    std::atomic<int> m_done;
+
+    BatchRenderer( const BatchRenderer& other);
+    BatchRenderer& operator=( const BatchRenderer& other );
+};
@@ -0,0 +1,96 @@
+/*
+ * This is the headless batch rendering main
+ *
+ * Usage: $./carta-batch [--cfg config file] [manifest file] ...
+ *
+ * Renders the images listed in the manifests, without a connector or the state tree.
+ * A manifest looks like this (relative paths are relative to the manifest):
+ *
+ * {
+ *     "defaults" : { "colormap" : "Gray", "width" : 256, "height" : 256, "clip" : 0.995 },
+ *     "renders" : [
+ *         { "file" : "aH.fits", "output" : "previews/aH.png" },
+ *         { "file" : "cube.fits", "output" : "previews/cube_10.png", "channel" : 10,
+ *           "stokes" : 0, "scale" : "Logarithm", "clipMin" : -0.01, "clipMax" : 0.5 }
+ *     ]
+ * }
+ *
+ * Other keys of a render are "invert", "reverse", "gamma", "nanColor" and "aspectMode"
+ * ("keep", "expand" or "ignore"). The exit code is the number of renders that failed.
+ */
+
+#include "BatchRenderer.h"
+#include "core/CmdLine.h"
+#include "core/MainConfig.h"
+#include "core/Globals.h"
+#include "CartaLib/Hooks/Initialize.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+namespace {
+
+int batchMainCPP( int argc, char * * argv ){
+    // no window system is needed to render images
+    QCoreApplication qapp( argc, argv );
+    QCoreApplication::setApplicationName( "carta-batch" );
+
+    // alias globals
+    auto & globals = * Globals::instance();
+
+    // parse command line arguments & environment variables
+    auto cmdLineInfo = CmdLine::parse( QCoreApplication::arguments() );
+    globals.setCmdLineInfo( & cmdLineInfo );
+    if ( cmdLineInfo.fileList().isEmpty() ) {
+        qFatal( "Usage: ./carta-batch [manifest file] ..." );
+    }
+
+    // load the config file
+    QString configFilePath = cmdLineInfo.configFilePath();
+    MainConfig::ParsedInfo mainConfig = MainConfig::parse( configFilePath );
+    globals.setMainConfig( & mainConfig );
+
+    // initialize plugin manager and load the plugins
+    globals.setPluginManager( std::make_shared < PluginManager > () );
+    auto pm = globals.pluginManager();
+    pm-> setPluginSearchPaths( globals.mainConfig()->pluginDirectories() );
+    pm-> loadPlugins();
+
+    // tell all plugins that the core has initialized
+    pm-> prepare <Carta::Lib::Hooks::Initialize> ().executeAll();
+
+    BatchRenderer renderer;
+    for ( const QString & manifest : cmdLineInfo.fileList() ) {
+        QString error = renderer.readManifest( manifest );
+        if ( ! error.isEmpty() ) {
+            qCritical() << "Could not read manifest:" << error;
+            return - 1;
+        }
+    }
+    return renderer.run();
+} // batchMainCPP
+
+}
+
+int main( int argc, char * * argv ){
+    try {
+        return batchMainCPP( argc, argv );
+    }
+    catch ( const char * err ) {
+        qCritical() << "Exception(char*):" << err;
+    }
+    catch ( const std::string & err ) {
+        qCritical() << "Exception(std::string &):" << err.c_str();
+    }
+    catch ( const QString & err ) {
+        qCritical() << "Exception(QString &):" << err;
+    }
+    catch( const std::exception & ex ) {
+        qCritical() << "Exception(std::runtime_error)!" << ex.what();
+    }
+    catch ( ... ) {
+        qCritical() << "Exception(unknown type)!";
+    }
+    qFatal( "%s", "...caught in main()" );
+    return - 1;
+} // main
@@ -39,6 +39,39 @@ static Carta::Lib::NdArray::Double viewSliceForFrame(Carta::Lib::NdArray::Double
     return viewSlice;
 }
 
+/// compute requested percentiles of values that are already in memory
+/// \param allValues the finite values of the dataset; they are reordered in place
+/// \param percentiles which percentiles to compute
+/// \return the computed intensities
+///
+/// \note allValues must not be empty
+///
+/// \note for best performance, the supplied list of percentiles should be sorted small->large
+template < typename Scalar >
+static
+typename std::map < double, Scalar >
+selectPercentiles(
+    std::vector < Scalar > & allValues,
+    const std::vector < double > & percentiles
+    )
+{
+    std::map < double, Scalar > result;
+
+    // for every input percentile, do quickselect and store the result
+
+    for ( double q : percentiles ) {
+        // we clamp to incremented values and decrement at the end because size_t cannot be negative
+        size_t x1 = Carta::Lib::clamp<size_t>(allValues.size() * q , 1, allValues.size()) - 1;
+        CARTA_ASSERT( 0 <= x1 && x1 < allValues.size() );
+        std::nth_element( allValues.begin(), allValues.begin() + x1, allValues.end() );
+        result[q] = allValues[x1];
+    }
+
+    CARTA_ASSERT( result.size() == percentiles.size());
+
+    return result;
+} // selectPercentiles
+
 /// compute requested percentiles
 /// \param view the input dataset
 /// \param percentiles which percentiles to compute
@@ -123,21 +156,7 @@ percentile2pixels(
         qFatal( "The size of raw data is zero !!" );
     }
 
-    std::map < double, Scalar > result;
-
-    // for every input percentile, do quickselect and store the result
-
-    for ( double q : percentiles ) {
-        // we clamp to incremented values and decrement at the end because size_t cannot be negative
-        size_t x1 = Carta::Lib::clamp<size_t>(allValues.size() * q , 1, allValues.size()) - 1;
-        CARTA_ASSERT( 0 <= x1 && x1 < allValues.size() );
-        std::nth_element( allValues.begin(), allValues.begin() + x1, allValues.end() );
-        result[q] = allValues[x1];
-    }   
-
-    CARTA_ASSERT( result.size() == percentiles.size());
-
-    return result;
+    return selectPercentiles( allValues, percentiles );
 } // percentile2pixels
 
 
@@ -235,6 +235,23 @@ void Animator::clear(){
 
 void Animator::_frameChanged( int index, const QString& axisName ){
     changeFrame( index, axisName );
+
+    //While an axis is being animated, have the images read the frames that
+    //come next.
+    if ( axisName != Selection::IMAGE && axisName != Selection::REGION &&
+            m_animators.contains( axisName ) ){
+        AxisInfo::KnownType axisType = AxisMapper::getType( axisName );
+        std::vector<int> framesAhead = m_animators[axisName]->_getFramesAhead();
+        if ( axisType != AxisInfo::KnownType::OTHER && !framesAhead.empty() ){
+            int linkCount = m_linkImpl->getLinkCount();
+            for( int i = 0; i < linkCount; i++ ){
+                Controller* controller = dynamic_cast<Controller*>( m_linkImpl->getLink(i));
+                if ( controller != nullptr ){
+                    controller->_prefetchFrames( axisType, framesAhead );
+                }
+            }
+        }
+    }
 }
 
 AnimatorType* Animator::getAnimator( const QString& type ){
@@ -3,6 +3,8 @@
 #include "Data/Util.h"
 #include "State/UtilState.h"
 
+#include <algorithm>
+#include <cmath>
 #include <set>
 
 #include <QDebug>
@@ -31,6 +33,18 @@ const QString AnimatorType::RATE = "frameRate";
 const QString AnimatorType::SETTINGS_VISIBLE = "showSettings";
 const QString AnimatorType::STEP = "frameStep";
 
+namespace {
+//Largest frame rate the client offers; the client turns the rate into the time
+//between frames, from 2 seconds down to 10 milliseconds at this rate.
+const int RATE_MAX = 100;
+const int FRAME_INTERVAL_MAX = 2000;
+const int FRAME_INTERVAL_MIN = 10;
+
+//How far ahead of playback frames are read, in milliseconds and in frames.
+const int PREFETCH_TIME = 2000;
+const int PREFETCH_FRAME_COUNT_MAX = 16;
+}
+
 const QString AnimatorType::CLASS_NAME = "AnimatorType";
 const QString AnimatorType::ANIMATIONS = "animators";
 
@@ -43,6 +57,8 @@ AnimatorType::AnimatorType(const QString& path, const QString& id ):
         m_select = nullptr;
         m_removed = false;
         m_visible = true;
+        m_frameCurrent = -1;
+        m_framePrevious = -1;
         _initializeState();
         _makeSelection();
 
@@ -56,6 +72,76 @@ int AnimatorType::getFrame() const {
     return m_select->getIndex();
 }
 
+int AnimatorType::_getFrameInterval() const {
+    int rate = m_state.getValue<int>( RATE );
+    double ratePercent = 1 - static_cast<double>( rate ) / RATE_MAX;
+    int interval = std::round( ratePercent * FRAME_INTERVAL_MAX );
+    return std::max( interval, FRAME_INTERVAL_MIN );
+}
+
+std::vector<int> AnimatorType::_getFramesAhead() const {
+    std::vector<int> frames;
+    if ( m_framePrevious < 0 || m_frameCurrent < 0 ){
+        return frames;
+    }
+    int step = m_state.getValue<int>( STEP );
+    int lowerBound = m_select->getLowerBoundUser();
+    int upperBound = m_select->getUpperBoundUser();
+    QString endBehavior = m_state.getValue<QString>( END_BEHAVIOR );
+
+    //Jumping goes back and forth between the bounds.
+    if ( endBehavior == END_BEHAVIOR_JUMP ){
+        if ( ( m_framePrevious == lowerBound && m_frameCurrent == upperBound ) ||
+                ( m_framePrevious == upperBound && m_frameCurrent == lowerBound ) ){
+            frames.push_back( m_framePrevious );
+        }
+        return frames;
+    }
+
+    //Figure out which way the animation is going.
+    int direction = 0;
+    int delta = m_frameCurrent - m_framePrevious;
+    if ( delta == step ){
+        direction = 1;
+    }
+    else if ( delta == -step ){
+        direction = -1;
+    }
+    else if ( endBehavior == END_BEHAVIOR_WRAP && m_frameCurrent == lowerBound &&
+            m_framePrevious > m_frameCurrent ){
+        direction = 1;
+    }
+    else if ( endBehavior == END_BEHAVIOR_WRAP && m_frameCurrent == upperBound &&
+            m_framePrevious < m_frameCurrent ){
+        direction = -1;
+    }
+    if ( direction == 0 ){
+        return frames;
+    }
+
+    int frameCount = std::ceil( static_cast<double>( PREFETCH_TIME ) / _getFrameInterval() );
+    frameCount = std::min( frameCount, PREFETCH_FRAME_COUNT_MAX );
+    int frame = m_frameCurrent;
+    for ( int i = 0; i < frameCount; i++ ){
+        int next = frame + direction * step;
+        if ( next > upperBound || next < lowerBound ){
+            if ( endBehavior == END_BEHAVIOR_WRAP ){
+                next = direction > 0 ? lowerBound : upperBound;
+            }
+            else {
+                direction = -direction;
+                next = frame + direction * step;
+            }
+        }
+        if ( next < lowerBound || next > upperBound || next == m_frameCurrent ){
+            break;
+        }
+        frames.push_back( next );
+        frame = next;
+    }
+    return frames;
+}
+
 QString AnimatorType::getStateData() const {
     QString result = m_select->getStateString();
     return result;
@@ -233,6 +319,8 @@ void AnimatorType::resetStateData( const QString& state ){
 }
 
 void AnimatorType::_selectionChanged(){
+    m_framePrevious = m_frameCurrent;
+    m_frameCurrent = m_select->getIndex();
     emit indexChanged( m_select->getIndex(), m_type );
 }
 
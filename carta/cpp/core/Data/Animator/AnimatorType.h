@@ -6,6 +6,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <QObject>
 #include <State/StateInterface.h>
 #include <State/ObjectManager.h>
@@ -146,6 +147,14 @@ private:
     AnimatorType( const QString& path, const QString& id );
     class Factory;
 
+    //Returns the frames the animation is likely to show next, in order, assuming
+    //it goes on the way it moved to the current frame; empty if the last frame
+    //change did not look like a step of the animation.
+    std::vector<int> _getFramesAhead() const;
+
+    //Returns the time between frames during playback in milliseconds.
+    int _getFrameInterval() const;
+
     //Initialize an individual animator's state (image, channel, etc).
     void _initializeState( );
 
@@ -172,6 +181,11 @@ private:
 
     bool m_visible;
     bool m_removed;
+
+    //The current frame and the frame shown before it.
+    int m_frameCurrent;
+    int m_framePrevious;
+
     AnimatorType( const AnimatorType& other);
     AnimatorType& operator=( const AnimatorType& other );
 };
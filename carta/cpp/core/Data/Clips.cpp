@@ -37,7 +37,7 @@ Clips::Clips( const QString& path, const QString& id):
     _initializeDefaultState();
 }
 
-std::vector<double> Clips::_initializeClipValues() const {
+std::vector<double> Clips::_initializeClipValues() {
     std::vector<double> clips;
     clips.push_back( 0.9 );
     clips.push_back( 0.925 );
@@ -67,7 +67,7 @@ void Clips::_initializeDefaultState(){
     m_state.flushState();
 }
 
-std::vector<double> Clips::getAllClips2percentiles() const {
+std::vector<double> Clips::getAllClips2percentiles() {
     std::vector<double> clipValues = _initializeClipValues();
     int sizeOfClipValues = clipValues.size();
     std::vector<double> percentiles;
@@ -29,7 +29,7 @@ public:
      * @param non.
      * @return all clips associated with the sorted percentiles from small to large.
      */
-    std::vector<double> getAllClips2percentiles() const;
+    static std::vector<double> getAllClips2percentiles();
 
     /**
      * Returns the index of the corresponding clip value or -1 if there is no such clip value.
@@ -45,7 +45,7 @@ public:
 private:
 
     // set clip values in UI
-    std::vector<double> _initializeClipValues() const;
+    static std::vector<double> _initializeClipValues();
 
     void _initializeDefaultState();
 
@@ -0,0 +1,134 @@
+#include "ComputePool.h"
+#include "Globals.h"
+#include "MainConfig.h"
+#include "CartaLib/IImage.h"
+#include "CartaLib/Regions/IRegion.h"
+#include <QCoreApplication>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QDebug>
+#include <algorithm>
+
+namespace Carta {
+namespace Data {
+
+namespace {
+
+/// An image handle opened by one pool thread.
+struct ThreadImage {
+    std::weak_ptr<Carta::Lib::Image::ImageInterface> source;
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> handle;
+};
+
+QThreadStorage< std::vector<ThreadImage> > threadImages;
+}
+
+
+ComputeJob::ComputeJob( std::function<void()> work, CancelFlag cancelFlag ):
+    m_work( work ),
+    m_cancelFlag( cancelFlag ){
+    setAutoDelete( true );
+}
+
+ComputeJob::CancelFlag ComputeJob::makeCancelFlag(){
+    return std::make_shared<std::atomic<bool> >( false );
+}
+
+void ComputeJob::run(){
+    if ( *m_cancelFlag ){
+        return;
+    }
+    m_work();
+    if ( !*m_cancelFlag ){
+        emit finished();
+    }
+}
+
+ComputeJob::~ComputeJob(){
+}
+
+
+QThreadPool* ComputePool::pool(){
+    //Initialization of a local static is thread-safe, so jobs started from several
+    //threads at once still share a single pool.
+    static QThreadPool* computePool = _makePool();
+    return computePool;
+}
+
+QThreadPool* ComputePool::_makePool(){
+    QThreadPool* computePool = new QThreadPool( QCoreApplication::instance() );
+    int threadMax = Globals::instance()->mainConfig()->getComputeThreadCountMax();
+    if ( threadMax <= 0 ){
+        threadMax = QThread::idealThreadCount();
+    }
+    computePool->setMaxThreadCount( std::max( threadMax, 1 ) );
+    //Keep the threads (and the image handles they hold) around.
+    computePool->setExpiryTimeout( -1 );
+    return computePool;
+}
+
+void ComputePool::start( ComputeJob* job ){
+    pool()->start( job );
+}
+
+std::shared_ptr<Carta::Lib::Image::ImageInterface>
+ComputePool::threadImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image ){
+    if ( !image || QThread::currentThread() == QCoreApplication::instance()->thread() ){
+        return image;
+    }
+    std::vector<ThreadImage>& handles = threadImages.localData();
+
+    //Release handles to images that have been closed since.
+    handles.erase( std::remove_if( handles.begin(), handles.end(),
+            []( const ThreadImage& ti ){ return ti.source.expired(); } ), handles.end() );
+
+    for ( const ThreadImage& ti : handles ){
+        if ( ti.source.lock() == image ){
+            return ti.handle;
+        }
+    }
+    ThreadImage ti;
+    ti.source = image;
+    ti.handle = image->cloneForThread();
+    if ( !ti.handle ){
+        //Threads take turns reading the image through its access lock, if it has one.
+        return image;
+    }
+    handles.push_back( ti );
+    return ti.handle;
+}
+
+ComputePool::ImageLock::ImageLock(
+        const std::vector<std::shared_ptr<Carta::Lib::Image::ImageInterface> >& images ){
+    for ( const auto& image : images ){
+        QMutex* mutex = image ? image->accessMutex() : nullptr;
+        if ( mutex ){
+            m_mutexes.push_back( mutex );
+        }
+    }
+    //A fixed order, so that jobs locking several images cannot deadlock.
+    std::sort( m_mutexes.begin(), m_mutexes.end() );
+    m_mutexes.erase( std::unique( m_mutexes.begin(), m_mutexes.end() ), m_mutexes.end() );
+    for ( QMutex* mutex : m_mutexes ){
+        mutex->lock();
+    }
+}
+
+ComputePool::ImageLock::~ImageLock(){
+    for ( auto it = m_mutexes.rbegin(); it != m_mutexes.rend(); ++it ){
+        (*it)->unlock();
+    }
+}
+
+std::shared_ptr<Carta::Lib::Regions::RegionBase>
+ComputePool::regionSnapshot( std::shared_ptr<Carta::Lib::Regions::RegionBase> region ){
+    std::shared_ptr<Carta::Lib::Regions::RegionBase> copy( nullptr );
+    if ( region ){
+        copy.reset( Carta::Lib::Regions::fromJson( region->toJson() ) );
+    }
+    return copy;
+}
+}
+}
@@ -0,0 +1,149 @@
+/***
+ * Shared pool of worker threads for computations that read image data (histograms,
+ * profiles, statistics), together with per-thread image handles.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QRunnable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QMutex;
+class QThreadPool;
+
+namespace Carta {
+namespace Lib {
+namespace Image {
+class ImageInterface;
+}
+namespace Regions {
+class RegionBase;
+}
+}
+
+namespace Data {
+
+/**
+ * A unit of work for the compute pool. The job deletes itself after it has run.
+ * Unless it was cancelled, it emits finished() once the work is done, so the
+ * result can be picked up on the thread of whatever object is connected to it.
+ */
+class ComputeJob : public QObject, public QRunnable {
+
+    Q_OBJECT
+
+public:
+
+    /// Shared flag used to cancel a job; a cancelled job that has not started
+    /// yet skips its work, and a cancelled job never reports being finished.
+    typedef std::shared_ptr<std::atomic<bool> > CancelFlag;
+
+    /**
+     * Constructor.
+     * @param work - the computation to run on a pool thread.
+     * @param cancelFlag - flag the owner can set to cancel the job.
+     */
+    ComputeJob( std::function<void()> work, CancelFlag cancelFlag );
+
+    /**
+     * Returns a new flag, initially not cancelled.
+     * @return - a new cancellation flag.
+     */
+    static CancelFlag makeCancelFlag();
+
+    /**
+     * Run the job.
+     */
+    virtual void run() Q_DECL_OVERRIDE;
+
+    virtual ~ComputeJob();
+
+signals:
+
+    /**
+     * Notification that the work is done.
+     */
+    void finished();
+
+private:
+    std::function<void()> m_work;
+    CancelFlag m_cancelFlag;
+
+    ComputeJob( const ComputeJob& other);
+    ComputeJob& operator=( const ComputeJob& other );
+};
+
+
+class ComputePool {
+
+public:
+
+    /**
+     * Holds the access locks of images that a job reads without a handle of its own
+     * (see ImageInterface::accessMutex()) for as long as it exists, so that the job
+     * and the other threads reading those images take turns.
+     */
+    class ImageLock {
+    public:
+        /**
+         * Constructor; waits for the locks of the images that have one.
+         * @param images - the images the job reads.
+         */
+        ImageLock( const std::vector<std::shared_ptr<Carta::Lib::Image::ImageInterface> >& images );
+
+        ~ImageLock();
+
+    private:
+        std::vector<QMutex*> m_mutexes;
+
+        ImageLock( const ImageLock& other);
+        ImageLock& operator=( const ImageLock& other );
+    };
+
+    /**
+     * Returns the shared pool. The number of threads is bounded by the
+     * computeThreadCountMax configuration setting (default: one per core), and the
+     * threads are kept alive so the image handles they opened can be reused.
+     * @return - the shared compute pool.
+     */
+    static QThreadPool* pool();
+
+    /**
+     * Queue a job on the shared pool.
+     * @param job - the job to run; the pool takes ownership.
+     */
+    static void start( ComputeJob* job );
+
+    /**
+     * Returns a handle to the image that may be used on the calling thread while
+     * other threads use the image. Handles are opened once per thread and image
+     * (see ImageInterface::cloneForThread) and reused by later jobs on the same thread.
+     * @param image - an image.
+     * @return - a handle to the image for the calling thread; the image itself if it
+     *      cannot be reopened or if this is the main thread, in which case jobs hold an
+     *      ImageLock on it while they read it.
+     */
+    static std::shared_ptr<Carta::Lib::Image::ImageInterface>
+    threadImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image );
+
+    /**
+     * Returns a copy of the region that a job can read while the user goes on
+     * editing the original.
+     * @param region - a region; may be null.
+     * @return - a copy of the region or null if there was no region.
+     */
+    static std::shared_ptr<Carta::Lib::Regions::RegionBase>
+    regionSnapshot( std::shared_ptr<Carta::Lib::Regions::RegionBase> region );
+
+private:
+    ComputePool();
+
+    //Makes the shared pool.
+    static QThreadPool* _makePool();
+};
+}
+}
@@ -402,6 +402,14 @@ QList<QString> Histogram::getLinks() const {
     return m_linkImpl->getLinkIds();
 }
 
+QList<Carta::Lib::Hooks::HistogramResult> Histogram::getHistogramResults() const {
+    QList<Carta::Lib::Hooks::HistogramResult> results;
+    for ( std::shared_ptr<BinData> binData : m_binDatas ){
+        results.append( binData->getHistogramResult() );
+    }
+    return results;
+}
+
 bool Histogram::getLogCount() const {
     bool logCount = m_state.getValue<bool>(GRAPH_LOG_COUNT);
     return logCount;
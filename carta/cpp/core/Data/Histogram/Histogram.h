@@ -85,6 +85,12 @@ public:
 	 */
 	QString getFootPrint2D() const;
 
+	/**
+	 * Return the (value,count) pairs of the histograms that have been computed.
+	 * @return - the result of each histogram computation that is shown.
+	 */
+	QList<Carta::Lib::Hooks::HistogramResult> getHistogramResults() const;
+
 	/**
 	 * Determine whether or not the vertical axis is using a log scale.
 	 * @return true if the vertical axis is using a log scale; false otherwise.
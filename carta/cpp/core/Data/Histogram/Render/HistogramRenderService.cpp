@@ -1,6 +1,5 @@
 #include "HistogramRenderService.h"
 #include "HistogramRenderWorker.h"
-#include "HistogramRenderThread.h"
 #include "CartaLib/Hooks/Histogram.h"
 #include "Data/Util.h"
 
@@ -9,8 +8,7 @@ namespace Data {
 
 HistogramRenderService::HistogramRenderService( QObject * parent ) :
         QObject( parent ),
-        m_worker( nullptr),
-        m_renderThread( nullptr ){
+        m_worker( nullptr){
     m_renderQueued = false;
 }
 
@@ -19,8 +17,9 @@ bool HistogramRenderService::renderHistogram( const HistogramRenderRequest& requ
 	bool histogramRender = true;
 	if ( request.getImage() ){
 		if ( ! m_requests.contains( request ) ){
+			_removeSuperseded( request );
 			m_requests.enqueue( request );
-			_scheduleRender( request );
+			_scheduleRender( m_requests.head() );
 		}
 	}
 	else {
@@ -30,35 +29,37 @@ bool HistogramRenderService::renderHistogram( const HistogramRenderRequest& requ
 }
 
 
+void HistogramRenderService::_removeSuperseded( const HistogramRenderRequest& request ){
+	//The head of the queue is being computed, so leave it alone.
+	for ( int i = m_requests.size() - 1; i > 0; i-- ){
+		if ( m_requests[i].getFileName() == request.getFileName() &&
+				m_requests[i].getRegionId() == request.getRegionId() ){
+			m_requests.removeAt( i );
+		}
+	}
+}
+
+
 void HistogramRenderService::_scheduleRender( const HistogramRenderRequest& request ){
 	if ( m_renderQueued ) {
 		return;
 	}
 	m_renderQueued = true;
 	if ( !m_worker ){
-		m_worker = new HistogramRenderWorker();
+		m_worker.reset( new HistogramRenderWorker() );
 	}
 	m_worker->setParameters( request );
-	int pid = m_worker->computeHist();
-	if ( pid != -1 ){
-		if ( !m_renderThread ){
-			m_renderThread = new HistogramRenderThread( pid );
-			connect( m_renderThread, SIGNAL(finished()), this, SLOT( _postResult()));
-		}
-		else {
-			m_renderThread->setFileDescriptor( pid );
-		}
-		m_renderThread->start();
-	}
-	else {
-		qDebug() << "Bad file descriptor: "<<pid;
-		m_renderQueued = false;
-	}
 
+	//Compute on the shared pool; the job keeps the worker alive even if we go away.
+	std::shared_ptr<HistogramRenderWorker> worker = m_worker;
+	m_cancelFlag = ComputeJob::makeCancelFlag();
+	ComputeJob* job = new ComputeJob( [worker](){ worker->computeHist(); }, m_cancelFlag );
+	connect( job, SIGNAL(finished()), this, SLOT( _postResult()));
+	ComputePool::start( job );
 }
 
 void HistogramRenderService::_postResult( ){
-	Carta::Lib::Hooks::HistogramResult result = m_renderThread->getResult();
+	Carta::Lib::Hooks::HistogramResult result = m_worker->getResult();
 	m_requests.dequeue();
 	emit histogramResult( result );
 	m_renderQueued = false;
@@ -70,11 +71,9 @@ void HistogramRenderService::_postResult( ){
 
 
 HistogramRenderService::~HistogramRenderService(){
-    if ( m_renderThread ){
-    	m_renderThread->wait();
-    	delete m_renderThread;
+    if ( m_cancelFlag ){
+        *m_cancelFlag = true;
     }
-    delete m_worker;
 }
 }
 }
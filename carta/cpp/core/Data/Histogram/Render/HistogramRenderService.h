@@ -6,6 +6,7 @@
 #include "HistogramRenderRequest.h"
 #include "CartaLib/CartaLib.h"
 #include "CartaLib/Hooks/HistogramResult.h"
+#include "Data/Compute/ComputePool.h"
 
 #include <QQueue>
 #include <memory>
@@ -26,7 +27,6 @@ namespace Carta{
 namespace Data{
 
 class HistogramRenderWorker;
-class HistogramRenderThread;
 
 class HistogramRenderService : public QObject {
     Q_OBJECT
@@ -61,9 +61,12 @@ private slots:
     void _postResult( );
 
 private:
+    //Drop queued requests that a newer request for the same image and region replaces.
+    void _removeSuperseded( const HistogramRenderRequest& request );
     void _scheduleRender( const HistogramRenderRequest& request );
-    HistogramRenderWorker* m_worker;
-    HistogramRenderThread* m_renderThread;
+    std::shared_ptr<HistogramRenderWorker> m_worker;
+    //Cancels the job that is currently running, if any.
+    ComputeJob::CancelFlag m_cancelFlag;
     bool m_renderQueued;
     QQueue<HistogramRenderRequest> m_requests;
 
@@ -1,5 +1,5 @@
 /**
- * Initiates the work of computing the histogram in a separate process.
+ * Computes a histogram; meant to be run on a thread of the compute pool.
  **/
 
 #pragma once
@@ -40,11 +40,16 @@ public:
     void setParameters( const HistogramRenderRequest& request );
 
     /**
-     * Performs the work of computing the histogram data in a separate process.
-     * @return - the file descriptor for the pipe that can be used to read the
-     *      histogram data.
+     * Performs the work of computing the histogram data, using an image handle
+     * that belongs to the calling thread.
      */
-    int computeHist();
+    void computeHist();
+
+    /**
+     * Returns the histogram data.
+     * @return - the computed data for a histogram plot.
+     */
+    Carta::Lib::Hooks::HistogramResult getResult() const;
 
     /**
      * Destructor.
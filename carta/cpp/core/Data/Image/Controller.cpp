@@ -15,15 +15,22 @@
 #include "Data/Settings.h"
 #include "Data/DataLoader.h"
 #include "Data/Error/ErrorManager.h"
+#include "Data/Compute/ComputePool.h"
 
 #include "Data/Util.h"
 #include "ImageView.h"
 #include "CartaLib/IImage.h"
+#include "CartaLib/Hooks/ConversionSpectralHook.h"
+#include "CartaLib/Hooks/MomentsHook.h"
+#include "CartaLib/Hooks/FitCubeHook.h"
 #include "Globals.h"
 
 #include <QtCore/QDebug>
 #include <QtCore/QList>
 #include <QtCore/QDir>
+#include <QtCore/QUuid>
+#include <atomic>
+#include <limits>
 #include <memory>
 #include <set>
 
@@ -67,6 +74,42 @@ using Carta::State::UtilState;
 using Carta::State::StateInterface;
 using Carta::Lib::AxisInfo;
 
+struct Controller::MomentsRequest {
+    //Name of the layer the moments are computed for.
+    QString layerName;
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image;
+    std::shared_ptr<Carta::Lib::Regions::RegionBase> region;
+    std::vector<Carta::Lib::Hooks::MomentsHook::MomentType> moments;
+    int spectralAxis;
+    int channelMin;
+    int channelMax;
+    std::vector<int> frames;
+    std::vector<double> spectralValues;
+    QString spectralUnit;
+    double includeMin;
+    double includeMax;
+    Carta::Lib::Hooks::MomentsHook::ResultType result;
+    std::atomic<bool> done;
+};
+
+struct Controller::FitCubeRequest {
+    //Name of the layer being fitted.
+    QString layerName;
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image;
+    std::shared_ptr<Carta::Lib::Regions::RegionBase> region;
+    int gaussCount;
+    int polyTerms;
+    int spectralAxis;
+    int channelMin;
+    int channelMax;
+    std::vector<int> frames;
+    std::vector<double> spectralValues;
+    QString spectralUnit;
+    bool average;
+    Carta::Lib::Hooks::FitCubeHook::ResultType result;
+    std::atomic<bool> done;
+};
+
 Controller::Controller( const QString& path, const QString& id ) :
         		CartaObject( CLASS_NAME, path, id),
 				m_stateMouse(UtilState::getLookup(path, Util::VIEW)){
@@ -112,6 +155,8 @@ Controller::Controller( const QString& path, const QString& id ) :
 
 	RegionControls* regionObj = objMan->createObject<RegionControls>();
 	connect( regionObj, SIGNAL(regionsChanged()), this, SLOT(_regionsChanged()));
+	connect( regionObj, SIGNAL(regionDragged(int, const QJsonObject&)),
+			this, SLOT(_regionDragged(int, const QJsonObject&)));
 
 	m_regionControls.reset( regionObj );
 }
@@ -129,19 +174,32 @@ QString Controller::addData(const QString& fileName, bool* success) {
 QString Controller::_addDataImage(const QString& fileName, bool* success ) {
     QString result = m_stack->_addDataImage( fileName, success );
     if ( *success ){
-        if ( isStackSelectAuto() ){
-            QStringList selectedLayers;
-            QString stackId= m_stack->_getCurrentId();
-            selectedLayers.append( stackId );
-            _setLayersSelected( selectedLayers );
-        }
-        _setSkyCSName();
-        _updateDisplayAxes();
-        emit dataChanged( this );
+        _dataImageAdded();
     }
     return result;
 }
 
+QString Controller::_addDataImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+        const QString& imageId, const QString& name, bool* success ){
+    QString result = m_stack->_addDataImage( image, imageId, name, success );
+    if ( *success ){
+        _dataImageAdded();
+    }
+    return result;
+}
+
+void Controller::_dataImageAdded(){
+    if ( isStackSelectAuto() ){
+        QStringList selectedLayers;
+        QString stackId= m_stack->_getCurrentId();
+        selectedLayers.append( stackId );
+        _setLayersSelected( selectedLayers );
+    }
+    _setSkyCSName();
+    _updateDisplayAxes();
+    emit dataChanged( this );
+}
+
 QStringList Controller::getFileList(){
   return m_stack->_getFileList();
 }
@@ -254,6 +312,212 @@ std::set<AxisInfo::KnownType> Controller::_getAxesHidden() const {
 }
 
 
+QString Controller::generateMoments( const QStringList& moments, int channelMin, int channelMax,
+        double includeMin, double includeMax, const QString& spectralUnit, bool useRegion ){
+    typedef Carta::Lib::Hooks::MomentsHook::MomentType MomentType;
+    std::shared_ptr<Layer> layer = m_stack->_getLayer( "" );
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image;
+    if ( layer ){
+        image = layer->_getImage();
+    }
+    if ( !image ){
+        return "Please load an image before generating moments.";
+    }
+    int spectralAxis = Util::getAxisIndex( image, AxisInfo::KnownType::SPECTRAL );
+    if ( spectralAxis < 2 ){
+        return "Moments can only be generated for cubes with a spectral axis after the spatial axes.";
+    }
+
+    std::shared_ptr<MomentsRequest> request( new MomentsRequest() );
+    request->done = false;
+    for ( const QString& momentName : moments ){
+        QString name = momentName.trimmed().toLower();
+        if ( name == "0" || name == "integrated" ){
+            request->moments.push_back( MomentType::INTEGRATED );
+        }
+        else if ( name == "1" || name == "weighted_coord" ){
+            request->moments.push_back( MomentType::WEIGHTED_COORD );
+        }
+        else if ( name == "2" || name == "weighted_dispersion_coord" ){
+            request->moments.push_back( MomentType::WEIGHTED_DISPERSION );
+        }
+        else if ( name == "maximum" ){
+            request->moments.push_back( MomentType::MAXIMUM );
+        }
+        else if ( name == "median" ){
+            request->moments.push_back( MomentType::MEDIAN );
+        }
+        else if ( !name.isEmpty() ){
+            return "Unrecognized moment: "+momentName;
+        }
+    }
+    if ( request->moments.empty() ){
+        return "Please specify the moments to generate.";
+    }
+    if ( channelMin >= 0 && channelMax >= 0 && channelMin > channelMax ){
+        return "The first channel of the moments must not be after the last one.";
+    }
+    if ( includeMin > includeMax ){
+        return "The minimum intensity of the moments must not be above the maximum.";
+    }
+
+    if ( useRegion ){
+        std::shared_ptr<Region> region = m_regionControls->getRegion( "" );
+        if ( !region ){
+            return "Please select a region for the moments.";
+        }
+        request->region = ComputePool::regionSnapshot( region->getModel() );
+    }
+
+    //Spectral coordinates of the channels from the spectral conversion plugin.
+    int channelCount = image->dims()[spectralAxis];
+    std::vector<double> channels( channelCount );
+    for ( int i = 0; i < channelCount; i++ ){
+        channels[i] = i;
+    }
+    auto conversion = Globals::instance()-> pluginManager()
+            -> prepare <Carta::Lib::Hooks::ConversionSpectralHook>( image, "", spectralUnit, channels );
+    std::vector<double>& spectralValues = request->spectralValues;
+    auto lam = [&spectralValues] ( const Carta::Lib::Hooks::ConversionSpectralHook::ResultType &data ) {
+        spectralValues = data;
+    };
+    conversion.forEach( lam );
+
+    request->layerName = layer->_getLayerName();
+    request->image = image;
+    request->spectralAxis = spectralAxis;
+    request->channelMin = channelMin;
+    request->channelMax = channelMax;
+    request->frames = m_stack->_getImageSlice();
+    request->spectralUnit = spectralUnit;
+    request->includeMin = includeMin;
+    request->includeMax = includeMax;
+    auto work = [request](){
+        std::shared_ptr<Carta::Lib::Image::ImageInterface> threadImage =
+                ComputePool::threadImage( request->image );
+        ComputePool::ImageLock lock( { threadImage } );
+        auto result = Globals::instance()-> pluginManager()
+                -> prepare <Carta::Lib::Hooks::MomentsHook>( threadImage, request->region,
+                        request->moments, request->spectralAxis, request->channelMin,
+                        request->channelMax, request->frames, request->spectralValues,
+                        request->spectralUnit, request->includeMin, request->includeMax ).first();
+        if ( !result.isNull() ){
+            request->result = result.val();
+        }
+        request->done = true;
+    };
+    ComputeJob* job = new ComputeJob( work, ComputeJob::makeCancelFlag() );
+    connect( job, SIGNAL(finished()), this, SLOT(_momentsGenerated()) );
+    m_momentsRequests.append( request );
+    ComputePool::start( job );
+    return "";
+}
+
+
+QString Controller::fitCube( int gaussCount, int polyDegree, int channelMin, int channelMax,
+        const QString& spectralUnit, bool useRegion, bool average ){
+    std::shared_ptr<Layer> layer = m_stack->_getLayer( "" );
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image;
+    if ( layer ){
+        image = layer->_getImage();
+    }
+    if ( !image ){
+        return "Please load an image before fitting.";
+    }
+    int spectralAxis = Util::getAxisIndex( image, AxisInfo::KnownType::SPECTRAL );
+    if ( spectralAxis < 2 ){
+        return "Only cubes with a spectral axis after the spatial axes can be fitted.";
+    }
+    if ( gaussCount < 1 ){
+        return "Please fit at least one Gaussian.";
+    }
+    if ( polyDegree < -1 ){
+        return "The degree of the baseline must be -1 (no baseline) or more.";
+    }
+    if ( channelMin >= 0 && channelMax >= 0 && channelMin > channelMax ){
+        return "The first channel of the fit must not be after the last one.";
+    }
+
+    std::shared_ptr<FitCubeRequest> request( new FitCubeRequest() );
+    request->done = false;
+    if ( useRegion ){
+        std::shared_ptr<Region> region = m_regionControls->getRegion( "" );
+        if ( !region ){
+            return "Please select a region for the fit.";
+        }
+        request->region = ComputePool::regionSnapshot( region->getModel() );
+    }
+
+    //Spectral coordinates of the channels from the spectral conversion plugin.
+    int channelCount = image->dims()[spectralAxis];
+    std::vector<double> channels( channelCount );
+    for ( int i = 0; i < channelCount; i++ ){
+        channels[i] = i;
+    }
+    auto conversion = Globals::instance()-> pluginManager()
+            -> prepare <Carta::Lib::Hooks::ConversionSpectralHook>( image, "", spectralUnit, channels );
+    std::vector<double>& spectralValues = request->spectralValues;
+    auto lam = [&spectralValues] ( const Carta::Lib::Hooks::ConversionSpectralHook::ResultType &data ) {
+        spectralValues = data;
+    };
+    conversion.forEach( lam );
+
+    request->layerName = layer->_getLayerName();
+    request->image = image;
+    request->gaussCount = gaussCount;
+    request->polyTerms = polyDegree + 1;
+    request->spectralAxis = spectralAxis;
+    request->channelMin = channelMin;
+    request->channelMax = channelMax;
+    request->frames = m_stack->_getImageSlice();
+    request->spectralUnit = spectralUnit;
+    request->average = average;
+    auto work = [request](){
+        std::shared_ptr<Carta::Lib::Image::ImageInterface> threadImage =
+                ComputePool::threadImage( request->image );
+        ComputePool::ImageLock lock( { threadImage } );
+        auto result = Globals::instance()-> pluginManager()
+                -> prepare <Carta::Lib::Hooks::FitCubeHook>( threadImage, request->region,
+                        request->gaussCount, request->polyTerms, request->spectralAxis,
+                        request->channelMin, request->channelMax, request->frames,
+                        request->spectralValues, request->spectralUnit, request->average ).first();
+        if ( !result.isNull() ){
+            request->result = result.val();
+        }
+        request->done = true;
+    };
+    ComputeJob* job = new ComputeJob( work, ComputeJob::makeCancelFlag() );
+    connect( job, SIGNAL(finished()), this, SLOT(_cubeFitted()) );
+    m_fitCubeRequests.append( request );
+    ComputePool::start( job );
+    return "";
+}
+
+void Controller::_cubeFitted(){
+    for ( int i = m_fitCubeRequests.size() - 1; i >= 0; i-- ){
+        std::shared_ptr<FitCubeRequest> request = m_fitCubeRequests[i];
+        if ( !request->done ){
+            continue;
+        }
+        m_fitCubeRequests.removeAt( i );
+        if ( request->result.empty() ){
+            QString msg = "Gaussians could not be fitted to "+request->layerName+".";
+            Util::commandPostProcess( msg );
+            continue;
+        }
+        for ( const Carta::Lib::Hooks::FitCubeHook::FitMap& fitMap : request->result ){
+            QString name = request->layerName + "." + fitMap.m_name;
+            QString imageId = "fit:" + QUuid::createUuid().toString() + "/" + name;
+            bool success = false;
+            QString result = _addDataImage( fitMap.m_image, imageId, name, &success );
+            if ( !success ){
+                Util::commandPostProcess( result );
+            }
+        }
+    }
+}
+
+
 QPointF Controller::getCenterPixel() const {
     QPointF center = m_stack->_getCenterPixel();
     return center;
@@ -317,6 +581,10 @@ std::vector< std::shared_ptr<Carta::Lib::Image::ImageInterface> > Controller::ge
     return m_stack->_getImages();
 }
 
+QStringList Controller::getImageFileNames() {
+    return m_stack->_getImageFileNames();
+}
+
 
 std::shared_ptr<ContourControls> Controller::getContourControls() {
     return m_contourControls;
@@ -662,6 +930,82 @@ void Controller::_initializeCallbacks(){
             return result;
         });
 
+    addCommandCallback( "generateMoments", [=] (const QString & /*cmd*/,
+                        const QString & params, const QString & /*sessionId*/) -> QString {
+            std::set<QString> keys = {"moments", "channelMin", "channelMax",
+                "includeMin", "includeMax", "spectralUnit", "useRegion"};
+            std::map<QString,QString> dataValues = Carta::State::UtilState::parseParamMap( params, keys );
+            QString result;
+            //Moments are separated by spaces; an empty intensity means no bound.
+            QStringList moments = dataValues["moments"].split( " ", QString::SkipEmptyParts );
+            bool validMin = false;
+            int channelMin = dataValues["channelMin"].toInt( &validMin );
+            bool validMax = false;
+            int channelMax = dataValues["channelMax"].toInt( &validMax );
+            bool validIncludeMin = true;
+            double includeMin = -std::numeric_limits<double>::infinity();
+            if ( !dataValues["includeMin"].isEmpty() ){
+                includeMin = dataValues["includeMin"].toDouble( &validIncludeMin );
+            }
+            bool validIncludeMax = true;
+            double includeMax = std::numeric_limits<double>::infinity();
+            if ( !dataValues["includeMax"].isEmpty() ){
+                includeMax = dataValues["includeMax"].toDouble( &validIncludeMax );
+            }
+            bool validBool = false;
+            bool useRegion = Util::toBool( dataValues["useRegion"], &validBool );
+            if ( !validMin || !validMax ){
+                result = "Moment channels must be integers: "+params;
+            }
+            else if ( !validIncludeMin || !validIncludeMax ){
+                result = "Moment intensity bounds must be numbers: "+params;
+            }
+            else if ( !validBool ){
+                result = "Whether to use the region for moments must be true/false: "+params;
+            }
+            else {
+                result = generateMoments( moments, channelMin, channelMax, includeMin, includeMax,
+                        dataValues["spectralUnit"], useRegion );
+            }
+            Util::commandPostProcess( result );
+            return result;
+        });
+
+    addCommandCallback( "fitCube", [=] (const QString & /*cmd*/,
+                        const QString & params, const QString & /*sessionId*/) -> QString {
+            std::set<QString> keys = {"gaussCount", "polyDegree", "channelMin", "channelMax",
+                "spectralUnit", "useRegion", "average"};
+            std::map<QString,QString> dataValues = Carta::State::UtilState::parseParamMap( params, keys );
+            QString result;
+            bool validGauss = false;
+            int gaussCount = dataValues["gaussCount"].toInt( &validGauss );
+            bool validPoly = false;
+            int polyDegree = dataValues["polyDegree"].toInt( &validPoly );
+            bool validMin = false;
+            int channelMin = dataValues["channelMin"].toInt( &validMin );
+            bool validMax = false;
+            int channelMax = dataValues["channelMax"].toInt( &validMax );
+            bool validRegion = false;
+            bool useRegion = Util::toBool( dataValues["useRegion"], &validRegion );
+            bool validAverage = false;
+            bool average = Util::toBool( dataValues["average"], &validAverage );
+            if ( !validGauss || !validPoly ){
+                result = "The Gaussian count and baseline degree must be integers: "+params;
+            }
+            else if ( !validMin || !validMax ){
+                result = "Fit channels must be integers: "+params;
+            }
+            else if ( !validRegion || !validAverage ){
+                result = "Whether to use the region and whether to fit its mean spectrum must be true/false: "+params;
+            }
+            else {
+                result = fitCube( gaussCount, polyDegree, channelMin, channelMax,
+                        dataValues["spectralUnit"], useRegion, average );
+            }
+            Util::commandPostProcess( result );
+            return result;
+        });
+
     /*QString pointerPath= UtilState::getLookup( getPath(), UtilState::getLookup( Util::VIEW, Util::POINTER_MOVE));
     addStateCallback( pointerPath, [=] ( const QString& path, const QString& value ) {
         QStringList mouseList = value.split( " ");
@@ -964,6 +1308,9 @@ void Controller::_loadViewQueued( ){
 }
 
 void Controller::_loadView(){
+    //Pan and zoom change which regions are in view.
+    _updateRegionGraphics();
+
     //Load the image.
     bool autoClip = m_state.getValue<bool>(AUTO_CLIP);
     double clipValueMin = m_state.getValue<double>(CLIP_VALUE_MIN);
@@ -972,6 +1319,32 @@ void Controller::_loadView(){
     emit contextChanged();
 }
 
+void Controller::_momentsGenerated(){
+    for ( int i = m_momentsRequests.size() - 1; i >= 0; i-- ){
+        std::shared_ptr<MomentsRequest> request = m_momentsRequests[i];
+        if ( !request->done ){
+            continue;
+        }
+        m_momentsRequests.removeAt( i );
+        if ( request->result.empty() ){
+            QString msg = "Moments could not be generated for "+request->layerName+".";
+            Util::commandPostProcess( msg );
+            continue;
+        }
+        //The maps only exist in memory, so each gets a new identifier in place
+        //of a file name.
+        for ( const Carta::Lib::Hooks::MomentsHook::Moment& moment : request->result ){
+            QString name = request->layerName + "." + moment.m_name;
+            QString imageId = "moments:" + QUuid::createUuid().toString() + "/" + name;
+            bool success = false;
+            QString result = _addDataImage( moment.m_image, imageId, name, &success );
+            if ( !success ){
+                Util::commandPostProcess( result );
+            }
+        }
+    }
+}
+
 QString Controller::moveSelectedLayers( bool moveDown ){
     QString result = m_stack->_moveSelectedLayers( moveDown );
     return result;
@@ -990,9 +1363,11 @@ void Controller::refreshState(){
     m_contourControls->refreshState();
 }
 
+void Controller::_regionDragged( int index, const QJsonObject& model ){
+	emit regionDragged( this, index, model );
+}
+
 void Controller::_regionsChanged(){
-	Carta::Lib::VectorGraphics::VGList vgList = m_regionControls->vgList();
-	m_stack-> _setRegionGraphics ( vgList );
 	_loadView();
 	emit dataChangedRegion( this );
 }
@@ -1001,6 +1376,13 @@ void Controller::removeContourSet( std::shared_ptr<DataContours> contourSet ){
     m_stack->_removeContourSet( contourSet );
 }
 
+void Controller::_prefetchFrames( AxisInfo::KnownType axisType, const std::vector<int>& frameIndices ){
+    bool autoClip = m_state.getValue<bool>(AUTO_CLIP);
+    double clipValueMin = m_state.getValue<double>(CLIP_VALUE_MIN);
+    double clipValueMax = m_state.getValue<double>(CLIP_VALUE_MAX);
+    m_stack->_prefetchFrames( axisType, frameIndices, autoClip, clipValueMin, clipValueMax );
+}
+
 void Controller::_renderZoom( double factor ){
     int mouseX = m_stateMouse.getValue<int>(ImageView::MOUSE_X );
     int mouseY = m_stateMouse.getValue<int>(ImageView::MOUSE_Y );
@@ -1398,6 +1780,22 @@ void Controller::_updateCursorText(bool notifyClients ){
 }
 
 
+void Controller::_updateRegionGraphics(){
+    //Only the regions in the part of the image that is in view are drawn.
+    QSize outputSize = getOutputSize();
+    QRectF viewRect;
+    bool validTopLeft = false;
+    bool validBottomRight = false;
+    QPointF topLeft = m_stack->_getImagePt( QPointF( 0, 0 ), outputSize, &validTopLeft );
+    QPointF bottomRight = m_stack->_getImagePt( QPointF( outputSize.width(), outputSize.height() ),
+            outputSize, &validBottomRight );
+    if ( validTopLeft && validBottomRight && !outputSize.isEmpty() ){
+        viewRect = QRectF( topLeft, bottomRight ).normalized();
+    }
+    Carta::Lib::VectorGraphics::VGList vgList = m_regionControls->vgList( viewRect );
+    m_stack-> _setRegionGraphics ( vgList );
+}
+
 void Controller::_updateDisplayAxes(){
     if ( m_gridControls ){
         std::vector<AxisInfo> supportedAxes = m_stack->_getAxisInfos();
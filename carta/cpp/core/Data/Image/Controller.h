@@ -110,6 +110,42 @@ public:
      */
     QString closeImage( const QString& id );
 
+    /**
+     * Fit Gaussians to every spectrum of the current image in the background and
+     * add maps of the amplitude, center and fwhm of each Gaussian and of the rms
+     * residual as new layers once the fit is done.
+     * @param gaussCount - the number of Gaussians fitted to each spectrum.
+     * @param polyDegree - the degree of the polynomial baseline fitted with the
+     *      Gaussians, or -1 for no baseline.
+     * @param channelMin - the first channel to fit, or -1 to start at the first channel.
+     * @param channelMax - the last channel to fit, or -1 to end at the last channel.
+     * @param spectralUnit - the unit of the centers and widths, for example 'km/s'.
+     * @param useRegion - whether only spectra in the selected region are fitted.
+     * @param average - whether the mean spectrum of the region (or of the image) is
+     *      fitted once instead of fitting each spectrum.
+     * @return - an error message if the fit could not be started; otherwise,
+     *      an empty string.
+     */
+    QString fitCube( int gaussCount, int polyDegree, int channelMin, int channelMax,
+            const QString& spectralUnit, bool useRegion, bool average );
+
+    /**
+     * Compute moment maps of the current image in the background and add each
+     * map as a new layer once they are all done.
+     * @param moments - the maps to compute: 'integrated' (or 0), 'weighted_coord' (or 1),
+     *      'weighted_dispersion_coord' (or 2), 'maximum', or 'median'.
+     * @param channelMin - the first channel to use, or -1 to start at the first channel.
+     * @param channelMax - the last channel to use, or -1 to end at the last channel.
+     * @param includeMin - pixels below this intensity are not used.
+     * @param includeMax - pixels above this intensity are not used.
+     * @param spectralUnit - the unit of the spectral coordinates, for example 'km/s'.
+     * @param useRegion - whether only pixels in the selected region are used.
+     * @return - an error message if the moments could not be started; otherwise,
+     *      an empty string.
+     */
+    QString generateMoments( const QStringList& moments, int channelMin, int channelMax,
+            double includeMin, double includeMax, const QString& spectralUnit, bool useRegion );
+
     /**
       * Get the image pixel that is currently centered.
       * @return a QPointF value consisting of the x- and y-coordinates of
@@ -199,6 +235,12 @@ public:
      */
     std::vector<std::shared_ptr<Carta::Lib::Image::ImageInterface> > getImages();
 
+    /**
+     * Return the files of the images returned by getImages().
+     * @return - the locations of the loaded image files.
+     */
+    QStringList getImageFileNames();
+
 
     /**
      * Get the image dimensions.
@@ -610,6 +652,14 @@ signals:
      */
     void dataChangedRegion( Controller* controller );
 
+    /**
+     * Notification that a region is being moved or resized.
+     * @param controller this Controller.
+     * @param index - the index of the region.
+     * @param model - a json representation of the region model at the current drag position.
+     */
+    void regionDragged( Controller* controller, int index, const QJsonObject& model );
+
     /**
      * Notification that the context image needs to be redrawn.  For example,
      * if the pan or zoom has changed.
@@ -637,6 +687,7 @@ private slots:
 
 	void _contourSetAdded( Layer* cData, const QString& setName );
 	void _contourSetRemoved( const QString setName );
+	void _cubeFitted();
 
 	void _gridChanged( const Carta::State::StateInterface& state, bool applyAll );
 	void _onInputEvent( InputEvent ev );
@@ -644,7 +695,9 @@ private slots:
 	//Refresh the view based on the latest data selection information.
 	void _loadView(  );
 	void _loadViewQueued( );
+	void _momentsGenerated();
 	void _notifyFrameChange( Carta::Lib::AxisInfo::KnownType axis );
+	void _regionDragged( int index, const QJsonObject& model );
 	void _regionsChanged();
 
 	// Asynchronous result from saveFullImage().
@@ -662,6 +715,13 @@ private:
 	/// Add an image to the stack from a file.
 	QString _addDataImage( const QString& fileName, bool* success );
 
+	/// Add an image that is not read from a file to the stack.
+	QString _addDataImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+	        const QString& imageId, const QString& name, bool* success );
+
+	//Finish adding an image to the stack.
+	void _dataImageAdded();
+
 	//Clear the color map.
 	void _clearColorMap();
 
@@ -691,6 +751,13 @@ private:
 	void _initializeState();
 	void _initializeCallbacks();
 
+	/**
+	 * Start reading frames that are likely to be shown next in the background.
+	 * @param axisType - the axis being animated.
+	 * @param frameIndices - the frames of the axis that will be shown next, in order.
+	 */
+	void _prefetchFrames( Carta::Lib::AxisInfo::KnownType axisType, const std::vector<int>& frameIndices );
+
 	void _renderZoom( double factor );
 	void _renderContext( double zoomFactor );
 
@@ -714,6 +781,8 @@ private:
 	void _updateCursor( int mouseX, int mouseY );
 	void _updateCursorText(bool notifyClients );
 	void _updateDisplayAxes( /*int targetIndex*/ );
+	//Gives the stack the graphics of the regions in view.
+	void _updateRegionGraphics();
 
 	static bool m_registered;
 
@@ -734,6 +803,14 @@ private:
 
 	std::unique_ptr<Settings> m_settings;
 
+	//Moment maps being computed in the background.
+	struct MomentsRequest;
+	QList< std::shared_ptr<MomentsRequest> > m_momentsRequests;
+
+	//Cubes being fitted in the background.
+	struct FitCubeRequest;
+	QList< std::shared_ptr<FitCubeRequest> > m_fitCubeRequests;
+
 	//Data available to and managed by this controller.
 	std::unique_ptr<Stack> m_stack;
 
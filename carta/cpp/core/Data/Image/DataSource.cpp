@@ -1,5 +1,7 @@
 #include "DataSource.h"
 #include "CoordinateSystems.h"
+#include "FramePrefetcher.h"
+#include "Data/Compute/ComputePool.h"
 #include "Data/Colormap/Colormaps.h"
 #include "Globals.h"
 #include "MainConfig.h"
@@ -19,6 +21,10 @@
 #include "../Clips.h"
 #include <QDebug>
 #include <QElapsedTimer>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <map>
 
 using Carta::Lib::AxisInfo;
 using Carta::Lib::AxisDisplayInfo;
@@ -38,6 +44,31 @@ const int DataSource::INDEX_FRAME_HIGH = 4;
 
 CoordinateSystems* DataSource::m_coords = nullptr;
 
+namespace {
+//Key of a percentile intensity in the disk cache.
+QString intensityCacheKey( const QString& fileName, int frameLow, int frameHigh,
+        double percentile, int stokeFrame, const QString& transformation_label ){
+    return QString("%1/%2/%3/%4/%5/%6/intensity").arg(fileName).arg(frameLow).arg(frameHigh).arg(stokeFrame).arg(percentile).arg(transformation_label);
+}
+
+//Key of the marker written to the disk cache once the clips of every plane are stored.
+QString clipsPrecomputedKey( const QString& fileName ){
+    return QString("%1/clipsPrecomputed").arg(fileName);
+}
+}
+
+struct DataSource::PrecomputedClips {
+    QString fileName;
+    //Channel, Stokes index and slice of each plane.
+    std::vector<int> channels;
+    std::vector<int> stokes;
+    std::vector<SliceND> slices;
+    //Intensity of each percentile, per plane; empty for planes without finite values.
+    std::vector< std::map<double, double> > clips;
+    ComputeJob::CancelFlag cancel;
+    std::atomic<bool> done;
+};
+
 DataSource::DataSource() :
     m_image( nullptr ),
     m_permuteImage( nullptr),
@@ -71,6 +102,8 @@ DataSource::DataSource() :
         else {
             m_diskCache = res.val();
         }
+
+        m_prefetcher.reset( new FramePrefetcher() );
 }
 
 std::vector<int> DataSource::_getPermOrder() const
@@ -445,7 +478,7 @@ std::pair<double, double> DataSource::_readIntensityCache(int frameLow, int fram
         bool intensityInCache = false;
         double value = -1; // define intensity
         double error = -1; // define intensity error order, i.e. (max-min)*[error order]
-        QString intensityKey = QString("%1/%2/%3/%4/%5/%6/intensity").arg(m_fileName).arg(frameLow).arg(frameHigh).arg(stokeFrame).arg(percentile).arg(transformation_label);
+        QString intensityKey = intensityCacheKey(m_fileName, frameLow, frameHigh, percentile, stokeFrame, transformation_label);
         QByteArray intensityVal, intensityError;
         intensityInCache = m_diskCache->readEntry(intensityKey.toUtf8(), intensityVal, intensityError);
         if (intensityInCache) {
@@ -461,7 +494,7 @@ std::pair<double, double> DataSource::_readIntensityCache(int frameLow, int fram
 // TODO: have to add the transformation label
 void DataSource::_setIntensityCache(double intensity, double error, int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformation_label) const {
     if (m_diskCache) {
-        QString intensityKey = QString("%1/%2/%3/%4/%5/%6/intensity").arg(m_fileName).arg(frameLow).arg(frameHigh).arg(stokeFrame).arg(percentile).arg(transformation_label);
+        QString intensityKey = intensityCacheKey(m_fileName, frameLow, frameHigh, percentile, stokeFrame, transformation_label);
         m_diskCache->setEntry(intensityKey.toUtf8(), d2qb(intensity), d2qb(error));
     }
 }
@@ -607,8 +640,7 @@ std::vector<double> DataSource::_getIntensity(int frameLow, int frameHigh,
             qDebug() << "++++++++ [apply] Carta::Core::Algorithms::percentile2pixels_approximation() function !!";
             
             // get all clip settings for approximate percentile calculations
-            std::shared_ptr<Carta::Data::Clips> m_clips;
-            std::vector<double> percentiles_from_all_clips = m_clips -> getAllClips2percentiles();
+            std::vector<double> percentiles_from_all_clips = Clips::getAllClips2percentiles();
 
             // get extra clipping values from UI which is not equal to current clipping ones
             // TODO: we check before caching these at the end, but we don't check if they are cached now.
@@ -757,13 +789,48 @@ std::vector<double> DataSource::_getPercentiles( int frameLow, int frameHigh, st
 }
 
 QPointF DataSource::_getPixelCoordinates( double ra, double dec, bool* valid ) const{
-    QPointF result;
+    std::vector<bool> validPts;
+    std::vector<QPointF> result = _getPixelCoordinates( { QPointF( ra, dec ) }, &validPts );
+    *valid = validPts[0];
+    return result[0];
+}
+
+std::vector<QPointF> DataSource::_getPixelCoordinates( const std::vector<QPointF>& worldPts,
+        std::vector<bool>* valid ) const{
+    int pointCount = worldPts.size();
+    std::vector<QPointF> result( pointCount );
+    valid->assign( pointCount, false );
+    if ( pointCount == 0 ){
+        return result;
+    }
     CoordinateFormatterInterface::SharedPtr cf( m_image-> metaData()-> coordinateFormatter()-> clone() );
-    const CoordinateFormatterInterface::VD world { ra, dec };
-    CoordinateFormatterInterface::VD pixel;
-    *valid = cf->toPixel( world, pixel );
-    if ( *valid ){
-        result = QPointF( pixel[0], pixel[1]);
+
+    //World values for the axes other than ra/dec are taken from the pixel origin.
+    int imageDims = _getDimensions();
+    CoordinateFormatterInterface::VD origin( imageDims, 0.0 );
+    CoordinateFormatterInterface::VD originWorld;
+    std::vector<bool> failures;
+    if ( !cf->toWorldMany( origin, originWorld, failures ) || originWorld.size() < 2 ){
+        return result;
+    }
+    int worldDims = originWorld.size();
+    CoordinateFormatterInterface::VD world( pointCount * worldDims );
+    for ( int i = 0; i < pointCount; i++ ){
+        std::copy( originWorld.begin(), originWorld.end(), world.begin() + i * worldDims );
+        world[i * worldDims] = worldPts[i].x();
+        world[i * worldDims + 1] = worldPts[i].y();
+    }
+
+    CoordinateFormatterInterface::VD pixels;
+    cf->toPixelMany( world, pixels, failures );
+    int pixelDims = pixels.size() / pointCount;
+    if ( pixelDims >= 2 ){
+        for ( int i = 0; i < pointCount; i++ ){
+            if ( !failures[i] ){
+                result[i] = QPointF( pixels[i * pixelDims], pixels[i * pixelDims + 1] );
+                (*valid)[i] = true;
+            }
+        }
     }
     return result;
 }
@@ -791,17 +858,40 @@ QPointF DataSource::_getScreenPt( const QPointF& imagePt, const QPointF& pan,
 
 QPointF DataSource::_getWorldCoordinates( double pixelX, double pixelY,
         Carta::Lib::KnownSkyCS coordSys, bool* valid ) const{
-    QPointF result;
+    std::vector<bool> validPts;
+    std::vector<QPointF> result = _getWorldCoordinates( { QPointF( pixelX, pixelY ) },
+            coordSys, &validPts );
+    *valid = validPts[0];
+    return result[0];
+}
+
+std::vector<QPointF> DataSource::_getWorldCoordinates( const std::vector<QPointF>& pixelPts,
+        Carta::Lib::KnownSkyCS coordSys, std::vector<bool>* valid ) const{
+    int pointCount = pixelPts.size();
+    std::vector<QPointF> result( pointCount );
+    valid->assign( pointCount, false );
+    if ( pointCount == 0 ){
+        return result;
+    }
     CoordinateFormatterInterface::SharedPtr cf( m_image-> metaData()-> coordinateFormatter()-> clone() );
     cf->setSkyCS( coordSys );
     int imageDims = _getDimensions();
-    std::vector<double> pixel( imageDims );
-    pixel[0] = pixelX;
-    pixel[1] = pixelY;
+    CoordinateFormatterInterface::VD pixels( pointCount * imageDims, 0.0 );
+    for ( int i = 0; i < pointCount; i++ ){
+        pixels[i * imageDims] = pixelPts[i].x();
+        pixels[i * imageDims + 1] = pixelPts[i].y();
+    }
     CoordinateFormatterInterface::VD world;
-    *valid = cf->toWorld( pixel, world );
-    if ( *valid ){
-        result = QPointF( world[0], world[1]);
+    std::vector<bool> failures;
+    cf->toWorldMany( pixels, world, failures );
+    int worldDims = world.size() / pointCount;
+    if ( worldDims >= 2 ){
+        for ( int i = 0; i < pointCount; i++ ){
+            if ( !failures[i] ){
+                result[i] = QPointF( world[i * worldDims], world[i * worldDims + 1] );
+                (*valid)[i] = true;
+            }
+        }
     }
     return result;
 }
@@ -979,13 +1069,21 @@ Carta::Lib::NdArray::RawViewInterface* DataSource::_getRawData( const std::vecto
     Carta::Lib::NdArray::RawViewInterface* rawData = nullptr;
     std::vector<int> mFrames = _fitFramesToImage( frames );
 
+    if ( m_permuteImage ){
+        rawData = m_permuteImage->getDataSlice( _getFrameSlice( mFrames ) );
+    }
+    return rawData;
+}
+
+
+SliceND DataSource::_getFrameSlice( const std::vector<int>& mFrames ) const {
+    SliceND nextSlice = SliceND();
     if ( m_permuteImage ){
         int imageDim =m_permuteImage->dims().size();
 
         //Build a vector showing the permute order.
         std::vector<int> indices = _getPermOrder();
 
-        SliceND nextSlice = SliceND();
         SliceND& slice = nextSlice;
 
         for ( int i = 0; i < imageDim; i++ ){
@@ -1022,9 +1120,8 @@ Carta::Lib::NdArray::RawViewInterface* DataSource::_getRawData( const std::vecto
                 slice.next();
             }
         }
-        rawData = m_permuteImage->getDataSlice( nextSlice );
     }
-    return rawData;
+    return nextSlice;
 }
 
 
@@ -1110,22 +1207,180 @@ void DataSource::_load(std::vector<int> frames, bool recomputeClipsOnNewFrame,
 		int frameSize = frames.size();
 		CARTA_ASSERT( frameSize == static_cast<int>(AxisInfo::KnownType::OTHER));
 		std::vector<int> mFrames = _fitFramesToImage( frames );
-		std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> view ( _getRawData( mFrames ) );
-		std::vector<int> dimVector = view->dims();
+		QString renderId = _getViewIdCurrent( mFrames );
+
+		//Use the frame if it has been read ahead.
+		FramePrefetcher::Frame prefetched;
+		std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> view;
+		if ( m_prefetcher->getFrame( renderId, prefetched ) ){
+			view = prefetched.view;
+		}
+		else {
+			view.reset( _getRawData( mFrames ) );
+		}
 
 		//Update the clip values
 		if ( recomputeClipsOnNewFrame ){
-			_updateClips( view,  minClipPercentile, maxClipPercentile, mFrames );
+			if ( prefetched.view && prefetched.minClipPercentile == minClipPercentile &&
+					prefetched.maxClipPercentile == maxClipPercentile ){
+				if ( std::isfinite( prefetched.clipMin ) && std::isfinite( prefetched.clipMax ) ){
+					m_pixelPipeline-> setMinMax( prefetched.clipMin, prefetched.clipMax );
+				}
+			}
+			else {
+				_updateClips( view,  minClipPercentile, maxClipPercentile, mFrames );
+			}
         }
 		QString cacheId=m_pixelPipeline-> cacheId();
 		m_renderService-> setPixelPipeline( m_pixelPipeline,cacheId );
 
-		QString renderId = _getViewIdCurrent( mFrames );
 		m_renderService-> setInputView( view, renderId );
 	}
 }
 
 
+void DataSource::_prefetchFrames( const std::vector< std::vector<int> >& frameList,
+        bool recomputeClipsOnNewFrame, double minClipPercentile, double maxClipPercentile ){
+    QList<FramePrefetcher::Request> requests;
+    for ( const std::vector<int>& frames : frameList ){
+        if ( _isLoadable( frames ) ){
+            std::vector<int> mFrames = _fitFramesToImage( frames );
+            FramePrefetcher::Request request;
+            request.viewId = _getViewIdCurrent( mFrames );
+            request.slice = _getFrameSlice( mFrames );
+            requests.append( request );
+        }
+    }
+    if ( !recomputeClipsOnNewFrame ){
+        minClipPercentile = std::numeric_limits<double>::quiet_NaN();
+        maxClipPercentile = std::numeric_limits<double>::quiet_NaN();
+    }
+    m_prefetcher->prefetch( m_permuteImage, requests, minClipPercentile, maxClipPercentile );
+}
+
+void DataSource::_precomputeClips(){
+    if ( !m_diskCache || !m_image || !Globals::instance()->mainConfig()->isClipPrecomputation() ){
+        return;
+    }
+
+    //Nothing to do if an earlier pass over this image stored its clips.
+    QByteArray markerVal, markerError;
+    if ( m_diskCache->readEntry( clipsPrecomputedKey( m_fileName ).toUtf8(), markerVal, markerError ) ){
+        return;
+    }
+
+    //The planes are the first two axes of the image, as it is shown when loaded;
+    //the cache keys only record the channel and Stokes index of a plane.
+    std::vector<int> dims = m_image->dims();
+    int imageDim = dims.size();
+    int spectralAxis = Util::getAxisIndex( m_image, AxisInfo::KnownType::SPECTRAL );
+    int stokesAxis = Util::getAxisIndex( m_image, AxisInfo::KnownType::STOKES );
+    if ( imageDim < 2 || ( 0 <= spectralAxis && spectralAxis < 2 ) ||
+            ( 0 <= stokesAxis && stokesAxis < 2 ) ){
+        return;
+    }
+    int channelCount = spectralAxis >= 0 ? dims[spectralAxis] : 1;
+    int stokeCount = stokesAxis >= 0 ? dims[stokesAxis] : 1;
+
+    std::shared_ptr<PrecomputedClips> precomputed( new PrecomputedClips() );
+    precomputed->fileName = m_fileName;
+    precomputed->cancel = ComputeJob::makeCancelFlag();
+    precomputed->done = false;
+    //Visit the planes in the order they are stored, so the cube is read in one pass.
+    for ( int stoke = 0; stoke < stokeCount; stoke++ ){
+        for ( int channel = 0; channel < channelCount; channel++ ){
+            SliceND slice;
+            for ( int i = 0; i < imageDim; i++ ){
+                if ( i != 0 && i != 1 ){
+                    int frameIndex = 0;
+                    if ( i == spectralAxis ){
+                        frameIndex = channel;
+                    }
+                    else if ( i == stokesAxis ){
+                        frameIndex = stoke;
+                    }
+                    slice.start( frameIndex );
+                    slice.end( frameIndex + 1 );
+                }
+                if ( i < imageDim - 1 ){
+                    slice.next();
+                }
+            }
+            precomputed->channels.push_back( channel );
+            precomputed->stokes.push_back( stokesAxis >= 0 ? stoke : -1 );
+            precomputed->slices.push_back( slice );
+        }
+    }
+    precomputed->clips.resize( precomputed->slices.size() );
+
+    //Percentiles of every clip preset, including the full range.
+    std::vector<double> percentiles = Clips::getAllClips2percentiles();
+    percentiles.insert( percentiles.begin(), 0 );
+    percentiles.push_back( 1 );
+
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image = m_image;
+    auto work = [image, percentiles, precomputed](){
+        std::shared_ptr<Carta::Lib::Image::ImageInterface> threadImage =
+                ComputePool::threadImage( image );
+        std::vector<double> values;
+        int planeCount = precomputed->slices.size();
+        for ( int i = 0; i < planeCount && !*precomputed->cancel; i++ ){
+            std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> view(
+                    threadImage->getDataSlice( precomputed->slices[i] ) );
+            if ( !view ){
+                continue;
+            }
+            values.clear();
+            Carta::Lib::NdArray::Double doubleView( view.get(), false );
+            doubleView.forEach( [&values]( const double& val ){
+                if ( std::isfinite( val ) ){
+                    values.push_back( val );
+                }
+            });
+            if ( !values.empty() ){
+                precomputed->clips[i] = Carta::Core::Algorithms::selectPercentiles( values, percentiles );
+            }
+        }
+        precomputed->done = true;
+    };
+    ComputeJob* computeJob = new ComputeJob( work, precomputed->cancel );
+    connect( computeJob, SIGNAL(finished()), this, SLOT(_clipsPrecomputed()) );
+    m_precomputedClips = precomputed;
+    ComputePool::start( computeJob );
+}
+
+void DataSource::_clipsPrecomputed(){
+    std::shared_ptr<PrecomputedClips> precomputed = m_precomputedClips;
+    if ( !precomputed || !precomputed->done ){
+        return;
+    }
+    m_precomputedClips.reset();
+    if ( !m_diskCache ){
+        return;
+    }
+
+    //Percentile intensities are exact, so they are stored with a zero error.
+    std::vector<Carta::Lib::IPCache::Entry> entries;
+    QByteArray exact = d2qb( 0 );
+    int planeCount = precomputed->slices.size();
+    for ( int i = 0; i < planeCount; i++ ){
+        for ( const std::pair<const double, double>& clip : precomputed->clips[i] ){
+            Carta::Lib::IPCache::Entry entry;
+            entry.key = intensityCacheKey( precomputed->fileName, precomputed->channels[i],
+                    precomputed->channels[i], clip.first, precomputed->stokes[i], "NONE" ).toUtf8();
+            entry.val = d2qb( clip.second );
+            entry.error = exact;
+            entries.push_back( entry );
+        }
+    }
+    Carta::Lib::IPCache::Entry marker;
+    marker.key = clipsPrecomputedKey( precomputed->fileName ).toUtf8();
+    marker.val = d2qb( planeCount );
+    marker.error = exact;
+    entries.push_back( marker );
+    m_diskCache->setEntries( entries );
+}
+
 void DataSource::_resetZoom(){
     m_renderService-> setZoom( ZOOM_DEFAULT );
 }
@@ -1149,13 +1404,8 @@ QString DataSource::_setFileName( const QString& fileName, bool* success ){
                                       -> prepare <Carta::Lib::Hooks::LoadAstroImage>( file )
                                       .first();
                 if (!res.isNull()){
-                    m_image = res.val();
-                    m_permuteImage = m_image;
-                    // reset zoom/pan
-                    _resetZoom();
-                    _resetPan();
-
-                    m_fileName = file;
+                    _resetImage( res.val(), file );
+                    _precomputeClips();
                 }
                 else {
                     result = "Could not find any plugin to load image";
@@ -1179,6 +1429,38 @@ QString DataSource::_setFileName( const QString& fileName, bool* success ){
 }
 
 
+QString DataSource::_setImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+        const QString& name, bool* success ){
+    QString result;
+    *success = false;
+    if ( !image ){
+        result = "There is no image to add.";
+    }
+    else if ( name.trimmed().isEmpty() ){
+        result = "The image needs a name.";
+    }
+    else {
+        //Clips are not precomputed for images in memory; they are small enough
+        //to compute on demand and are not around in later sessions.
+        _resetImage( image, name.trimmed() );
+        *success = true;
+    }
+    return result;
+}
+
+void DataSource::_resetImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+        const QString& name ){
+    m_image = image;
+    m_permuteImage = m_image;
+    m_prefetcher->clear();
+    _stopClipPrecomputation();
+    // reset zoom/pan
+    _resetZoom();
+    _resetPan();
+
+    m_fileName = name;
+}
+
 void DataSource::_setColorMap( const QString& name ){
     Carta::State::ObjectManager* objManager = Carta::State::ObjectManager::objectManager();
     Carta::State::CartaObject* obj = objManager->getObject( Colormaps::CLASS_NAME );
@@ -1272,6 +1554,7 @@ void DataSource::_setDisplayAxes(std::vector<AxisInfo::KnownType> displayAxisTyp
 
     if ( axisXChanged || axisYChanged ){
         m_permuteImage = _getPermutedImage();
+        m_prefetcher->clear();
         _resetPan();
     }
     std::vector<int> mFrames = _fitFramesToImage( frames );
@@ -1394,8 +1677,15 @@ void DataSource::_viewResize( const QSize& newSize ){
 }
 
 
-DataSource::~DataSource() {
+void DataSource::_stopClipPrecomputation(){
+    if ( m_precomputedClips ){
+        *m_precomputedClips->cancel = true;
+        m_precomputedClips.reset();
+    }
+}
 
+DataSource::~DataSource() {
+    _stopClipPrecomputation();
 }
 }
 }
@@ -40,6 +40,7 @@ class Service;
 namespace Data {
 
 class CoordinateSystems;
+class FramePrefetcher;
 
 class DataSource : public QObject {
 
@@ -60,9 +61,16 @@ public:
 
     virtual ~DataSource();
 
+private slots:
+
+    //Clips of the planes of the image have been computed in the background.
+    void _clipsPrecomputed();
 
 private:
 
+    //Clips of the planes of an image being computed in the background.
+    struct PrecomputedClips;
+
     /**
      * Resizes the frame indices to fit the current image.
      * @param sourceFrames - a list of current image frames.
@@ -279,6 +287,16 @@ private:
      */
     QPointF _getPixelCoordinates( double ra, double dec, bool* valid ) const;
 
+    /**
+     * Return the pixel coordinates corresponding to a list of world coordinates,
+     * converted in one batch.
+     * @param worldPts - (ra,dec) pairs (in radians) of the world coordinates.
+     * @param valid - for each point, true if its pixel coordinates are valid; false otherwise.
+     * @return - the pixel coordinates, in the same order as the world coordinates.
+     */
+    std::vector<QPointF> _getPixelCoordinates( const std::vector<QPointF>& worldPts,
+            std::vector<bool>* valid ) const;
+
     /**
      * Return the rest frequency and units for the image.
      * @return - the image rest frequency and units; a blank string and a negative
@@ -296,6 +314,17 @@ private:
     QPointF _getWorldCoordinates( double pixelX, double pixelY,
             Carta::Lib::KnownSkyCS coordSys, bool* valid ) const;
 
+    /**
+     * Return the world coordinates corresponding to a list of pixel coordinates,
+     * converted in one batch.
+     * @param pixelPts - the pixel coordinates to convert.
+     * @param coordSys - the sky coordinate system of the result.
+     * @param valid - for each point, true if its world coordinates are valid; false otherwise.
+     * @return - the world coordinates, in the same order as the pixel coordinates.
+     */
+    std::vector<QPointF> _getWorldCoordinates( const std::vector<QPointF>& pixelPts,
+            Carta::Lib::KnownSkyCS coordSys, std::vector<bool>* valid ) const;
+
     /**
      * Return the units of the pixels.
      * @return the units of the pixels, or blank if units could not be obtained.
@@ -348,6 +377,13 @@ private:
      */
     Carta::Lib::NdArray::RawViewInterface* _getRawData( const std::vector<int> frames ) const;
 
+    /**
+     * Returns the slice of the (permuted) image containing the view for the frames.
+     * @param frames - a list of image frames fitted to the image.
+     * @return the slice of the view.
+     */
+    SliceND _getFrameSlice( const std::vector<int>& frames ) const;
+
     std::shared_ptr<Carta::Core::ImageRenderService::Service> _getRenderer() const;
 
     /**
@@ -384,6 +420,33 @@ private:
     void _load( std::vector<int> frames, bool recomputeClipsOnNewFrame,
             double clipMinPercentile, double clipMaxPercentile );
 
+    /**
+     * Start reading frames that are likely to be shown next in the background.
+     * @param frameList - the frames to read, each a list of frames, one for each axis,
+     *      the most urgent first.
+     * @param recomputeClipsOnNewFrame - true if the clips will be recalculated when the
+     *      frames are shown; false otherwise.
+     * @param clipMinPercentile the minimum clip value.
+     * @param clipMaxPercentile the maximum clip value.
+     */
+    void _prefetchFrames( const std::vector< std::vector<int> >& frameList,
+            bool recomputeClipsOnNewFrame, double clipMinPercentile, double clipMaxPercentile );
+
+    /**
+     * Start computing the clips of every channel and Stokes plane of the image for
+     * the clip presets on the compute pool, if the configuration asks for it. The
+     * clips are written to the disk cache together once all planes are done.
+     */
+    void _precomputeClips();
+
+    /**
+     * Start using a new image, with the default pan and zoom.
+     * @param image - the image.
+     * @param name - the file name of the image, or a name identifying it.
+     */
+    void _resetImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+            const QString& name );
+
     /**
      * Center the image.
      */
@@ -484,6 +547,23 @@ private:
      */
     QString _setFileName( const QString& fileName, bool* success );
 
+    /**
+     * Use an image that is not read from a file, for example one that was computed.
+     * @param image - the image.
+     * @param name - identifies the image in place of a file name.  Cached values
+     *      such as clips are keyed on it, so it should be unique.
+     * @param success - set to true if the image can be used; otherwise, set to false.
+     * @return - an error message if the image could not be used; otherwise, an
+     *      empty string.
+     */
+    QString _setImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+            const QString& name, bool* success );
+
+    /**
+     * Stop computing clips in the background.
+     */
+    void _stopClipPrecomputation();
+
 
     /**
      * Set the data transform.
@@ -535,6 +615,12 @@ private:
     
     // disk cache
     std::shared_ptr<Carta::Lib::IPCache> m_diskCache;
+
+    //Frames read ahead during animation.
+    std::unique_ptr<FramePrefetcher> m_prefetcher;
+
+    //Clips being computed in the background; null if there are none.
+    std::shared_ptr<PrecomputedClips> m_precomputedClips;
     
     //Indices of the display axes.
     int m_axisIndexX;
@@ -0,0 +1,381 @@
+#include "FramePrefetcher.h"
+#include "Data/Compute/ComputePool.h"
+#include "Globals.h"
+#include "MainConfig.h"
+#include "../../Algorithms/percentileAlgorithms.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+namespace Carta {
+
+namespace Data {
+
+namespace {
+//Memory used for frames read ahead when the configuration does not limit it, in megabytes.
+const int PREFETCH_MEMORY_DEFAULT = 256;
+}
+
+
+PlaneView::PlaneView( Carta::Lib::NdArray::RawViewInterface* view ):
+    m_dims( view->dims() ),
+    m_start( 0 ),
+    m_steps( view->dims().size(), 1 ),
+    m_pixelCount( 1 ),
+    m_readPos( 0 ),
+    m_currentPos( view->dims().size(), 0 ){
+    //The values are stored in sequential order, with the first axis varying fastest.
+    int dimCount = m_dims.size();
+    for ( int i = 0; i < dimCount; i++ ){
+        m_steps[i] = m_pixelCount;
+        m_pixelCount *= m_dims[i];
+    }
+    std::shared_ptr<std::vector<float> > values( new std::vector<float>() );
+    values->reserve( m_pixelCount );
+    Carta::Lib::NdArray::Float floatView( view, false );
+    floatView.forEach( [&values]( const float& val ){
+        values->push_back( val );
+    });
+    m_values = values;
+}
+
+PlaneView::PlaneView( std::shared_ptr<const std::vector<float> > values, const VI& dims,
+        int64_t start, const std::vector<int64_t>& steps ):
+    m_values( values ),
+    m_dims( dims ),
+    m_start( start ),
+    m_steps( steps ),
+    m_pixelCount( 1 ),
+    m_readPos( 0 ),
+    m_currentPos( dims.size(), 0 ){
+    for ( int dim : m_dims ){
+        m_pixelCount *= dim;
+    }
+}
+
+void PlaneView::_copy( int64_t first, int64_t count, float* buff ) const {
+    if ( count <= 0 ){
+        return;
+    }
+    //Position of the first pixel, then step through the pixels in sequential order.
+    int dimCount = m_dims.size();
+    VI pos( dimCount, 0 );
+    int64_t rest = first;
+    for ( int i = 0; i < dimCount; i++ ){
+        pos[i] = rest % m_dims[i];
+        rest /= m_dims[i];
+    }
+    int64_t offset = _getOffset( pos );
+    const float* values = m_values->data();
+    for ( int64_t j = 0; j < count; j++ ){
+        buff[j] = values[offset];
+        for ( int i = 0; i < dimCount; i++ ){
+            pos[i]++;
+            offset += m_steps[i];
+            if ( pos[i] < m_dims[i] ){
+                break;
+            }
+            offset -= m_steps[i] * m_dims[i];
+            pos[i] = 0;
+        }
+    }
+}
+
+int64_t PlaneView::_getOffset( const VI& pos ) const {
+    int64_t offset = m_start;
+    int dimCount = m_dims.size();
+    for ( int i = 0; i < dimCount; i++ ){
+        offset += pos[i] * m_steps[i];
+    }
+    return offset;
+}
+
+qint64 PlaneView::getByteCount() const {
+    return static_cast<qint64>( m_values->size() ) * sizeof( float );
+}
+
+PlaneView::PixelType PlaneView::pixelType(){
+    return PixelType::Real32;
+}
+
+const PlaneView::VI& PlaneView::dims(){
+    return m_dims;
+}
+
+const char* PlaneView::get( const VI& pos ){
+    int dimCount = m_dims.size();
+    for ( int i = 0; i < dimCount; i++ ){
+        if ( pos[i] < 0 || pos[i] >= m_dims[i] ){
+            throw std::runtime_error( "invalid position" );
+        }
+    }
+    return reinterpret_cast<const char*>( m_values->data() + _getOffset( pos ) );
+}
+
+void PlaneView::forEach( std::function < void (const char *) > func, Traversal /*traversal*/ ){
+    std::fill( m_currentPos.begin(), m_currentPos.end(), 0 );
+    if ( m_pixelCount <= 0 ){
+        return;
+    }
+    int dimCount = m_dims.size();
+    int64_t offset = m_start;
+    const float* values = m_values->data();
+    for ( int64_t j = 0; j < m_pixelCount; j++ ){
+        func( reinterpret_cast<const char*>( values + offset ) );
+        for ( int i = 0; i < dimCount; i++ ){
+            m_currentPos[i]++;
+            offset += m_steps[i];
+            if ( m_currentPos[i] < m_dims[i] ){
+                break;
+            }
+            offset -= m_steps[i] * m_dims[i];
+            m_currentPos[i] = 0;
+        }
+    }
+}
+
+const PlaneView::VI& PlaneView::currentPos(){
+    return m_currentPos;
+}
+
+Carta::Lib::NdArray::RawViewInterface* PlaneView::getView( const SliceND& sliceInfo ){
+    SliceND::ApplyResult ar = sliceInfo.apply( m_dims );
+    if ( ar.isError() ){
+        return nullptr;
+    }
+    //The new view shares the values; each axis of the slice moves its first pixel
+    //and scales the distance between its pixels.
+    const std::vector<Slice1D::ApplyResult>& axes = ar.dims();
+    int dimCount = m_dims.size();
+    VI dims( dimCount, 1 );
+    std::vector<int64_t> steps( dimCount, 0 );
+    int64_t start = m_start;
+    for ( int i = 0; i < dimCount; i++ ){
+        start += axes[i].start * m_steps[i];
+        if ( !axes[i].isSingle() ){
+            dims[i] = axes[i].count;
+            steps[i] = axes[i].step * m_steps[i];
+        }
+    }
+    return new PlaneView( m_values, dims, start, steps );
+}
+
+int64_t PlaneView::read( int64_t buffSize, char* buff, Traversal /*traversal*/ ){
+    int64_t count = std::min( buffSize / static_cast<int64_t>( sizeof( float ) ),
+            m_pixelCount - m_readPos );
+    if ( count <= 0 ){
+        return 0;
+    }
+    _copy( m_readPos, count, reinterpret_cast<float*>( buff ) );
+    m_readPos += count;
+    return count * sizeof( float );
+}
+
+void PlaneView::seek( int64_t ind ){
+    m_readPos = std::max( static_cast<int64_t>( 0 ), std::min( ind, m_pixelCount ) );
+}
+
+int64_t PlaneView::read( int64_t chunk, int64_t buffSize, char* buff, Traversal /*traversal*/ ){
+    int64_t chunkCount = buffSize / sizeof( float );
+    if ( chunkCount <= 0 || chunk < 0 ){
+        return 0;
+    }
+    int64_t first = chunk * chunkCount;
+    int64_t count = std::min( chunkCount, m_pixelCount - first );
+    if ( count <= 0 ){
+        return 0;
+    }
+    _copy( first, count, reinterpret_cast<float*>( buff ) );
+    return count * sizeof( float );
+}
+
+void PlaneView::forEach( int64_t buffSize, std::function < void (const char *, int64_t count) > func,
+        char* buff, Traversal /*traversal*/ ){
+    int64_t chunkCount = std::max( buffSize / static_cast<int64_t>( sizeof( float ) ),
+            static_cast<int64_t>( 1 ) );
+    //A view of all the copied values can hand them out directly.
+    if ( m_start == 0 && m_pixelCount == static_cast<int64_t>( m_values->size() ) ){
+        bool sequential = true;
+        int64_t stride = 1;
+        int dimCount = m_dims.size();
+        for ( int i = 0; i < dimCount; i++ ){
+            if ( m_dims[i] > 1 && m_steps[i] != stride ){
+                sequential = false;
+                break;
+            }
+            stride *= m_dims[i];
+        }
+        if ( sequential ){
+            const float* values = m_values->data();
+            for ( int64_t first = 0; first < m_pixelCount; first += chunkCount ){
+                int64_t count = std::min( chunkCount, m_pixelCount - first );
+                func( reinterpret_cast<const char*>( values + first ), count );
+            }
+            return;
+        }
+    }
+    std::vector<float> ownBuffer;
+    float* chunkBuff = reinterpret_cast<float*>( buff );
+    if ( !chunkBuff ){
+        ownBuffer.resize( std::min( chunkCount, m_pixelCount ) );
+        chunkBuff = ownBuffer.data();
+    }
+    for ( int64_t first = 0; first < m_pixelCount; first += chunkCount ){
+        int64_t count = std::min( chunkCount, m_pixelCount - first );
+        _copy( first, count, chunkBuff );
+        func( reinterpret_cast<const char*>( chunkBuff ), count );
+    }
+}
+
+PlaneView::~PlaneView(){
+}
+
+
+FramePrefetcher::FramePrefetcher( QObject* parent ):
+    QObject( parent ){
+    int memoryMax = Globals::instance()->mainConfig()->getFramePrefetchMemoryMax();
+    if ( memoryMax <= 0 ){
+        memoryMax = PREFETCH_MEMORY_DEFAULT;
+    }
+    m_frames.setMaxCost( memoryMax * 1024 );
+}
+
+void FramePrefetcher::clear(){
+    for ( std::shared_ptr<PendingFrame> pending : m_pending ){
+        *pending->cancel = true;
+    }
+    m_pending.clear();
+    m_frames.clear();
+}
+
+void FramePrefetcher::_frameFetched(){
+    for ( int i = m_pending.size() - 1; i >= 0; i-- ){
+        if ( m_pending[i]->done ){
+            std::shared_ptr<PendingFrame> pending = m_pending.takeAt( i );
+            PlaneView* plane = dynamic_cast<PlaneView*>( pending->frame.view.get() );
+            if ( plane ){
+                m_frames.insert( pending->viewId, new Frame( pending->frame ),
+                        _getCost( plane->getByteCount() ) );
+            }
+        }
+    }
+}
+
+int FramePrefetcher::_getCost( qint64 byteCount ){
+    return static_cast<int>( std::max( byteCount / 1024, static_cast<qint64>( 1 ) ) );
+}
+
+bool FramePrefetcher::getFrame( const QString& viewId, Frame& frame ) const {
+    Frame* cached = m_frames.object( viewId );
+    if ( cached ){
+        frame = *cached;
+    }
+    return cached != nullptr;
+}
+
+void FramePrefetcher::prefetch( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+        const QList<Request>& requests, double minClipPercentile, double maxClipPercentile ){
+    if ( !image ){
+        return;
+    }
+
+    //Cancel frames we are reading that are no longer wanted.
+    QStringList viewIds;
+    for ( const Request& request : requests ){
+        viewIds.append( request.viewId );
+    }
+    for ( int i = m_pending.size() - 1; i >= 0; i-- ){
+        if ( !viewIds.contains( m_pending[i]->viewId ) ){
+            *m_pending[i]->cancel = true;
+            m_pending.removeAt( i );
+        }
+    }
+
+    //Only read as many frames as fit into the memory budget; the first two axes of
+    //the image are the display axes.
+    qint64 frameBytes = sizeof( float );
+    if ( image->dims().size() >= 2 ){
+        frameBytes *= static_cast<qint64>( image->dims()[0] ) * image->dims()[1];
+    }
+    int budget = m_frames.maxCost();
+    bool clips = !std::isnan( minClipPercentile ) && !std::isnan( maxClipPercentile );
+    for ( const Request& request : requests ){
+        //Frames already read do not take up more memory.
+        Frame* cached = m_frames.object( request.viewId );
+        bool clipsMatch = !clips || ( cached &&
+                cached->minClipPercentile == minClipPercentile &&
+                cached->maxClipPercentile == maxClipPercentile );
+        if ( cached && clipsMatch ){
+            continue;
+        }
+        budget -= _getCost( frameBytes );
+        if ( budget < 0 ){
+            break;
+        }
+        bool reading = false;
+        for ( std::shared_ptr<PendingFrame> pending : m_pending ){
+            if ( pending->viewId == request.viewId ){
+                reading = true;
+                break;
+            }
+        }
+        if ( reading ){
+            continue;
+        }
+
+        std::shared_ptr<PendingFrame> pending( new PendingFrame() );
+        pending->viewId = request.viewId;
+        pending->cancel = ComputeJob::makeCancelFlag();
+        pending->done = false;
+        pending->frame.minClipPercentile = std::numeric_limits<double>::quiet_NaN();
+        pending->frame.maxClipPercentile = std::numeric_limits<double>::quiet_NaN();
+        pending->frame.clipMin = std::numeric_limits<double>::quiet_NaN();
+        pending->frame.clipMax = std::numeric_limits<double>::quiet_NaN();
+        SliceND slice = request.slice;
+        auto work = [image, slice, clips, minClipPercentile, maxClipPercentile, pending](){
+            std::shared_ptr<Carta::Lib::Image::ImageInterface> threadImage =
+                    ComputePool::threadImage( image );
+            std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> view(
+                    threadImage->getDataSlice( slice ) );
+            if ( !view || *pending->cancel ){
+                return;
+            }
+            std::shared_ptr<PlaneView> plane( new PlaneView( view.get() ) );
+            if ( clips ){
+                std::vector<double> values;
+                Carta::Lib::NdArray::Double doubleView( plane.get(), false );
+                doubleView.forEach( [&values]( const double& val ){
+                    if ( std::isfinite( val ) ){
+                        values.push_back( val );
+                    }
+                });
+                //Planes without finite values keep NaN clips, which the renderer skips.
+                pending->frame.minClipPercentile = minClipPercentile;
+                pending->frame.maxClipPercentile = maxClipPercentile;
+                if ( !values.empty() ){
+                    std::map<double, double> clipsMap = Carta::Core::Algorithms::selectPercentiles(
+                            values, { minClipPercentile, maxClipPercentile } );
+                    pending->frame.clipMin = clipsMap[minClipPercentile];
+                    pending->frame.clipMax = clipsMap[maxClipPercentile];
+                }
+            }
+            pending->frame.view = plane;
+            pending->done = true;
+        };
+        ComputeJob* job = new ComputeJob( work, pending->cancel );
+        connect( job, SIGNAL(finished()), this, SLOT(_frameFetched()) );
+        m_pending.append( pending );
+        ComputePool::start( job );
+    }
+}
+
+FramePrefetcher::~FramePrefetcher(){
+    clear();
+}
+}
+}
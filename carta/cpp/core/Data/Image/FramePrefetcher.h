@@ -0,0 +1,173 @@
+/***
+ * Reads image frames ahead of an animation on the compute pool, so that the
+ * frames are already in memory, with their clips computed, when they are shown.
+ */
+
+#pragma once
+
+#include "CartaLib/IImage.h"
+#include "CartaLib/Slice.h"
+
+#include <QCache>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Carta {
+
+namespace Data {
+
+/**
+ * An in-memory copy of a view into an image, stored as floats. Views into the
+ * copy share its values.
+ */
+class PlaneView : public Carta::Lib::NdArray::RawViewInterface {
+
+public:
+
+    /**
+     * Constructor; copies the data of the view.
+     * @param view - the view to copy.
+     */
+    PlaneView( Carta::Lib::NdArray::RawViewInterface* view );
+
+    /**
+     * Returns the number of bytes used for the pixel values.
+     * @return - the size of the copied data in bytes.
+     */
+    qint64 getByteCount() const;
+
+    virtual PixelType pixelType() Q_DECL_OVERRIDE;
+    virtual const VI& dims() Q_DECL_OVERRIDE;
+    virtual const char* get( const VI& pos ) Q_DECL_OVERRIDE;
+    virtual void forEach( std::function < void (const char *) > func,
+            Traversal traversal = Traversal::Sequential ) Q_DECL_OVERRIDE;
+    virtual const VI& currentPos() Q_DECL_OVERRIDE;
+    virtual RawViewInterface* getView( const SliceND& sliceInfo ) Q_DECL_OVERRIDE;
+    virtual int64_t read( int64_t buffSize, char* buff,
+            Traversal traversal = Traversal::Sequential ) Q_DECL_OVERRIDE;
+    virtual void seek( int64_t ind = 0 ) Q_DECL_OVERRIDE;
+    virtual int64_t read( int64_t chunk, int64_t buffSize, char* buff,
+            Traversal traversal = Traversal::Sequential ) Q_DECL_OVERRIDE;
+    virtual void forEach( int64_t buffSize,
+            std::function < void (const char *, int64_t count) > func,
+            char* buff = nullptr, Traversal traversal = Traversal::Sequential ) Q_DECL_OVERRIDE;
+
+    virtual ~PlaneView();
+
+private:
+
+    //A view into values copied by another PlaneView.
+    PlaneView( std::shared_ptr<const std::vector<float> > values, const VI& dims,
+            int64_t start, const std::vector<int64_t>& steps );
+
+    //Returns the index into m_values of the pixel at the position.
+    int64_t _getOffset( const VI& pos ) const;
+
+    //Copies count pixels, starting at the given pixel index in sequential order.
+    void _copy( int64_t first, int64_t count, float* buff ) const;
+
+    std::shared_ptr<const std::vector<float> > m_values;
+    VI m_dims;
+    //Index into m_values of the first pixel of the view, and the distance between
+    //neighbouring pixels along each axis.
+    int64_t m_start;
+    std::vector<int64_t> m_steps;
+    int64_t m_pixelCount;
+    int64_t m_readPos;
+    VI m_currentPos;
+
+    PlaneView( const PlaneView& other);
+    PlaneView& operator=( const PlaneView& other );
+};
+
+
+class FramePrefetcher : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    /// A frame that should be read ahead.
+    struct Request {
+        /// render identifier of the frame.
+        QString viewId;
+        /// slice of the image containing the frame.
+        SliceND slice;
+    };
+
+    /// A frame that has been read ahead.
+    struct Frame {
+        std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> view;
+        /// percentiles the clips were computed for; NaN if no clips were computed.
+        double minClipPercentile;
+        double maxClipPercentile;
+        /// clip values; NaN if the frame has no finite pixels.
+        double clipMin;
+        double clipMax;
+    };
+
+    /**
+     * Constructor.
+     * @param parent - the owner of the prefetcher.
+     */
+    FramePrefetcher( QObject* parent = nullptr );
+
+    /**
+     * Discard all frames that have been read ahead and cancel the ones being read.
+     */
+    void clear();
+
+    /**
+     * Returns a frame that has been read ahead.
+     * @param viewId - the render identifier of the frame.
+     * @param frame - the frame (return value).
+     * @return - true if the frame is available; false otherwise.
+     */
+    bool getFrame( const QString& viewId, Frame& frame ) const;
+
+    /**
+     * Start reading frames in the background. Frames that are still being read from
+     * an earlier call but are no longer requested are cancelled. Frames beyond the
+     * memory budget are not read.
+     * @param image - the image to read from.
+     * @param requests - the frames to read, the most urgent first.
+     * @param minClipPercentile - the lower clip percentile; NaN if clips should not be
+     *      computed.
+     * @param maxClipPercentile - the upper clip percentile; NaN if clips should not be
+     *      computed.
+     */
+    void prefetch( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+            const QList<Request>& requests, double minClipPercentile, double maxClipPercentile );
+
+    virtual ~FramePrefetcher();
+
+private slots:
+
+    //A frame has been read.
+    void _frameFetched();
+
+private:
+
+    //A frame being read on the compute pool.
+    struct PendingFrame {
+        QString viewId;
+        Frame frame;
+        std::shared_ptr<std::atomic<bool> > cancel;
+        std::atomic<bool> done;
+    };
+
+    static int _getCost( qint64 byteCount );
+
+    //Frames that have been read, with their size in kilobytes as cost.
+    QCache<QString, Frame> m_frames;
+    QList<std::shared_ptr<PendingFrame> > m_pending;
+
+    FramePrefetcher( const FramePrefetcher& other);
+    FramePrefetcher& operator=( const FramePrefetcher& other );
+};
+}
+}
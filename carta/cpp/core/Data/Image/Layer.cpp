@@ -81,6 +81,14 @@ std::vector< std::shared_ptr<Carta::Lib::Image::ImageInterface> > Layer::_getIma
     return images;
 }
 
+QString Layer::_getImageFileName(){
+    return _getFileName();
+}
+
+QStringList Layer::_getImageFileNames(){
+    return QStringList();
+}
+
 std::shared_ptr<Layer> Layer::_getLayer( const QString& /*name*/ ){
     std::shared_ptr<Layer> layer( nullptr );
     return layer;
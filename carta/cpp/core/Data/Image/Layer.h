@@ -243,6 +243,18 @@ protected:
 
     virtual std::vector< std::shared_ptr<Carta::Lib::Image::ImageInterface> > _getImages();
 
+    /**
+     * Returns the file of the underlying image.
+     * @return - the location of the file of the image returned by _getImage().
+     */
+    virtual QString _getImageFileName();
+
+    /**
+     * Returns the files of the images returned by _getImages(), in the same order.
+     * @return - the locations of the image files.
+     */
+    virtual QStringList _getImageFileNames();
+
     /**
      * Returns the location on the image corresponding to a screen point in
      * pixels.
@@ -463,6 +475,17 @@ protected:
      */
     virtual bool _isSpectralAxis() const;
 
+    /**
+     * Start reading frames that are likely to be shown next in the background.
+     * @param frameList - the frames to read, each a list of frames, one for each of the
+     *      known axis types, the most urgent first.
+     * @param autoClip true if clips should be automatically generated; false otherwise.
+     * @param clipMinPercentile the minimum clip value.
+     * @param clipMaxPercentile the maximum clip value.
+     */
+    virtual void _prefetchFrames( const std::vector< std::vector<int> >& frameList,
+            bool autoClip, double clipMinPercentile, double clipMaxPercentile ) = 0;
+
     /**
      * Remove the contour set from this layer.
      * @param contourSet - the contour set to remove from the layer.
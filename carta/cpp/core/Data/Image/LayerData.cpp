@@ -732,6 +732,14 @@ void LayerData::_load(std::vector<int> frames, bool recomputeClipsOnNewFrame,
 }
 
 
+void LayerData::_prefetchFrames( const std::vector< std::vector<int> >& frameList,
+        bool autoClip, double clipMinPercentile, double clipMaxPercentile ){
+    if ( m_dataSource ){
+        m_dataSource->_prefetchFrames( frameList, autoClip, clipMinPercentile, clipMaxPercentile );
+    }
+}
+
+
 void LayerData::_removeContourSet( std::shared_ptr<DataContours> contourSet ){
     if ( contourSet ){
         QString targetName = contourSet->getName();
@@ -763,7 +771,10 @@ void LayerData::_renderingDone(
 		QPointF pan = _getPan();
 		double zoom = _getZoom();
 		QTransform tf;
-		bool valid =  _getTransform( pan, zoom, qImage.size(), tf );
+		//The image may only be a viewport of the output, so the transform has to be
+		//based on the size of the whole output.
+		QSize outputSize = m_dataSource->_getRenderer()->outputSize();
+		bool valid =  _getTransform( pan, zoom, outputSize, tf );
 		if ( _isContourDraw() && valid ){
 			if ( m_dataSource ){
 				comp.append< Carta::Lib::VectorGraphics::Entries::Save >( );
@@ -805,6 +816,7 @@ void LayerData::_renderStart(){
     std::shared_ptr<Carta::Core::ImageRenderService::Service> imageService = m_dataSource->_getRenderer();
 
     m_dataSource->_viewResize( outputSize );
+    imageService->setOutputViewport( request->getViewport() );
 
     //Use the zoom and pan from the render request, if they have been set;
     //otherwise, use the ones from our state.
@@ -981,30 +993,42 @@ QString LayerData::_getFileName() {
 QString LayerData::_setFileName( const QString& fileName, bool * success ){
     QString result = m_dataSource->_setFileName( fileName, success );
     if ( *success){
-
-        // Carta::Lib::KnownSkyCS cs;
-        QString csName = m_dataSource->_getSkyCS();
-        bool csChanged = false;
-        QString initCS = m_dataGrid->_setCoordinateSystem( csName, &csChanged);
-
-        //Reset the pan and zoom when the image is loaded.
-        _resetPan();
-        _resetZoom();
-
         //Default is to have the layer name match the file name, unless
         //the user has explicitly set it.
         DataLoader* dLoader = Util::findSingletonObject<DataLoader>();
         QString shortName = dLoader->getShortName( fileName );
-        QString layerName = m_state.getValue<QString>( Util::NAME );
-        if ( layerName.isEmpty() || layerName.length() == 0 ){
-            m_state.setValue<QString>( Util::NAME, shortName );
-            m_state.flushState();
-        }
-        result = m_state.getValue<QString>( Util::ID );
+        result = _imageChanged( shortName );
     }
     return result;
 }
 
+QString LayerData::_setImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+        const QString& imageId, const QString& name, bool* success ){
+    QString result = m_dataSource->_setImage( image, imageId, success );
+    if ( *success ){
+        result = _imageChanged( name );
+    }
+    return result;
+}
+
+QString LayerData::_imageChanged( const QString& defaultName ){
+    // Carta::Lib::KnownSkyCS cs;
+    QString csName = m_dataSource->_getSkyCS();
+    bool csChanged = false;
+    QString initCS = m_dataGrid->_setCoordinateSystem( csName, &csChanged);
+
+    //Reset the pan and zoom when the image is loaded.
+    _resetPan();
+    _resetZoom();
+
+    QString layerName = m_state.getValue<QString>( Util::NAME );
+    if ( layerName.isEmpty() || layerName.length() == 0 ){
+        m_state.setValue<QString>( Util::NAME, defaultName );
+        m_state.flushState();
+    }
+    return m_state.getValue<QString>( Util::ID );
+}
+
 bool LayerData::_setLayersGrouped( bool /*grouped*/, const QSize& /*viewSize*/  ){
     return false;
 }
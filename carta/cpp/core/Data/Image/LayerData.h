@@ -336,6 +336,18 @@ protected:
      */
     virtual QString _setFileName( const QString& fileName, bool* success ) Q_DECL_OVERRIDE;
 
+    /**
+     * Use an image that is not read from a file, for example one that was computed.
+     * @param image - the image.
+     * @param imageId - a unique identifier for the image, used in place of a file name.
+     * @param name - the name of the layer, unless the user has explicitly set one.
+     * @param success - set to true if the image can be used.
+     * @return - an error message if the image could not be used or the id of
+     *      the layer if it is successfully set.
+     */
+    QString _setImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+            const QString& imageId, const QString& name, bool* success );
+
     /**
      * Returns the location on the image corresponding to a screen point in
      * pixels.
@@ -391,6 +403,17 @@ protected:
      */
     virtual bool _isOnCelestialPlane( bool includelinear=1 ) const Q_DECL_OVERRIDE;
 
+    /**
+     * Start reading frames that are likely to be shown next in the background.
+     * @param frameList - the frames to read, each a list of frames, one for each of the
+     *      known axis types, the most urgent first.
+     * @param autoClip true if clips should be automatically generated; false otherwise.
+     * @param clipMinPercentile the minimum clip value.
+     * @param clipMaxPercentile the maximum clip value.
+     */
+    virtual void _prefetchFrames( const std::vector< std::vector<int> >& frameList,
+            bool autoClip, double clipMinPercentile, double clipMaxPercentile ) Q_DECL_OVERRIDE;
+
     /**
      * Remove the contour set from this layer.
      * @param contourSet - the contour set to remove from the layer.
@@ -508,6 +531,10 @@ private:
 
     bool _getTransform( const QPointF& pan, double zoom, const QSize& size, QTransform& tf ) const;
 
+    //Sets up the grid, pan and zoom for a new image and names the layer if the
+    //user has not; returns the layer id.
+    QString _imageChanged( const QString& defaultName );
+
     void _initializeState();
 
     /**
@@ -67,7 +67,23 @@ void LayerGroup::_addContourSet( std::shared_ptr<DataContours> contourSet){
 }
 
 QString LayerGroup::_addData(const QString& fileName, bool* success, int* stackIndex ) {
-    QString result;
+    LayerData* targetSource = _makeDataLayer();
+    QString result = targetSource->_setFileName(fileName, success );
+    _insertDataLayer( targetSource, *success, stackIndex );
+    return result;
+}
+
+
+QString LayerGroup::_addData( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+        const QString& imageId, const QString& name, bool* success, int* stackIndex ){
+    LayerData* targetSource = _makeDataLayer();
+    QString result = targetSource->_setImage( image, imageId, name, success );
+    _insertDataLayer( targetSource, *success, stackIndex );
+    return result;
+}
+
+
+LayerData* LayerGroup::_makeDataLayer(){
     Carta::State::ObjectManager* objMan = Carta::State::ObjectManager::objectManager();
     LayerData* targetSource = objMan->createObject<LayerData>();
     connect( targetSource, SIGNAL(contourSetAdded(Layer*,const QString&)),
@@ -75,10 +91,14 @@ QString LayerGroup::_addData(const QString& fileName, bool* success, int* stackI
     connect( targetSource, SIGNAL(contourSetRemoved(const QString&)),
             this, SIGNAL(contourSetRemoved(const QString&)));
     connect( targetSource, SIGNAL(colorStateChanged()), this, SIGNAL(colorStateChanged() ));
-    result = targetSource->_setFileName(fileName, success );
+    return targetSource;
+}
+
+
+void LayerGroup::_insertDataLayer( LayerData* targetSource, bool loaded, int* stackIndex ){
     //If we are making a new layer, see if there is a selected group.  If so,
     //add to the group.  If not, add to this group.
-    if ( *success ){
+    if ( loaded ){
         _setColorSupport( targetSource );
         std::shared_ptr<Layer> selectedGroup = _getSelectedGroup();
         if (selectedGroup ){
@@ -92,7 +112,6 @@ QString LayerGroup::_addData(const QString& fileName, bool* success, int* stackI
     else {
         delete targetSource;
     }
-    return result;
 }
 
 
@@ -462,6 +481,26 @@ std::vector< std::shared_ptr<Carta::Lib::Image::ImageInterface> > LayerGroup::_g
     return images;
 }
 
+QString LayerGroup::_getImageFileName(){
+    QString fileName;
+    int dataIndex = _getIndexCurrent();
+    if ( dataIndex >= 0 ){
+        fileName = m_children[dataIndex]->_getImageFileName();
+    }
+    return fileName;
+}
+
+QStringList LayerGroup::_getImageFileNames(){
+    QStringList fileNames;
+    int dataCount = m_children.size();
+    for ( int i = 0; i < dataCount; i++ ){
+        if ( m_children[i]->_isVisible() ){
+            fileNames.append( m_children[i]->_getImageFileName() );
+        }
+    }
+    return fileNames;
+}
+
 
 int LayerGroup::_getIndexCurrent( ) const {
     int dataIndex = -1;
@@ -799,6 +838,16 @@ void LayerGroup::_removeData( int index ){
 }
 
 
+void LayerGroup::_prefetchFrames( const std::vector< std::vector<int> >& frameList,
+        bool autoClip, double clipMinPercentile, double clipMaxPercentile ){
+    for ( std::shared_ptr<Layer> layer : m_children ){
+        if ( layer->_isVisible() ){
+            layer->_prefetchFrames( frameList, autoClip, clipMinPercentile, clipMaxPercentile );
+        }
+    }
+}
+
+
 void LayerGroup::_removeContourSet( std::shared_ptr<DataContours> contourSet ){
     for ( std::shared_ptr<Layer> layer : m_children ){
         layer->_removeContourSet( contourSet );
@@ -52,6 +52,17 @@ protected:
      */
     QString _addData(const QString& fileName, bool* success, int* stackIndex);
 
+    /**
+     * Add a data layer for an image that is not read from a file.
+     * @param image - the image.
+     * @param imageId - a unique identifier for the image, used in place of a file name.
+     * @param name - the name of the layer.
+     * @param success - set to true if the image is successfully added.
+     * @param stackIndex - set to the index of the image in this group if it is added
+     *      to this group.
+     */
+    QString _addData( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+            const QString& imageId, const QString& name, bool* success, int* stackIndex );
 
 
     virtual bool _addGroup();
@@ -199,6 +210,10 @@ protected:
 
     virtual std::vector< std::shared_ptr<Carta::Lib::Image::ImageInterface> > _getImages() Q_DECL_OVERRIDE;
 
+    virtual QString _getImageFileName() Q_DECL_OVERRIDE;
+
+    virtual QStringList _getImageFileNames() Q_DECL_OVERRIDE;
+
     /**
      * Returns the location on the image corresponding to a screen point in
      * pixels.
@@ -388,6 +403,17 @@ protected:
      */
     virtual bool _isSpectralAxis() const Q_DECL_OVERRIDE;
 
+    /**
+     * Start reading frames that are likely to be shown next in the background.
+     * @param frameList - the frames to read, each a list of frames, one for each of the
+     *      known axis types, the most urgent first.
+     * @param autoClip true if clips should be automatically generated; false otherwise.
+     * @param clipMinPercentile the minimum clip value.
+     * @param clipMaxPercentile the maximum clip value.
+     */
+    virtual void _prefetchFrames( const std::vector< std::vector<int> >& frameList,
+            bool autoClip, double clipMinPercentile, double clipMaxPercentile ) Q_DECL_OVERRIDE;
+
     /**
      * Remove the contour set from this layer.
      * @param contourSet - the contour set to remove from the layer.
@@ -533,6 +559,13 @@ private:
 
     void _initializeState();
 
+    //Add a newly loaded data layer to the selected group or to this one; the layer
+    //is deleted if it was not loaded.
+    void _insertDataLayer( LayerData* layer, bool loaded, int* stackIndex );
+
+    //Make a data layer whose contour and color changes are passed on by this group.
+    LayerData* _makeDataLayer();
+
     void _removeData( int index );
 
     //Set the color support of the child to conform to that of the group.
@@ -61,6 +61,10 @@ QSize RenderRequest::getOutputSize() const {
     return m_outputSize;
 }
 
+QRect RenderRequest::getViewport() const {
+    return m_viewport;
+}
+
 
 int RenderRequest::getTopIndex() const {
     return m_topIndex;
@@ -128,7 +132,8 @@ bool RenderRequest::operator==( const RenderRequest& other ) const {
 											( otherPan.x() != otherPan.x() && m_pan.x() != m_pan.x() &&
 													otherPan.y()!= otherPan.y() && m_pan.y()!= m_pan.y() )){
 										QList<std::shared_ptr<Layer> > otherData = other.getData();
-										if ( otherData.size() == m_datas.size()){
+										if ( otherData.size() == m_datas.size() &&
+												other.getViewport() == m_viewport ){
 											//We could put in a check to make sure the layers are the
 											//same, but this is a quick check that reduces the size of the
 											//queue.
@@ -156,6 +161,11 @@ void RenderRequest::setOutputSize( const QSize& size ){
 }
 
 
+void RenderRequest::setViewport( const QRect& viewport ){
+    m_viewport = viewport;
+}
+
+
 void RenderRequest::setPan( QPointF pan ){
     m_pan = pan;
 }
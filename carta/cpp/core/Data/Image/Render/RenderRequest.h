@@ -8,6 +8,7 @@
 #include <QPointF>
 #include <QString>
 #include <QSize>
+#include <QRect>
 #include <QList>
 
 namespace Carta {
@@ -123,6 +124,13 @@ public:
      */
     QSize getOutputSize() const;
 
+    /**
+     * Returns the part of the output image that should be rendered.
+     * @return - the part of the output image to render; a null rectangle if the
+     *      whole output image should be rendered.
+     */
+    QRect getViewport() const;
+
     /**
      * Returns whether or not the other request is equal to this one.
      * @param other - the other request.
@@ -175,6 +183,14 @@ public:
      */
     void setOutputSize( const QSize& size );
 
+    /**
+     * Render only part of the output image, for example one tile of a large image
+     * being saved. Positions in the rendered image are relative to the top left
+     * corner of the viewport.
+     * @param viewport - the part of the output image to render.
+     */
+    void setViewport( const QRect& viewport );
+
     /**
      * Set whether or not clips should be recomputed on a new frame.
      * @param recomputeClipsOnNewFrame - true if clips should be recomputed; false, otherwise.
@@ -213,6 +229,7 @@ private:
     bool m_requestZoom;
     QPointF m_pan;
     QSize m_outputSize;
+    QRect m_viewport;
     QList<std::shared_ptr<Layer> > m_datas;
     bool m_recomputeClips;
     double m_minClipPercent;
@@ -3,6 +3,12 @@
 #include "Data/Image/Layer.h"
 #include "Data/Image/Render/RenderResponse.h"
 #include "Data/Image/Render/RenderRequest.h"
+#include "Data/Image/Save/TiledImageWriter.h"
+#include "Data/Compute/ComputePool.h"
+#include "Globals.h"
+#include "MainConfig.h"
+
+#include <QPainter>
 
 
 namespace Carta
@@ -10,9 +16,20 @@ namespace Carta
 namespace Data
 {
 
+namespace {
+
+//Tile size used unless the configuration sets one.
+const int TILE_SIZE_DEFAULT = 2048;
+//Number of bands of tiles that may wait to be written before rendering pauses.
+const int BANDS_PENDING_MAX = 2;
+}
+
 SaveService::SaveService( QObject * parent ) :
         QObject( parent ),
-        m_view( new SaveViewLayered()){
+        m_view( new SaveViewLayered()),
+        m_tiled( false ),
+        m_rendering( false ),
+        m_writing( false ){
 }
 
 bool SaveService::_isFileValid() const {
@@ -33,38 +50,168 @@ QSize SaveService::_getSaveSize( const std::shared_ptr<RenderRequest>& request )
     return saveSize;
 }
 
+bool SaveService::_isTiled( const std::shared_ptr<RenderRequest>& request ) const {
+    bool tiled = false;
+    //Scaling the saved image to ignore the aspect ratio needs the whole image.
+    if ( m_aspectRatioMode != Qt::IgnoreAspectRatio && TiledImageWriter::isSupported( m_fileName ) ){
+        QSize outputSize = request->getOutputSize();
+        if ( outputSize.width() > 2 * m_tileSize || outputSize.height() > 2 * m_tileSize ){
+            tiled = true;
+        }
+    }
+    return tiled;
+}
+
 bool SaveService::saveImage( const std::shared_ptr<RenderRequest>& request){
     m_images.clear();
-    int dataCount = m_layers.size();
     bool fileValid = _isFileValid();
     m_selectIndex = request->getTopIndex();
     m_outputSize = request->getOutputSize();
     if ( fileValid ){
-        m_renderCount = 0;
-        m_redrawCount = dataCount;
-        int stackIndex = 0;
-        for ( int i = 0; i < dataCount; i++ ){
-            bool layerVisible = m_layers[i]->_isVisible();
-            if ( layerVisible ){
-                connect( m_layers[i].get(),
-                        SIGNAL(renderingDone( const std::shared_ptr<RenderResponse>&)),
-                        this,
-                        SLOT( _scheduleSave( const std::shared_ptr<RenderResponse>&)),
-                        Qt::UniqueConnection);
-                bool topOfStack = false;
-                if ( i == m_selectIndex ){
-                    topOfStack = true;
-                }
-                std::shared_ptr<RenderRequest> layerRequest( new RenderRequest(*request));
-                layerRequest->setStackTop( topOfStack );
-                m_layers[i]->_render( layerRequest );
-                stackIndex++;
-            }
+        m_tileSize = Globals::instance()->mainConfig()->getSaveTileSize();
+        if ( m_tileSize <= 0 ){
+            m_tileSize = TILE_SIZE_DEFAULT;
+        }
+        m_tiled = _isTiled( request );
+        if ( m_tiled ){
+            m_writer.reset( new TiledImageWriter() );
+            fileValid = m_writer->begin( m_fileName, m_outputSize );
+        }
+        if ( !fileValid ){
+            m_tiled = false;
+            m_writer.reset();
+        }
+        else if ( m_tiled ){
+            m_request = request;
+            m_tileColumns = ( m_outputSize.width() + m_tileSize - 1 ) / m_tileSize;
+            m_tileRows = ( m_outputSize.height() + m_tileSize - 1 ) / m_tileSize;
+            m_tileIndex = 0;
+            m_bands.clear();
+            m_writeOk.reset( new std::atomic<bool>( true ) );
+            _requestTile();
+        }
+        else {
+            _requestLayers( request );
         }
     }
     return fileValid;
 }
 
+void SaveService::_requestLayers( const std::shared_ptr<RenderRequest>& request ){
+    m_images.clear();
+    int dataCount = m_layers.size();
+    m_renderCount = 0;
+    m_redrawCount = 0;
+    for ( int i = 0; i < dataCount; i++ ){
+        if ( m_layers[i]->_isVisible() ){
+            m_redrawCount++;
+        }
+    }
+    for ( int i = 0; i < dataCount; i++ ){
+        bool layerVisible = m_layers[i]->_isVisible();
+        if ( layerVisible ){
+            connect( m_layers[i].get(),
+                    SIGNAL(renderingDone( const std::shared_ptr<RenderResponse>&)),
+                    this,
+                    SLOT( _scheduleSave( const std::shared_ptr<RenderResponse>&)),
+                    Qt::UniqueConnection);
+            bool topOfStack = false;
+            if ( i == m_selectIndex ){
+                topOfStack = true;
+            }
+            std::shared_ptr<RenderRequest> layerRequest( new RenderRequest(*request));
+            layerRequest->setStackTop( topOfStack );
+            m_layers[i]->_render( layerRequest );
+        }
+    }
+}
+
+void SaveService::_requestTile(){
+    int tileCount = m_tileColumns * m_tileRows;
+    if ( m_rendering || m_tileIndex >= tileCount || !(*m_writeOk) ){
+        return;
+    }
+    m_tileColumn = m_tileIndex % m_tileColumns;
+    int tileRow = m_tileIndex / m_tileColumns;
+    if ( m_tileColumn == 0 ){
+        //Wait for earlier bands to be written so the tiles in memory stay bounded.
+        if ( m_bands.size() >= BANDS_PENDING_MAX ){
+            return;
+        }
+        std::shared_ptr<TileBand> band( new TileBand() );
+        band->tiles.resize( m_tileColumns );
+        band->tilesLeft = m_tileColumns;
+        m_bands.append( band );
+    }
+    QRect imageRect( QPoint( 0, 0 ), m_outputSize );
+    m_tileRect = QRect( m_tileColumn * m_tileSize, tileRow * m_tileSize,
+            m_tileSize, m_tileSize ).intersected( imageRect );
+    m_tileIndex++;
+    m_rendering = true;
+
+    //Every tile is rendered as part of the full image.
+    std::shared_ptr<RenderRequest> tileRequest( new RenderRequest( *m_request ) );
+    tileRequest->setViewport( m_tileRect );
+    _requestLayers( tileRequest );
+}
+
+void SaveService::_tileComposed(){
+    _writeBands();
+}
+
+void SaveService::_writeBands(){
+    if ( m_writing || m_bands.isEmpty() || m_bands.first()->tilesLeft > 0 ){
+        return;
+    }
+    m_writing = true;
+    std::shared_ptr<TileBand> band = m_bands.first();
+    std::shared_ptr<TiledImageWriter> writer = m_writer;
+    std::shared_ptr<std::atomic<bool> > writeOk = m_writeOk;
+    int width = m_outputSize.width();
+    int tileSize = m_tileSize;
+    auto work = [band, writer, writeOk, width, tileSize](){
+        QImage bandImage( width, band->tiles[0].height(), QImage::Format_ARGB32_Premultiplied );
+        QPainter painter( &bandImage );
+        int tileCount = band->tiles.size();
+        for ( int i = 0; i < tileCount; i++ ){
+            painter.drawImage( i * tileSize, 0, band->tiles[i] );
+        }
+        painter.end();
+        band->tiles.clear();
+        if ( *writeOk ){
+            *writeOk = writer->writeRows( bandImage );
+        }
+    };
+    ComputeJob* job = new ComputeJob( work, ComputeJob::makeCancelFlag() );
+    connect( job, SIGNAL(finished()), this, SLOT(_bandWritten()) );
+    ComputePool::start( job );
+}
+
+void SaveService::_bandWritten(){
+    m_writing = false;
+    m_bands.removeFirst();
+    _writeBands();
+    _requestTile();
+    _finishTiles();
+}
+
+void SaveService::_finishTiles(){
+    //Layers have to be done with their tile and the writer with its band.
+    if ( !m_tiled || m_rendering || m_writing ){
+        return;
+    }
+    int tileCount = m_tileColumns * m_tileRows;
+    bool allWritten = m_tileIndex >= tileCount && m_bands.isEmpty();
+    if ( allWritten || !(*m_writeOk) ){
+        m_tiled = false;
+        bool result = m_writer->finish() && *m_writeOk;
+        m_writer.reset();
+        m_bands.clear();
+        m_request.reset();
+        emit saveImageResult( result );
+    }
+}
+
 void SaveService::_saveImage( QImage img ){
     QImage imgScaled = img;
     //May need to scale if the image size isn't exactly right and we are ignoring
@@ -85,31 +232,61 @@ void SaveService::_scheduleSave( const std::shared_ptr<RenderResponse>& response
         return;
     }
 
-    m_view->resetLayers();
-
     //We want the selected index to be the last one in the stack.
+    std::vector<QImage> images;
+    std::vector<Carta::Lib::VectorGraphics::VGList> graphicsLists;
     int dataCount = m_layers.size();
-    int stackIndex = 0;
     for ( int i = 0; i < dataCount; i++ ){
         int dIndex = ( m_selectIndex + i + 1) % dataCount;
         m_layers[dIndex]->disconnect( this );
         if ( m_layers[dIndex]->_isVisible() ){
             QString layerId = m_layers[dIndex]->_getLayerId();
             if ( m_images.contains( layerId ) ){
-                QImage image = m_images[layerId]->getImage();
-                Carta::Lib::VectorGraphics::VGList graphicsList = m_images[layerId]->getVectorGraphics();
-                m_view->setRasterLayer( stackIndex, image );
-                m_view->setVectorGraphicsLayer( stackIndex, graphicsList );
-                stackIndex++;
+                images.push_back( m_images[layerId]->getImage() );
+                graphicsLists.push_back( m_images[layerId]->getVectorGraphics() );
             }
         }
     }
+    m_images.clear();
     for ( int i = 0; i < dataCount; i++ ){
            m_layers[i]->_renderDone();
        }
-    m_view->paintLayers();
-    QImage image = m_view->getImage();
-    _saveImage( image );
+
+    if ( !m_tiled ){
+        m_view->resetLayers();
+        int layerCount = images.size();
+        for ( int i = 0; i < layerCount; i++ ){
+            m_view->setRasterLayer( i, images[i] );
+            m_view->setVectorGraphicsLayer( i, graphicsLists[i] );
+        }
+        m_view->paintLayers();
+        QImage image = m_view->getImage();
+        _saveImage( image );
+    }
+    else {
+        //Compose the tile on the compute pool while the layers render the next one.
+        std::shared_ptr<TileBand> band = m_bands.last();
+        int column = m_tileColumn;
+        QRect tileRect = m_tileRect;
+        auto work = [band, column, tileRect, images, graphicsLists](){
+            SaveViewLayered view;
+            int layerCount = images.size();
+            for ( int i = 0; i < layerCount; i++ ){
+                view.setRasterLayer( i, images[i] );
+                view.setVectorGraphicsLayer( i, graphicsLists[i] );
+            }
+            view.setViewport( tileRect );
+            view.paintLayers();
+            band->tiles[column] = view.getImage();
+            band->tilesLeft--;
+        };
+        ComputeJob* job = new ComputeJob( work, ComputeJob::makeCancelFlag() );
+        connect( job, SIGNAL(finished()), this, SLOT(_tileComposed()) );
+        ComputePool::start( job );
+        m_rendering = false;
+        _requestTile();
+        _finishTiles();
+    }
 }
 
 void SaveService::setFileName( const QString& saveName ){
@@ -1,6 +1,8 @@
 /**
  * The SaveService is responsible for saving images to a file.
  * It uses ImageRenderService internally
+ * Large images are rendered a tile at a time and streamed to the file, with the
+ * tiles composed and encoded on the compute pool.
  **/
 
 #pragma once
@@ -9,13 +11,17 @@
 #include <QSize>
 #include <QImage>
 #include <QList>
+#include <QRect>
+#include <atomic>
 #include <memory>
+#include <vector>
 #include "CartaLib/CartaLib.h"
 
 namespace Carta{
 namespace Data{
 
 class SaveViewLayered;
+class TiledImageWriter;
 class Layer;
 class RenderRequest;
 class RenderResponse;
@@ -77,8 +83,21 @@ private slots:
             const Carta::Lib::VectorGraphics::VGList& vg, const QString& layerName*/
             const std::shared_ptr<RenderResponse>& response);
 
+    //A band of tiles has been composed or written when saving in tiles.
+    void _tileComposed();
+    void _bandWritten();
+
 private:
 
+    //A row of tiles of an image that is saved in tiles.
+    struct TileBand {
+        std::vector<QImage> tiles;
+        std::atomic<int> tilesLeft;
+    };
+
+    //Saving is finished when saving in tiles.
+    void _finishTiles();
+
     QSize _getSaveSize( const std::shared_ptr<RenderRequest>& request ) const;
 
     /**
@@ -87,6 +106,22 @@ private:
      */
     bool _isFileValid() const;
 
+    /**
+     * Returns true if the image is large enough to be saved in tiles.
+     * @param request - the request for the full image.
+     * @return - true if the image should be rendered and written in tiles.
+     */
+    bool _isTiled( const std::shared_ptr<RenderRequest>& request ) const;
+
+    //Asks the visible layers to render the request.
+    void _requestLayers( const std::shared_ptr<RenderRequest>& request );
+
+    //Asks the layers to render the next tile, unless too many are waiting to be written.
+    void _requestTile();
+
+    //Writes the next band of tiles, if all of its tiles have been composed.
+    void _writeBands();
+
     /**
      * Saves the image to disk.
      * @param img - the image to save.
@@ -118,6 +153,24 @@ private:
     //Count of images that have been redrawn to date.
     int m_redrawCount;
 
+    //State of a save in tiles.
+    bool m_tiled;
+    std::shared_ptr<RenderRequest> m_request;
+    int m_tileSize;
+    int m_tileColumns;
+    int m_tileRows;
+    //Index of the next tile to render.
+    int m_tileIndex;
+    //Tile being rendered by the layers.
+    QRect m_tileRect;
+    int m_tileColumn;
+    bool m_rendering;
+    //Bands that have not been written, in the order they appear in the image.
+    QList<std::shared_ptr<TileBand> > m_bands;
+    bool m_writing;
+    std::shared_ptr<TiledImageWriter> m_writer;
+    std::shared_ptr<std::atomic<bool> > m_writeOk;
+
     SaveService( const SaveService& other);
     SaveService& operator=( const SaveService& other );
 };
@@ -17,6 +17,9 @@ qint64 SaveView::scheduleRepaint( qint64 id ){
     m_buffer = m_raster;
     if ( !m_buffer.isNull()){
         QPainter painter( & m_buffer);
+        if ( m_viewport.isValid() ){
+            painter.setWindow( m_viewport );
+        }
         Carta::Lib::VectorGraphics::VGListQPainterRenderer renderer;
         renderer.render( m_vgList, painter);
         painter.end();
@@ -32,6 +35,10 @@ void SaveView::setRaster( const QImage & image ){
     m_raster = image;
 }
 
+void SaveView::setViewport( const QRect & viewport ){
+    m_viewport = viewport;
+}
+
 void SaveView::setVectorGraphics( const Lib::IRemoteVGView::VGList & vglist ){
     m_vgList = vglist;
 }
@@ -7,6 +7,7 @@
 #include "CartaLib/IRemoteVGView.h"
 #include "CartaLib/VectorGraphics/VGList.h"
 
+#include <QRect>
 #include <QSize>
 #include <QImage>
 
@@ -42,6 +43,14 @@ public:
      */
     void setVectorGraphics( const Carta::Lib::VectorGraphics::VGList & vglist );
 
+    /**
+     * Set the part of the vector graphics covered by the raster, when the raster is
+     * only a piece (e.g. one tile) of the full image.
+     * @param viewport - the rectangle of the full image covered by the raster; an
+     *      invalid rectangle for the full image.
+     */
+    void setViewport( const QRect & viewport );
+
     /**
      * Produce a new image.
      */
@@ -55,6 +64,7 @@ private:
     QImage m_buffer;
 
     Carta::Lib::VectorGraphics::VGList m_vgList;
+    QRect m_viewport;
     qint64 m_lastRepaintId = - 1;
 
     SaveView( const SaveView& other);
@@ -29,6 +29,11 @@ void SaveViewLayered::setRasterLayer( int layer, const QImage & img ){
 }
 
 
+void SaveViewLayered::setViewport( const QRect & viewport ){
+    m_vgView->setViewport( viewport );
+}
+
+
 void SaveViewLayered::setVectorGraphicsLayer( int layer, const Carta::Lib::VectorGraphics::VGList & vglist ){
     CARTA_ASSERT( layer >= 0 && layer < 1000 );
     if ( int ( m_vgLayers.size() ) <= layer ) {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "CartaLib/VectorGraphics/VGList.h"
+#include <QRect>
 #include <QSize>
 #include <QImage>
 
@@ -49,6 +50,13 @@ class SaveViewLayered {
          */
         void setVectorGraphicsLayer( int layer, const Carta::Lib::VectorGraphics::VGList & vglist );
 
+        /**
+         * Set the part of the full image the layers cover, when only one tile of a
+         * large image is being combined.
+         * @param viewport - the rectangle of the full image covered by the raster layers.
+         */
+        void setViewport( const QRect & viewport );
+
         /**
          * Returns the image produced.
          */
@@ -0,0 +1,269 @@
+#include "Data/Image/Save/TiledImageWriter.h"
+#include <QFileInfo>
+#include <QDebug>
+#include <zlib.h>
+#include <cstring>
+
+namespace Carta {
+
+namespace Data {
+
+namespace {
+
+//Size of the compressed data in one PNG IDAT chunk.
+const int PNG_CHUNK_SIZE = 256 * 1024;
+
+void appendBigEndian( QByteArray& bytes, quint32 value ){
+    bytes.append( char( (value >> 24) & 0xff ) );
+    bytes.append( char( (value >> 16) & 0xff ) );
+    bytes.append( char( (value >> 8) & 0xff ) );
+    bytes.append( char( value & 0xff ) );
+}
+
+void appendLittleEndian( QByteArray& bytes, quint32 value, int byteCount ){
+    for ( int i = 0; i < byteCount; i++ ){
+        bytes.append( char( (value >> (8 * i)) & 0xff ) );
+    }
+}
+
+//Appends a TIFF directory entry whose value fits in the entry.
+void appendTiffEntry( QByteArray& bytes, quint16 tag, quint16 type, quint32 count, quint32 value ){
+    appendLittleEndian( bytes, tag, 2 );
+    appendLittleEndian( bytes, type, 2 );
+    appendLittleEndian( bytes, count, 4 );
+    if ( type == 3 && count == 1 ){
+        appendLittleEndian( bytes, value, 2 );
+        appendLittleEndian( bytes, 0, 2 );
+    }
+    else {
+        appendLittleEndian( bytes, value, 4 );
+    }
+}
+
+//The rows of the image as packed 8 bit RGB, each row optionally preceded by a byte.
+QByteArray packRows( const QImage& band, int width, bool rowPrefix ){
+    QImage rgb = band.convertToFormat( QImage::Format_RGB888 );
+    int rowBytes = width * 3;
+    int prefixBytes = rowPrefix ? 1 : 0;
+    QByteArray rows( ( rowBytes + prefixBytes ) * rgb.height(), 0 );
+    char* out = rows.data();
+    for ( int y = 0; y < rgb.height(); y++ ){
+        //PNG filter type 0 (none) if there is a prefix byte.
+        out += prefixBytes;
+        memcpy( out, rgb.constScanLine( y ), rowBytes );
+        out += rowBytes;
+    }
+    return rows;
+}
+}
+
+struct TiledImageWriter::Deflater {
+    z_stream stream;
+    QByteArray buffer;
+};
+
+TiledImageWriter::TiledImageWriter(){
+}
+
+bool TiledImageWriter::isSupported( const QString& fileName ){
+    QString suffix = QFileInfo( fileName ).suffix().toLower();
+    return suffix == "png" || suffix == "tif" || suffix == "tiff";
+}
+
+bool TiledImageWriter::begin( const QString& fileName, const QSize& size ){
+    m_size = size;
+    m_rowsWritten = 0;
+    QString suffix = QFileInfo( fileName ).suffix().toLower();
+    m_format = ( suffix == "png" ) ? Format::PNG : Format::TIFF;
+    m_file.setFileName( fileName );
+    m_ok = m_file.open( QIODevice::WriteOnly | QIODevice::Truncate );
+    if ( !m_ok ){
+        qWarning() << "Could not open"<<fileName<<"for writing";
+        return false;
+    }
+    if ( m_format == Format::PNG ){
+        const char signature[] = { char(0x89), 'P', 'N', 'G', '\r', '\n', char(0x1a), '\n' };
+        m_ok = m_file.write( signature, sizeof(signature) ) == sizeof(signature);
+        QByteArray header;
+        appendBigEndian( header, size.width() );
+        appendBigEndian( header, size.height() );
+        //8 bit RGB, deflate compression, adaptive filtering, no interlacing.
+        header.append( char(8) );
+        header.append( char(2) );
+        header.append( char(0) );
+        header.append( char(0) );
+        header.append( char(0) );
+        m_ok = m_ok && _writePngChunk( "IHDR", header );
+
+        m_deflater.reset( new Deflater() );
+        memset( &m_deflater->stream, 0, sizeof(z_stream) );
+        if ( deflateInit( &m_deflater->stream, Z_DEFAULT_COMPRESSION ) != Z_OK ){
+            m_deflater.reset();
+            m_ok = false;
+        }
+    }
+    else {
+        //Baseline TIFF offsets are 32 bit.
+        if ( quint64( size.width() ) * size.height() * 3 > 0xffff0000ULL ){
+            qWarning() << "Image is too large to be saved as TIFF";
+            m_file.close();
+            m_ok = false;
+            return false;
+        }
+        //Little endian header; the offset of the directory is filled in at the end,
+        //after the pixel data starting at offset 8.
+        QByteArray header( "II" );
+        appendLittleEndian( header, 42, 2 );
+        appendLittleEndian( header, 0, 4 );
+        m_ok = m_file.write( header ) == header.size();
+    }
+    return m_ok;
+}
+
+bool TiledImageWriter::_writePngChunk( const char* type, const QByteArray& data ){
+    QByteArray chunk;
+    appendBigEndian( chunk, data.size() );
+    chunk.append( type, 4 );
+    chunk.append( data );
+    //The crc covers the type and the data.
+    uLong crc = crc32( 0L, Z_NULL, 0 );
+    crc = crc32( crc, reinterpret_cast<const Bytef*>( chunk.constData() + 4 ), chunk.size() - 4 );
+    appendBigEndian( chunk, crc );
+    return m_file.write( chunk ) == chunk.size();
+}
+
+bool TiledImageWriter::_deflate( const QByteArray& rows, bool last ){
+    z_stream& stream = m_deflater->stream;
+    QByteArray& buffer = m_deflater->buffer;
+    stream.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( rows.constData() ) );
+    stream.avail_in = rows.size();
+    int flush = last ? Z_FINISH : Z_NO_FLUSH;
+    bool deflated = true;
+    int status = Z_OK;
+    do {
+        int used = buffer.size();
+        buffer.resize( PNG_CHUNK_SIZE );
+        stream.next_out = reinterpret_cast<Bytef*>( buffer.data() + used );
+        stream.avail_out = PNG_CHUNK_SIZE - used;
+        status = deflate( &stream, flush );
+        buffer.resize( PNG_CHUNK_SIZE - stream.avail_out );
+        if ( status == Z_STREAM_ERROR ){
+            deflated = false;
+            break;
+        }
+        //Write full chunks as they are filled and whatever is left at the end.
+        if ( buffer.size() == PNG_CHUNK_SIZE || ( last && status == Z_STREAM_END && buffer.size() > 0 ) ){
+            deflated = _writePngChunk( "IDAT", buffer );
+            buffer.clear();
+        }
+    } while ( deflated && ( stream.avail_in > 0 || ( last && status != Z_STREAM_END ) ) );
+    return deflated;
+}
+
+bool TiledImageWriter::writeRows( const QImage& band ){
+    if ( !m_ok ){
+        return false;
+    }
+    if ( band.width() != m_size.width() || m_rowsWritten + band.height() > m_size.height() ){
+        qWarning() << "Image band does not fit the image being written";
+        m_ok = false;
+        return false;
+    }
+    if ( m_format == Format::PNG ){
+        m_ok = _deflate( packRows( band, m_size.width(), true ), false );
+    }
+    else {
+        QByteArray rows = packRows( band, m_size.width(), false );
+        m_ok = m_file.write( rows ) == rows.size();
+    }
+    m_rowsWritten += band.height();
+    return m_ok;
+}
+
+bool TiledImageWriter::_finishTiff(){
+    const quint32 dataOffset = 8;
+    quint32 dataSize = quint32( m_size.width() ) * m_size.height() * 3;
+    //The directory has to start on a word boundary.
+    if ( m_file.pos() % 2 == 1 ){
+        m_file.write( QByteArray( 1, 0 ) );
+    }
+    const int entryCount = 14;
+    quint32 ifdOffset = m_file.pos();
+    //Values that do not fit in an entry follow the directory.
+    quint32 extraOffset = ifdOffset + 2 + entryCount * 12 + 4;
+    quint32 bitsOffset = extraOffset;
+    quint32 xResOffset = bitsOffset + 6;
+    quint32 yResOffset = xResOffset + 8;
+
+    QByteArray ifd;
+    appendLittleEndian( ifd, entryCount, 2 );
+    const quint16 SHORT = 3;
+    const quint16 LONG = 4;
+    const quint16 RATIONAL = 5;
+    appendTiffEntry( ifd, 256, LONG, 1, m_size.width() );
+    appendTiffEntry( ifd, 257, LONG, 1, m_size.height() );
+    appendTiffEntry( ifd, 258, SHORT, 3, bitsOffset );
+    //No compression, RGB.
+    appendTiffEntry( ifd, 259, SHORT, 1, 1 );
+    appendTiffEntry( ifd, 262, SHORT, 1, 2 );
+    //The pixels are stored as one strip.
+    appendTiffEntry( ifd, 273, LONG, 1, dataOffset );
+    appendTiffEntry( ifd, 277, SHORT, 1, 3 );
+    appendTiffEntry( ifd, 278, LONG, 1, m_size.height() );
+    appendTiffEntry( ifd, 279, LONG, 1, dataSize );
+    appendTiffEntry( ifd, 282, RATIONAL, 1, xResOffset );
+    appendTiffEntry( ifd, 283, RATIONAL, 1, yResOffset );
+    appendTiffEntry( ifd, 284, SHORT, 1, 1 );
+    appendTiffEntry( ifd, 296, SHORT, 1, 2 );
+    //Software
+    QByteArray software( "CARTA" );
+    software.append( char(0) );
+    appendTiffEntry( ifd, 305, 2, software.size(), yResOffset + 8 );
+    //No more directories.
+    appendLittleEndian( ifd, 0, 4 );
+    for ( int i = 0; i < 3; i++ ){
+        appendLittleEndian( ifd, 8, 2 );
+    }
+    //72 pixels per inch.
+    for ( int i = 0; i < 2; i++ ){
+        appendLittleEndian( ifd, 72, 4 );
+        appendLittleEndian( ifd, 1, 4 );
+    }
+    ifd.append( software );
+    bool written = m_file.write( ifd ) == ifd.size();
+
+    QByteArray offset;
+    appendLittleEndian( offset, ifdOffset, 4 );
+    written = written && m_file.seek( 4 ) && m_file.write( offset ) == offset.size();
+    return written;
+}
+
+bool TiledImageWriter::finish(){
+    if ( m_ok && m_rowsWritten != m_size.height() ){
+        qWarning() << "Only"<<m_rowsWritten<<"of"<<m_size.height()<<"rows were written";
+        m_ok = false;
+    }
+    if ( m_format == Format::PNG ){
+        if ( m_deflater ){
+            m_ok = m_ok && _deflate( QByteArray(), true );
+            deflateEnd( &m_deflater->stream );
+            m_deflater.reset();
+        }
+        m_ok = m_ok && _writePngChunk( "IEND", QByteArray() );
+    }
+    else {
+        m_ok = m_ok && _finishTiff();
+    }
+    if ( m_file.isOpen() ){
+        m_file.close();
+    }
+    return m_ok;
+}
+
+TiledImageWriter::~TiledImageWriter(){
+    if ( m_deflater ){
+        deflateEnd( &m_deflater->stream );
+    }
+}
+}
+}
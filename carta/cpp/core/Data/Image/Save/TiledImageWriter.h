@@ -0,0 +1,80 @@
+/**
+ * Writes an image to a file a band of rows at a time, so that images larger than
+ * what fits in memory can be saved.  Supports PNG and (uncompressed) TIFF.
+ **/
+
+#pragma once
+
+#include <QFile>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <memory>
+
+namespace Carta{
+
+namespace Data{
+
+class TiledImageWriter {
+
+public:
+
+    /**
+     * Constructor.
+     */
+    TiledImageWriter();
+
+    /**
+     * Returns true if images can be written a band at a time to the file.
+     * @param fileName - the path of the file, whose suffix determines the format.
+     * @return - true if the format of the file is supported; false otherwise.
+     */
+    static bool isSupported( const QString& fileName );
+
+    /**
+     * Open the file and write the header of the image.
+     * @param fileName - the path of the file to write.
+     * @param size - the size of the full image in pixels.
+     * @return - true if the file could be opened; false otherwise.
+     */
+    bool begin( const QString& fileName, const QSize& size );
+
+    /**
+     * Append rows to the image.
+     * @param band - rows of the image, as wide as the image; the rows are written
+     *      following the ones written before.
+     * @return - true if the rows were written; false otherwise.
+     */
+    bool writeRows( const QImage& band );
+
+    /**
+     * Write the end of the image and close the file.
+     * @return - true if the whole image was written; false otherwise.
+     */
+    bool finish();
+
+    virtual ~TiledImageWriter();
+
+private:
+
+    enum class Format { PNG, TIFF };
+
+    bool _writePngChunk( const char* type, const QByteArray& data );
+    bool _deflate( const QByteArray& rows, bool last );
+    bool _finishTiff();
+
+    QFile m_file;
+    Format m_format = Format::PNG;
+    QSize m_size;
+    int m_rowsWritten = 0;
+    bool m_ok = false;
+
+    //zlib stream used to compress PNG data.
+    struct Deflater;
+    std::unique_ptr<Deflater> m_deflater;
+
+    TiledImageWriter( const TiledImageWriter& other);
+    TiledImageWriter& operator=( const TiledImageWriter& other );
+};
+}
+}
@@ -66,6 +66,17 @@ QString Stack::_addDataImage(const QString& fileName, bool* success ) {
     return result;
 }
 
+QString Stack::_addDataImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+        const QString& imageId, const QString& name, bool* success ){
+    int stackIndex = -1;
+    QString result = _addData( image, imageId, name, success, &stackIndex );
+    if ( *success && stackIndex >= 0 ){
+        _resetFrames( stackIndex );
+        _saveState();
+    }
+    return result;
+}
+
 bool Stack::_addGroup( ){
     bool groupAdded = LayerGroup::_addGroup();
     if ( groupAdded ){
@@ -453,6 +464,24 @@ void Stack::_render( QList<std::shared_ptr<Layer> > datas, int gridIndex,
 
 
 
+void Stack::_prefetchFrames( AxisInfo::KnownType axisType, const std::vector<int>& frameIndices,
+        bool recomputeClipsOnNewFrame, double minClipPercentile, double maxClipPercentile ){
+    int axisIndex = static_cast<int>( axisType );
+    std::vector<int> frames = _getFrameIndices();
+    if ( axisIndex < 0 || axisIndex >= static_cast<int>( frames.size() ) ){
+        return;
+    }
+    std::vector< std::vector<int> > frameList;
+    for ( int frameIndex : frameIndices ){
+        frames[axisIndex] = frameIndex;
+        frameList.push_back( frames );
+    }
+    QList<std::shared_ptr<Layer> > datas = _getDrawChildren();
+    for ( std::shared_ptr<Layer> data : datas ){
+        data->_prefetchFrames( frameList, recomputeClipsOnNewFrame, minClipPercentile, maxClipPercentile );
+    }
+}
+
 void Stack::_renderAll(bool recomputeClipsOnNewFrame,
         double minClipPercentile, double maxClipPercentile){
     int gridIndex = 0;
@@ -38,6 +38,7 @@ public:
     using LayerGroup::_getCursorText;
     using LayerGroup::_getStateString;
     using LayerGroup::_gridChanged;
+    using LayerGroup::_prefetchFrames;
     using LayerGroup::_resetPan;
     using LayerGroup::_resetZoom;
     using LayerGroup::_setMaskAlpha;
@@ -95,6 +96,10 @@ private:
 
     QString _addDataImage(const QString& fileName, bool* success );
 
+    //Add a layer for an image that is not read from a file.
+    QString _addDataImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image,
+            const QString& imageId, const QString& name, bool* success );
+
     void _displayAxesChanged(std::vector<Carta::Lib::AxisInfo::KnownType> displayAxisTypes, bool applyAll );
 
     int _findRegionIndex( std::shared_ptr<Region> region ) const;
@@ -139,6 +144,8 @@ private:
     QString _moveSelectedLayers( bool moveDown );
     void _render(QList<std::shared_ptr<Layer> > datas, int gridIndex,
     		bool recomputeClipsOnNewFrame, double minClipPercentile, double maxClipPercentile);
+    void _prefetchFrames( Carta::Lib::AxisInfo::KnownType axisType, const std::vector<int>& frameIndices,
+            bool recomputeClipsOnNewFrame, double minClipPercentile, double maxClipPercentile );
     void _renderAll(bool recomputeClipsOnNewFrame, double minClipPercentile, double maxClipPercentile);
     void _renderContext( double zoomFactor );
     void _renderZoom( int mouseX, int mouseY, double factor );
@@ -1,6 +1,5 @@
 #include "ProfileRenderService.h"
 #include "ProfileRenderWorker.h"
-#include "ProfileRenderThread.h"
 #include "ProfileRenderRequest.h"
 #include "Data/Image/Layer.h"
 #include "Data/Region/Region.h"
@@ -11,8 +10,7 @@ namespace Data {
 
 ProfileRenderService::ProfileRenderService( QObject * parent ) :
         QObject( parent ),
-        m_worker( nullptr),
-        m_renderThread( nullptr ){
+        m_worker( nullptr){
     m_renderQueued = false;
 }
 
@@ -45,32 +43,25 @@ void ProfileRenderService::_scheduleRender( std::shared_ptr<Layer> layer,
 
     //Create a worker if we don't have one.
     if ( !m_worker ){
-        m_worker = new ProfileRenderWorker();
-    }
-
-    if ( !m_renderThread ){
-        m_renderThread = new ProfileRenderThread();
-        connect( m_renderThread, SIGNAL(finished()),
-                this, SLOT( _postResult()));
+        m_worker.reset( new ProfileRenderWorker() );
     }
     std::shared_ptr<Carta::Lib::Regions::RegionBase> regionInfo(nullptr);
     if ( region ){
-        regionInfo = region->getModel();
+        regionInfo = ComputePool::regionSnapshot( region->getModel() );
     }
     std::shared_ptr<Carta::Lib::Image::ImageInterface> dataSource = layer->_getImage();
     m_worker->setParameters( dataSource, regionInfo, profInfo );
-    int pid = m_worker->computeProfile();
-    if ( pid != -1 ){
-        m_renderThread->setFileDescriptor( pid );
-        m_renderThread->start();
-    }
-    else {
-        m_renderQueued = false;
-    }
+
+    //Compute on the shared pool; the job keeps the worker alive even if we go away.
+    std::shared_ptr<ProfileRenderWorker> worker = m_worker;
+    m_cancelFlag = ComputeJob::makeCancelFlag();
+    ComputeJob* job = new ComputeJob( [worker](){ worker->computeProfile(); }, m_cancelFlag );
+    connect( job, SIGNAL(finished()), this, SLOT( _postResult()));
+    ComputePool::start( job );
 }
 
 void ProfileRenderService::_postResult(  ){
-    Lib::Hooks::ProfileResult result = m_renderThread->getResult();
+    Lib::Hooks::ProfileResult result = m_worker->getResult();
     ProfileRenderRequest request = m_requests.dequeue();
     emit profileResult(result, request.getLayer(), request.getRegion(), request.isCreateNew() );
     m_renderQueued = false;
@@ -82,8 +73,9 @@ void ProfileRenderService::_postResult(  ){
 
 
 ProfileRenderService::~ProfileRenderService(){
-    delete m_worker;
-    delete m_renderThread;
+    if ( m_cancelFlag ){
+        *m_cancelFlag = true;
+    }
 }
 }
 }
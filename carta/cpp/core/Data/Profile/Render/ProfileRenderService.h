@@ -7,6 +7,7 @@
 
 #include "CartaLib/CartaLib.h"
 #include "CartaLib/Hooks/ProfileResult.h"
+#include "Data/Compute/ComputePool.h"
 
 #include <QObject>
 #include <QQueue>
@@ -18,7 +19,6 @@ namespace Data{
 
 class Layer;
 class ProfileRenderWorker;
-class ProfileRenderThread;
 class ProfileRenderRequest;
 class Region;
 
@@ -66,8 +66,9 @@ private slots:
 private:
     void _scheduleRender( std::shared_ptr<Layer> layer,
             std::shared_ptr<Region> region, const Carta::Lib::ProfileInfo& profInfo );
-    ProfileRenderWorker* m_worker;
-    ProfileRenderThread* m_renderThread;
+    std::shared_ptr<ProfileRenderWorker> m_worker;
+    //Cancels the job that is currently running, if any.
+    ComputeJob::CancelFlag m_cancelFlag;
     bool m_renderQueued;
     QQueue<ProfileRenderRequest> m_requests;
 
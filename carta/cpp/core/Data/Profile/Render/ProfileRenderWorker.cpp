@@ -2,10 +2,8 @@
 #include "Globals.h"
 #include "PluginManager.h"
 #include "CartaLib/Hooks/ProfileHook.h"
-#include <QFile>
-#include <QDataStream>
-#include <string.h>
-#include <unistd.h>
+#include "Data/Compute/ComputePool.h"
+#include <QDebug>
 
 namespace Carta
 {
@@ -36,31 +34,14 @@ bool ProfileRenderWorker::setParameters(std::shared_ptr<Carta::Lib::Image::Image
 }
 
 
-int ProfileRenderWorker::computeProfile(){
-    //Note:  we compute the Profile in a separate process because casacore tables
-    //cannot be accessed by different threads at the same time.
-    int ProfilePipes [2];
-    if (pipe (ProfilePipes)){
-        qDebug() << "*** ProfileRenderWorker::run: pipe creation failed: " << strerror (errno);
-        return -1;
-    }
-
-    int pid = fork ();
-    if (pid == -1){
-        // Failure
-        qDebug() << "*** ProfileRenderWorker::run: fork failed: " << strerror (errno);
-        return -1;
-
-    }
-    else if (pid != 0){
-        // The original process comes here.
-        close (ProfilePipes [1]); // close write end of the pipe
-        return ProfilePipes [0]; // return the read end of the pipe
-    }
-
-    // We're our own process
+void ProfileRenderWorker::computeProfile(){
+    //Casacore images cannot be read by different threads through the same object,
+    //so use this thread's own handle to the image.
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image = ComputePool::threadImage( m_dataSource );
+    ComputePool::ImageLock lock( { image } );
+    m_result = Carta::Lib::Hooks::ProfileResult();
     auto result = Globals::instance()-> pluginManager()
-                          -> prepare <Carta::Lib::Hooks::ProfileHook>(m_dataSource, m_regionInfo,
+                          -> prepare <Carta::Lib::Hooks::ProfileHook>(image, m_regionInfo,
                                   m_profileInfo);
     auto lam = [=] ( const Carta::Lib::Hooks::ProfileResult &data ) {
         m_result = data;
@@ -72,19 +53,11 @@ int ProfileRenderWorker::computeProfile(){
         qDebug() << "ProfileRenderWorker::run: caught error: " << error;
         m_result.setError( QString(error) );
     }
+}
 
-    QFile file;
-    if ( !file.open( ProfilePipes[1], QIODevice::WriteOnly, QFileDevice::AutoCloseHandle ) ){
-        qDebug() << "Could not write Profile results";
-        return 0;
-    }
-    QDataStream dataStream( &file );
-    dataStream << m_result;
-    file.close();
-    // If using "exit()", this child process will become a zombie process in CARTA
-    // We tried to use "wait()" and "waitpid()" to clean the dead process, but failed.
-    _exit(EXIT_SUCCESS);
-    return 0;
+
+Carta::Lib::Hooks::ProfileResult ProfileRenderWorker::getResult() const {
+    return m_result;
 }
 
 
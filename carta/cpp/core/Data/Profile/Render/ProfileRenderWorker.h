@@ -1,5 +1,5 @@
 /**
- * Initiates the work of computing the Profile in a separate process.
+ * Computes a profile; meant to be run on a thread of the compute pool.
  **/
 
 #pragma once
@@ -45,11 +45,16 @@ public:
         const Carta::Lib::ProfileInfo& profInfo );
 
     /**
-     * Performs the work of computing the Profile data in a separate process.
-     * @return - the file descriptor for the pipe that can be used to read the
-     *      Profile data.
+     * Performs the work of computing the Profile data, using an image handle
+     * that belongs to the calling thread.
      */
-    int computeProfile();
+    void computeProfile();
+
+    /**
+     * Returns the profile data.
+     * @return - the computed profile data.
+     */
+    Carta::Lib::Hooks::ProfileResult getResult() const;
 
     /**
      * Destructor.
@@ -26,6 +26,10 @@ Region::Region(const QString& className, const QString& path, const QString& id
 	_initializeState();
 }
 
+QRectF Region::getBoundingBox() const {
+	return m_shape->getBoundingBox();
+}
+
 QPointF Region::getCenter() const {
 	return m_shape->getCenter();
 }
@@ -108,6 +112,11 @@ void Region::handleDrag( const Carta::Lib::InputEvents::Drag2Event& ev, const QP
 	}
 }
 
+void Region::_shapeDragged( const QJsonObject& model ){
+	emit regionDragged( getId(), model );
+}
+
+
 void Region::handleDrag( const QPointF & pt ) {
 	if ( isDraggable() ){
 		if ( m_shape ){
@@ -34,6 +34,12 @@ Q_OBJECT
 
 public:
 
+	/**
+	 * Returns a box containing the region and its control points, in image pixels.
+	 * @return - a box containing everywhere the region responds to touches.
+	 */
+	QRectF getBoundingBox() const;
+
 	/**
 	 * Returns the center point of the bounding box enclosing the region.
 	 * @return - the center point of the bounding box enclosing the region.
@@ -287,6 +293,21 @@ signals:
 	 */
 	void regionShapeChanged( );
 
+	/**
+	 * Notification that the region is being moved or resized.
+	 * @param id - an identifier for this region.
+	 * @param model - a json representation of the region model at the current drag position.
+	 */
+	void regionDragged( const QString& id, const QJsonObject& model );
+
+protected slots:
+
+	/**
+	 * Pass on the position of a shape that is being dragged.
+	 * @param model - a json representation of the region model at the current drag position.
+	 */
+	void _shapeDragged( const QJsonObject& model );
+
 protected:
 
 	double _getErrorMargin() const;
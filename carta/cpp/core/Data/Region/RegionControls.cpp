@@ -10,6 +10,7 @@
 #include "CartaLib/Regions/Ellipse.h"
 
 #include <QDebug>
+#include <algorithm>
 
 namespace Carta {
 
@@ -59,11 +60,7 @@ void RegionControls::_addDataRegions( std::vector<std::shared_ptr<Region>> regio
 		if ( regionIndex < 0 ){
 			regions[i]->setEditMode( false );
 			m_regions.push_back( regions[i]);
-			int regionIndex = m_regions.size() - 1;
-			connect( m_regions[regionIndex].get(), SIGNAL(regionSelectionChanged(const QString&)),
-					this, SLOT(_regionSelectionChanged( const QString&)));
-			connect( m_regions[regionIndex].get(), SIGNAL(regionShapeChanged()),
-					this, SLOT(_regionShapeChanged()));
+			_initializeRegion( regions[i].get() );
 		}
 	}
     count = m_regions.size();
@@ -94,6 +91,8 @@ QString RegionControls::closeRegion( int index ){
     int regionCount = m_regions.size();
     if ( index >= 0 && index < regionCount ){
         QString id = m_regions[index]->getId();
+        m_regionIndex.remove( m_regions[index].get() );
+        m_regionsSelected.erase( m_regions[index].get() );
         objMan->removeObject( id );
         m_regions.erase( m_regions.begin() + index );
         regionRemoved = true;
@@ -123,11 +122,7 @@ void RegionControls::_editDone(){
 
 		m_regionEdit->setActive( true );
 		m_regions.push_back( m_regionEdit );
-		int regionCount = m_regions.size();
-		connect( m_regions[regionCount-1].get(), SIGNAL(regionSelectionChanged(const QString&)),
-				this, SLOT(_regionSelectionChanged( const QString&)));
-		connect( m_regions[regionCount-1].get(), SIGNAL(regionShapeChanged()),
-				this, SLOT(_regionShapeChanged()));
+		_initializeRegion( m_regionEdit.get() );
 
 		m_selectRegion->setUpperBound( m_regions.size() );
 		m_regionEdit = std::shared_ptr<Region>(nullptr);
@@ -151,6 +146,12 @@ int RegionControls::_findRegionIndex( const QString& id ) const {
 	return index;
 }
 
+std::vector<Region*> RegionControls::_getRegionsSelected() const {
+	std::vector<Region*> selected( m_regionsSelected.begin(), m_regionsSelected.end() );
+	m_regionIndex.sort( selected );
+	return selected;
+}
+
 std::shared_ptr<Region> RegionControls::getRegion( const QString& regionName ) const {
     std::shared_ptr<Region> region( nullptr );
     int regionIndex = -1;
@@ -216,11 +217,12 @@ bool RegionControls::_handleDrag( const Carta::Lib::InputEvents::Drag2Event& ev,
 			emit regionsChanged();
 		}
 		else {
-			int regionCount = m_regions.size();
-			for ( int i = 0; i < regionCount; i++ ){
-				m_regions[i]->handleDrag( ev, imagePt );
+			//Only selected regions can be dragged.
+			std::vector<Region*> selected = _getRegionsSelected();
+			for ( Region* region : selected ){
+				region->handleDrag( ev, imagePt );
 			}
-			if ( regionCount > 0 ){
+			if ( m_regions.size() > 0 ){
 				emit regionsChanged();
 			}
 		}
@@ -239,11 +241,20 @@ bool RegionControls::_handleTouch( const Carta::Lib::InputEvents::TouchEvent& ev
 			emit regionsChanged();
 		}
 		else {
-			int regionCount = m_regions.size();
-			for ( int i = 0; i < regionCount; i++ ){
-				m_regions[i]->handleTouch( imagePt);
+			//A touch selects the regions under it and deselects the others, so only
+			//the regions whose boxes hold the point and those already selected are
+			//affected.
+			std::vector<Region*> touched = m_regionIndex.getRegions( imagePt );
+			for ( Region* region : m_regionsSelected ){
+				if ( std::find( touched.begin(), touched.end(), region ) == touched.end() ){
+					touched.push_back( region );
+				}
 			}
-			if ( regionCount > 0 ){
+			m_regionIndex.sort( touched );
+			for ( Region* region : touched ){
+				region->handleTouch( imagePt );
+			}
+			if ( m_regions.size() > 0 ){
 			        emit regionsChanged();
 			}
 		}
@@ -426,6 +437,19 @@ void RegionControls::_initializeCallbacks(){
         });
 }
 
+void RegionControls::_initializeRegion( Region* region ){
+	connect( region, SIGNAL(regionSelectionChanged(const QString&)),
+			this, SLOT(_regionSelectionChanged( const QString&)));
+	connect( region, SIGNAL(regionShapeChanged()),
+			this, SLOT(_regionShapeChanged()));
+	connect( region, SIGNAL(regionDragged(const QString&, const QJsonObject&)),
+			this, SLOT(_regionDragged(const QString&, const QJsonObject&)));
+	m_regionIndex.insert( region, region->getBoundingBox() );
+	if ( region->isSelected() ){
+		m_regionsSelected.insert( region );
+	}
+}
+
 void RegionControls::_initializeSelections(){
 	Carta::State::ObjectManager* objMan = Carta::State::ObjectManager::objectManager();
 	m_selectRegion = objMan->createObject<Selection>();
@@ -483,6 +507,15 @@ void RegionControls::refreshState(){
 
 
 void RegionControls::_regionSelectionChanged( const QString& id ){
+    Region* region = qobject_cast<Region*>( sender() );
+    if ( region ){
+        if ( region->isSelected() ){
+            m_regionsSelected.insert( region );
+        }
+        else {
+            m_regionsSelected.erase( region );
+        }
+    }
     int regionIndex = _findRegionIndex( id );
     if ( regionIndex >= 0 ){
         if ( m_regions[regionIndex]->isSelected() ){
@@ -492,7 +525,18 @@ void RegionControls::_regionSelectionChanged( const QString& id ){
     _saveStateRegions();
 }
 
+void RegionControls::_regionDragged( const QString& id, const QJsonObject& model ){
+	int regionIndex = _findRegionIndex( id );
+	if ( regionIndex >= 0 ){
+		emit regionDragged( regionIndex, model );
+	}
+}
+
 void RegionControls::_regionShapeChanged( ){
+	Region* region = qobject_cast<Region*>( sender() );
+	if ( region ){
+		_updateRegionIndex( region );
+	}
 	_saveStateRegions();
 }
 
@@ -532,10 +576,7 @@ void RegionControls::_resetStateData( const QString& state ){
     	QString regionKey = Carta::State::UtilState::getLookup( REGIONS, i);
     	QString regionValue = dataState.toString( regionKey );
     	m_regions[i] = RegionFactory::makeRegion( regionValue );
-    	connect( m_regions[i].get(), SIGNAL(regionSelectionChanged(const QString&)),
-    					this, SLOT(_regionSelectionChanged( const QString&)));
-    	connect( m_regions[i].get(), SIGNAL(regionShapeChanged()),
-    					this, SLOT(_regionShapeChanged()));
+    	_initializeRegion( m_regions[i].get() );
     }
     int regionIndex = dataState.getValue<int>(REGION_INDEX);
     m_stateData.setValue<int>(REGION_INDEX, regionIndex);
@@ -593,6 +634,7 @@ void RegionControls::setRegionCenter( const QPointF& center ){
 		if ( m_regions[i]->isSelected() ){
 			if ( m_regions[i]->setCenter( center ) ){
 				centerChanged = true;
+				_updateRegionIndex( m_regions[i].get() );
 			}
 		}
 	}
@@ -647,6 +689,7 @@ QString RegionControls::setRegionHeight( double height ){
 			if ( m_regions[i]->isSelected() ){
 				if ( m_regions[i]->setHeight( height ) ){
 					heightChanged = true;
+					_updateRegionIndex( m_regions[i].get() );
 				}
 			}
 		}
@@ -672,6 +715,7 @@ QString RegionControls::setRegionRadiusMajor( double radius ){
 				result = m_regions[i]->setRadiusMajor( radius, &changed );
 				if ( changed ){
 					radiusChanged = true;
+					_updateRegionIndex( m_regions[i].get() );
 				}
 			}
 		}
@@ -697,6 +741,7 @@ QString RegionControls::setRegionRadiusMinor( double radius ){
 				result = m_regions[i]->setRadiusMinor( radius, &changed );
 				if ( changed ){
 					radiusChanged = true;
+					_updateRegionIndex( m_regions[i].get() );
 				}
 			}
 		}
@@ -720,6 +765,7 @@ QString RegionControls::setRegionWidth( double width ){
 			if ( m_regions[i]->isSelected() ){
 				if ( m_regions[i]->setWidth( width ) ){
 					widthChanged = true;
+					_updateRegionIndex( m_regions[i].get() );
 				}
 			}
 		}
@@ -776,18 +822,39 @@ void RegionControls::_setRegionsSelected( QStringList ids ){
 	}
 }
 
-Carta::Lib::VectorGraphics::VGList RegionControls::vgList() const {
+void RegionControls::_updateRegionIndex( Region* region ){
+	m_regionIndex.insert( region, region->getBoundingBox() );
+}
+
+Carta::Lib::VectorGraphics::VGList RegionControls::vgList( const QRectF& viewRect ) const {
 	//Get the region graphics
 	Carta::Lib::VectorGraphics::VGList vgList;
-	int regionCount = m_regions.size();
 	Carta::Lib::VectorGraphics::VGComposer comp = Carta::Lib::VectorGraphics::VGComposer( );
 	if ( m_regionEdit ){
 		Carta::Lib::VectorGraphics::VGList editRegionList = m_regionEdit->getVGList();
 		comp.appendList( editRegionList );
 	}
-	for ( int i = 0; i < regionCount; i++ ){
-		Carta::Lib::VectorGraphics::VGList regionList = m_regions[i]->getVGList();
-		comp.appendList( regionList );
+	if ( !viewRect.isValid() ){
+		int regionCount = m_regions.size();
+		for ( int i = 0; i < regionCount; i++ ){
+			Carta::Lib::VectorGraphics::VGList regionList = m_regions[i]->getVGList();
+			comp.appendList( regionList );
+		}
+	}
+	else {
+		//Selected regions are drawn even out of view, as the shadow of one being dragged
+		//may be in view.
+		std::vector<Region*> visible = m_regionIndex.getRegions( viewRect );
+		for ( Region* region : m_regionsSelected ){
+			if ( std::find( visible.begin(), visible.end(), region ) == visible.end() ){
+				visible.push_back( region );
+			}
+		}
+		m_regionIndex.sort( visible );
+		for ( Region* region : visible ){
+			Carta::Lib::VectorGraphics::VGList regionList = region->getVGList();
+			comp.appendList( regionList );
+		}
 	}
 	return comp.vgList();
 }
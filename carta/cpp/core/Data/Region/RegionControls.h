@@ -3,11 +3,13 @@
  */
 
 #pragma once
+#include "RegionIndex.h"
 #include "State/StateInterface.h"
 #include "State/ObjectManager.h"
 #include "CartaLib/InputEvents.h"
 #include "CartaLib/VectorGraphics/VGList.h"
 #include <memory>
+#include <set>
 
 namespace Carta {
 namespace Data {
@@ -149,10 +151,13 @@ public:
 	virtual QStringList setRegionColor( int redAmount, int greenAmount, int blueAmount );
 
 	/**
-	 * Return the vector graphics for all the managed regions.
-	 * @return - the vector graphics for all the managed regions.
+	 * Return the vector graphics for the managed regions in view.
+	 * @param viewRect - the part of the image in view, in image pixels; if it is not
+	 * 		valid, all the regions are in view.
+	 * @return - the vector graphics for the regions in view, the selected regions,
+	 * 		and the region being drawn.
 	 */
-	Carta::Lib::VectorGraphics::VGList vgList() const;
+	Carta::Lib::VectorGraphics::VGList vgList( const QRectF& viewRect = QRectF() ) const;
 
 	virtual ~RegionControls();
 
@@ -166,6 +171,13 @@ signals:
 	 */
 	void regionsChanged( );
 
+	/**
+	 * Notification that a region is being moved or resized.
+	 * @param index - the index of the region.
+	 * @param model - a json representation of the region model at the current drag position.
+	 */
+	void regionDragged( int index, const QJsonObject& model );
+
 
 private slots:
 
@@ -173,6 +185,8 @@ private slots:
 
 	void _indexChanged();
 
+	void _regionDragged( const QString& id, const QJsonObject& model );
+
 	void _regionSelectionChanged( const QString& id );
 
 	void _regionShapeChanged();
@@ -189,9 +203,14 @@ private:
 
 	int _findRegionIndex( const QString& id ) const;
 
+	//Returns the regions that are selected, in the order they were added.
+	std::vector<Region*> _getRegionsSelected() const;
+
 	QString _getStateString( const QString& sessionId, SnapshotType type ) const;
 
 	void _initializeCallbacks();
+	//Listens to a region that has just been added and puts it in the index.
+	void _initializeRegion( Region* region );
 	void _initializeSelections();
 	void _initializeState();
 	void _initializeStatics();
@@ -210,6 +229,7 @@ private:
 
 	void _saveStateRegions();
 	void _setRegionsSelected( QStringList ids );
+	void _updateRegionIndex( Region* region );
 
 	RegionControls( const RegionControls& other);
 	RegionControls& operator=( const RegionControls& other );
@@ -225,6 +245,11 @@ private:
 	std::shared_ptr<Region> m_regionEdit;
 	static RegionTypes* m_regionTypes;
 
+	//Boxes of the regions, so touches and drawing only look at the regions involved.
+	RegionIndex m_regionIndex;
+	//The regions that are selected, which are the only ones that can be dragged.
+	std::set<Region*> m_regionsSelected;
+
 	static const QString CREATE_TYPE;
 	static const QString REGIONS;
 	static const QString REGION_INDEX;
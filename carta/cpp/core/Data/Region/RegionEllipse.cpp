@@ -36,6 +36,8 @@ RegionEllipse::RegionEllipse(const QString& path, const QString& id )
 	m_shape.reset( new Shape::ShapeEllipse() );
 	connect( m_shape.get(), SIGNAL(shapeChanged( const QJsonObject&)),
 				this, SLOT(_updateStateFromJson( const QJsonObject&)));
+	connect( m_shape.get(), SIGNAL(shapeDragged( const QJsonObject&)),
+				this, SLOT(_shapeDragged( const QJsonObject&)));
 
     _initializeState();
     _updateShapeFromState();
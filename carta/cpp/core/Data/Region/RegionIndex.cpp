@@ -0,0 +1,199 @@
+#include "RegionIndex.h"
+
+#include <QtCore/qmath.h>
+#include <algorithm>
+#include <limits>
+
+namespace Carta {
+
+namespace Data {
+
+namespace {
+
+//Unlike QRectF::intersects and contains, boxes that are lines or points count.
+inline bool overlaps( const QRectF& box, const QRectF& rect ){
+    return box.left() <= rect.right() && rect.left() <= box.right() &&
+            box.top() <= rect.bottom() && rect.top() <= box.bottom();
+}
+
+inline bool contains( const QRectF& box, const QPointF& pt ){
+    return box.left() <= pt.x() && pt.x() <= box.right() &&
+            box.top() <= pt.y() && pt.y() <= box.bottom();
+}
+}
+
+const int RegionIndex::MAX_CELLS = 256;
+
+RegionIndex::RegionIndex( double cellSize ):
+    m_cellSize( cellSize > 0 ? cellSize : 64 ),
+    m_nextOrder( 0 ){
+}
+
+void RegionIndex::_addToCells( Region* region, const Entry& entry ){
+    if ( entry.large ){
+        m_large.push_back( region );
+    }
+    else {
+        for ( int y = entry.cellTop; y <= entry.cellBottom; y++ ){
+            for ( int x = entry.cellLeft; x <= entry.cellRight; x++ ){
+                m_cells[_getKey( x, y )].push_back( region );
+            }
+        }
+    }
+}
+
+void RegionIndex::clear(){
+    m_entries.clear();
+    m_cells.clear();
+    m_large.clear();
+    m_nextOrder = 0;
+}
+
+int RegionIndex::_getCell( double value ) const {
+    double cell = qFloor( value / m_cellSize );
+    double limit = std::numeric_limits<int>::max() / 2;
+    return static_cast<int>( qBound( -limit, cell, limit ) );
+}
+
+qint64 RegionIndex::_getKey( int cellX, int cellY ){
+    return ( static_cast<qint64>( cellX ) << 32 ) | static_cast<quint32>( cellY );
+}
+
+std::vector<Region*> RegionIndex::getRegions( const QPointF& pt ) const {
+    std::vector<Region*> regions;
+    auto cell = m_cells.find( _getKey( _getCell( pt.x() ), _getCell( pt.y() ) ) );
+    if ( cell != m_cells.end() ){
+        for ( Region* region : cell->second ){
+            if ( contains( m_entries.at( region ).box, pt ) ){
+                regions.push_back( region );
+            }
+        }
+    }
+    for ( Region* region : m_large ){
+        if ( contains( m_entries.at( region ).box, pt ) ){
+            regions.push_back( region );
+        }
+    }
+    _sortByOrder( regions );
+    return regions;
+}
+
+std::vector<Region*> RegionIndex::getRegions( const QRectF& rect ) const {
+    std::vector<Region*> regions;
+    int left = _getCell( rect.left() );
+    int right = _getCell( rect.right() );
+    int top = _getCell( rect.top() );
+    int bottom = _getCell( rect.bottom() );
+    double cellCount = ( static_cast<double>( right ) - left + 1 ) * ( static_cast<double>( bottom ) - top + 1 );
+
+    //When the rectangle covers more cells than there are regions, looking at each
+    //region is quicker.
+    if ( cellCount > m_entries.size() ){
+        for ( const std::pair<Region* const, Entry>& entry : m_entries ){
+            if ( overlaps( entry.second.box, rect ) ){
+                regions.push_back( entry.first );
+            }
+        }
+    }
+    else {
+        for ( int y = top; y <= bottom; y++ ){
+            for ( int x = left; x <= right; x++ ){
+                auto cell = m_cells.find( _getKey( x, y ) );
+                if ( cell == m_cells.end() ){
+                    continue;
+                }
+                for ( Region* region : cell->second ){
+                    //A region in several cells of the rectangle is only reported from the
+                    //first of them.
+                    const Entry& entry = m_entries.at( region );
+                    if ( x == qMax( entry.cellLeft, left ) && y == qMax( entry.cellTop, top ) &&
+                            overlaps( entry.box, rect ) ){
+                        regions.push_back( region );
+                    }
+                }
+            }
+        }
+        for ( Region* region : m_large ){
+            if ( overlaps( m_entries.at( region ).box, rect ) ){
+                regions.push_back( region );
+            }
+        }
+    }
+    _sortByOrder( regions );
+    return regions;
+}
+
+void RegionIndex::insert( Region* region, const QRectF& box ){
+    Entry entry;
+    auto existing = m_entries.find( region );
+    if ( existing != m_entries.end() ){
+        entry = existing->second;
+        _removeFromCells( region, entry );
+    }
+    else {
+        entry.order = m_nextOrder;
+        m_nextOrder++;
+    }
+    entry.box = box.normalized();
+    entry.cellLeft = _getCell( entry.box.left() );
+    entry.cellRight = _getCell( entry.box.right() );
+    entry.cellTop = _getCell( entry.box.top() );
+    entry.cellBottom = _getCell( entry.box.bottom() );
+    double cellCount = ( static_cast<double>( entry.cellRight ) - entry.cellLeft + 1 ) *
+            ( static_cast<double>( entry.cellBottom ) - entry.cellTop + 1 );
+    entry.large = cellCount > MAX_CELLS;
+    m_entries[region] = entry;
+    _addToCells( region, entry );
+}
+
+void RegionIndex::remove( Region* region ){
+    auto existing = m_entries.find( region );
+    if ( existing != m_entries.end() ){
+        _removeFromCells( region, existing->second );
+        m_entries.erase( existing );
+    }
+}
+
+void RegionIndex::_removeFromCells( Region* region, const Entry& entry ){
+    if ( entry.large ){
+        m_large.erase( std::remove( m_large.begin(), m_large.end(), region ), m_large.end() );
+    }
+    else {
+        for ( int y = entry.cellTop; y <= entry.cellBottom; y++ ){
+            for ( int x = entry.cellLeft; x <= entry.cellRight; x++ ){
+                auto cell = m_cells.find( _getKey( x, y ) );
+                if ( cell == m_cells.end() ){
+                    continue;
+                }
+                std::vector<Region*>& cellRegions = cell->second;
+                auto pos = std::find( cellRegions.begin(), cellRegions.end(), region );
+                if ( pos != cellRegions.end() ){
+                    *pos = cellRegions.back();
+                    cellRegions.pop_back();
+                }
+                if ( cellRegions.empty() ){
+                    m_cells.erase( cell );
+                }
+            }
+        }
+    }
+}
+
+void RegionIndex::sort( std::vector<Region*>& regions ) const {
+    _sortByOrder( regions );
+}
+
+void RegionIndex::_sortByOrder( std::vector<Region*>& regions ) const {
+    std::sort( regions.begin(), regions.end(), [this]( Region* a, Region* b ){
+        auto entryA = m_entries.find( a );
+        auto entryB = m_entries.find( b );
+        qint64 orderA = entryA != m_entries.end() ? entryA->second.order : m_nextOrder;
+        qint64 orderB = entryB != m_entries.end() ? entryB->second.order : m_nextOrder;
+        return orderA < orderB;
+    });
+}
+
+RegionIndex::~RegionIndex(){
+}
+}
+}
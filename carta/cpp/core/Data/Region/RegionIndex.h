@@ -0,0 +1,112 @@
+/***
+ * Spatial index over the bounding boxes of regions, for finding the regions under
+ * a point or in view without looking at every region.
+ */
+
+#pragma once
+
+#include <QRectF>
+#include <unordered_map>
+#include <vector>
+
+namespace Carta {
+
+namespace Data {
+
+class Region;
+
+class RegionIndex {
+
+public:
+
+    /**
+     * Constructor.
+     * @param cellSize - the size, in image pixels, of the cells of the grid the
+     * 		boxes are stored in.
+     */
+    RegionIndex( double cellSize = 64 );
+
+    /**
+     * Remove all regions from the index.
+     */
+    void clear();
+
+    /**
+     * Returns the regions whose boxes contain a point.
+     * @param pt - a point in image pixels.
+     * @return - the regions whose boxes contain the point, in the order they were
+     * 		first added to the index.
+     */
+    std::vector<Region*> getRegions( const QPointF& pt ) const;
+
+    /**
+     * Returns the regions whose boxes intersect a rectangle.
+     * @param rect - a rectangle in image pixels.
+     * @return - the regions whose boxes intersect the rectangle, in the order they were
+     * 		first added to the index.
+     */
+    std::vector<Region*> getRegions( const QRectF& rect ) const;
+
+    /**
+     * Add a region to the index or move it if its box has changed.
+     * @param region - the region.
+     * @param box - the box containing the region, in image pixels.
+     */
+    void insert( Region* region, const QRectF& box );
+
+    /**
+     * Remove a region from the index.
+     * @param region - the region to remove.
+     */
+    void remove( Region* region );
+
+    /**
+     * Sort regions in the order they were first added to the index; regions that
+     * are not in the index go last.
+     * @param regions - the regions to sort.
+     */
+    void sort( std::vector<Region*>& regions ) const;
+
+    virtual ~RegionIndex();
+
+private:
+
+    struct Entry {
+        QRectF box;
+        qint64 order;
+        //The cells covered by the box; empty if the box is stored with the large ones.
+        int cellLeft;
+        int cellTop;
+        int cellRight;
+        int cellBottom;
+        bool large;
+    };
+
+    //Adds or removes a region from the cells its entry covers.
+    void _addToCells( Region* region, const Entry& entry );
+    void _removeFromCells( Region* region, const Entry& entry );
+
+    //Returns the cell holding a coordinate.
+    int _getCell( double value ) const;
+
+    //Returns the key of a cell of the grid.
+    static qint64 _getKey( int cellX, int cellY );
+
+    //Sorts regions by the order of their entries.
+    void _sortByOrder( std::vector<Region*>& regions ) const;
+
+    double m_cellSize;
+    qint64 m_nextOrder;
+    std::unordered_map<Region*, Entry> m_entries;
+    std::unordered_map<qint64, std::vector<Region*> > m_cells;
+    //Regions whose boxes cover too many cells to store them cell by cell.
+    std::vector<Region*> m_large;
+
+    //Largest number of cells a box is stored in.
+    static const int MAX_CELLS;
+
+    RegionIndex( const RegionIndex& other);
+    RegionIndex& operator=( const RegionIndex& other );
+};
+}
+}
@@ -1,5 +1,6 @@
 
 #include "Statistics.h"
+#include "StatisticsCache.h"
 #include "Data/Settings.h"
 #include "Data/LinkableImpl.h"
 #include "Data/Image/Controller.h"
@@ -39,6 +40,26 @@ public:
     }
 };
 
+struct Statistics::StatisticsResult {
+    Carta::Lib::Hooks::ImageStatisticsHook::ResultType data;
+    QString error;
+    //Keys of the statistics in the cache; empty keys are not cached.
+    std::vector<QString> imageKeys;
+    QString planeKey;
+    std::vector<QString> regionKeys;
+    //Statistics of each image found in the cache, with an empty list for the image
+    //or a region whose statistics were not found.
+    Carta::Lib::Hooks::ImageStatisticsHook::ResultType cached;
+    //Whether the statistics of each image, followed by those of each region, were
+    //found in the cache.
+    std::vector< std::vector<bool> > found;
+    //Regions whose statistics are computed, in the order they were passed to the hook.
+    std::vector<int> computedRegions;
+    //Set once the computation is complete; a notification from a cancelled
+    //job may still arrive before the current one is done.
+    std::atomic<bool> done{ false };
+};
+
 bool Statistics::m_registered =
         Carta::State::ObjectManager::objectManager()->registerClass ( CLASS_NAME, new Statistics::Factory());
 
@@ -54,6 +75,7 @@ Statistics::Statistics( const QString& path, const QString& id):
     Carta::State::ObjectManager* objMan = Carta::State::ObjectManager::objectManager();
     Settings* settingsObj = objMan->createObject<Settings>();
     m_settings.reset( settingsObj );
+    m_cache.reset( new StatisticsCache() );
 
     _initializeDefaultState();
     _initializeCallbacks();
@@ -85,6 +107,8 @@ QString Statistics::addLink( CartaObject*  target){
                         this, SLOT(_updateStatistics(Controller*, Carta::Lib::AxisInfo::KnownType)));
                 connect(controller, SIGNAL(dataChangedRegion(Controller*)),
                         this, SLOT( _updateStatistics( Controller*)));
+                connect(controller, SIGNAL(regionDragged(Controller*, int, const QJsonObject&)),
+                        this, SLOT( _updateStatisticsDrag( Controller*, int, const QJsonObject&)));
                 m_controllerLinked = true;
                 _updateStatistics( controller, Carta::Lib::AxisInfo::KnownType::OTHER );
             }
@@ -428,12 +452,96 @@ QString Statistics::setStatVisible( bool showStat, const QString& statName,
 }
 
 
+void Statistics::_statisticsComputed(){
+    if ( !m_statsResult || !m_statsResult->done ){
+        return;
+    }
+    std::shared_ptr<StatisticsResult> computed = m_statsResult;
+    m_statsResult.reset();
+    if ( !computed->error.isEmpty() ){
+        ErrorManager* hr = Util::findSingletonObject<ErrorManager>();
+        hr->registerError( computed->error );
+        return;
+    }
+
+    //Combine the statistics that were computed with those found in the cache.
+    Carta::Lib::Hooks::ImageStatisticsHook::ResultType data = computed->data;
+    int imageCount = computed->imageKeys.size();
+    int computedCount = computed->computedRegions.size();
+    bool complete = imageCount > 0 && computed->data.size() == imageCount;
+    for ( int i = 0; i < computed->data.size() && complete; i++ ){
+        complete = computed->data[i].size() == computedCount + 1;
+    }
+    //Only the statistics missing from the cache are stored.
+    if ( complete ){
+        data = computed->cached;
+        for ( int i = 0; i < imageCount; i++ ){
+            data[i][0] = computed->data[i][0];
+            if ( !computed->found[i][0] ){
+                m_cache->setImageStats( computed->imageKeys[i], data[i][0] );
+            }
+            for ( int k = 0; k < computedCount; k++ ){
+                int regionIndex = computed->computedRegions[k];
+                data[i][regionIndex + 1] = computed->data[i][k + 1];
+                if ( !computed->found[i][regionIndex + 1] ){
+                    m_cache->setRegionStats( computed->imageKeys[i], computed->planeKey,
+                            computed->regionKeys[regionIndex], data[i][regionIndex + 1] );
+                }
+            }
+        }
+        m_cache->flush();
+    }
+
+    //An array for each image
+    int dataCount = data.size();
+    m_stateData.resizeArray( STATS, dataCount );
+    for ( int i = 0; i < dataCount; i++ ){
+        //Each element of the image array contains an array of statistics.
+        QString arrayLookup = UtilState::getLookup( STATS, i );
+        int statCount = data[i].size();
+        m_stateData.setArray( arrayLookup, statCount );
+
+        //Go through each set of statistics for the image.
+        for ( int k = 0; k < statCount; k++ ){
+            QString objLookup = UtilState::getLookup( arrayLookup, k );
+            int keyCount = data[i][k].size();
+            for ( int j = 0; j < keyCount; j++ ){
+                QString label = data[i][k][j].getLabel();
+                QString lookup = UtilState::getLookup( objLookup, label );
+                m_stateData.insertValue<QString>( lookup, data[i][k][j].getValue() );
+            }
+        }
+    }
+    m_stateData.flushState();
+}
+
+
 void Statistics::_updateStatistics( Controller* controller, Carta::Lib::AxisInfo::KnownType /*type*/  ){
+    _startStatistics( controller, -1, nullptr );
+}
+
+
+void Statistics::_updateStatisticsDrag( Controller* controller, int regionIndex, const QJsonObject& model ){
+    std::shared_ptr<Carta::Lib::Regions::RegionBase> dragModel( Carta::Lib::Regions::fromJson( model ) );
+    if ( dragModel ){
+        _startStatistics( controller, regionIndex, dragModel );
+    }
+}
+
+
+void Statistics::_startStatistics( Controller* controller, int dragIndex,
+        std::shared_ptr<Carta::Lib::Regions::RegionBase> dragModel ){
     if ( controller != nullptr ){
 
         int selectedIndex = controller->getSelectImageIndex();
         m_stateData.setValue<int>(SELECTED_INDEX, selectedIndex );
 
+        //Results of an earlier computation are out of date.
+        if ( m_statsCancel ){
+            *m_statsCancel = true;
+        }
+        m_statsResult.reset();
+
         std::vector< std::shared_ptr<Carta::Lib::Image::ImageInterface> > dataSources =
                 controller->getImages();
 
@@ -446,47 +554,100 @@ void Statistics::_updateStatistics( Controller* controller, Carta::Lib::AxisInfo
         int regionCount = coreRegions.size();
         std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> > regions;
         for ( int i = 0; i < regionCount; i++ ){
-            regions.push_back( coreRegions[i]->getModel() );
+            if ( i == dragIndex ){
+                regions.push_back( dragModel );
+            }
+            else {
+                regions.push_back( ComputePool::regionSnapshot( coreRegions[i]->getModel() ) );
+            }
         }
 
         std::vector<int> frameIndices = controller->getImageSlice();
+        QStringList fileNames = controller->getImageFileNames();
 
         int sourceCount = dataSources.size();
         if ( sourceCount > 0 ){
-            auto result = Globals::instance()-> pluginManager()
-                         -> prepare <Carta::Lib::Hooks::ImageStatisticsHook>(dataSources, regions, frameIndices);
-            auto lam = [=] ( const Carta::Lib::Hooks::ImageStatisticsHook::ResultType &data ) {
-
-                //An array for each image
-                int dataCount = data.size();
-                m_stateData.resizeArray( STATS, dataCount );
-                for ( int i = 0; i < dataCount; i++ ){
-                    //Each element of the image array contains an array of statistics.
-                    QString arrayLookup = UtilState::getLookup( STATS, i );
-                    int statCount = data[i].size();
-                    m_stateData.setArray( arrayLookup, statCount );
-
-                    //Go through each set of statistics for the image.
-                    for ( int k = 0; k < statCount; k++ ){
-                        QString objLookup = UtilState::getLookup( arrayLookup, k );
-                        QList<QString> existingKeys = m_stateData.getMemberNames( objLookup );
-                        int keyCount = data[i][k].size();
-                        for ( int j = 0; j < keyCount; j++ ){
-                            QString label = data[i][k][j].getLabel();
-                            QString lookup = UtilState::getLookup( objLookup, label );
-                            m_stateData.insertValue<QString>( lookup, data[i][k][j].getValue() );
-                        }
+            std::shared_ptr<StatisticsResult> computed = std::make_shared<StatisticsResult>();
+
+            //Look for statistics of the same images, plane and region geometries.
+            computed->planeKey = StatisticsCache::getPlaneKey( frameIndices );
+            for ( int i = 0; i < regionCount; i++ ){
+                //A region being dragged is about to move again, so it is not cached.
+                QString regionKey;
+                if ( i != dragIndex ){
+                    regionKey = StatisticsCache::getRegionKey( regions[i] );
+                }
+                computed->regionKeys.push_back( regionKey );
+            }
+            bool imagesCached = true;
+            std::vector<bool> regionsCached( regionCount, true );
+            for ( int i = 0; i < sourceCount; i++ ){
+                QString imageKey;
+                if ( fileNames.size() == sourceCount ){
+                    imageKey = StatisticsCache::getImageKey( fileNames[i] );
+                }
+                computed->imageKeys.push_back( imageKey );
+                QList< QList<Carta::Lib::StatInfo> > imageResults;
+                std::vector<bool> imageFound;
+                QList<Carta::Lib::StatInfo> imageStats;
+                imageFound.push_back( m_cache->getImageStats( imageKey, imageStats ) );
+                if ( !imageFound.back() ){
+                    imagesCached = false;
+                }
+                imageResults.append( imageStats );
+                for ( int j = 0; j < regionCount; j++ ){
+                    QList<Carta::Lib::StatInfo> regionStats;
+                    imageFound.push_back( m_cache->getRegionStats( imageKey, computed->planeKey,
+                            computed->regionKeys[j], regionStats ) );
+                    if ( !imageFound.back() ){
+                        regionsCached[j] = false;
                     }
+                    imageResults.append( regionStats );
+                }
+                computed->cached.append( imageResults );
+                computed->found.push_back( imageFound );
+            }
+
+            //Only the regions that were not found are computed.
+            std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> > computeRegions;
+            for ( int j = 0; j < regionCount; j++ ){
+                if ( !regionsCached[j] ){
+                    computed->computedRegions.push_back( j );
+                    computeRegions.push_back( regions[j] );
                 }
-                m_stateData.flushState();
-            };
-            try {
-                result.forEach( lam );
             }
-            catch( char*& error ){
-                QString errorStr( error );
-                ErrorManager* hr = Util::findSingletonObject<ErrorManager>();
-                hr->registerError( errorStr );
+            if ( imagesCached && computeRegions.empty() ){
+                computed->data = computed->cached;
+                computed->imageKeys.clear();
+                computed->done = true;
+                m_statsResult = computed;
+                _statisticsComputed();
+            }
+            else {
+                auto work = [computed, dataSources, computeRegions, frameIndices](){
+                    std::vector< std::shared_ptr<Carta::Lib::Image::ImageInterface> > images;
+                    for ( const auto& dataSource : dataSources ){
+                        images.push_back( ComputePool::threadImage( dataSource ) );
+                    }
+                    ComputePool::ImageLock lock( images );
+                    auto result = Globals::instance()-> pluginManager()
+                                 -> prepare <Carta::Lib::Hooks::ImageStatisticsHook>(images, computeRegions, frameIndices);
+                    auto lam = [=] ( const Carta::Lib::Hooks::ImageStatisticsHook::ResultType &data ) {
+                        computed->data = data;
+                    };
+                    try {
+                        result.forEach( lam );
+                    }
+                    catch( char*& error ){
+                        computed->error = QString( error );
+                    }
+                    computed->done = true;
+                };
+                m_statsResult = computed;
+                m_statsCancel = ComputeJob::makeCancelFlag();
+                ComputeJob* job = new ComputeJob( work, m_statsCancel );
+                connect( job, SIGNAL(finished()), this, SLOT(_statisticsComputed()));
+                ComputePool::start( job );
             }
         }
         //No statistics
@@ -500,6 +661,9 @@ void Statistics::_updateStatistics( Controller* controller, Carta::Lib::AxisInfo
 
 
 Statistics::~Statistics(){
+    if ( m_statsCancel ){
+        *m_statsCancel = true;
+    }
 
 }
 }
@@ -9,7 +9,9 @@
 #include "State/StateInterface.h"
 #include "Data/ILinkable.h"
 #include "CartaLib/AxisInfo.h"
+#include "Data/Compute/ComputePool.h"
 
+#include <QJsonObject>
 #include <QObject>
 
 
@@ -21,6 +23,7 @@ namespace Data {
 class Controller;
 class LinkableImpl;
 class Settings;
+class StatisticsCache;
 
 class Statistics : public QObject, public Carta::State::CartaObject, public ILinkable {
 
@@ -93,6 +96,19 @@ private slots:
      */
     void _updateStatistics( Controller* controller, Carta::Lib::AxisInfo::KnownType type = Carta::Lib::AxisInfo::KnownType::SPECTRAL );
 
+    /**
+     * Recompute the statistics with a region at the position it is being dragged to.
+     * @param controller - the controller to use for statistics generation.
+     * @param regionIndex - the index of the region being dragged.
+     * @param model - a json representation of the region at its current drag position.
+     */
+    void _updateStatisticsDrag( Controller* controller, int regionIndex, const QJsonObject& model );
+
+    /**
+     * Store statistics computed in the background.
+     */
+    void _statisticsComputed();
+
 private:
     const static QString FROM;
     const static QString LABEL;
@@ -113,6 +129,10 @@ private:
     void _initializeDefaultState();
     void _initializeLabel( const QString& arrayName, int arrayIndex, const QString& label, bool visible);
 
+    //Start computing statistics, replacing the region at dragIndex (if any) with dragModel.
+    void _startStatistics( Controller* controller, int dragIndex,
+            std::shared_ptr<Carta::Lib::Regions::RegionBase> dragModel );
+
 
     static bool m_registered;
 
@@ -129,6 +149,14 @@ private:
     //Preference settings
     std::unique_ptr<Settings> m_settings;
 
+    //Statistics being computed in the background.
+    struct StatisticsResult;
+    std::shared_ptr<StatisticsResult> m_statsResult;
+    ComputeJob::CancelFlag m_statsCancel;
+
+    //Statistics computed earlier.
+    std::unique_ptr<StatisticsCache> m_cache;
+
 
     Carta::State::StateInterface m_stateData;
 
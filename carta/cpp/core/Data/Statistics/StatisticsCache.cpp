@@ -0,0 +1,195 @@
+#include "StatisticsCache.h"
+#include "CartaLib/Hooks/GetPersistentCache.h"
+#include "CartaLib/Regions/IRegion.h"
+#include "Globals.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+namespace Carta {
+
+namespace Data {
+
+namespace {
+
+//Number of statistics lists (one per image or region and plane) kept in memory.
+const int STATS_CACHED_MAX = 4096;
+
+//Version of the serialized statistics, so entries written in an older layout are ignored.
+const qint32 STATS_FORMAT_VERSION = 1;
+
+//Removes the colors from the json of a region, leaving only its geometry.
+QJsonObject geometryJson( QJsonObject json ){
+    json.remove( "lineColor" );
+    json.remove( "fillColor" );
+    if ( json.contains( "kids" ) ){
+        QJsonArray kids = json["kids"].toArray();
+        QJsonArray geometryKids;
+        for ( const QJsonValue& kid : kids ){
+            geometryKids.append( geometryJson( kid.toObject() ) );
+        }
+        json["kids"] = geometryKids;
+    }
+    return json;
+}
+}
+
+StatisticsCache::StatisticsCache(){
+    m_stats.setMaxCost( STATS_CACHED_MAX );
+    auto res = Globals::instance()-> pluginManager()
+               -> prepare < Carta::Lib::Hooks::GetPersistentCache > ().first();
+    if ( !res.isNull() && res.val() ){
+        m_diskCache = res.val();
+    }
+}
+
+QString StatisticsCache::getImageKey( const QString& fileName ){
+    QString key;
+    QFileInfo fileInfo( fileName );
+    if ( !fileName.isEmpty() && fileInfo.exists() ){
+        key = QString( "%1/%2/%3" ).arg( fileInfo.absoluteFilePath() )
+                .arg( fileInfo.size() ).arg( fileInfo.lastModified().toMSecsSinceEpoch() );
+    }
+    return key;
+}
+
+QString StatisticsCache::getPlaneKey( const std::vector<int>& frameIndices ){
+    QStringList indices;
+    for ( int index : frameIndices ){
+        indices.append( QString::number( index ) );
+    }
+    return indices.join( "," );
+}
+
+QString StatisticsCache::getRegionKey( std::shared_ptr<Carta::Lib::Regions::RegionBase> region ){
+    QString key;
+    if ( region ){
+        //The keys of a json object are sorted, so equal geometries serialize the same way.
+        QJsonDocument doc( geometryJson( region->toJson() ) );
+        key = QString( QCryptographicHash::hash( doc.toJson( QJsonDocument::Compact ),
+                QCryptographicHash::Sha1 ).toHex() );
+    }
+    return key;
+}
+
+bool StatisticsCache::getImageStats( const QString& imageKey, QList<Carta::Lib::StatInfo>& stats ){
+    bool found = false;
+    if ( !imageKey.isEmpty() ){
+        found = _getStats( imageKey + "/imageStats", stats );
+    }
+    return found;
+}
+
+bool StatisticsCache::getRegionStats( const QString& imageKey, const QString& planeKey,
+        const QString& regionKey, QList<Carta::Lib::StatInfo>& stats ){
+    bool found = false;
+    if ( !imageKey.isEmpty() && !regionKey.isEmpty() ){
+        found = _getStats( QString( "%1/%2/%3/regionStats" ).arg( imageKey ).arg( planeKey ).arg( regionKey ), stats );
+    }
+    return found;
+}
+
+void StatisticsCache::setImageStats( const QString& imageKey, const QList<Carta::Lib::StatInfo>& stats ){
+    if ( !imageKey.isEmpty() ){
+        _setStats( imageKey + "/imageStats", stats );
+    }
+}
+
+void StatisticsCache::setRegionStats( const QString& imageKey, const QString& planeKey,
+        const QString& regionKey, const QList<Carta::Lib::StatInfo>& stats ){
+    if ( !imageKey.isEmpty() && !regionKey.isEmpty() ){
+        _setStats( QString( "%1/%2/%3/regionStats" ).arg( imageKey ).arg( planeKey ).arg( regionKey ), stats );
+    }
+}
+
+bool StatisticsCache::_getStats( const QString& key, QList<Carta::Lib::StatInfo>& stats ){
+    QList<Carta::Lib::StatInfo>* cached = m_stats.object( key );
+    if ( cached ){
+        stats = *cached;
+        return true;
+    }
+    bool found = false;
+    if ( m_diskCache ){
+        QByteArray val;
+        QByteArray error;
+        if ( m_diskCache->readEntry( key.toUtf8(), val, error ) ){
+            found = _deserialize( val, stats );
+            if ( found ){
+                m_stats.insert( key, new QList<Carta::Lib::StatInfo>( stats ) );
+            }
+        }
+    }
+    return found;
+}
+
+void StatisticsCache::_setStats( const QString& key, const QList<Carta::Lib::StatInfo>& stats ){
+    m_stats.insert( key, new QList<Carta::Lib::StatInfo>( stats ) );
+    if ( m_diskCache ){
+        Carta::Lib::IPCache::Entry entry;
+        entry.key = key.toUtf8();
+        entry.val = _serialize( stats );
+        m_unflushed.push_back( entry );
+    }
+}
+
+void StatisticsCache::flush(){
+    if ( m_diskCache && !m_unflushed.empty() ){
+        m_diskCache->setEntries( m_unflushed );
+    }
+    m_unflushed.clear();
+}
+
+QByteArray StatisticsCache::_serialize( const QList<Carta::Lib::StatInfo>& stats ){
+    QByteArray bytes;
+    QDataStream out( &bytes, QIODevice::WriteOnly );
+    out << STATS_FORMAT_VERSION << qint32( stats.size() );
+    for ( const Carta::Lib::StatInfo& stat : stats ){
+        out << qint32( stat.getType() ) << stat.getLabel() << stat.getValue()
+            << stat.getNumericValue() << stat.isImageStat();
+    }
+    return bytes;
+}
+
+bool StatisticsCache::_deserialize( const QByteArray& bytes, QList<Carta::Lib::StatInfo>& stats ){
+    QDataStream in( bytes );
+    qint32 version = 0;
+    qint32 statCount = 0;
+    in >> version >> statCount;
+    if ( version != STATS_FORMAT_VERSION || statCount < 0 ){
+        return false;
+    }
+    QList<Carta::Lib::StatInfo> read;
+    for ( int i = 0; i < statCount; i++ ){
+        qint32 type = 0;
+        QString label;
+        QString value;
+        double numericValue = 0;
+        bool imageStat = false;
+        in >> type >> label >> value >> numericValue >> imageStat;
+        Carta::Lib::StatInfo stat( static_cast<Carta::Lib::StatInfo::StatType>( type ) );
+        stat.setLabel( label );
+        stat.setValue( value );
+        stat.setNumericValue( numericValue );
+        stat.setImageStat( imageStat );
+        read.append( stat );
+    }
+    if ( in.status() != QDataStream::Ok ){
+        qWarning() << "Could not read cached statistics";
+        return false;
+    }
+    stats = read;
+    return true;
+}
+
+StatisticsCache::~StatisticsCache(){
+    flush();
+}
+}
+}
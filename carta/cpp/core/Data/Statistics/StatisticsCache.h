@@ -0,0 +1,120 @@
+/***
+ * Keeps statistics that have been computed, in memory and in the persistent cache,
+ * so that showing the statistics of the same image, plane and region again does
+ * not compute them again.
+ */
+
+#pragma once
+
+#include "CartaLib/IPCache.h"
+#include "CartaLib/StatInfo.h"
+
+#include <QCache>
+#include <QList>
+#include <QString>
+#include <memory>
+#include <vector>
+
+namespace Carta {
+namespace Lib {
+namespace Regions {
+class RegionBase;
+}
+}
+
+namespace Data {
+
+class StatisticsCache {
+
+public:
+
+    /**
+     * Constructor.
+     */
+    StatisticsCache();
+
+    /**
+     * Returns a key identifying the contents of an image file, which changes when
+     * the file is rewritten.
+     * @param fileName - the location of the image file.
+     * @return - a key for the image; empty if the file cannot be found.
+     */
+    static QString getImageKey( const QString& fileName );
+
+    /**
+     * Returns a key identifying the plane statistics are computed for.
+     * @param frameIndices - the index of the plane along each axis of the image.
+     * @return - a key for the plane.
+     */
+    static QString getPlaneKey( const std::vector<int>& frameIndices );
+
+    /**
+     * Returns a key identifying the geometry of a region; regions of the same shape
+     * and position have the same key, whatever their colors.
+     * @param region - a region.
+     * @return - a key for the region geometry; empty if there is no region.
+     */
+    static QString getRegionKey( std::shared_ptr<Carta::Lib::Regions::RegionBase> region );
+
+    /**
+     * Look up the statistics of an image.
+     * @param imageKey - the key of the image.
+     * @param stats - set to the statistics of the image if they are in the cache.
+     * @return - true if the statistics were found; false otherwise.
+     */
+    bool getImageStats( const QString& imageKey, QList<Carta::Lib::StatInfo>& stats );
+
+    /**
+     * Look up the statistics of a region.
+     * @param imageKey - the key of the image.
+     * @param planeKey - the key of the plane.
+     * @param regionKey - the key of the region geometry.
+     * @param stats - set to the statistics of the region if they are in the cache.
+     * @return - true if the statistics were found; false otherwise.
+     */
+    bool getRegionStats( const QString& imageKey, const QString& planeKey,
+            const QString& regionKey, QList<Carta::Lib::StatInfo>& stats );
+
+    /**
+     * Store the statistics of an image.
+     * @param imageKey - the key of the image.
+     * @param stats - the statistics of the image.
+     */
+    void setImageStats( const QString& imageKey, const QList<Carta::Lib::StatInfo>& stats );
+
+    /**
+     * Store the statistics of a region.
+     * @param imageKey - the key of the image.
+     * @param planeKey - the key of the plane.
+     * @param regionKey - the key of the region geometry.
+     * @param stats - the statistics of the region.
+     */
+    void setRegionStats( const QString& imageKey, const QString& planeKey,
+            const QString& regionKey, const QList<Carta::Lib::StatInfo>& stats );
+
+    /**
+     * Write the statistics stored since the last flush to the persistent cache.
+     */
+    void flush();
+
+    virtual ~StatisticsCache();
+
+private:
+
+    bool _getStats( const QString& key, QList<Carta::Lib::StatInfo>& stats );
+    void _setStats( const QString& key, const QList<Carta::Lib::StatInfo>& stats );
+
+    static QByteArray _serialize( const QList<Carta::Lib::StatInfo>& stats );
+    static bool _deserialize( const QByteArray& bytes, QList<Carta::Lib::StatInfo>& stats );
+
+    QCache<QString, QList<Carta::Lib::StatInfo> > m_stats;
+    std::shared_ptr<Carta::Lib::IPCache> m_diskCache;
+
+    //Statistics waiting to be written to the persistent cache.
+    std::vector<Carta::Lib::IPCache::Entry> m_unflushed;
+
+    StatisticsCache( const StatisticsCache& other);
+    StatisticsCache& operator=( const StatisticsCache& other );
+};
+}
+}
@@ -6,6 +6,7 @@
 #include "IConnector.h"
 #include "IPlatform.h"
 #include "PluginManager.h"
+#include "CartaLib/Algorithms/ParallelTasks.h"
 
 Globals * Globals::m_instance = nullptr;
 
@@ -62,6 +63,8 @@ void Globals::setMainConfig(const MainConfig::ParsedInfo * mainConfig)
 {
     Q_ASSERT_X( ! m_mainConfig, "Globals", "Redefinging main config info!?!?!");
     m_mainConfig = mainConfig;
+    //Computations running in plugins share the same limit as the compute pool.
+    Carta::Lib::Algorithms::ParallelTasks::setThreadCountMax( mainConfig->getComputeThreadCountMax() );
 }
 
 
@@ -20,6 +20,25 @@ static constexpr QImage::Format OptimalQImageFormat = QImage::Format_ARGB32_Prem
 /// \todo check if the bug is still there in Qt5.4+, it definitely is there in Qt5.3
 static constexpr bool QtPremultipliedBugStillExists = true;
 
+/// make sure qImage has the given size and the format we render frames in
+static void
+prepareFrameImage( const QSize & size, QImage & qImage )
+{
+    QImage::Format desiredFormat = OptimalQImageFormat;
+    if ( QtPremultipliedBugStillExists ) {
+        desiredFormat = QImage::Format_ARGB32;
+    }
+
+    // QImage::Format desiredFormat = QImage::Format_ARGB32;
+    if ( qImage.format() != desiredFormat ||
+         qImage.size() != size ) {
+        qImage = QImage( size, desiredFormat );
+    }
+    auto bytesPerLine = qImage.bytesPerLine();
+    CARTA_ASSERT( bytesPerLine == size.width() * 4 );
+    Q_UNUSED( bytesPerLine );
+}
+
 /// internal algorithm for converting an instance of image interface to qimage
 /// using the pixel pipeline
 ///
@@ -36,20 +55,7 @@ iView2qImage( NdArray::RawViewInterface * rawView, Pipeline & pipe, QImage & qIm
     typedef double Scalar;
 
     QSize size( rawView->dims()[0], rawView->dims()[1] );
-
-    QImage::Format desiredFormat = OptimalQImageFormat;
-    if ( QtPremultipliedBugStillExists ) {
-        desiredFormat = QImage::Format_ARGB32;
-    }
-
-    // QImage::Format desiredFormat = QImage::Format_ARGB32;
-    if ( qImage.format() != desiredFormat ||
-         qImage.size() != size ) {
-        qImage = QImage( size, desiredFormat );
-    }
-    auto bytesPerLine = qImage.bytesPerLine();
-    CARTA_ASSERT( bytesPerLine == size.width() * 4 );
-    Q_UNUSED( bytesPerLine );
+    prepareFrameImage( size, qImage );
 
     // start with a pointer to the beginning of last row (we are constructing image
     // bottom-up)
@@ -71,19 +77,70 @@ iView2qImage( NdArray::RawViewInterface * rawView, Pipeline & pipe, QImage & qIm
     /// higher performance APIs and maybe even sprinkle it with some openmp/cilk magic :)
     int64_t counter = 0;
 
+    // collect a row of values and convert it in one go, so that the pipeline
+    // can use its buffer kernel
+    std::vector < Scalar > row( size.width() );
+    int col = 0;
 
+    auto lambda = [&] ( const Scalar & ival )
+    {
+        row[col++] = ival;
+        counter++;
+
+        // build the image bottom-up
+        if ( col == size.width() ) {
+            pipe.convertqMany( row.data(), col, outPtr, nanColor );
+            outPtr -= size.width();
+            col = 0;
+        }
+    };
+    typedView.forEach( lambda );
+
+    CARTA_ASSERT( counter == size.width() * size.height());
+
+} // rawView2QImage
+
+/// quantize the view into indices between the clips, laid out in the same
+/// order as the pixels of the rendered frame (i.e. top row first)
+static void
+iView2indexRaster( NdArray::RawViewInterface * rawView, double clipMin, double clipMax,
+                   Carta::Core::ImageRenderService::IndexRaster & raster )
+{
+    typedef double Scalar;
+    typedef Carta::Core::ImageRenderService::IndexRaster IndexRaster;
+
+    QSize size( rawView->dims()[0], rawView->dims()[1] );
+    raster.size = size;
+    raster.indices.resize( size_t( size.width() ) * size.height() );
+
+    double scale = 0;
+    if ( clipMax > clipMin ) {
+        scale = IndexRaster::MaxIndex / ( clipMax - clipMin );
+    }
+
+    // build the raster bottom-up, like iView2qImage()
+    quint16 * outPtr = raster.indices.data() + size_t( size.width() ) * ( size.height() - 1 );
+    int64_t counter = 0;
+    NdArray::TypedView < Scalar > typedView( rawView, false );
     auto lambda = [&] ( const Scalar & ival )
     {
         if ( Q_LIKELY( ! std::isnan( ival ) ) ) {
-            pipe.convertq( ival, * outPtr );
+            double index = ( ival - clipMin ) * scale + 0.5;
+            if ( index <= 0 ) {
+                * outPtr = 0;
+            }
+            else if ( index >= IndexRaster::MaxIndex ) {
+                * outPtr = IndexRaster::MaxIndex;
+            }
+            else {
+                * outPtr = static_cast < quint16 > ( index );
+            }
         }
         else {
-            * outPtr = nanColor;
+            * outPtr = IndexRaster::NanIndex;
         }
         outPtr++;
         counter++;
-
-        // build the image bottom-up
         if ( counter % size.width() == 0 ) {
             outPtr -= size.width() * 2;
         }
@@ -91,8 +148,7 @@ iView2qImage( NdArray::RawViewInterface * rawView, Pipeline & pipe, QImage & qIm
     typedView.forEach( lambda );
 
     CARTA_ASSERT( counter == size.width() * size.height());
-
-} // rawView2QImage
+} // iView2indexRaster
 
 namespace Carta
 {
@@ -107,6 +163,10 @@ Service::setInputView( NdArray::RawViewInterface::SharedPtr view, QString cacheI
 
     m_inputViewCacheId = cacheId;
     m_frameImage = QImage(); // indicate a need to recompute
+
+    // the index raster belongs to the previous view
+    m_indexRasterId = QString();
+    m_indexRaster = IndexRaster();
 }
 
 void
@@ -115,6 +175,12 @@ Service::setOutputSize( QSize size )
     m_outputSize = size;
 }
 
+void
+Service::setOutputViewport( const QRect & viewport )
+{
+    m_outputViewport = viewport;
+}
+
 QSize
 Service::outputSize() const
 {
@@ -178,9 +244,8 @@ Service::setPixelPipeline( IClippedPixelPipeline::SharedPtr pixelPipeline,
     // invalidate frame cache
     m_frameImage = QImage();
 
-    // invalidate pixel pipeline cache
-    m_cachedPP = nullptr;
-    m_cachedPPinterp = nullptr;
+    // invalidate the lookup table, the index raster only depends on the view and clips
+    m_lutId = QString();
 }
 
 void
@@ -191,9 +256,8 @@ Service::setPixelPipelineCacheSettings( const PixelPipelineCacheSettings & param
     // invalidate frame cache
     m_frameImage = QImage();
 
-    // invalidate pixel pipeline cache
-    m_cachedPP = nullptr;
-    m_cachedPPinterp = nullptr;
+    // invalidate the lookup table, the index raster only depends on the view and clips
+    m_lutId = QString();
 }
 
 const Service::PixelPipelineCacheSettings &
@@ -217,6 +281,44 @@ Service::render( JobId jobId )
     return m_lastSubmittedJobId;
 }
 
+void
+Service::_renderFromIndexRaster( double clipMin, double clipMax, QRgb nanColor )
+{
+    QString clipsId = QString( "%1/%2" )
+                          .arg( clipMin, 0, 'g', 17 )
+                          .arg( clipMax, 0, 'g', 17 );
+    QString rasterId = QString( "%1/%2" ).arg( m_inputViewCacheId ).arg( clipsId );
+    if ( m_indexRasterId.isEmpty() || m_indexRasterId != rasterId ) {
+        iView2indexRaster( m_inputView.get(), clipMin, clipMax, m_indexRaster );
+        m_indexRasterId = rasterId;
+    }
+
+    QString lutId = QString( "%1/%2/%3" )
+                        .arg( m_pixelPipelineCacheId )
+                        .arg( clipsId )
+                        .arg( QString::number( nanColor ) );
+    if ( m_lutId.isEmpty() || m_lutId != lutId ) {
+        m_lut.resize( IndexRaster::NanIndex + 1 );
+        std::vector < double > vals( IndexRaster::MaxIndex + 1 );
+        double step = ( clipMax - clipMin ) / IndexRaster::MaxIndex;
+        for ( int i = 0 ; i <= IndexRaster::MaxIndex ; i++ ) {
+            vals[i] = clipMin + i * step;
+        }
+        m_pixelPipelineRaw-> convertqMany( vals.data(), vals.size(), m_lut.data(), nanColor );
+        m_lut[IndexRaster::NanIndex] = nanColor;
+        m_lutId = lutId;
+    }
+
+    prepareFrameImage( m_indexRaster.size, m_frameImage );
+    QRgb * outPtr = reinterpret_cast < QRgb * > ( m_frameImage.bits() );
+    const quint16 * indexPtr = m_indexRaster.indices.data();
+    const QRgb * lut = m_lut.data();
+    size_t pixelCount = m_indexRaster.indices.size();
+    for ( size_t i = 0 ; i < pixelCount ; i++ ) {
+        outPtr[i] = lut[indexPtr[i]];
+    }
+} // _renderFromIndexRaster
+
 Service::Service( QObject * parent ) : Carta::Lib::IImageRenderService( parent ),
         m_defaultNan( true ),
         m_nanColor( 255, 0, 0 )
@@ -284,6 +386,13 @@ Service::screen2image( const QPointF & p, const QPointF& pan, double zoom,
     return res;
 }
 
+void
+Service::renderFrame( NdArray::RawViewInterface * view, IClippedPixelPipeline & pixelPipeline,
+                      QRgb nanColor, QImage & frameImage )
+{
+    ::iView2qImage( view, pixelPipeline, frameImage, nanColor );
+}
+
 void
 Service::internalRenderSlot()
 {
@@ -361,22 +470,9 @@ Service::internalRenderSlot()
 
         // disable pixelPipelineCache in case [clipMin, clipMax] = nan
         if ( pixelPipelineCacheSettings().enabled && !std::isnan(clipMin) && !std::isnan(clipMax) ) {
-            if ( pixelPipelineCacheSettings().interpolated ) {
-                if ( ! m_cachedPPinterp ) {
-                    m_cachedPPinterp.reset( new Lib::PixelPipeline::CachedPipeline < true > () );
-                    m_cachedPPinterp-> cache( * m_pixelPipelineRaw,
-                            pixelPipelineCacheSettings().size, clipMin, clipMax );
-                }
-                ::iView2qImage( m_inputView.get(), * m_cachedPPinterp, m_frameImage, nanColor );
-            }
-            else {
-                if ( ! m_cachedPP ) {
-                    m_cachedPP.reset( new Lib::PixelPipeline::CachedPipeline < false > () );
-                    m_cachedPP-> cache( * m_pixelPipelineRaw,
-                            pixelPipelineCacheSettings().size, clipMin, clipMax );
-                }
-                ::iView2qImage( m_inputView.get(), * m_cachedPP, m_frameImage, nanColor );
-            }
+            // quantize the view once per frame and clips, then colormap, gamma and
+            // scale changes only need a new lookup table
+            _renderFromIndexRaster( clipMin, clipMax, nanColor );
         }
         else {
             ::iView2qImage( m_inputView.get(), * m_pixelPipelineRaw, m_frameImage, nanColor );
@@ -391,13 +487,20 @@ Service::internalRenderSlot()
     // end the timer
     qDebug() << "Time for applying the colormap on the current view of image:" << timer.elapsed() << "ms";
 
-    // prepare output
-    QImage img( m_outputSize, OptimalQImageFormat );
-    if ( m_outputSize.width() > 0 && m_outputSize.height() > 0 ){
+    // prepare output, which is only the viewport if one was set
+    QSize imgSize = m_outputSize;
+    if ( m_outputViewport.isValid() ) {
+        imgSize = m_outputViewport.size();
+    }
+    QImage img( imgSize, OptimalQImageFormat );
+    if ( imgSize.width() > 0 && imgSize.height() > 0 ){
 
         //    img.fill( QColor( "blue" ) );
         img.fill( QColor( 50, 50, 50 ) );
         QPainter p( & img );
+        if ( m_outputViewport.isValid() ) {
+            p.translate( - m_outputViewport.topLeft() );
+        }
 
         // draw the frame image to satisfy zoom/pan
         //    QPointF p1 = img2screen( QPointF( -0.5, -0.5 ) );
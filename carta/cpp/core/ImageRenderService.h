@@ -39,6 +39,7 @@
 #include <QStringList>
 #include <QCache>
 #include <QTimer>
+#include <vector>
 
 namespace Carta
 {
@@ -54,6 +55,20 @@ typedef Lib::PixelPipeline::IClippedPixelPipeline IClippedPixelPipeline;
 /// job id
 typedef int64_t JobId;
 
+/// pixel values of a frame quantized between the clips, one index per pixel, in the
+/// same order as the pixels of the rendered frame
+struct IndexRaster
+{
+    /// index of the last bin, which holds values at or above the upper clip
+    static constexpr int MaxIndex = 65534;
+
+    /// index used for nan values
+    static constexpr int NanIndex = 65535;
+
+    QSize size;
+    std::vector < quint16 > indices;
+};
+
 /// Implementation of the rendering service
 /// \warning this object could potentially live it a separate thread, so make all connections
 /// to it as explicitly queued
@@ -106,6 +121,12 @@ public:
     virtual void
     setOutputSize( QSize size ) override;
 
+    /// render only part of the output image, e.g. one tile of a large image being saved;
+    /// the rendered image then has the size of the viewport
+    /// \param viewport the part of the output to render, or a null rectangle for all of it
+    void
+    setOutputViewport( const QRect & viewport );
+
     ///
     /// \brief return the last output size requested
     /// \return
@@ -200,6 +221,16 @@ public:
     virtual QPointF
     screen2image( const QPointF & p, const QPointF& pan, double zoom, const QSize& size ) const override;
 
+    /// render a whole frame through the pixel pipeline, without pan/zoom or caching;
+    /// safe to call from any thread as long as the view and pipeline are not shared
+    /// \param view the frame to render, its first two axes are x and y
+    /// \param pixelPipeline the pipeline (with its clips set) used to convert the values
+    /// \param nanColor color for nan values
+    /// \param frameImage where to put the result, one image pixel per data pixel
+    static void
+    renderFrame( Carta::Lib::NdArray::RawViewInterface * view,
+                 IClippedPixelPipeline & pixelPipeline, QRgb nanColor, QImage & frameImage );
+
 public slots:
 
     /// ask the service to render using the current settings and use the given
@@ -226,11 +257,17 @@ protected slots:
 
 private:
 
+    /// render m_frameImage by mapping the index raster through a lookup table
+    /// built from the pixel pipeline, recomputing either only when needed
+    void
+    _renderFromIndexRaster( double clipMin, double clipMax, QRgb nanColor );
+
     // the following are rendering parameters
     Carta::Lib::NdArray::RawViewInterface::SharedPtr m_inputView = nullptr;
     QString m_inputViewCacheId;
     QString m_pixelPipelineCacheId;
     QSize m_outputSize = QSize( 10, 10 );
+    QRect m_outputViewport;
 
     /// instance of the pixel pipeline (very likely slow)
     IClippedPixelPipeline::SharedPtr m_pixelPipelineRaw = nullptr;
@@ -241,9 +278,6 @@ private:
     /// current pan (coordinates of the image pixel that is to be centered on the screen)
     QPointF m_pan = QPointF( 0, 0 );
 
-    // cached pipelines
-    Lib::PixelPipeline::CachedPipeline < true >::UniquePtr m_cachedPPinterp = nullptr;
-    Lib::PixelPipeline::CachedPipeline < false >::UniquePtr m_cachedPP = nullptr;
     PixelPipelineCacheSettings m_pixelPipelineCacheSettings;
 
     /// here we store the whole frame rendered, it is essentially a cache to make
@@ -253,6 +287,15 @@ private:
     /// cache for individual frames (to make movie playing little bit faster)
     QCache < QString, QImage > m_frameCache;
 
+    /// the current frame quantized between the clips, and the view/clips it was made for
+    IndexRaster m_indexRaster;
+    QString m_indexRasterId;
+
+    /// pixel pipeline evaluated for every index of the raster, and the
+    /// pipeline/clips/nan color it was made for
+    std::vector < QRgb > m_lut;
+    QString m_lutId;
+
     /// last requested job id
     JobId m_lastSubmittedJobId = - 1;
 
@@ -107,9 +107,13 @@ ParsedInfo parse(const QString & filePath)
     _storeBool( json["hacksEnabled"], &info.m_hacksEnabled, "hacks enabled");
     _storeBool( json["developerLayout"], &info.m_developerLayout, "developer layout");
     _storeBool( json["percentileApproximation"], &info.m_percentileApproximation, "whether to use approximation method for percentile calculation");
+    _storeBool( json["clipPrecomputation"], &info.m_clipPrecomputation, "whether to precompute clips for every plane on load");
 
     _storePositiveInt( json["histogramBinCountMax"], &info.m_histogramBinCountMax, "histogram bin count max");
     _storePositiveInt( json["contourLevelCountMax"], &info.m_contourLevelCountMax, "contour level count max");
+    _storePositiveInt( json["computeThreadCountMax"], &info.m_computeThreadCountMax, "compute thread count max");
+    _storePositiveInt( json["framePrefetchMemoryMax"], &info.m_framePrefetchMemoryMax, "frame prefetch memory max");
+    _storePositiveInt( json["saveTileSize"], &info.m_saveTileSize, "save tile size");
     _storeUnsignedInt( json["percentApproxDividedNum"], &info.m_percentApproxDividedNum, "define the pixel bin size=(max-min)/m_percentApproxDividedNum");
 
     return info;
@@ -130,6 +134,10 @@ bool ParsedInfo::isPercentileApproximation() const {
     return m_percentileApproximation;
 }
 
+bool ParsedInfo::isClipPrecomputation() const {
+    return m_clipPrecomputation;
+}
+
 bool ParsedInfo::isDeveloperLayout() const {
     return m_developerLayout;
 }
@@ -138,6 +146,18 @@ int ParsedInfo::getContourLevelCountMax() const {
     return m_contourLevelCountMax;
 }
 
+int ParsedInfo::getComputeThreadCountMax() const {
+    return m_computeThreadCountMax;
+}
+
+int ParsedInfo::getFramePrefetchMemoryMax() const {
+    return m_framePrefetchMemoryMax;
+}
+
+int ParsedInfo::getSaveTileSize() const {
+    return m_saveTileSize;
+}
+
 int ParsedInfo::getHistogramBinCountMax() const {
     return m_histogramBinCountMax;
 }
@@ -40,6 +40,31 @@ public:
      */
     int getContourLevelCountMax() const;
 
+    /**
+     * Returns any valid user set maximum number of threads used for background
+     * computations (histograms, profiles, statistics) or -1 if no valid user
+     * supplied value has been provided.
+     * @return the maximum number of compute threads or -1 if no valid value has
+     *   been specified.
+     */
+    int getComputeThreadCountMax() const;
+
+    /**
+     * Returns any valid user set maximum amount of memory in megabytes used per image
+     * for frames read ahead during animation or -1 if no valid user supplied value
+     * has been provided.
+     * @return the maximum frame prefetch memory in megabytes or -1 if no valid value
+     *   has been specified.
+     */
+    int getFramePrefetchMemoryMax() const;
+
+    /**
+     * Returns any valid user set size in pixels of the tiles large images are saved
+     * in or -1 if no valid user supplied value has been provided.
+     * @return the save tile size in pixels or -1 if no valid value has been specified.
+     */
+    int getSaveTileSize() const;
+
     /// whether hacks are enabled or not
     bool hacksEnabled() const;
 
@@ -55,6 +80,12 @@ public:
      */
     bool isPercentileApproximation() const;
 
+    /**
+     * Returns whether CARTA should compute the clips of every channel and Stokes
+     * plane for the clip presets in the background when an image is loaded.
+     */
+    bool isClipPrecomputation() const;
+
     /**
      * Returns the value used to divide the range of pixel value: (max - min),
      * so the pixel bin size used for percentile approximation is (max - min) / getPercentApproxDividedNum.
@@ -105,8 +136,12 @@ protected:
     bool m_hacksEnabled = false;
     bool m_percentileApproximation = false;
     bool m_developerLayout = false;
+    bool m_clipPrecomputation = false;
     int m_histogramBinCountMax = -1;
     int m_contourLevelCountMax = -1;
+    int m_computeThreadCountMax = -1;
+    int m_framePrefetchMemoryMax = -1;
+    int m_saveTileSize = -1;
     unsigned int m_percentApproxDividedNum = 1000000;
 
     QJsonObject m_json;
@@ -0,0 +1,92 @@
+/**
+ *
+ **/
+
+#include "BinaryMessage.h"
+
+#include <QJsonDocument>
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace Carta
+{
+namespace Core
+{
+namespace ScriptedClient
+{
+BinaryMessage::BinaryMessage( const QJsonObject & header, const std::vector < double > & values )
+    : m_header( header ), m_values( values )
+{
+    m_header.insert( "dtype", QString( "<f8" ) );
+}
+
+TagMessage
+BinaryMessage::toTagMessage() const
+{
+    QByteArray headerBytes = QJsonDocument( m_header ).toJson( QJsonDocument::Compact );
+    qint64 headerSize = headerBytes.size();
+    qint64 valuesSize = static_cast < qint64 > ( m_values.size() * sizeof( double ) );
+    if ( static_cast < qint64 > ( m_values.size() ) > VALUE_COUNT_MAX ||
+         8 + headerSize + valuesSize > std::numeric_limits < int >::max() ) {
+        throw std::runtime_error( "binary message is too large" );
+    }
+
+    VarLengthMessage buff( static_cast < int > ( 8 + headerSize + valuesSize ), Qt::Uninitialized );
+    uchar * dest = reinterpret_cast < uchar * > ( buff.data() );
+    qToLittleEndian( headerSize, dest );
+    dest += 8;
+    std::memcpy( dest, headerBytes.constData(), headerSize );
+    dest += headerSize;
+    for ( double value : m_values ) {
+        quint64 bits;
+        std::memcpy( & bits, & value, sizeof( bits ) );
+        qToLittleEndian( bits, dest );
+        dest += sizeof( bits );
+    }
+    return TagMessage( TAG, buff );
+}
+
+BinaryMessage
+BinaryMessage::fromTagMessage( const TagMessage & message )
+{
+    if ( message.tag() != TAG ) {
+        throw std::runtime_error( "tag message does not have 'binary' as tag" );
+    }
+    const QByteArray & data = message.data();
+    const uchar * src = reinterpret_cast < const uchar * > ( data.constData() );
+    if ( data.size() < 8 ) {
+        throw std::runtime_error( "binary message is too short" );
+    }
+    qint64 headerSize = qFromLittleEndian < qint64 > ( src );
+    if ( headerSize < 0 || headerSize > data.size() - 8 ) {
+        throw std::runtime_error( "binary message has an invalid header size" );
+    }
+    QJsonObject header = QJsonDocument::fromJson( data.mid( 8, headerSize ) ).object();
+
+    qint64 valueCount = ( data.size() - 8 - headerSize ) / sizeof( double );
+    std::vector < double > values( valueCount );
+    src += 8 + headerSize;
+    for ( qint64 i = 0; i < valueCount; i++ ) {
+        quint64 bits = qFromLittleEndian < quint64 > ( src );
+        std::memcpy( & values[i], & bits, sizeof( bits ) );
+        src += sizeof( bits );
+    }
+    return BinaryMessage( header, values );
+}
+
+const QJsonObject &
+BinaryMessage::header() const
+{
+    return m_header;
+}
+
+const std::vector < double > &
+BinaryMessage::values() const
+{
+    return m_values;
+}
+}
+}
+}
@@ -0,0 +1,61 @@
+/**
+ * Layer 3 : implemented on top of layer 2
+ *
+ * \note Like JsonMessage, this is a convenience layer. It carries arrays of numbers
+ * (pixel data, profiles, histograms, statistics) without converting each value to text.
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "TagMessage.h"
+
+#include <QJsonObject>
+#include <vector>
+
+namespace Carta
+{
+namespace Core
+{
+namespace ScriptedClient
+{
+/// holds a json header describing an array of numbers, followed by the raw array
+/// can be serialized to/from TagMessage, with tag = "binary"
+///
+/// Message format (after the tag):
+/// - 8 bytes representing the length of the header (n) in little endian
+/// - n bytes of json header; "dtype" and "shape" describe the array
+/// - the array itself, as little endian 8 byte floating point values
+class BinaryMessage
+{
+public:
+
+    /// the largest number of values a message can carry; larger arrays have to be
+    /// requested in parts
+    static constexpr qint64 VALUE_COUNT_MAX = 16 * 1024 * 1024;
+
+    BinaryMessage( const QJsonObject & header, const std::vector < double > & values );
+
+    /// will throw exception if there are more than VALUE_COUNT_MAX values
+    TagMessage
+    toTagMessage() const;
+
+    /// will throw exception if message.tag != "binary"
+    static BinaryMessage
+    fromTagMessage( const TagMessage & message );
+
+    const QJsonObject &
+    header() const;
+
+    const std::vector < double > &
+    values() const;
+
+private:
+
+    QJsonObject m_header;
+    std::vector < double > m_values;
+    static constexpr char const * TAG = "binary";
+};
+}
+}
+}
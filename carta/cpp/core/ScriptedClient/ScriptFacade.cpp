@@ -13,9 +13,24 @@
 #include "Data/Preferences/PreferencesSave.h"
 #include "Data/Image/Grid/GridControls.h"
 #include "Data/Image/Contour/ContourControls.h"
+#include "Data/Region/Region.h"
+#include "Data/Region/RegionControls.h"
+#include "Globals.h"
+#include "PluginManager.h"
+#include "BinaryMessage.h"
+#include "CartaLib/IImage.h"
+#include "CartaLib/Hooks/HistogramResult.h"
+#include "CartaLib/Hooks/ImageStatisticsHook.h"
+#include "CartaLib/Hooks/ProfileBatchHook.h"
+#include "CartaLib/Hooks/StatisticsBatchHook.h"
+#include "CartaLib/Regions/IRegion.h"
 
 #include <QDebug>
+#include <QJsonArray>
+#include <QMap>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 using Carta::State::ObjectManager;
 
@@ -502,12 +517,21 @@ QStringList ScriptFacade::saveImage( const QString& controlId, const QString& fi
     if ( widthError.isEmpty() && heightError.isEmpty() && aspectModeError.isEmpty() ){
         QString id = objMan->parseId( controlId );
         Carta::State::CartaObject* obj = objMan->getObject( id );
+        Carta::Data::Controller* controller = nullptr;
         if ( obj != nullptr ){
-            Carta::Data::Controller* controller = dynamic_cast<Carta::Data::Controller*>(obj);
-            if ( controller != nullptr ){
-                errorList = QStringList( controller->saveImage( filename) );
+            controller = dynamic_cast<Carta::Data::Controller*>(obj);
+        }
+        if ( controller != nullptr ){
+            errorList = QStringList( controller->saveImage( filename) );
+            //A save that could not be started does not report a result.
+            if ( !errorList[0].isEmpty() ){
+                emit saveImageResult( false );
             }
         }
+        else {
+            errorList = QStringList( IMAGE_VIEW_NOT_FOUND + controlId );
+            emit saveImageResult( false );
+        }
     }
     else {
         if ( !widthError.isEmpty()){
@@ -888,6 +912,363 @@ QStringList ScriptFacade::getPixelValue( const QString& controlId, double x, dou
     return resultList;
 }
 
+QStringList ScriptFacade::getImageData( const QString& controlId, const std::vector<int>& start,
+        const std::vector<int>& count, QJsonObject& header, std::vector<double>& values ){
+    QStringList resultList;
+    Carta::State::CartaObject* obj = _getObject( controlId );
+    if ( obj != nullptr ){
+        Carta::Data::Controller* controller = dynamic_cast<Carta::Data::Controller*>(obj);
+        if ( controller != nullptr ){
+            std::shared_ptr<Carta::Lib::Image::ImageInterface> image = _getSelectedImage( controller );
+            if ( image ){
+                std::vector<int> dims = image->dims();
+                int dimCount = dims.size();
+                int startCount = start.size();
+                int countCount = count.size();
+                SliceND slice;
+                QJsonArray shape;
+                bool validRange = true;
+                qint64 valueCount = 1;
+                for ( int i = 0; i < dimCount; i++ ){
+                    int first = i < startCount ? start[i] : 0;
+                    int pixelCount = ( i < countCount && count[i] >= 0 ) ? count[i] : dims[i] - first;
+                    if ( first < 0 || pixelCount <= 0 || first + pixelCount > dims[i] ){
+                        validRange = false;
+                        break;
+                    }
+                    valueCount *= pixelCount;
+                    slice.start( first );
+                    slice.end( first + pixelCount );
+                    if ( i < dimCount - 1 ){
+                        slice.next();
+                    }
+                    shape.append( pixelCount );
+                }
+                //The reply has to fit into one message.
+                qint64 valueCountMax = Carta::Core::ScriptedClient::BinaryMessage::VALUE_COUNT_MAX;
+                std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> view;
+                if ( validRange && valueCount <= valueCountMax ){
+                    view.reset( image->getDataSlice( slice ) );
+                }
+                if ( validRange && valueCount > valueCountMax ){
+                    resultList = _logErrorMessage( ERROR, "The block has " + QString::number( valueCount ) +
+                            " pixels, but at most " + QString::number( valueCountMax ) +
+                            " can be fetched at once; use start and count to fetch it in parts." );
+                }
+                else if ( view ){
+                    values.reserve( valueCount );
+                    Carta::Lib::NdArray::Double doubleView( view.get(), false );
+                    doubleView.forEach( [&values]( const double& val ){
+                        values.push_back( val );
+                    });
+                    header.insert( "shape", shape );
+                    resultList = QStringList( "" );
+                }
+                else {
+                    resultList = _logErrorMessage( ERROR, "Invalid block of the image." );
+                }
+            }
+            else {
+                resultList = _logErrorMessage( ERROR, NO_IMAGE );
+            }
+        }
+        else {
+            resultList = _logErrorMessage( ERROR, UNKNOWN_ERROR );
+        }
+    }
+    else {
+        resultList = _logErrorMessage( ERROR, IMAGE_VIEW_NOT_FOUND + controlId );
+    }
+    return resultList;
+}
+
+QStringList ScriptFacade::getSpectralProfileData( const QString& controlId, int x, int y,
+        QJsonObject& header, std::vector<double>& values ){
+    QStringList resultList;
+    Carta::State::CartaObject* obj = _getObject( controlId );
+    if ( obj != nullptr ){
+        Carta::Data::Controller* controller = dynamic_cast<Carta::Data::Controller*>(obj);
+        if ( controller != nullptr ){
+            std::shared_ptr<Carta::Lib::Image::ImageInterface> image = _getSelectedImage( controller );
+            if ( image ){
+                std::vector<int> dims = image->dims();
+                int dimCount = dims.size();
+                int spectralAxis = Carta::Data::Util::getAxisIndex( image, Carta::Lib::AxisInfo::KnownType::SPECTRAL );
+                int stokesAxis = Carta::Data::Util::getAxisIndex( image, Carta::Lib::AxisInfo::KnownType::STOKES );
+                std::vector<int> frames = controller->getImageSlice();
+                int stokesIndex = static_cast<int>( Carta::Lib::AxisInfo::KnownType::STOKES );
+                if ( spectralAxis < 2 ){
+                    resultList = _logErrorMessage( ERROR, "The image does not have a spectral axis." );
+                }
+                else if ( dimCount < 2 || x < 0 || x >= dims[0] || y < 0 || y >= dims[1] ){
+                    resultList = _logErrorMessage( ERROR, "Invalid pixel: ("+QString::number(x)+
+                            ", "+QString::number(y)+")" );
+                }
+                else {
+                    //The first two axes are the spatial ones.
+                    SliceND slice;
+                    for ( int i = 0; i < dimCount; i++ ){
+                        if ( i != spectralAxis ){
+                            int frame = 0;
+                            if ( i == 0 ){
+                                frame = x;
+                            }
+                            else if ( i == 1 ){
+                                frame = y;
+                            }
+                            else if ( i == stokesAxis && stokesIndex < static_cast<int>( frames.size() ) ){
+                                frame = std::max( 0, std::min( frames[stokesIndex], dims[i] - 1 ) );
+                            }
+                            slice.start( frame );
+                            slice.end( frame + 1 );
+                        }
+                        if ( i < dimCount - 1 ){
+                            slice.next();
+                        }
+                    }
+                    std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> view( image->getDataSlice( slice ) );
+                    if ( view ){
+                        Carta::Lib::NdArray::Double doubleView( view.get(), false );
+                        doubleView.forEach( [&values]( const double& val ){
+                            values.push_back( val );
+                        });
+                        QJsonArray shape;
+                        shape.append( static_cast<int>( values.size() ) );
+                        header.insert( "shape", shape );
+                        resultList = QStringList( "" );
+                    }
+                    else {
+                        resultList = _logErrorMessage( ERROR, UNKNOWN_ERROR );
+                    }
+                }
+            }
+            else {
+                resultList = _logErrorMessage( ERROR, NO_IMAGE );
+            }
+        }
+        else {
+            resultList = _logErrorMessage( ERROR, UNKNOWN_ERROR );
+        }
+    }
+    else {
+        resultList = _logErrorMessage( ERROR, IMAGE_VIEW_NOT_FOUND + controlId );
+    }
+    return resultList;
+}
+
+QStringList ScriptFacade::getRegionStatsData( const QString& controlId,
+        QJsonObject& header, std::vector<double>& values ){
+    QStringList resultList;
+    Carta::State::CartaObject* obj = _getObject( controlId );
+    if ( obj != nullptr ){
+        Carta::Data::Controller* controller = dynamic_cast<Carta::Data::Controller*>(obj);
+        if ( controller != nullptr ){
+            std::vector< std::shared_ptr<Carta::Lib::Image::ImageInterface> > images = controller->getImages();
+            std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > regions = _getRegions( controller );
+            std::vector<int> frames = controller->getImageSlice();
+            Carta::Lib::Hooks::ImageStatisticsHook::ResultType data;
+            QString error;
+            if ( !images.empty() ){
+                auto result = Globals::instance()-> pluginManager()
+                        -> prepare <Carta::Lib::Hooks::ImageStatisticsHook>(images, regions, frames);
+                try {
+                    result.forEach( [&data]( const Carta::Lib::Hooks::ImageStatisticsHook::ResultType& stats ){
+                        data = stats;
+                    });
+                }
+                catch( char*& errorMsg ){
+                    error = QString( errorMsg );
+                }
+            }
+
+            if ( images.empty() ){
+                resultList = _logErrorMessage( ERROR, NO_IMAGE );
+            }
+            else if ( !error.isEmpty() ){
+                resultList = _logErrorMessage( ERROR, error );
+            }
+            else {
+                //A column for each region statistic that is a number in some set.
+                QList<Carta::Lib::StatInfo::StatType> columnTypes;
+                for ( Carta::Lib::StatInfo::StatType statType : Carta::Lib::StatInfo::getStatTypesRegion() ){
+                    bool numeric = false;
+                    for ( const QList< QList<Carta::Lib::StatInfo> >& imageStats : data ){
+                        for ( const QList<Carta::Lib::StatInfo>& statSet : imageStats ){
+                            for ( const Carta::Lib::StatInfo& info : statSet ){
+                                if ( info.getType() == statType && !std::isnan( info.getNumericValue() ) ){
+                                    numeric = true;
+                                }
+                            }
+                        }
+                    }
+                    if ( numeric ){
+                        columnTypes.append( statType );
+                    }
+                }
+
+                //A row for each set of statistics with a number in it.
+                QJsonArray columns;
+                for ( Carta::Lib::StatInfo::StatType statType : columnTypes ){
+                    columns.append( Carta::Lib::StatInfo::toString( statType ) );
+                }
+                QJsonArray rows;
+                int columnCount = columnTypes.size();
+                int imageCount = data.size();
+                for ( int i = 0; i < imageCount; i++ ){
+                    int setCount = data[i].size();
+                    for ( int k = 0; k < setCount; k++ ){
+                        std::vector<double> row( columnCount, std::numeric_limits<double>::quiet_NaN() );
+                        bool numeric = false;
+                        for ( const Carta::Lib::StatInfo& info : data[i][k] ){
+                            int column = columnTypes.indexOf( info.getType() );
+                            if ( column >= 0 && !std::isnan( info.getNumericValue() ) ){
+                                row[column] = info.getNumericValue();
+                                numeric = true;
+                            }
+                        }
+                        if ( numeric ){
+                            values.insert( values.end(), row.begin(), row.end() );
+                            QJsonArray rowId;
+                            rowId.append( i );
+                            rowId.append( k );
+                            rows.append( rowId );
+                        }
+                    }
+                }
+                QJsonArray shape;
+                shape.append( rows.size() );
+                shape.append( columnCount );
+                header.insert( "shape", shape );
+                header.insert( "columns", columns );
+                header.insert( "rows", rows );
+                resultList = QStringList( "" );
+            }
+        }
+        else {
+            resultList = _logErrorMessage( ERROR, UNKNOWN_ERROR );
+        }
+    }
+    else {
+        resultList = _logErrorMessage( ERROR, IMAGE_VIEW_NOT_FOUND + controlId );
+    }
+    return resultList;
+}
+
+QStringList ScriptFacade::getRegionStatsColumns( const QString& controlId,
+        QJsonObject& header, std::vector<double>& values ){
+    QStringList resultList;
+    Carta::State::CartaObject* obj = _getObject( controlId );
+    if ( obj != nullptr ){
+        Carta::Data::Controller* controller = dynamic_cast<Carta::Data::Controller*>(obj);
+        if ( controller != nullptr ){
+            std::shared_ptr<Carta::Lib::Image::ImageInterface> image = _getSelectedImage( controller );
+            if ( image ){
+                std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > regions = _getRegions( controller );
+                std::vector<int> frames = controller->getImageSlice();
+                Carta::Lib::Hooks::StatisticsBatchHook::ResultType data;
+                auto result = Globals::instance()-> pluginManager()
+                        -> prepare <Carta::Lib::Hooks::StatisticsBatchHook>(image, regions, frames);
+                auto lam = [&data]( const Carta::Lib::Hooks::StatisticsBatchHook::ResultType& columns ){
+                    data = columns;
+                };
+                result.forEach( lam );
+
+                //Only the statistics some region has a value for.
+                QJsonArray columns;
+                for ( const auto& column : data ){
+                    bool numeric = std::any_of( column.second.begin(), column.second.end(),
+                            []( double value ){ return !std::isnan( value ); } );
+                    if ( numeric ){
+                        columns.append( Carta::Lib::StatInfo::toString( column.first ) );
+                        values.insert( values.end(), column.second.begin(), column.second.end() );
+                    }
+                }
+                QJsonArray shape;
+                shape.append( columns.size() );
+                shape.append( static_cast<int>( regions.size() ) );
+                header.insert( "shape", shape );
+                header.insert( "columns", columns );
+                resultList = QStringList( "" );
+            }
+            else {
+                resultList = _logErrorMessage( ERROR, NO_IMAGE );
+            }
+        }
+        else {
+            resultList = _logErrorMessage( ERROR, UNKNOWN_ERROR );
+        }
+    }
+    else {
+        resultList = _logErrorMessage( ERROR, IMAGE_VIEW_NOT_FOUND + controlId );
+    }
+    return resultList;
+}
+
+QStringList ScriptFacade::getRegionProfilesData( const QString& controlId, const QString& statistic,
+        QJsonObject& header, std::vector<double>& values ){
+    QStringList resultList;
+    QMap<QString, Carta::Lib::ProfileInfo::AggregateType> aggregateTypes;
+    aggregateTypes.insert( "mean", Carta::Lib::ProfileInfo::AggregateType::MEAN );
+    aggregateTypes.insert( "sum", Carta::Lib::ProfileInfo::AggregateType::SUM );
+    aggregateTypes.insert( "flux", Carta::Lib::ProfileInfo::AggregateType::FLUX_DENSITY );
+    aggregateTypes.insert( "rms", Carta::Lib::ProfileInfo::AggregateType::RMS );
+    aggregateTypes.insert( "variance", Carta::Lib::ProfileInfo::AggregateType::VARIANCE );
+    aggregateTypes.insert( "min", Carta::Lib::ProfileInfo::AggregateType::MIN );
+    aggregateTypes.insert( "max", Carta::Lib::ProfileInfo::AggregateType::MAX );
+    Carta::State::CartaObject* obj = _getObject( controlId );
+    if ( obj != nullptr ){
+        Carta::Data::Controller* controller = dynamic_cast<Carta::Data::Controller*>(obj);
+        if ( controller != nullptr ){
+            std::shared_ptr<Carta::Lib::Image::ImageInterface> image = _getSelectedImage( controller );
+            int spectralAxis = -1;
+            if ( image ){
+                spectralAxis = Carta::Data::Util::getAxisIndex( image, Carta::Lib::AxisInfo::KnownType::SPECTRAL );
+            }
+            if ( !image ){
+                resultList = _logErrorMessage( ERROR, NO_IMAGE );
+            }
+            else if ( spectralAxis < 2 ){
+                resultList = _logErrorMessage( ERROR, "The image does not have a spectral axis." );
+            }
+            else if ( !aggregateTypes.contains( statistic.toLower() ) ){
+                resultList = _logErrorMessage( ERROR, "Unrecognized profile statistic: "+statistic );
+            }
+            else {
+                std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > regions = _getRegions( controller );
+                std::vector<int> frames = controller->getImageSlice();
+                Carta::Lib::Hooks::ProfileBatchHook::ResultType data;
+                auto result = Globals::instance()-> pluginManager()
+                        -> prepare <Carta::Lib::Hooks::ProfileBatchHook>(image, regions, spectralAxis,
+                                frames, aggregateTypes[statistic.toLower()] );
+                auto lam = [&data]( const Carta::Lib::Hooks::ProfileBatchHook::ResultType& profiles ){
+                    data = profiles;
+                };
+                result.forEach( lam );
+                if ( data.size() != regions.size() ){
+                    resultList = _logErrorMessage( ERROR, "Could not compute the region profiles." );
+                }
+                else {
+                    for ( const std::vector<double>& profile : data ){
+                        values.insert( values.end(), profile.begin(), profile.end() );
+                    }
+                    QJsonArray shape;
+                    shape.append( static_cast<int>( data.size() ) );
+                    shape.append( image->dims()[spectralAxis] );
+                    header.insert( "shape", shape );
+                    resultList = QStringList( "" );
+                }
+            }
+        }
+        else {
+            resultList = _logErrorMessage( ERROR, UNKNOWN_ERROR );
+        }
+    }
+    else {
+        resultList = _logErrorMessage( ERROR, IMAGE_VIEW_NOT_FOUND + controlId );
+    }
+    return resultList;
+}
+
 QStringList ScriptFacade::getPixelUnits( const QString& controlId ){
     QStringList resultList;
     Carta::State::CartaObject* obj = _getObject( controlId );
@@ -1322,6 +1703,44 @@ QStringList ScriptFacade::getIntensity( const QString& controlId, int frameLow,
     return resultList;
 }
 
+QStringList ScriptFacade::getHistogramData( const QString& histogramId,
+        QJsonObject& header, std::vector<double>& values ) {
+    QStringList resultList;
+    Carta::State::CartaObject* obj = _getObject( histogramId );
+    if ( obj != nullptr ){
+        Carta::Data::Histogram* histogram = dynamic_cast<Carta::Data::Histogram*>(obj);
+        if ( histogram != nullptr ){
+            QJsonArray names;
+            QJsonArray lengths;
+            int pairCount = 0;
+            for ( const Carta::Lib::Hooks::HistogramResult& result : histogram->getHistogramResults() ){
+                std::vector<std::pair<double,double> > data = result.getData();
+                for ( const std::pair<double,double>& pair : data ){
+                    values.push_back( pair.first );
+                    values.push_back( pair.second );
+                }
+                names.append( result.getName() );
+                lengths.append( static_cast<int>( data.size() ) );
+                pairCount += data.size();
+            }
+            QJsonArray shape;
+            shape.append( pairCount );
+            shape.append( 2 );
+            header.insert( "shape", shape );
+            header.insert( "names", names );
+            header.insert( "lengths", lengths );
+            resultList = QStringList( "" );
+        }
+        else {
+            resultList = _logErrorMessage( ERROR, UNKNOWN_ERROR );
+        }
+    }
+    else {
+        resultList = _logErrorMessage( ERROR, HISTOGRAM_NOT_FOUND + histogramId );
+    }
+    return resultList;
+}
+
 QStringList ScriptFacade::setBinCount( const QString& histogramId, int binCount ) {
     QStringList resultList;
     Carta::State::CartaObject* obj = _getObject( histogramId );
@@ -2444,6 +2863,29 @@ Carta::State::CartaObject* ScriptFacade::_getObject( const QString& id ) {
     return obj;
 }
 
+std::shared_ptr<Carta::Lib::Image::ImageInterface> ScriptFacade::_getSelectedImage(
+        Carta::Data::Controller* controller ){
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image;
+    std::vector< std::shared_ptr<Carta::Lib::Image::ImageInterface> > images = controller->getImages();
+    int selectIndex = controller->getSelectImageIndex();
+    if ( 0 <= selectIndex && selectIndex < static_cast<int>( images.size() ) ){
+        image = images[selectIndex];
+    }
+    return image;
+}
+
+std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > ScriptFacade::_getRegions(
+        Carta::Data::Controller* controller ){
+    std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > regions;
+    std::shared_ptr<Carta::Data::RegionControls> regionControls = controller->getRegionControls();
+    if ( regionControls ){
+        for ( std::shared_ptr<Carta::Data::Region> region : regionControls->getRegions() ){
+            regions.push_back( region->getModel() );
+        }
+    }
+    return regions;
+}
+
 QStringList ScriptFacade::_logErrorMessage( const QString& key, const QString& value ) {
     QStringList result( key );
     result.append( value );
@@ -7,12 +7,24 @@
 #pragma once
 #include <QString>
 #include <QObject>
+#include <QJsonObject>
 #include "CartaLib/CartaLib.h"
+#include <memory>
+#include <vector>
 
 namespace Carta {
     namespace Data {
+        class Controller;
         class ViewManager;
     }
+    namespace Lib {
+        namespace Image {
+            class ImageInterface;
+        }
+        namespace Regions {
+            class RegionBase;
+        }
+    }
 }
 
 namespace Carta {
@@ -260,6 +272,8 @@ public:
      *      if it is zoomed).
      * @param aspectRatioMode can be either "ignore", "keep", or "expand".
             See http://doc.qt.io/qt-5/qt.html#AspectRatioMode-enum for further information.
+     * @return an error message if the save could not be started; an empty string otherwise.
+     *      saveImageResult is emitted once for every call, including failed ones.
      */
     QStringList saveImage( const QString& controlId, const QString& filename,
             int width, int height, const QString& aspectRatioMode );
@@ -421,6 +435,73 @@ public:
      */
     QStringList getPixelValue( const QString& controlId, double x, double y );
 
+    /**
+     * Return the pixel values of a block of the selected image at full precision.
+     * @param controlId the unique server-side id of an object managing a controller.
+     * @param start the first pixel of the block along each image axis; missing axes start at 0.
+     * @param count the number of pixels of the block along each image axis; missing axes
+     *      and negative counts extend to the end of the axis.
+     * @param header set to describe the values: "shape" holds the size of the block, with
+     *      the first axis varying fastest in the values.
+     * @param values set to the pixel values of the block.
+     * @return an error message if the pixel values could not be obtained; an empty string otherwise.
+     */
+    QStringList getImageData( const QString& controlId, const std::vector<int>& start,
+            const std::vector<int>& count, QJsonObject& header, std::vector<double>& values );
+
+    /**
+     * Return the spectral profile of the selected image through pixel (x, y) at the
+     * current Stokes frame.
+     * @param controlId the unique server-side id of an object managing a controller.
+     * @param x the x-coordinate of the pixel.
+     * @param y the y-coordinate of the pixel.
+     * @param header set to describe the values: "shape" holds the number of channels.
+     * @param values set to the pixel value in each channel.
+     * @return an error message if the profile could not be obtained; an empty string otherwise.
+     */
+    QStringList getSpectralProfileData( const QString& controlId, int x, int y,
+            QJsonObject& header, std::vector<double>& values );
+
+    /**
+     * Return the region statistics of the images at the current frames.
+     * @param controlId the unique server-side id of an object managing a controller.
+     * @param header set to describe the values: "shape" holds the number of rows and
+     *      columns, "columns" the name of each statistic, and "rows" the image index and
+     *      statistics set of each row (set 0 holds image statistics, set r + 1 those of region r).
+     * @param values set to the statistics, row by row; NaN where a statistic is missing.
+     * @return an error message if the statistics could not be obtained; an empty string otherwise.
+     */
+    QStringList getRegionStatsData( const QString& controlId,
+            QJsonObject& header, std::vector<double>& values );
+
+    /**
+     * Return the statistics of all the regions of the selected image at the current
+     * frames, computed together in one pass over the plane.
+     * @param controlId the unique server-side id of an object managing a controller.
+     * @param header set to describe the values: "shape" holds the number of columns and
+     *      regions, and "columns" the name of each statistic.
+     * @param values set to the statistics, column by column, with a value for each
+     *      region; NaN where a region does not cover any valid pixels.
+     * @return an error message if the statistics could not be obtained; an empty string otherwise.
+     */
+    QStringList getRegionStatsColumns( const QString& controlId,
+            QJsonObject& header, std::vector<double>& values );
+
+    /**
+     * Return the spectral profiles of all the regions of the selected image at the
+     * current Stokes frame, computed together in one pass over each plane.
+     * @param controlId the unique server-side id of an object managing a controller.
+     * @param statistic how the pixels of a region are combined in each channel: one of
+     *      "mean", "sum", "flux", "rms", "variance", "min", or "max".
+     * @param header set to describe the values: "shape" holds the number of regions and
+     *      channels.
+     * @param values set to the profiles, region by region; NaN in the channels where a
+     *      region does not cover any valid pixels.
+     * @return an error message if the profiles could not be obtained; an empty string otherwise.
+     */
+    QStringList getRegionProfilesData( const QString& controlId, const QString& statistic,
+            QJsonObject& header, std::vector<double>& values );
+
     /**
      * Return the units of the pixels.
      * @param controlId the unique server-side id of an object managing a controller.
@@ -581,6 +662,17 @@ public:
      */
     QStringList getIntensity( const QString& controlId, int frameLow, int frameHigh, double percentile );
 
+    /**
+     * Return the (value,count) pairs of the histograms that have been computed.
+     * @param histogramId the unique server-side id of an object managing a histogram.
+     * @param header set to describe the values: "shape" holds the number of pairs and 2,
+     *      "names" and "lengths" the name and number of pairs of each histogram, in order.
+     * @param values set to the (value,count) pairs of all histograms.
+     * @return an error message if the histograms could not be obtained; an empty string otherwise.
+     */
+    QStringList getHistogramData( const QString& histogramId,
+            QJsonObject& header, std::vector<double>& values );
+
     /**
      * Set the number of bins in the histogram.
      * @param histogramId the unique server-side id of an object managing a histogram.
@@ -1042,6 +1134,8 @@ private:
     QString getHistogramViewId( int index = -1 ) const;
 
     Carta::State::CartaObject* _getObject( const QString& id );
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> _getSelectedImage( Carta::Data::Controller* controller );
+    std::vector< std::shared_ptr<Carta::Lib::Regions::RegionBase> > _getRegions( Carta::Data::Controller* controller );
     QStringList _logErrorMessage( const QString& key, const QString& value );
 
     const static QString TOGGLE;
@@ -5,6 +5,8 @@
 #include "Listener.h"
 #include "ScriptedCommandInterpreter.h"
 
+#include <stdexcept>
+
 namespace Carta
 {
 namespace Core
@@ -25,13 +27,6 @@ ScriptedCommandInterpreter::ScriptedCommandInterpreter( int port, QObject * pare
              this, & ScriptedCommandInterpreter::asyncMessageReceivedCB );
 }
 
-/// The bulk of this method is a massive if/else if/.../else statement.
-/// It's not pretty, but it works. So far I have been unable to come up
-/// with a way of simplifying it that doesn't just make it needlessly
-/// complex.
-/// In order to make it more readable, I have tried to include some
-/// extra comments about the commands, and also to group the commands
-/// according to which Python classes they relate to.
 void
 ScriptedCommandInterpreter::tagMessageReceivedCB( TagMessage tm )
 {
@@ -50,10 +45,90 @@ ScriptedCommandInterpreter::tagMessageReceivedCB( TagMessage tm )
     // Arguments will be parsed according to the command name.
     QString cmd = jo["cmd"].toString().toLower();
     auto args = jo["args"].toObject();
-    QStringList result;
+    // A client pipelining several requests tags each of them with an id,
+    // which is copied into the reply so the client can match them up.
+    QJsonValue requestId = jo.value( "id" );
+
+    QJsonObject rjo;
+    if ( cmd == "batch" ) {
+        rjo = runBatch( args["commands"].toArray() );
+    }
+    else {
+        CommandResult commandResult = runCommand( cmd, args );
+        if ( commandResult.binary && commandResult.key != "error" ) {
+            if ( ! requestId.isUndefined() ) {
+                commandResult.binaryHeader.insert( "id", requestId );
+            }
+            BinaryMessage rbm = BinaryMessage( commandResult.binaryHeader, commandResult.binaryValues );
+            try {
+                m_messageListener->send( rbm.toTagMessage() );
+                return;
+            }
+            catch ( const std::runtime_error & err ) {
+                commandResult.key = "error";
+                commandResult.values = QStringList( err.what() );
+            }
+        }
+        rjo.insert( commandResult.key, QJsonValue::fromVariant( commandResult.values ) );
+    }
+    if ( ! requestId.isUndefined() ) {
+        rjo.insert( "id", requestId );
+    }
+    JsonMessage rjm = JsonMessage( QJsonDocument( rjo ) );
+    m_messageListener->send( rjm.toTagMessage() );
+} // tagMessageReceivedCB
+
+QJsonObject
+ScriptedCommandInterpreter::runBatch( const QJsonArray & commands )
+{
+    // Every command runs, in order, whether or not the ones before it failed.
+    QJsonArray results;
+    for ( auto command : commands ) {
+        QJsonObject co = command.toObject();
+        CommandResult commandResult = runCommand( co["cmd"].toString().toLower(), co["args"].toObject() );
+        QJsonObject entry;
+        if ( commandResult.binary && commandResult.key != "error" ) {
+            // arrays of numbers are included in the batch reply as json numbers
+            QJsonArray values;
+            for ( double value : commandResult.binaryValues ) {
+                values.append( value );
+            }
+            commandResult.binaryHeader.insert( "values", values );
+            entry.insert( commandResult.key, commandResult.binaryHeader );
+        }
+        else {
+            entry.insert( commandResult.key, QJsonValue::fromVariant( commandResult.values ) );
+        }
+        if ( co.contains( "id" ) ) {
+            entry.insert( "id", co["id"] );
+        }
+        results.append( entry );
+    }
+    QJsonObject rjo;
+    rjo.insert( "result", results );
+    return rjo;
+} // runBatch
+
+/// The bulk of this method is a massive if/else if/.../else statement.
+/// It's not pretty, but it works. So far I have been unable to come up
+/// with a way of simplifying it that doesn't just make it needlessly
+/// complex.
+/// In order to make it more readable, I have tried to include some
+/// extra comments about the commands, and also to group the commands
+/// according to which Python classes they relate to.
+ScriptedCommandInterpreter::CommandResult
+ScriptedCommandInterpreter::runCommand( const QString & cmd, const QJsonObject & args )
+{
+    CommandResult commandResult;
+    QStringList & result = commandResult.values;
     // By default, assume that we will be sending a proper result back.
     // If an error occurs, key will be set to "error".
-    QString key = "result";
+    QString & key = commandResult.key;
+    // Commands returning arrays of numbers fill these, and a successful result
+    // is sent back as a BinaryMessage rather than json.
+    bool & binary = commandResult.binary;
+    QJsonObject & binaryHeader = commandResult.binaryHeader;
+    std::vector<double> & binaryValues = commandResult.binaryValues;
 
     /// Section: Application Commands
     /// -----------------------------
@@ -771,21 +846,71 @@ ScriptedCommandInterpreter::tagMessageReceivedCB( TagMessage tm )
         result = m_scriptFacade->saveHistogram( histogramView, filename, width, height, aspectStr );
     }
 
+    /// Section: Bulk Data Commands
+    /// ----------------------------
+    /// These commands come from the Python Image and Histogram classes.
+    /// They return pixel data, profiles, histograms and statistics as
+    /// raw little endian doubles, so a script gets all the values at full
+    /// precision in a single reply.
+
+    else if ( cmd == "getimagedata" ) {
+        QString imageView = args["imageView"].toString();
+        std::vector<int> start;
+        for ( auto value : args["start"].toArray() ) {
+            start.push_back( value.toInt() );
+        }
+        std::vector<int> count;
+        for ( auto value : args["count"].toArray() ) {
+            count.push_back( value.toInt() );
+        }
+        result = m_scriptFacade->getImageData( imageView, start, count, binaryHeader, binaryValues );
+        binary = true;
+    }
+
+    else if ( cmd == "getspectralprofiledata" ) {
+        QString imageView = args["imageView"].toString();
+        int x = args["x"].toInt();
+        int y = args["y"].toInt();
+        result = m_scriptFacade->getSpectralProfileData( imageView, x, y, binaryHeader, binaryValues );
+        binary = true;
+    }
+
+    else if ( cmd == "getregionstatsdata" ) {
+        QString imageView = args["imageView"].toString();
+        result = m_scriptFacade->getRegionStatsData( imageView, binaryHeader, binaryValues );
+        binary = true;
+    }
+
+    else if ( cmd == "getregionstatscolumns" ) {
+        QString imageView = args["imageView"].toString();
+        result = m_scriptFacade->getRegionStatsColumns( imageView, binaryHeader, binaryValues );
+        binary = true;
+    }
+
+    else if ( cmd == "getregionprofilesdata" ) {
+        QString imageView = args["imageView"].toString();
+        QString statistic = args["statistic"].toString();
+        result = m_scriptFacade->getRegionProfilesData( imageView, statistic, binaryHeader, binaryValues );
+        binary = true;
+    }
+
+    else if ( cmd == "gethistogramdata" ) {
+        QString histogramView = args["histogramView"].toString();
+        result = m_scriptFacade->getHistogramData( histogramView, binaryHeader, binaryValues );
+        binary = true;
+    }
+
     else {
         qDebug() << "Unknown command " + cmd+", sending error back";
         key = "error";
         result.append("Unknown command");
     }
 
-    if ( result[0] == "error" ) {
+    if ( ! result.isEmpty() && result[0] == "error" ) {
         key = "error";
     }
-
-    QJsonObject rjo;
-    rjo.insert( key, QJsonValue::fromVariant( result ) );
-    JsonMessage rjm = JsonMessage( QJsonDocument( rjo ) );
-    m_messageListener->send( rjm.toTagMessage() );
-} // tagMessageReceivedCB
+    return commandResult;
+} // runCommand
 
 void
 ScriptedCommandInterpreter::asyncMessageReceivedCB( TagMessage tm )
@@ -802,12 +927,14 @@ ScriptedCommandInterpreter::asyncMessageReceivedCB( TagMessage tm )
     }
 
     connect( m_scriptFacade, & ScriptFacade::saveImageResult,
-             this, & ScriptedCommandInterpreter::saveImageResultCB );
+             this, & ScriptedCommandInterpreter::saveImageResultCB, Qt::UniqueConnection );
 
     QJsonObject jo = jm.doc().object();
     QString cmd = jo["cmd"].toString().toLower();
     auto args = jo["args"].toObject();
     if ( cmd == "saveimage" ) {
+        // every save reports exactly one result, in the order they were requested
+        m_asyncRequestIds.enqueue( jo.value( "id" ) );
         QString imageView = args["imageView"].toString();
         QString filename = args["filename"].toString();
         int width = args["width"].toInt();
@@ -819,8 +946,10 @@ ScriptedCommandInterpreter::asyncMessageReceivedCB( TagMessage tm )
 } // asyncMessageReceivedCB
 
 void ScriptedCommandInterpreter::saveImageResultCB( bool saveResult ){
-    disconnect( m_scriptFacade, & ScriptFacade::saveImageResult,
-             this, & ScriptedCommandInterpreter::saveImageResultCB );
+    QJsonValue requestId( QJsonValue::Undefined );
+    if ( ! m_asyncRequestIds.isEmpty() ) {
+        requestId = m_asyncRequestIds.dequeue();
+    }
 
     QJsonObject rjo;
     QStringList result("");
@@ -830,6 +959,9 @@ void ScriptedCommandInterpreter::saveImageResultCB( bool saveResult ){
         result[0] = "Could not save image.";
     }
     rjo.insert( key, QJsonValue::fromVariant( result ) );
+    if ( ! requestId.isUndefined() ) {
+        rjo.insert( "id", requestId );
+    }
     JsonMessage rjm = JsonMessage( QJsonDocument( rjo ) );
     m_messageListener->send( rjm.toTagMessage() );
 }
@@ -9,12 +9,15 @@
 #include "Listener.h"
 #include "TagMessage.h"
 #include "JsonMessage.h"
+#include "BinaryMessage.h"
 #include <QTcpServer>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QQueue>
 #include <QDir>
 #include <memory>
+#include <vector>
 
 namespace Carta
 {
@@ -51,7 +54,32 @@ private slots:
 
 private:
 
+    /// the outcome of a single command
+    struct CommandResult {
+        /// "result", or "error" if the command failed
+        QString key = "result";
+        QStringList values;
+        /// set by commands returning arrays of numbers, which are sent back
+        /// as a BinaryMessage described by binaryHeader
+        bool binary = false;
+        QJsonObject binaryHeader;
+        std::vector < double > binaryValues;
+    };
+
+    /// run one command and collect its result
+    CommandResult
+    runCommand( const QString & cmd, const QJsonObject & args );
+
+    /// run an ordered list of {cmd, args, id} commands; the reply holds a
+    /// result, or error, for each of them in the same order
+    QJsonObject
+    runBatch( const QJsonArray & commands );
+
     std::unique_ptr < MessageListener > m_messageListener = nullptr;
+
+    /// ids of the pending asynchronous requests, oldest first; each reply takes
+    /// the id at the front
+    QQueue < QJsonValue > m_asyncRequestIds;
 };
 }
 }
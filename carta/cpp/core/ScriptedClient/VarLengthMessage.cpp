@@ -3,6 +3,9 @@
  **/
 
 #include "VarLengthMessage.h"
+#include <QDebug>
+#include <cstring>
+#include <stdexcept>
 
 namespace Carta
 {
@@ -30,14 +33,26 @@ VarLengthSocket::send( const Carta::Core::ScriptedClient::VarLengthMessage & dat
 void
 VarLengthSocket::socketCB()
 {
-    VarLengthMessage buff;
-    qint64 size;
-    readNBytes( 8, & size );
-    size = qFromLittleEndian( size );
-    buff.resize( size );
-    readNBytes( size, buff.data() );
-
-    emit received( buff );
+    // A client pipelining its requests may send several messages before we
+    // get to read any of them, and a large message may arrive in pieces, so
+    // the data is collected here and every complete message in it emitted.
+    m_buffer.append( m_rawSocket-> readAll() );
+    while ( m_buffer.size() >= 8 ) {
+        qint64 size;
+        memcpy( & size, m_buffer.constData(), 8 );
+        size = qFromLittleEndian( size );
+        if ( size < 0 ) {
+            qWarning() << "Discarding data with invalid message size" << size;
+            m_buffer.clear();
+            return;
+        }
+        if ( m_buffer.size() - 8 < size ) {
+            break;
+        }
+        VarLengthMessage buff = m_buffer.mid( 8, size );
+        m_buffer.remove( 0, 8 + size );
+        emit received( buff );
+    }
 }
 
 void
@@ -54,21 +69,6 @@ VarLengthSocket::sendNBytes( qint64 n, const void * data )
         ptr += written;
     }
 }
-
-void
-VarLengthSocket::readNBytes( qint64 n, void * dest )
-{
-    qint64 remaining = n;
-    char * ptr = reinterpret_cast < char * > ( dest );
-    while ( remaining > 0 ) {
-        auto n = m_rawSocket-> read( ptr, remaining );
-        if ( n < 0 ) {
-            throw std::runtime_error( "closed socket?" );
-        }
-        remaining -= n;
-        ptr += n;
-    }
-}
 }
 }
 }
@@ -61,17 +61,11 @@ private:
     void
     sendNBytes( qint64 n, const void * data );
 
-    /// Reads n bytes from a socket and puts the result into memory pointed to by dest. This
-    /// memory must be allocated by the caller. The method does not return until all n bytes
-    /// have been read. If there is an error reading the socket, exception is thrown.
-    /// \param n number of bytes to read
-    /// \param dest where to store the data read
-    ///
-    void
-    readNBytes( qint64 n, void * dest );
-
     /// pointer to the actual raw socket
     std::shared_ptr < QTcpSocket > m_rawSocket = nullptr;
+
+    /// data received but not yet emitted as a complete message
+    QByteArray m_buffer;
 };
 }
 }
@@ -18,6 +18,10 @@ void ControlPointEditable::_editShadow( const QPointF& /*pt*/ ){
 }
 
 
+QRectF ControlPointEditable::getBoundingBox() const {
+	return QRectF( m_pos.x() - m_size, m_pos.y() - m_size, 2 * m_size, 2 * m_size );
+}
+
 QPointF ControlPointEditable::getCenter() const {
 	return m_pos;
 }
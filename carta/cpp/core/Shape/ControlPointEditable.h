@@ -32,6 +32,12 @@ public:
      */
     virtual void editModeChanged() override;
 
+    /**
+     * Return the box in which points are inside the control point.
+     * @return - the box in which points are inside the control point.
+     */
+    QRectF getBoundingBox() const override;
+
     /**
      * Return the location of the point.
      * @return - the location of the point.
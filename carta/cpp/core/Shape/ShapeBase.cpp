@@ -26,6 +26,17 @@ void ShapeBase::editModeChanged(){
 	}
 }
 
+QRectF ShapeBase::getBoundingBox() const {
+	QSizeF size = getSize();
+	QPointF center = getCenter();
+	QRectF box( center.x() - size.width() / 2, center.y() - size.height() / 2,
+			size.width(), size.height() );
+	for ( auto & pt : m_controlPoints ) {
+		box = box.united( pt->getBoundingBox() );
+	}
+	return box;
+}
+
 QString ShapeBase::getCursor() const {
 	return m_cursor;
 }
@@ -40,6 +51,11 @@ Carta::Lib::VectorGraphics::VGList ShapeBase::getVGList() const {
 }
 
 
+QJsonObject ShapeBase::_getShadowModel() const {
+	return QJsonObject();
+}
+
+
 void * ShapeBase::getUserData() const {
 	return m_userData;
 }
@@ -66,6 +82,12 @@ void ShapeBase::handleDrag( const QPointF & pt ){
 			_editShadow( pt );
 		}
 	}
+	if ( !isEditMode() ){
+		QJsonObject shadowModel = _getShadowModel();
+		if ( !shadowModel.isEmpty() ){
+			emit shapeDragged( shadowModel );
+		}
+	}
 }
 
 void ShapeBase::handleDragDone( const QPointF & pt ) {
@@ -51,6 +51,13 @@ public:
 	 */
 	bool isDeletable() const;
 
+	/**
+	 * Return a box containing the shape and its control points; every point for
+	 * which isPointInside() is true lies in the box.
+	 * @return - a box containing the shape and its control points.
+	 */
+	virtual QRectF getBoundingBox() const;
+
 	/**
 	 * Return the center of the bounding box containing the shape.
 	 * @return - the center of the bounding box containing the shape.
@@ -173,8 +180,21 @@ signals:
 
 	void shapeChanged( const QJsonObject& jsonObj );
 
+	/**
+	 * Notification that the shape is being moved or resized.
+	 * @param jsonObj - the model the shape would have if the drag ended here.
+	 */
+	void shapeDragged( const QJsonObject& jsonObj );
+
 protected:
 	virtual void _editShadow( const QPointF& pt ) = 0;
+
+	/**
+	 * Returns the model matching the shadow of a shape that is being dragged.
+	 * @return - the shadow model; an empty object if the shape does not report drags.
+	 */
+	virtual QJsonObject _getShadowModel() const;
+
 	virtual void _moveShadow( const QPointF& pt ) = 0;
 	virtual void _syncShadowToCPs() = 0;
 	const static QPen shadowPen;
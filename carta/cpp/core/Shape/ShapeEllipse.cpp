@@ -41,6 +41,22 @@ void ShapeEllipse::_editShadow( const QPointF & pt ){
 	m_shadowRect.setBottomRight( pt );
 }
 
+QJsonObject ShapeEllipse::_getShadowModel() const {
+	QRectF rect = m_shadowRect.normalized();
+	Carta::Lib::Regions::Ellipse shadowRegion( rect.center(), rect.width() / 2, rect.height() / 2, 0 );
+	return shadowRegion.toJson();
+}
+
+QRectF ShapeEllipse::getBoundingBox() const {
+	QPointF center = m_ellipseRegion->getCenter();
+	double radius = qMax( m_ellipseRegion->getRadiusMajor(), m_ellipseRegion->getRadiusMinor() );
+	QRectF box( center.x() - radius, center.y() - radius, 2 * radius, 2 * radius );
+	for ( auto & pt : m_controlPoints ) {
+		box = box.united( pt->getBoundingBox() );
+	}
+	return box;
+}
+
 QPointF ShapeEllipse::getCenter() const {
 	return m_ellipseRegion->getCenter();
 }
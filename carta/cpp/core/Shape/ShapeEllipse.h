@@ -30,6 +30,12 @@ public:
      */
     ShapeEllipse( );
 
+    /**
+     * Return a box containing the ellipse, at any tilt, and its control points.
+     * @return - a box containing the ellipse and its control points.
+     */
+    virtual QRectF getBoundingBox() const override;
+
     /**
      * Return the center of the ellipse.
      * @return - the center of the ellipse.
@@ -84,6 +90,8 @@ protected:
 
     void _updateEllipseFromShadow();
 
+    virtual QJsonObject _getShadowModel() const override;
+
     virtual void _editShadow( const QPointF & pt ) override;
 
     std::shared_ptr<Carta::Lib::Regions::Ellipse> m_ellipseRegion;
@@ -37,6 +37,12 @@ void ShapeRectangle::_controlPointCB( int index, bool final ){
 	}
 }
 
+QJsonObject ShapeRectangle::_getShadowModel() const {
+	Carta::Lib::Regions::Rectangle shadowRegion;
+	shadowRegion.setRectangle( m_shadowRect.normalized() );
+	return shadowRegion.toJson();
+}
+
 QPointF ShapeRectangle::getCenter() const {
 	return m_rectRegion->outlineBox().center();
 }
@@ -76,6 +76,8 @@ protected:
 
     void _controlPointCB( int index, bool final );
 
+    virtual QJsonObject _getShadowModel() const override;
+
     virtual void _editShadow( const QPointF& pt ) override;
 
     virtual void _moveShadow( const QPointF& pt ) override;
@@ -42,7 +42,7 @@ HEADERS += \
     Data/Histogram/ChannelUnits.h \
     Data/Histogram/PlotStyles.h \
     Data/Histogram/Render/HistogramRenderService.h \
-    Data/Histogram/Render/HistogramRenderThread.h \
+    Data/Compute/ComputePool.h \
     Data/Histogram/Render/HistogramRenderWorker.h \
     Data/Histogram/Render/HistogramRenderRequest.h \
     Data/ILinkable.h \
@@ -63,6 +63,7 @@ HEADERS += \
     Data/Image/Contour/GeneratorState.h \
     Data/Image/CoordinateSystems.h \
     Data/Image/DataSource.h \
+    Data/Image/FramePrefetcher.h \
     Data/Image/Draw/DrawGroupSynchronizer.h \
     Data/Image/Draw/DrawImageViewsSynchronizer.h \
     Data/Image/Draw/DrawSynchronizer.h \
@@ -82,6 +83,7 @@ HEADERS += \
     Data/Image/Save/SaveService.h \
     Data/Image/Save/SaveView.h \
     Data/Image/Save/SaveViewLayered.h \
+    Data/Image/Save/TiledImageWriter.h \
     Data/Selection.h \
     Data/Layout/Layout.h \
     Data/Layout/LayoutNode.h \
@@ -101,7 +103,6 @@ HEADERS += \
     Data/Profile/ProfilePlotStyles.h \
     Data/Profile/Render/ProfileRenderRequest.h \
     Data/Profile/Render/ProfileRenderService.h \
-    Data/Profile/Render/ProfileRenderThread.h \
     Data/Profile/Render/ProfileRenderWorker.h \
     Data/Profile/ProfileStatistics.h \
     Data/Profile/GenerateModes.h \
@@ -112,12 +113,14 @@ HEADERS += \
     Data/Region/RegionPoint.h \
     Data/Region/RegionRectangle.h \
     Data/Region/RegionFactory.h \
+    Data/Region/RegionIndex.h \
     Data/Region/RegionTypes.h \
     Data/Snapshot/ISnapshotsImplementation.h \
     Data/Snapshot/Snapshots.h \
     Data/Snapshot/Snapshot.h \
     Data/Snapshot/SnapshotsFile.h \
     Data/Statistics/Statistics.h \
+    Data/Statistics/StatisticsCache.h \
     Data/Units/UnitsFrequency.h \
     Data/Units/UnitsIntensity.h \
     Data/Units/UnitsSpectral.h \
@@ -153,6 +156,7 @@ HEADERS += \
     ScriptedClient/VarLengthMessage.h \
     ScriptedClient/TagMessage.h \
     ScriptedClient/JsonMessage.h \
+    ScriptedClient/BinaryMessage.h \
     DefaultContourGeneratorService.h \
     Hacks/HackViewer.h \
     Hacks/ImageViewController.h \
@@ -209,6 +213,7 @@ SOURCES += \
     Data/Image/Contour/GeneratorState.cpp \
     Data/Image/CoordinateSystems.cpp \
     Data/Image/DataSource.cpp \
+    Data/Image/FramePrefetcher.cpp \
     Data/Image/Grid/AxisMapper.cpp \
     Data/Image/Grid/DataGrid.cpp \
     Data/Image/Grid/Fonts.cpp \
@@ -227,6 +232,7 @@ SOURCES += \
     Data/Image/Save/SaveService.cpp \
     Data/Image/Save/SaveView.cpp \
     Data/Image/Save/SaveViewLayered.cpp \
+    Data/Image/Save/TiledImageWriter.cpp \
     Data/DataLoader.cpp \
     Data/Error/ErrorReport.cpp \
     Data/Error/ErrorManager.cpp \
@@ -234,7 +240,7 @@ SOURCES += \
     Data/Histogram/Histogram.cpp \
     Data/Histogram/ChannelUnits.cpp \
     Data/Histogram/Render/HistogramRenderService.cpp \
-    Data/Histogram/Render/HistogramRenderThread.cpp \
+    Data/Compute/ComputePool.cpp \
     Data/Histogram/Render/HistogramRenderWorker.cpp \
     Data/Histogram/Render/HistogramRenderRequest.cpp \
     Data/Histogram/PlotStyles.cpp \
@@ -257,7 +263,6 @@ SOURCES += \
     Data/Profile/ProfilePlotStyles.cpp \
     Data/Profile/Render/ProfileRenderRequest.cpp \
     Data/Profile/Render/ProfileRenderService.cpp \
-    Data/Profile/Render/ProfileRenderThread.cpp \
     Data/Profile/Render/ProfileRenderWorker.cpp \
     Data/Profile/ProfileStatistics.cpp \
     Data/Profile/GenerateModes.cpp \
@@ -267,12 +272,14 @@ SOURCES += \
     Data/Region/RegionPolygon.cpp \
     Data/Region/RegionEllipse.cpp \
     Data/Region/RegionFactory.cpp \
+    Data/Region/RegionIndex.cpp \
     Data/Region/RegionRectangle.cpp \
     Data/Region/RegionTypes.cpp \
     Data/Snapshot/Snapshots.cpp \
     Data/Snapshot/Snapshot.cpp \
     Data/Snapshot/SnapshotsFile.cpp \
     Data/Statistics/Statistics.cpp \
+    Data/Statistics/StatisticsCache.cpp \
     Data/Units/UnitsFrequency.cpp \
     Data/Units/UnitsIntensity.cpp \
     Data/Units/UnitsSpectral.cpp \
@@ -308,6 +315,7 @@ SOURCES += \
     ScriptedClient/VarLengthMessage.cpp \
     ScriptedClient/TagMessage.cpp \
     ScriptedClient/JsonMessage.cpp \
+    ScriptedClient/BinaryMessage.cpp \
     DefaultContourGeneratorService.cpp \
     Hacks/HackViewer.cpp \
     Hacks/ImageViewController.cpp \
@@ -353,4 +361,7 @@ else {
 	LIBS +=-L../CartaLib -lCartaLib -L$$QWT_ROOT/lib -lqwt
 }
 
+# zlib is used to stream large images to PNG files
+LIBS += -lz
+
 DEPENDPATH += $$PROJECT_ROOT/CartaLib
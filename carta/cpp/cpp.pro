@@ -7,6 +7,7 @@ SUBDIRS = \
     CartaLib \
     core \
     desktop \
+    batch \
     plugins \
     Tests \
     testCache \
@@ -20,6 +21,7 @@ isEmpty(NOSERVER) {
 # explicit dependencies, to make sure parallel make works (i.e. make -j4...)
 core.depends = CartaLib
 desktop.depends = core
+batch.depends = core
 server.depends = core
 testRegion.depends = core
 plugins.depends = core
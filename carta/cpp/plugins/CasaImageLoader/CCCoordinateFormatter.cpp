@@ -230,6 +230,46 @@ CCCoordinateFormatter::toPixel( const CoordinateFormatterInterface::VD & world,
     return valid;
 }
 
+bool
+CCCoordinateFormatter::toWorldMany( const CoordinateFormatterInterface::VD & pixels,
+                                    CoordinateFormatterInterface::VD & world,
+                                    std::vector < bool > & failures ) const
+{
+    // the points are stored one after another, which is exactly the memory layout
+    // of a casacore (nAxes x nPoints) matrix, so we can share the input buffer
+    int nPix = m_casaCS->nPixelAxes();
+    CARTA_ASSERT( nPix > 0 );
+    size_t nPoints = pixels.size() / nPix;
+    casacore::Matrix < casacore::Double > pixelM(
+        casacore::IPosition( 2, nPix, nPoints ),
+        const_cast < double * > ( pixels.data() ), casacore::SHARE );
+    casacore::Matrix < casacore::Double > worldM;
+    casacore::Vector < casacore::Bool > failuresV;
+    bool valid = m_casaCS->toWorldMany( worldM, pixelM, failuresV );
+    world.assign( worldM.begin(), worldM.end() );
+    failures.assign( failuresV.begin(), failuresV.end() );
+    return valid;
+}
+
+bool
+CCCoordinateFormatter::toPixelMany( const CoordinateFormatterInterface::VD & world,
+                                    CoordinateFormatterInterface::VD & pixels,
+                                    std::vector < bool > & failures ) const
+{
+    int nWorld = m_casaCS->nWorldAxes();
+    CARTA_ASSERT( nWorld > 0 );
+    size_t nPoints = world.size() / nWorld;
+    casacore::Matrix < casacore::Double > worldM(
+        casacore::IPosition( 2, nWorld, nPoints ),
+        const_cast < double * > ( world.data() ), casacore::SHARE );
+    casacore::Matrix < casacore::Double > pixelM;
+    casacore::Vector < casacore::Bool > failuresV;
+    bool valid = m_casaCS->toPixelMany( pixelM, worldM, failuresV );
+    pixels.assign( pixelM.begin(), pixelM.end() );
+    failures.assign( failuresV.begin(), failuresV.end() );
+    return valid;
+}
+
 void
 CCCoordinateFormatter::setTextOutputFormat( CoordinateFormatterInterface::TextFormat fmt )
 {
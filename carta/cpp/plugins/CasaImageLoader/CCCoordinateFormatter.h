@@ -44,6 +44,12 @@ public:
     virtual bool
     toPixel( const VD & world, VD & pixel ) const override;
 
+    virtual bool
+    toWorldMany( const VD & pixels, VD & world, std::vector < bool > & failures ) const override;
+
+    virtual bool
+    toPixelMany( const VD & world, VD & pixels, std::vector < bool > & failures ) const override;
+
     virtual void
     setTextOutputFormat( TextFormat fmt ) override;
 
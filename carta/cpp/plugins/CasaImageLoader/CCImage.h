@@ -10,10 +10,13 @@
 #include "CCRawView.h"
 #include "CCMetaDataInterface.h"
 #include "casacore/images/Images/ImageInterface.h"
+#include "casacore/images/Images/ImageOpener.h"
 #include "casacore/images/Images/ImageUtilities.h"
 #include "casacore/images/Images/TempImage.h"
 
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
 #include <memory>
 #include <set>
 
@@ -100,6 +103,7 @@ public:
         }
 
         //Make a new image and copy the data into it.
+        QMutexLocker locker( accessMutex() );
         casacore::ImageInterface<PType>* newImage = new casacore::TempImage<PType>(casacore::TiledShape( newShape), coordSys);
         casacore::Array<PType> dataCopy = m_casaII->get();
         newImage->put( reorderArray( dataCopy, newOrder ));
@@ -196,6 +200,11 @@ public:
         img-> m_casaII    = casaImage;
         img-> m_unit      = Carta::Lib::Unit( casaImage-> units().getName().c_str() );
 
+        // images that cannot be reopened are read by one thread at a time
+        if ( ! casaImage-> isPersistent() ) {
+            img-> m_accessMutex.reset( new QMutex( QMutex::Recursive ) );
+        }
+
         // get title and escape html characters in case there are any
         QString htmlTitle = casaImage->imageInfo().objectName().c_str();
         htmlTitle = htmlTitle.toHtmlEscaped();
@@ -228,6 +237,32 @@ public:
         return m_casaII;
     }
 
+    /// casacore images on disk cannot be read from several threads through the same
+    /// object, so every thread gets its own copy, reopened from the file; images in
+    /// memory cannot be reopened (cloneII() would share their storage), so nullptr
+    /// is returned for them and their readers take turns through accessMutex()
+    virtual std::shared_ptr<Carta::Lib::Image::ImageInterface>
+    cloneForThread() override
+    {
+        if ( ! m_casaII-> isPersistent() ) {
+            return nullptr;
+        }
+        casacore::LatticeBase * lat = casacore::ImageOpener::openImage( m_casaII-> name() );
+        casacore::ImageInterface < PType > * clone =
+            dynamic_cast < casacore::ImageInterface < PType > * > ( lat );
+        if ( ! clone ) {
+            delete lat;
+            return nullptr;
+        }
+        return create( clone );
+    }
+
+    virtual QMutex *
+    accessMutex() override
+    {
+        return m_accessMutex.get();
+    }
+
     casacore::ImageInfo getImageInfo() const override{
                return m_casaII->imageInfo();
            }
@@ -267,6 +302,9 @@ protected:
     /// meta data pointer
     CCMetaDataInterface::SharedPtr m_meta;
 
+    /// serializes reads of images that are not persistent; nullptr for the others
+    std::unique_ptr < QMutex > m_accessMutex;
+
     /// we want CCRawView to access our internals...
     /// \todo maybe we just need a public accessor, no? I don't like friends :) (Pavol)
     friend class CCRawView < PType >;
@@ -173,20 +173,52 @@ public:
     src2dst( const Carta::Lib::Regions::PointN & pt,
              Carta::Lib::Regions::PointN & result ) override
     {
-        /// \todo implement
-        Q_UNUSED( pt );
-        Q_UNUSED( result );
-        return false;
+        std::vector < bool > failures;
+        return src2dstMany( pt, result, failures );
     }
 
     virtual bool
     dst2src( const Carta::Lib::Regions::PointN & pt,
              Carta::Lib::Regions::PointN & result ) override
     {
-        /// \todo implement
-        Q_UNUSED( pt );
-        Q_UNUSED( result );
-        return false;
+        std::vector < bool > failures;
+        return dst2srcMany( pt, result, failures );
+    }
+
+    /// pixel to world using casacore's vectorized toWorldMany()
+    virtual bool
+    src2dstMany( const std::vector < double > & pts, std::vector < double > & result,
+                 std::vector < bool > & failures ) override
+    {
+        // points stored one after another have the memory layout of a casacore
+        // (naxes x npoints) matrix, so the input buffer is shared, not copied
+        int nPix = m_casaCS-> nPixelAxes();
+        casacore::Matrix < casacore::Double > pixelM(
+            casacore::IPosition( 2, nPix, pts.size() / nPix ),
+            const_cast < double * > ( pts.data() ), casacore::SHARE );
+        casacore::Matrix < casacore::Double > worldM;
+        casacore::Vector < casacore::Bool > failuresV;
+        bool valid = m_casaCS-> toWorldMany( worldM, pixelM, failuresV );
+        result.assign( worldM.begin(), worldM.end() );
+        failures.assign( failuresV.begin(), failuresV.end() );
+        return valid;
+    }
+
+    /// world to pixel using casacore's vectorized toPixelMany()
+    virtual bool
+    dst2srcMany( const std::vector < double > & pts, std::vector < double > & result,
+                 std::vector < bool > & failures ) override
+    {
+        int nWorld = m_casaCS-> nWorldAxes();
+        casacore::Matrix < casacore::Double > worldM(
+            casacore::IPosition( 2, nWorld, pts.size() / nWorld ),
+            const_cast < double * > ( pts.data() ), casacore::SHARE );
+        casacore::Matrix < casacore::Double > pixelM;
+        casacore::Vector < casacore::Bool > failuresV;
+        bool valid = m_casaCS-> toPixelMany( pixelM, worldM, failuresV );
+        result.assign( pixelM.begin(), pixelM.end() );
+        failures.assign( failuresV.begin(), failuresV.end() );
+        return valid;
     }
 
     virtual const Carta::Lib::Regions::CompositeCoordinateSystem &
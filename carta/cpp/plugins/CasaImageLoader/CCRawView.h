@@ -8,6 +8,8 @@
 #include <casacore/lattices/Lattices/LatticeStepper.h>
 #include <casacore/lattices/Lattices/LatticeIterator.h>
 #include <casacore/casa/Arrays/IPosition.h>
+#include <casacore/casa/Arrays/Slicer.h>
+#include <QMutexLocker>
 #include <algorithm>
 
 template < typename PType >
@@ -100,19 +102,16 @@ public:
     /// yet another high performance accessor... similar to forEach above,
     /// but this time the supplied function gets called with whatever number
     /// elements that fit into the buffer
+    ///
+    /// The view is read with casacore getSlice() in slabs of at most buffSize
+    /// bytes, and the function is handed the storage of each slab, so the
+    /// buffer argument is not used.
     virtual void
     forEach(
         int64_t buffSize,
         std::function < void (const char *, int64_t count) > func,
         char * buff = nullptr,
-        Traversal traversal = Traversal::Sequential ) override
-    {
-        Q_UNUSED( buffSize );
-        Q_UNUSED( func );
-        Q_UNUSED( buff );
-        Q_UNUSED( traversal );
-        qFatal( "not implemented" );
-    }
+        Traversal traversal = Traversal::Sequential ) override;
 
 protected:
 
@@ -199,6 +198,7 @@ CCRawView < PType >::get( const Carta::Lib::NdArray::RawViewInterface::VI & pos
     // casacore::ImageInterface::operator() returns the result by value
     // so in order to return reference (to satisfy our API) we need to store this
     // in a buffer first...
+    QMutexLocker locker( m_ccimage-> accessMutex() );
     m_buff = m_ccimage-> m_casaII->
                  operator() ( m_destPos );
 
@@ -245,6 +245,7 @@ CCRawView < PType >::forEach(
         inc( i ) = slice1d.step;
     }
     stepper.subSection( blc, trc, inc );
+    QMutexLocker locker( m_ccimage-> accessMutex() );
     casacore::RO_LatticeIterator < PType > iterator( * casaII, stepper );
 
     for ( iterator.reset() ; ! iterator.atEnd() ; iterator++ ) {
@@ -255,6 +256,84 @@ CCRawView < PType >::forEach(
     }
 } // forEach
 
+template < typename PType >
+void
+CCRawView < PType >::forEach(
+    int64_t buffSize,
+    std::function < void (const char *, int64_t count) > func,
+    char * buff,
+    Carta::Lib::NdArray::RawViewInterface::Traversal traversal )
+{
+    Q_UNUSED( buff );
+    if ( traversal != Carta::Lib::NdArray::RawViewInterface::Traversal::Sequential ) {
+        qFatal( "sorry, not implemented yet" );
+    }
+    const int ndim = m_viewDims.size();
+    for ( int count : m_viewDims ) {
+        if ( count <= 0 ) {
+            return;
+        }
+    }
+    const int64_t chunkCount = std::max < int64_t > ( 1, buffSize / sizeof( PType ) );
+
+    // the leading axes that fit into a chunk are read whole, the next one is
+    // read a few entries at a time and the ones after it one entry at a time
+    int slabAxis = 0;
+    int64_t unit = 1;
+    while ( slabAxis < ndim && unit * m_viewDims[slabAxis] <= chunkCount ) {
+        unit *= m_viewDims[slabAxis];
+        slabAxis++;
+    }
+    if ( slabAxis == ndim ) {
+        slabAxis = ndim - 1;
+        unit /= m_viewDims[slabAxis];
+    }
+    const int thickness = std::max < int64_t > ( 1, std::min < int64_t > (
+                                                     chunkCount / unit, m_viewDims[slabAxis] ) );
+
+    const auto & sliceDims = m_appliedSlice.dims();
+    casacore::IPosition blc( ndim ), length( ndim ), inc( ndim );
+    VI pos( ndim, 0 );
+    while ( true ) {
+        for ( int i = 0 ; i < ndim ; i++ ) {
+            inc( i ) = sliceDims[i].step;
+            if ( i < slabAxis ) {
+                blc( i ) = sliceDims[i].start;
+                length( i ) = m_viewDims[i];
+            }
+            else {
+                blc( i ) = sliceDims[i].start + pos[i] * sliceDims[i].step;
+                length( i ) = i == slabAxis ? std::min( thickness, m_viewDims[i] - pos[i] ) : 1;
+            }
+        }
+        casacore::Slicer slicer( blc, length, inc, casacore::Slicer::endIsLength );
+        casacore::Array < PType > slab;
+        {
+            QMutexLocker locker( m_ccimage-> accessMutex() );
+            slab.reference( m_ccimage-> m_casaII-> getSlice( slicer ) );
+        }
+        bool deleteIt = false;
+        const PType * data = slab.getStorage( deleteIt );
+        int64_t total = slab.nelements();
+        for ( int64_t done = 0 ; done < total ; done += chunkCount ) {
+            func( reinterpret_cast < const char * > ( data + done ),
+                  std::min( chunkCount, total - done ) );
+        }
+        slab.freeStorage( data, deleteIt );
+
+        // next slab
+        int axis = slabAxis;
+        pos[axis] += thickness;
+        while ( pos[axis] >= m_viewDims[axis] ) {
+            pos[axis] = 0;
+            if ( ++axis == ndim ) {
+                return;
+            }
+            pos[axis]++;
+        }
+    }
+} // forEach
+
 template < typename PType >
 const Carta::Lib::NdArray::RawViewInterface::VI &
 CCRawView < PType >::currentPos()
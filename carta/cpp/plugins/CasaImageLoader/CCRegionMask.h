@@ -0,0 +1,104 @@
+/**
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/Regions/RegionMask.h"
+#include <casacore/casa/Arrays/Array.h>
+#include <casacore/coordinates/Coordinates/CoordinateSystem.h>
+#include <casacore/images/Regions/ImageRegion.h>
+#include <casacore/lattices/LRegions/LCBox.h>
+#include <casacore/lattices/LRegions/LCExtension.h>
+#include <casacore/lattices/LRegions/LCPixelSet.h>
+#include <QDebug>
+
+/// makes casacore regions out of the rasterized masks of region models, so the
+/// casacore based analysis covers exactly the pixels the native engines do
+class CCRegionMask
+{
+public:
+
+    /// make a region of an image that holds the pixels covered by a region model
+    /// on every plane of the image
+    /// \param shape the shape of the image
+    /// \param cs the coordinate system of the image
+    /// \param region the region model, in pixel coordinates of the direction axes
+    /// \return the region, owned by the caller, or nullptr if the image has no
+    /// direction axes or the region does not cover any of its pixels
+    static casacore::ImageRegion *
+    makeImageRegion( const casacore::IPosition & shape, const casacore::CoordinateSystem & cs,
+                     const Carta::Lib::Regions::RegionBase * region )
+    {
+        casacore::Vector < casacore::Int > displayAxes = cs.directionAxesNumbers();
+        if ( ! region || displayAxes.nelements() < 2 || displayAxes[0] < 0 || displayAxes[1] < 0 ) {
+            return nullptr;
+        }
+        int xAxis = displayAxes[0];
+        int yAxis = displayAxes[1];
+        Carta::Lib::Regions::RegionMask::ConstSharedPtr mask =
+            Carta::Lib::Regions::RegionMask::get( region, shape[xAxis], shape[yAxis] );
+        QRect box = mask-> boundingBox();
+        if ( box.isEmpty() ) {
+            return nullptr;
+        }
+
+        // the pixel set has the direction axes in the order they have in the image
+        bool swapped = yAxis < xAxis;
+        int first = swapped ? 1 : 0;
+        int second = 1 - first;
+        casacore::IPosition setShape( 2 ), blc( 2 ), trc( 2 ), planeShape( 2 );
+        setShape[first] = box.width();
+        setShape[second] = box.height();
+        blc[first] = box.left();
+        blc[second] = box.top();
+        trc[first] = box.right();
+        trc[second] = box.bottom();
+        planeShape[first] = shape[xAxis];
+        planeShape[second] = shape[yAxis];
+        std::vector < char > bitmap = mask-> toBitmap( box );
+        casacore::Array < casacore::Bool > pixels( setShape, casacore::False );
+        casacore::IPosition pos( 2 );
+        for ( int y = 0 ; y < box.height() ; y++ ) {
+            const char * row = bitmap.data() + static_cast < size_t > ( y ) * box.width();
+            pos[second] = y;
+            for ( int x = 0 ; x < box.width() ; x++ ) {
+                if ( row[x] ) {
+                    pos[first] = x;
+                    pixels( pos ) = casacore::True;
+                }
+            }
+        }
+
+        casacore::ImageRegion * imageRegion = nullptr;
+        try {
+            casacore::LCPixelSet pixelSet( pixels, casacore::LCBox( blc, trc, planeShape ) );
+            int dims = shape.nelements();
+            if ( dims == 2 ) {
+                imageRegion = new casacore::ImageRegion( pixelSet );
+            }
+            else {
+                // the same pixels on every plane
+                casacore::IPosition extendAxes( dims - 2 ), extendBlc( dims - 2 );
+                casacore::IPosition extendTrc( dims - 2 ), extendShape( dims - 2 );
+                for ( int i = 0, k = 0 ; i < dims ; i++ ) {
+                    if ( i != xAxis && i != yAxis ) {
+                        extendAxes[k] = i;
+                        extendBlc[k] = 0;
+                        extendTrc[k] = shape[i] - 1;
+                        extendShape[k] = shape[i];
+                        k++;
+                    }
+                }
+                casacore::LCExtension extension( pixelSet, extendAxes,
+                                                 casacore::LCBox( extendBlc, extendTrc, extendShape ) );
+                imageRegion = new casacore::ImageRegion( extension );
+            }
+        }
+        catch ( const casacore::AipsError & error ) {
+            qDebug() << "Could not make image region: " << error.getMesg().c_str();
+        }
+        return imageRegion;
+    }
+};
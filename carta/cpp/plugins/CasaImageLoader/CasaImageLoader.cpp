@@ -1,5 +1,7 @@
 #include "CasaImageLoader.h"
 #include "CCImage.h"
+#include "FitsMmapImage.h"
+#include "FitsTilePixels.h"
 #include "CartaLib/Hooks/Initialize.h"
 #include "CartaLib/Hooks/LoadAstroImage.h"
 #include <QDebug>
@@ -23,6 +25,15 @@ CasaImageLoader::CasaImageLoader(QObject *parent) :
 {
 }
 
+void CasaImageLoader::initialize( const InitInfo & initInfo )
+{
+    // size of the cache of decompressed FITS tiles, in megabytes
+    int tileCacheSize = initInfo.json.value( "tileCacheSize" ).toInt( 0 );
+    if ( tileCacheSize > 0 ) {
+        FitsTilePixels::setCacheSize( tileCacheSize );
+    }
+}
+
 bool CasaImageLoader::handleHook(BaseHook & hookData)
 {
     qDebug() << "CasaImageLoader plugin is handling hook #" << hookData.hookId();
@@ -77,6 +88,13 @@ Carta::Lib::Image::ImageInterface::SharedPtr CasaImageLoader::loadImage( const Q
 {
     qDebug() << "CasaImageLoader plugin trying to load image: " << fname;
 
+    // FITS images are read straight from the mapped file, so opening them does
+    // not have to wait for casacore
+    FitsMmapImage::SharedPtr fitsImage = FitsMmapImage::open( fname );
+    if ( fitsImage ) {
+        return fitsImage;
+    }
+
     // get the image type
     casacore::ImageOpener::ImageTypes filetype = casacore::ImageOpener::imageType(fname.toStdString());
 
@@ -12,14 +12,21 @@ SOURCES += \
     CCImage.cpp \
     CCMetaDataInterface.cpp \
     CCRawView.cpp \
-    CCCoordinateFormatter.cpp
+    CCCoordinateFormatter.cpp \
+    FitsMmapImage.cpp \
+    FitsMmapRawView.cpp \
+    FitsTilePixels.cpp
 
 HEADERS += \
     CasaImageLoader.h \
     CCImage.h \
     CCMetaDataInterface.h \
+    CCRegionMask.h \
     CCRawView.h \
-    CCCoordinateFormatter.h
+    CCCoordinateFormatter.h \
+    FitsMmapImage.h \
+    FitsMmapRawView.h \
+    FitsTilePixels.h
 
 casacoreLIBS += -L$${CASACOREDIR}/lib
 casacoreLIBS += -lcasa_lattices -lcasa_tables -lcasa_scimath -lcasa_scimath_f -lcasa_mirlib
@@ -29,6 +36,7 @@ casacoreLIBS += -lcasa_images -lcasa_coordinates -lcasa_fits -lcasa_measures
 LIBS += $${casacoreLIBS}
 LIBS += -L$${WCSLIBDIR}/lib -lwcs
 LIBS += -L$${CFITSIODIR}/lib -lcfitsio
+LIBS += -lz
 LIBS += -L$$OUT_PWD/../../core/ -lcore
 LIBS += -L$$OUT_PWD/../../CartaLib/ -lCartaLib
 
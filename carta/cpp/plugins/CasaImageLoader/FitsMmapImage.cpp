@@ -0,0 +1,416 @@
+/**
+ *
+ **/
+
+#include "FitsMmapImage.h"
+#include "FitsTilePixels.h"
+#include <casacore/casa/Exceptions/Error.h>
+#include <casacore/casa/Containers/Record.h>
+#include <casacore/coordinates/Coordinates/CoordinateUtil.h>
+#include <casacore/coordinates/Coordinates/FITSCoordinateUtil.h>
+#include <casacore/images/Images/FITSImage.h>
+#include <casacore/images/Images/PagedImage.h>
+#include <QDebug>
+#include <QMap>
+#include <QMutexLocker>
+#include <QRegExp>
+
+namespace
+{
+/// FITS files are made of blocks of this many bytes
+const qint64 FITS_BLOCK = 2880;
+
+/// length of a header card
+const int CARD_LENGTH = 80;
+
+/// split a header card into its keyword and value; string values lose their quotes
+/// \return false if the card has no value
+bool
+parseCard( const QString & card, QString & keyword, QString & value )
+{
+    keyword = card.left( 8 ).trimmed();
+    value.clear();
+    if ( card.mid( 8, 2 ) != "= " ) {
+        return false;
+    }
+    QString rest = card.mid( 10 ).trimmed();
+    if ( rest.startsWith( '\'' ) ) {
+        // quotes inside a string are doubled
+        for ( int i = 1 ; i < rest.size() ; i++ ) {
+            if ( rest[i] == '\'' ) {
+                if ( i + 1 < rest.size() && rest[i + 1] == '\'' ) {
+                    value += '\'';
+                    i++;
+                    continue;
+                }
+                break;
+            }
+            value += rest[i];
+        }
+        // trailing spaces of a string are not significant
+        value = value.trimmed();
+    }
+    else {
+        int slash = rest.indexOf( '/' );
+        value = ( slash >= 0 ? rest.left( slash ) : rest ).trimmed();
+    }
+    return true;
+}
+
+/// FITS allows a 'D' exponent in floating point values
+double
+toDouble( QString value )
+{
+    value.replace( 'D', 'E' ).replace( 'd', 'e' );
+    return value.toDouble();
+}
+
+/// the header of a tile compressed image as if the image were not compressed:
+/// the keywords describing the binary table and the compression are left out,
+/// and ZBITPIX and ZNAXISn stand for BITPIX and NAXISn
+QStringList
+imageCards( const QStringList & tableCards )
+{
+    QRegExp tableKeyword( "XTENSION|BITPIX|NAXIS\\d*|PCOUNT|GCOUNT|TFIELDS|THEAP|T(TYPE|FORM|UNIT|DIM)\\d+"
+                          "|Z(IMAGE|TENSION|SIMPLE|EXTEND|PCOUNT|GCOUNT|CMPTYPE|QUANTIZ|DITHER0|HECKSUM|DATASUM|BLOCKED)"
+                          "|Z(TILE|NAME|VAL)\\d+" );
+    QRegExp imageKeyword( "Z(BITPIX|NAXIS\\d*)" );
+    QStringList cards;
+    for ( const QString & card : tableCards ) {
+        QString keyword = card.left( 8 ).trimmed();
+        if ( imageKeyword.exactMatch( keyword ) ) {
+            cards.append( keyword.mid( 1 ).leftJustified( 8, ' ' ) + card.mid( 8 ) );
+        }
+        else if ( ! tableKeyword.exactMatch( keyword ) ) {
+            cards.append( card );
+        }
+    }
+    return cards;
+}
+
+bool
+isValidBitpix( int bitpix )
+{
+    return bitpix == 8 || bitpix == 16 || bitpix == 32 || bitpix == 64
+           || bitpix == - 32 || bitpix == - 64;
+}
+}
+
+FitsMmapImage::FitsMmapImage()
+{ }
+
+FitsMmapImage::SharedPtr
+FitsMmapImage::open( const QString & fileName )
+{
+    std::shared_ptr < QFile > file = std::make_shared < QFile > ( fileName );
+    if ( ! file-> open( QIODevice::ReadOnly ) ) {
+        return nullptr;
+    }
+    qint64 fileSize = file-> size();
+    if ( fileSize < FITS_BLOCK ) {
+        return nullptr;
+    }
+
+    // looking at the first card is cheap and rules out anything that is not FITS
+    if ( ! file-> read( CARD_LENGTH ).startsWith( "SIMPLE  =" ) ) {
+        return nullptr;
+    }
+    const uchar * map = file-> map( 0, fileSize );
+    if ( ! map ) {
+        qWarning() << "Could not map" << fileName;
+        return nullptr;
+    }
+
+    // the pixels of the first HDU holding an image are used
+    qint64 pos = 0;
+    for ( unsigned int hdu = 0 ; pos + FITS_BLOCK <= fileSize ; hdu++ ) {
+        QStringList cards;
+        QMap < QString, QString > keys;
+        bool ended = false;
+        while ( ! ended && pos + FITS_BLOCK <= fileSize ) {
+            for ( int i = 0 ; i < FITS_BLOCK / CARD_LENGTH && ! ended ; i++ ) {
+                QString card = QString::fromLatin1(
+                    reinterpret_cast < const char * > ( map + pos + i * CARD_LENGTH ), CARD_LENGTH );
+                cards.append( card );
+                QString keyword;
+                QString value;
+                if ( parseCard( card, keyword, value ) ) {
+                    if ( ! keys.contains( keyword ) ) {
+                        keys.insert( keyword, value );
+                    }
+                }
+                else if ( keyword == "END" ) {
+                    ended = true;
+                }
+            }
+            pos += FITS_BLOCK;
+        }
+        if ( ! ended ) {
+            break;
+        }
+
+        if ( keys.value( "GROUPS" ) == "T" ) {
+            return nullptr;
+        }
+        int bitpix = keys.value( "BITPIX" ).toInt();
+        if ( ! isValidBitpix( bitpix ) ) {
+            return nullptr;
+        }
+        int naxis = keys.value( "NAXIS" ).toInt();
+        std::vector < int > dims;
+        qint64 pixelCount = naxis > 0 ? 1 : 0;
+        for ( int i = 1 ; i <= naxis ; i++ ) {
+            int axisLength = keys.value( QString( "NAXIS%1" ).arg( i ) ).toInt();
+            dims.push_back( axisLength );
+            pixelCount *= axisLength;
+        }
+        qint64 pcount = keys.value( "PCOUNT", "0" ).toLongLong();
+        qint64 gcount = keys.value( "GCOUNT", "1" ).toLongLong();
+        qint64 dataBytes = naxis > 0 ? ( std::abs( bitpix ) / 8 ) * gcount * ( pcount + pixelCount ) : 0;
+        if ( pos + dataBytes > fileSize ) {
+            qWarning() << "FITS file is truncated:" << fileName;
+            return nullptr;
+        }
+
+        // tile compressed images are stored in binary tables
+        if ( hdu > 0 && keys.value( "XTENSION" ) == "BINTABLE" && keys.value( "ZIMAGE" ) == "T" ) {
+            FitsTilePixels::SharedPtr tiles = FitsTilePixels::create( fileName, hdu, keys, map + pos, dataBytes );
+            if ( ! tiles ) {
+                return nullptr;
+            }
+            tiles-> file = file;
+            return _create( fileName, hdu, tiles, true, imageCards( cards ), keys );
+        }
+
+        // other binary tables are left to casacore
+        if ( hdu > 0 && keys.value( "XTENSION" ) != "IMAGE" ) {
+            return nullptr;
+        }
+
+        if ( naxis >= 2 && pixelCount > 0 ) {
+            std::shared_ptr < FitsMmapPixels > pixels = std::make_shared < FitsMmapPixels > ();
+            pixels-> file = file;
+            pixels-> data = map + pos;
+            pixels-> bitpix = bitpix;
+            pixels-> dims = dims;
+            if ( keys.contains( "BSCALE" ) ) {
+                pixels-> bscale = toDouble( keys.value( "BSCALE" ) );
+            }
+            if ( keys.contains( "BZERO" ) ) {
+                pixels-> bzero = toDouble( keys.value( "BZERO" ) );
+            }
+            // floating point images mark blank pixels with NaN instead
+            if ( bitpix > 0 && keys.contains( "BLANK" ) ) {
+                pixels-> hasBlank = true;
+                pixels-> blank = keys.value( "BLANK" ).toLongLong();
+            }
+            return _create( fileName, hdu, pixels, false, cards, keys );
+        }
+
+        // skip the data of this HDU, including the padding of its last block
+        pos += ( dataBytes + FITS_BLOCK - 1 ) / FITS_BLOCK * FITS_BLOCK;
+    }
+    return nullptr;
+} // open
+
+FitsMmapImage::SharedPtr
+FitsMmapImage::_create( const QString & fileName, unsigned int hdu,
+                        std::shared_ptr < const FitsPixelSource > pixels, bool compressed,
+                        const QStringList & cards, const QMap < QString, QString > & keys )
+{
+    FitsMmapImage::SharedPtr img = std::make_shared < FitsMmapImage > ();
+    img-> m_pixels = pixels;
+    img-> m_compressed = compressed;
+    img-> m_fileName = fileName;
+    img-> m_hdu = hdu;
+    img-> m_cards = cards;
+    img-> m_unit = Carta::Lib::Unit( keys.value( "BUNIT" ) );
+    img-> m_hasBeam = keys.contains( "BMAJ" ) || keys.value( "CASAMBM" ) == "T";
+    if ( compressed ) {
+        img-> m_decompressed = std::make_shared < Decompressed > ();
+    }
+    img-> m_object = keys.value( "OBJECT" );
+    img-> m_meta = img-> _makeMetaData( img-> m_object );
+    qDebug() << "\t-mapped FITS image" << fileName << "HDU" << hdu << ( compressed ? "(compressed)" : "" );
+    return img;
+}
+
+CCMetaDataInterface::SharedPtr
+FitsMmapImage::_makeMetaData( const QString & object )
+{
+    // the coordinate system is made from the header cards, without opening the image
+    casacore::Vector < casacore::String > header( m_cards.size() );
+    for ( int i = 0 ; i < m_cards.size() ; i++ ) {
+        header[i] = m_cards[i].toStdString();
+    }
+    casacore::IPosition shape( m_pixels-> dims.size() );
+    for ( size_t i = 0 ; i < m_pixels-> dims.size() ; i++ ) {
+        shape[i] = m_pixels-> dims[i];
+    }
+    std::shared_ptr < casacore::CoordinateSystem > casaCS = std::make_shared < casacore::CoordinateSystem > ();
+    bool valid = false;
+    try {
+        casacore::Int stokesFITSValue = - 1;
+        casacore::Record headerRec;
+        casacore::FITSCoordinateUtil fitsCoords;
+        valid = fitsCoords.fromFITSHeader( stokesFITSValue, * casaCS, headerRec, header, shape, 0 );
+    }
+    catch ( const casacore::AipsError & err ) {
+        qWarning() << "Could not read coordinates:" << err.getMesg().c_str();
+    }
+    if ( ! valid || casaCS-> nPixelAxes() != shape.size() ) {
+        if ( m_compressed ) {
+            casaCS = std::make_shared < casacore::CoordinateSystem > (
+                casacore::CoordinateUtil::defaultCoords( shape.size() ) );
+        }
+        else {
+            // let casacore work it out
+            casacore::ImageInterface < casacore::Float > * casaImage = _casaImage();
+            if ( casaImage ) {
+                casaCS.reset( static_cast < casacore::CoordinateSystem * > ( casaImage-> coordinates().clone() ) );
+            }
+        }
+    }
+    return std::make_shared < CCMetaDataInterface > ( object.toHtmlEscaped(), casaCS );
+}
+
+Carta::Lib::Image::MetaDataInterface::SharedPtr
+FitsMmapImage::metaData()
+{
+    return m_meta;
+}
+
+casacore::ImageInterface < casacore::Float > *
+FitsMmapImage::_casaImage() const
+{
+    QMutexLocker locker( & m_casaMutex );
+    if ( ! m_casaImage ) {
+        try {
+            if ( m_compressed ) {
+                // each copy opens its own handle to the shared pixels
+                QString path = _decompressedPath();
+                if ( ! path.isEmpty() ) {
+                    m_casaImage.reset( new casacore::PagedImage < casacore::Float > ( path.toStdString() ) );
+                }
+            }
+            else {
+                m_casaImage.reset( new casacore::FITSImage( m_fileName.toStdString(), 0, m_hdu ) );
+            }
+        }
+        catch ( const casacore::AipsError & err ) {
+            qWarning() << "Could not open" << m_fileName << ":" << err.getMesg().c_str();
+        }
+    }
+    return m_casaImage.get();
+}
+
+QString
+FitsMmapImage::_decompressedPath() const
+{
+    QMutexLocker locker( & m_decompressed-> mutex );
+    if ( ! m_decompressed-> dir && ! m_decompressed-> failed ) {
+        std::unique_ptr < QTemporaryDir > dir( new QTemporaryDir() );
+        QString path = dir-> path() + "/decompressed.image";
+        try {
+            if ( dir-> isValid() ) {
+                _writeDecompressed( path );
+                m_decompressed-> dir = std::move( dir );
+                m_decompressed-> path = path;
+            }
+        }
+        catch ( const casacore::AipsError & err ) {
+            qWarning() << "Could not decompress" << m_fileName << ":" << err.getMesg().c_str();
+        }
+        m_decompressed-> failed = ! m_decompressed-> dir;
+    }
+    return m_decompressed-> path;
+}
+
+void
+FitsMmapImage::_writeDecompressed( const QString & path ) const
+{
+    const std::vector < int > & imageDims = m_pixels-> dims;
+    casacore::IPosition shape( imageDims.size() );
+    for ( size_t i = 0 ; i < imageDims.size() ; i++ ) {
+        shape[i] = imageDims[i];
+    }
+    casacore::PagedImage < casacore::Float > image(
+        casacore::TiledShape( shape ), * m_meta-> getCoordinateSystem(), path.toStdString() );
+
+    // copy the pixels a plane at a time
+    casacore::IPosition planeShape( shape.size(), 1 );
+    planeShape[0] = shape[0];
+    planeShape[1] = shape[1];
+    std::vector < float > plane( planeShape.product() );
+    std::unique_ptr < FitsMmapRawView > view( new FitsMmapRawView( m_pixels, SliceND() ) );
+    casacore::IPosition where( shape.size(), 0 );
+    for ( int64_t index = 0 ;
+          view-> read( plane.size() * sizeof( float ), reinterpret_cast < char * > ( plane.data() ) ) > 0 ;
+          index++ ) {
+        int64_t rest = index;
+        for ( size_t i = 2 ; i < shape.size() ; i++ ) {
+            where[i] = rest % shape[i];
+            rest /= shape[i];
+        }
+        casacore::Array < casacore::Float > pixels( planeShape, plane.data(), casacore::SHARE );
+        image.putSlice( pixels, where );
+    }
+
+    casacore::ImageInfo info;
+    info.setObjectName( m_meta-> title().toStdString() );
+    image.setImageInfo( info );
+    try {
+        image.setUnits( casacore::Unit( m_unit.toStr().toStdString() ) );
+    }
+    catch ( const casacore::AipsError & ) {
+        qWarning() << "Unknown unit" << m_unit.toStr();
+    }
+}
+
+casacore::LatticeBase *
+FitsMmapImage::getCasaImage()
+{
+    return _casaImage();
+}
+
+casacore::ImageInfo
+FitsMmapImage::getImageInfo() const
+{
+    casacore::ImageInterface < casacore::Float > * casaImage = _casaImage();
+    if ( ! casaImage ) {
+        return casacore::ImageInfo();
+    }
+    return casaImage-> imageInfo();
+}
+
+std::shared_ptr < Carta::Lib::Image::ImageInterface >
+FitsMmapImage::getPermuted( const std::vector < int > & indices )
+{
+    // permuting copies all the pixels anyway, so it is left to casacore
+    casacore::ImageInterface < casacore::Float > * casaImage = _casaImage();
+    if ( ! casaImage ) {
+        return nullptr;
+    }
+    return CCImage < casacore::Float >::create( casaImage-> cloneII() )-> getPermuted( indices );
+}
+
+std::shared_ptr < Carta::Lib::Image::ImageInterface >
+FitsMmapImage::cloneForThread()
+{
+    FitsMmapImage::SharedPtr img = std::make_shared < FitsMmapImage > ();
+    img-> m_pixels = m_pixels;
+    img-> m_compressed = m_compressed;
+    img-> m_hasBeam = m_hasBeam;
+    img-> m_fileName = m_fileName;
+    img-> m_hdu = m_hdu;
+    img-> m_cards = m_cards;
+    img-> m_unit = m_unit;
+    img-> m_object = m_object;
+    img-> m_decompressed = m_decompressed;
+    // casacore coordinate systems cache their conversions, so each copy has its own
+    img-> m_meta = img-> _makeMetaData( m_object );
+    return img;
+}
+
+FitsMmapImage::~FitsMmapImage()
+{ }
@@ -0,0 +1,197 @@
+/**
+ *
+ **/
+
+#pragma once
+
+#include "CCImage.h"
+#include "FitsMmapRawView.h"
+#include <QMap>
+#include <QMutex>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <memory>
+
+/// implementation of the ImageInterface for FITS images, which reads the pixels
+/// straight from the memory mapped file
+///
+/// Opening the image only parses the header, so the first plane of even a very
+/// large cube can be rendered right away. Tile compressed images are decompressed
+/// a tile at a time, as the tiles are read. The casacore image that the analysis
+/// plugins work with (through getCasaImage()) is only made the first time it is
+/// asked for: a casacore::FITSImage of the same HDU, or for compressed images,
+/// which casacore cannot read, a casacore image in a temporary directory holding
+/// the decompressed pixels, which is written once for the image and its thread copies.
+class FitsMmapImage
+    : public CCImageBase
+      , public std::enable_shared_from_this < FitsMmapImage >
+{
+    CLASS_BOILERPLATE( FitsMmapImage );
+
+public:
+
+    /// map a FITS file and find its first image HDU
+    /// \param fileName the FITS file
+    /// \return the image, or nullptr if the file is not a FITS file with an
+    /// image this class can read
+    static FitsMmapImage::SharedPtr
+    open( const QString & fileName );
+
+    virtual const Carta::Lib::Unit &
+    getPixelUnit() const override
+    {
+        return m_unit;
+    }
+
+    virtual std::shared_ptr < Carta::Lib::Image::ImageInterface >
+    getPermuted( const std::vector < int > & indices ) override;
+
+    virtual const std::vector < int > &
+    dims() const override
+    {
+        return m_pixels-> dims;
+    }
+
+    virtual bool
+    hasMask() const override
+    {
+        return false;
+    }
+
+    virtual bool
+    hasBeam() const override
+    {
+        return m_hasBeam;
+    }
+
+    virtual bool
+    hasErrorsInfo() const override
+    {
+        return false;
+    }
+
+    /// blank and scaled pixels are converted, so the views are always float
+    virtual Carta::Lib::Image::PixelType
+    pixelType() const override
+    {
+        return Carta::Lib::Image::PixelType::Real32;
+    }
+
+    virtual Carta::Lib::Image::PixelType
+    errorType() const override
+    {
+        qFatal( "not implemented" );
+    }
+
+    virtual Carta::Lib::NdArray::RawViewInterface *
+    getDataSlice( const SliceND & sliceInfo ) override
+    {
+        return new FitsMmapRawView( m_pixels, sliceInfo );
+    }
+
+    /// \todo implement this
+    virtual Carta::Lib::NdArray::Byte *
+    getMaskSlice( const SliceND & sliceInfo ) override
+    {
+        Q_UNUSED( sliceInfo );
+        qFatal( "not implemented" );
+    }
+
+    /// \todo implement this
+    virtual Carta::Lib::NdArray::RawViewInterface *
+    getErrorSlice( const SliceND & sliceInfo ) override
+    {
+        Q_UNUSED( sliceInfo );
+        qFatal( "not implemented" );
+    }
+
+    virtual Carta::Lib::Image::MetaDataInterface::SharedPtr
+    metaData() override;
+
+    /// makes the casacore image the first time it is called
+    virtual casacore::LatticeBase *
+    getCasaImage() override;
+
+    /// the mapping can be read from any thread, but the casacore image cannot,
+    /// so the copy shares the mapping and the decompressed pixels, and opens its
+    /// own casacore image if needed
+    virtual std::shared_ptr < Carta::Lib::Image::ImageInterface >
+    cloneForThread() override;
+
+    virtual casacore::ImageInfo
+    getImageInfo() const override;
+
+    virtual
+    ~FitsMmapImage();
+
+    /// do not use this, use open() instead
+    FitsMmapImage();
+
+protected:
+
+    /// make the image of a HDU from its pixels and header
+    static FitsMmapImage::SharedPtr
+    _create( const QString & fileName, unsigned int hdu,
+             std::shared_ptr < const FitsPixelSource > pixels, bool compressed,
+             const QStringList & cards, const QMap < QString, QString > & keys );
+
+    /// the casacore image, made on demand
+    casacore::ImageInterface < casacore::Float > *
+    _casaImage() const;
+
+    /// the path of the casacore image holding all the decompressed pixels, written
+    /// the first time it is asked for by the image or any of its thread copies
+    /// \return the path, or an empty string if the pixels could not be written
+    QString
+    _decompressedPath() const;
+
+    /// write all the decompressed pixels to a new casacore image
+    /// \param path where to write the image
+    void
+    _writeDecompressed( const QString & path ) const;
+
+    /// meta data with the coordinate system described by the header cards
+    CCMetaDataInterface::SharedPtr
+    _makeMetaData( const QString & object );
+
+    /// the mapped pixels, shared with the views and with thread copies
+    std::shared_ptr < const FitsPixelSource > m_pixels;
+
+    /// whether the image is tile compressed
+    bool m_compressed = false;
+
+    /// whether the header describes a beam
+    bool m_hasBeam = false;
+
+    QString m_fileName;
+
+    /// index of the HDU holding the image
+    unsigned int m_hdu = 0;
+
+    /// the header cards of the image, 80 characters each
+    QStringList m_cards;
+
+    /// cached unit
+    Carta::Lib::Unit m_unit;
+
+    /// the OBJECT keyword, the title of the meta data
+    QString m_object;
+
+    /// meta data pointer
+    CCMetaDataInterface::SharedPtr m_meta;
+
+    /// the decompressed pixels of a tile compressed image, shared with thread copies
+    struct Decompressed {
+        QMutex mutex;
+        /// the directory holding the casacore image; nullptr until it is written
+        std::unique_ptr < QTemporaryDir > dir;
+        /// the path of the casacore image; empty until it is written
+        QString path;
+        /// whether writing the image failed, so it is not tried again
+        bool failed = false;
+    };
+    std::shared_ptr < Decompressed > m_decompressed;
+
+    mutable QMutex m_casaMutex;
+    mutable std::unique_ptr < casacore::ImageInterface < casacore::Float > > m_casaImage;
+};
@@ -0,0 +1,395 @@
+/**
+ *
+ **/
+
+#include "FitsMmapRawView.h"
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN && defined( __SSSE3__ )
+#include <tmmintrin.h>
+#endif
+
+namespace
+{
+template < typename Int >
+inline Int
+fromBigEndian( const uchar * src )
+{
+    return qFromBigEndian < Int > ( src );
+}
+
+template < >
+inline quint8
+fromBigEndian < quint8 > ( const uchar * src )
+{
+    return * src;
+}
+
+/// byte swap a contiguous run of 32 bit floats, 4 at a time where the cpu allows it
+void
+swapFloats( const uchar * src, int64_t count, float * out )
+{
+    int64_t i = 0;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN && defined( __SSSE3__ )
+    const __m128i reverse = _mm_set_epi8( 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3 );
+    for ( ; i + 4 <= count ; i += 4 ) {
+        __m128i v = _mm_loadu_si128( reinterpret_cast < const __m128i * > ( src + 4 * i ) );
+        _mm_storeu_si128( reinterpret_cast < __m128i * > ( out + i ), _mm_shuffle_epi8( v, reverse ) );
+    }
+#endif
+    // a simple loop the compiler can vectorize by itself
+    for ( ; i < count ; i++ ) {
+        quint32 bits = qFromBigEndian < quint32 > ( src + 4 * i );
+        memcpy( out + i, & bits, 4 );
+    }
+}
+
+template < typename Int >
+void
+convertInts( const FitsMmapPixels & pixels, const uchar * src, int64_t count, int64_t stride,
+             float * out )
+{
+    const int64_t step = stride * sizeof( Int );
+    const float nan = std::numeric_limits < float >::quiet_NaN();
+    for ( int64_t i = 0 ; i < count ; i++ ) {
+        Int val = fromBigEndian < Int > ( src + i * step );
+        if ( pixels.hasBlank && val == pixels.blank ) {
+            out[i] = nan;
+        }
+        else {
+            out[i] = val * pixels.bscale + pixels.bzero;
+        }
+    }
+}
+
+template < typename Bits, typename Real >
+void
+convertReals( const FitsMmapPixels & pixels, const uchar * src, int64_t count, int64_t stride,
+              float * out )
+{
+    if ( sizeof( Real ) == 4 && stride == 1 ) {
+        swapFloats( src, count, out );
+    }
+    else {
+        const int64_t step = stride * sizeof( Real );
+        for ( int64_t i = 0 ; i < count ; i++ ) {
+            Bits bits = qFromBigEndian < Bits > ( src + i * step );
+            Real val;
+            memcpy( & val, & bits, sizeof( Real ) );
+            out[i] = val;
+        }
+    }
+
+    // blank floating point pixels are NaN already, and stay NaN
+    if ( pixels.bscale != 1 || pixels.bzero != 0 ) {
+        for ( int64_t i = 0 ; i < count ; i++ ) {
+            out[i] = out[i] * pixels.bscale + pixels.bzero;
+        }
+    }
+}
+}
+
+bool
+FitsMmapPixels::isNative() const
+{
+    return Q_BYTE_ORDER == Q_BIG_ENDIAN && bitpix == - 32 && bscale == 1 && bzero == 0;
+}
+
+void
+FitsMmapPixels::convert( const uchar * src, int64_t count, int64_t stride, float * out ) const
+{
+    switch ( bitpix ) {
+    case 8:
+        convertInts < quint8 > ( * this, src, count, stride, out );
+        break;
+    case 16:
+        convertInts < qint16 > ( * this, src, count, stride, out );
+        break;
+    case 32:
+        convertInts < qint32 > ( * this, src, count, stride, out );
+        break;
+    case 64:
+        convertInts < qint64 > ( * this, src, count, stride, out );
+        break;
+    case - 32:
+        convertReals < quint32, float > ( * this, src, count, stride, out );
+        break;
+    case - 64:
+        convertReals < quint64, double > ( * this, src, count, stride, out );
+        break;
+    default:
+        qFatal( "unsupported BITPIX" );
+    }
+}
+
+void
+FitsMmapPixels::readRow( int64_t offset, int64_t count, int64_t step, float * out ) const
+{
+    convert( data + offset * bytesPerPixel(), count, step, out );
+}
+
+const float *
+FitsMmapPixels::nativePixels( int64_t offset ) const
+{
+    if ( ! isNative() ) {
+        return nullptr;
+    }
+    return reinterpret_cast < const float * > ( data + offset * bytesPerPixel() );
+}
+
+// public constructor
+FitsMmapRawView::FitsMmapRawView( std::shared_ptr < const FitsPixelSource > pixels,
+                                  const SliceND & sliceInfo )
+{
+    m_pixels = pixels;
+    m_appliedSlice = sliceInfo.apply( m_pixels-> dims );
+    _init();
+}
+
+// protected constructor
+FitsMmapRawView::FitsMmapRawView( std::shared_ptr < const FitsPixelSource > pixels,
+                                  const SliceND::ApplyResult & applyResult )
+{
+    m_pixels = pixels;
+    m_appliedSlice = applyResult;
+    _init();
+}
+
+void
+FitsMmapRawView::_init()
+{
+    int64_t imageStride = 1;
+    m_count = 1;
+    const auto & slices = m_appliedSlice.dims();
+    for ( size_t i = 0 ; i < slices.size() ; i++ ) {
+        // a single index is visited as an axis of length 1
+        int count = slices[i].isSingle() ? 1 : slices[i].count;
+        m_viewDims.push_back( count );
+        m_starts.push_back( slices[i].start * imageStride );
+        m_steps.push_back( slices[i].step * imageStride );
+        m_count *= count;
+        imageStride *= m_pixels-> dims[i];
+    }
+    m_currPos.resize( m_viewDims.size(), 0 );
+}
+
+int64_t
+FitsMmapRawView::_offset( const VI & pos ) const
+{
+    int64_t offset = 0;
+    for ( size_t i = 0 ; i < m_viewDims.size() ; i++ ) {
+        int p = i < pos.size() ? pos[i] : 0;
+        offset += m_starts[i] + p * m_steps[i];
+    }
+    return offset;
+}
+
+void
+FitsMmapRawView::_preparePlane( const VI & pos ) const
+{
+    int64_t plane = 0;
+    int64_t planeStride = 1;
+    for ( size_t i = 2 ; i < pos.size() ; i++ ) {
+        plane += pos[i] * planeStride;
+        planeStride *= m_viewDims[i];
+    }
+    if ( plane == m_preparedPlane ) {
+        return;
+    }
+    m_preparedPlane = plane;
+
+    // the whole of the first two axes, and the single position along the others
+    std::vector < Slice1D::ApplyResult > box = m_appliedSlice.dims();
+    for ( size_t i = 0 ; i < box.size() ; i++ ) {
+        if ( i < 2 ) {
+            box[i].count = m_viewDims[i];
+        }
+        else {
+            box[i].start += pos[i] * box[i].step;
+            box[i].count = 1;
+        }
+    }
+    m_pixels-> prepare( box );
+}
+
+void
+FitsMmapRawView::_readPixels( int64_t first, int64_t count, float * out ) const
+{
+    if ( m_viewDims.empty() ) {
+        return;
+    }
+    VI pos( m_viewDims.size() );
+    int64_t rest = first;
+    for ( size_t i = 0 ; i < m_viewDims.size() ; i++ ) {
+        pos[i] = rest % m_viewDims[i];
+        rest /= m_viewDims[i];
+    }
+
+    // convert the pixels a (partial) row at a time
+    while ( count > 0 ) {
+        _preparePlane( pos );
+        int64_t run = std::min < int64_t > ( count, m_viewDims[0] - pos[0] );
+        m_pixels-> readRow( _offset( pos ), run, m_steps[0], out );
+        out += run;
+        count -= run;
+        pos[0] = 0;
+        for ( size_t i = 1 ; i < pos.size() ; i++ ) {
+            if ( ++pos[i] < m_viewDims[i] ) {
+                break;
+            }
+            pos[i] = 0;
+        }
+    }
+}
+
+const char *
+FitsMmapRawView::get( const VI & pos )
+{
+    // preconditions
+    if ( CARTA_RUNTIME_CHECKS && pos.size() > dims().size() ) {
+        throw std::runtime_error( "invalid position" );
+    }
+    m_pixels-> readRow( _offset( pos ), 1, 1, & m_buff );
+    return reinterpret_cast < const char * > ( & m_buff );
+}
+
+void
+FitsMmapRawView::forEach( std::function < void (const char *) > func, Traversal traversal )
+{
+    // the sequential order is also the fastest one for FITS
+    Q_UNUSED( traversal );
+    if ( m_count == 0 ) {
+        return;
+    }
+    const int rowLength = m_viewDims[0];
+    const bool direct = m_steps[0] == 1 && m_pixels-> nativePixels( 0 );
+    m_rowBuff.resize( rowLength );
+    std::fill( m_currPos.begin(), m_currPos.end(), 0 );
+    for ( int64_t row = 0 ; row < m_count / rowLength ; row++ ) {
+        m_currPos[0] = 0;
+        const char * rowData;
+        if ( direct ) {
+            rowData = reinterpret_cast < const char * > ( m_pixels-> nativePixels( _offset( m_currPos ) ) );
+        }
+        else {
+            _preparePlane( m_currPos );
+            m_pixels-> readRow( _offset( m_currPos ), rowLength, m_steps[0], m_rowBuff.data() );
+            rowData = reinterpret_cast < const char * > ( m_rowBuff.data() );
+        }
+        for ( int i = 0 ; i < rowLength ; i++ ) {
+            m_currPos[0] = i;
+            func( rowData + i * sizeof( float ) );
+        }
+
+        // next row
+        for ( size_t i = 1 ; i < m_currPos.size() ; i++ ) {
+            if ( ++m_currPos[i] < m_viewDims[i] ) {
+                break;
+            }
+            m_currPos[i] = 0;
+        }
+    }
+} // forEach
+
+const Carta::Lib::NdArray::RawViewInterface::VI &
+FitsMmapRawView::currentPos()
+{
+    return m_currPos;
+}
+
+Carta::Lib::NdArray::RawViewInterface *
+FitsMmapRawView::getView( const SliceND & sliceInfo )
+{
+    // apply the slice to dimensions of this view
+    SliceND::ApplyResult ar = sliceInfo.apply( dims() );
+
+    // create applied result that combines m_appliedSlice with ar
+    SliceND::ApplyResult newAr = SliceND::ApplyResult::combine( m_appliedSlice, ar );
+
+    // return a new view based on the new slice
+    return new FitsMmapRawView( m_pixels, newAr );
+}
+
+int64_t
+FitsMmapRawView::read( int64_t buffSize, char * buff, Traversal traversal )
+{
+    Q_UNUSED( traversal );
+    int64_t count = std::min < int64_t > ( buffSize / sizeof( float ), m_count - m_readPos );
+    if ( count <= 0 ) {
+        return 0;
+    }
+    _readPixels( m_readPos, count, reinterpret_cast < float * > ( buff ) );
+    m_readPos += count;
+    return count * sizeof( float );
+}
+
+void
+FitsMmapRawView::seek( int64_t ind )
+{
+    m_readPos = std::max < int64_t > ( 0, std::min( ind, m_count ) );
+}
+
+int64_t
+FitsMmapRawView::read( int64_t chunk, int64_t buffSize, char * buff, Traversal traversal )
+{
+    Q_UNUSED( traversal );
+    int64_t chunkCount = buffSize / sizeof( float );
+    if ( chunkCount <= 0 || chunk < 0 ) {
+        return 0;
+    }
+    int64_t first = chunk * chunkCount;
+    int64_t count = std::min( chunkCount, m_count - first );
+    if ( count <= 0 ) {
+        return 0;
+    }
+    _readPixels( first, count, reinterpret_cast < float * > ( buff ) );
+    return count * sizeof( float );
+}
+
+void
+FitsMmapRawView::forEach(
+    int64_t buffSize,
+    std::function < void (const char *, int64_t count) > func,
+    char * buff,
+    Traversal traversal )
+{
+    Q_UNUSED( traversal );
+    int64_t chunkCount = std::max < int64_t > ( 1, buffSize / sizeof( float ) );
+    if ( m_count == 0 ) {
+        return;
+    }
+
+    // unscaled native floats are handed out straight from the mapping, a row at a time
+    if ( m_steps[0] == 1 && m_pixels-> nativePixels( 0 ) ) {
+        const int rowLength = m_viewDims[0];
+        VI pos( m_viewDims.size(), 0 );
+        for ( int64_t row = 0 ; row < m_count / rowLength ; row++ ) {
+            const char * rowData = reinterpret_cast < const char * > ( m_pixels-> nativePixels( _offset( pos ) ) );
+            for ( int64_t done = 0 ; done < rowLength ; done += chunkCount ) {
+                func( rowData + done * sizeof( float ), std::min < int64_t > ( chunkCount, rowLength - done ) );
+            }
+            for ( size_t i = 1 ; i < pos.size() ; i++ ) {
+                if ( ++pos[i] < m_viewDims[i] ) {
+                    break;
+                }
+                pos[i] = 0;
+            }
+        }
+        return;
+    }
+
+    std::vector < float > ownBuff;
+    float * out = reinterpret_cast < float * > ( buff );
+    if ( ! out ) {
+        ownBuff.resize( std::min( chunkCount, m_count ) );
+        out = ownBuff.data();
+    }
+    for ( int64_t first = 0 ; first < m_count ; first += chunkCount ) {
+        int64_t count = std::min( chunkCount, m_count - first );
+        _readPixels( first, count, out );
+        func( reinterpret_cast < const char * > ( out ), count );
+    }
+} // forEach
@@ -0,0 +1,210 @@
+/**
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/IImage.h"
+#include <QFile>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+/// pixels of a FITS image HDU in a memory mapped file, read as floats
+class FitsPixelSource
+{
+    CLASS_BOILERPLATE( FitsPixelSource );
+
+public:
+
+    /// the mapped file, which has to stay open for the mapping to remain valid
+    std::shared_ptr < QFile > file;
+
+    /// NAXISn of the image
+    std::vector < int > dims;
+
+    virtual
+    ~FitsPixelSource() { }
+
+    /// read pixels along the first axis
+    /// \param offset index of the first pixel, first axis fastest
+    /// \param count number of pixels to read
+    /// \param step distance between consecutive pixels, in pixels
+    /// \param out where to store the pixels
+    virtual void
+    readRow( int64_t offset, int64_t count, int64_t step, float * out ) const = 0;
+
+    /// the pixels starting at 'offset', if they can be handed out as floats
+    /// straight from the mapping; nullptr if they have to be read with readRow()
+    virtual const float *
+    nativePixels( int64_t offset ) const
+    {
+        Q_UNUSED( offset );
+        return nullptr;
+    }
+
+    /// called before a part of the image is read, so the source can get all of
+    /// its pixels ready at once
+    /// \param box the pixels about to be read along every axis
+    virtual void
+    prepare( const std::vector < Slice1D::ApplyResult > & box ) const
+    {
+        Q_UNUSED( box );
+    }
+};
+
+/// pixels of an uncompressed FITS image HDU
+///
+/// The raw pixels are big endian, in any of the FITS BITPIX types; they are
+/// converted to float on the fly, applying BSCALE, BZERO and BLANK (blank pixels
+/// become NaN), the same way casacore::FITSImage presents them.
+class FitsMmapPixels
+    : public FitsPixelSource
+{
+    CLASS_BOILERPLATE( FitsMmapPixels );
+
+public:
+
+    /// first byte of the pixel data of the HDU, inside the mapping
+    const uchar * data = nullptr;
+
+    /// BITPIX of the HDU
+    int bitpix = 0;
+
+    double bscale = 1;
+    double bzero = 0;
+    bool hasBlank = false;
+    qint64 blank = 0;
+
+    /// number of bytes of one raw pixel
+    int
+    bytesPerPixel() const
+    {
+        return std::abs( bitpix ) / 8;
+    }
+
+    /// true if the raw pixels already are unscaled floats in the byte order of
+    /// this machine, so they can be handed out straight from the mapping
+    bool
+    isNative() const;
+
+    /// convert 'count' raw pixels to floats
+    /// \param src first raw pixel
+    /// \param count number of pixels to convert
+    /// \param stride distance between consecutive pixels, in pixels
+    /// \param out where to store the converted pixels
+    void
+    convert( const uchar * src, int64_t count, int64_t stride, float * out ) const;
+
+    virtual void
+    readRow( int64_t offset, int64_t count, int64_t step, float * out ) const override;
+
+    virtual const float *
+    nativePixels( int64_t offset ) const override;
+};
+
+/// raw view into a memory mapped FITS image
+///
+/// The pixels are read from the source a row (first axis) at a time, and the
+/// bulk accessors convert whole runs of pixels in one go. The source is told
+/// about every plane (first two axes) of the view before it is read.
+class FitsMmapRawView
+    : public Carta::Lib::NdArray::RawViewInterface
+{
+public:
+
+    /// construct a view on the mapped pixels from provided slice information
+    /// \param pixels the mapped pixels, kept alive by the view
+    /// \param sliceInfo for which part of the image to create view
+    FitsMmapRawView( std::shared_ptr < const FitsPixelSource > pixels, const SliceND & sliceInfo );
+
+    virtual PixelType
+    pixelType() override
+    {
+        return PixelType::Real32;
+    }
+
+    virtual const VI &
+    dims() override
+    {
+        return m_viewDims;
+    }
+
+    virtual const char *
+    get( const VI & pos ) override;
+
+    virtual void
+    forEach( std::function < void (const char *) > func, Traversal traversal ) override;
+
+    virtual const VI &
+    currentPos() override;
+
+    virtual RawViewInterface *
+    getView( const SliceND & sliceInfo ) override;
+
+    /// reads the next pixels of the view, first axis fastest, as floats
+    virtual int64_t
+    read( int64_t buffSize, char * buff,
+          Traversal traversal = Traversal::Sequential ) override;
+
+    /// \param ind index of the pixel the next read() starts from
+    virtual void
+    seek( int64_t ind ) override;
+
+    virtual int64_t
+    read( int64_t chunk, int64_t buffSize, char * buff,
+          Traversal traversal = Traversal::Sequential ) override;
+
+    virtual void
+    forEach(
+        int64_t buffSize,
+        std::function < void (const char *, int64_t count) > func,
+        char * buff = nullptr,
+        Traversal traversal = Traversal::Sequential ) override;
+
+protected:
+
+    /// construct a view directly from applied slice
+    FitsMmapRawView( std::shared_ptr < const FitsPixelSource > pixels,
+                     const SliceND::ApplyResult & applyResult );
+
+    /// cache the dimensions and strides of the applied slice
+    void
+    _init();
+
+    /// convert 'count' pixels of the view, starting at pixel 'first', into 'out'
+    void
+    _readPixels( int64_t first, int64_t count, float * out ) const;
+
+    /// index of the image pixel at the given position of the view
+    int64_t
+    _offset( const VI & pos ) const;
+
+    /// let the source prepare the plane of the view holding the given position
+    void
+    _preparePlane( const VI & pos ) const;
+
+    std::shared_ptr < const FitsPixelSource > m_pixels;
+    SliceND::ApplyResult m_appliedSlice;
+    VI m_viewDims;
+
+    /// start and step of every axis, in pixels of the image
+    std::vector < int64_t > m_starts, m_steps;
+
+    /// total number of pixels in the view
+    int64_t m_count = 0;
+
+    /// position for the stateful read()
+    int64_t m_readPos = 0;
+
+    VI m_currPos;
+
+    /// index of the last plane of the view the source prepared
+    mutable int64_t m_preparedPlane = - 1;
+
+    /// buffer for reporting results when calling get()
+    float m_buff;
+
+    /// buffer for the rows visited by forEach()
+    std::vector < float > m_rowBuff;
+};
@@ -0,0 +1,785 @@
+/**
+ *
+ **/
+
+#include "FitsTilePixels.h"
+#include "CartaLib/Algorithms/ParallelTasks.h"
+#include <QCache>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <zlib.h>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+/// default size of the tile cache, in megabytes
+const int TILE_CACHE_SIZE_DEFAULT = 512;
+
+/// number of values in the table of random numbers used for dithering
+const int N_RANDOM = 10000;
+
+/// quantized value standing for an exact zero with SUBTRACTIVE_DITHER_2
+const qint64 ZERO_VALUE = - 2147483646;
+
+QMutex cacheMutex;
+
+/// decompressed tiles, the cost of a tile being its size in kilobytes
+QCache < QString, std::shared_ptr < const std::vector < float > > > tileCache(
+    TILE_CACHE_SIZE_DEFAULT * 1024 );
+
+/// the random numbers cfitsio dithers quantized pixels with
+const std::vector < float > &
+randomValues()
+{
+    static const std::vector < float > values = [] () {
+        std::vector < float > vals( N_RANDOM );
+        const double a = 16807.0;
+        const double m = 2147483647.0;
+        double seed = 1;
+        for ( int i = 0 ; i < N_RANDOM ; i++ ) {
+            double temp = a * seed;
+            seed = temp - m * static_cast < int > ( temp / m );
+            vals[i] = seed / m;
+        }
+        return vals;
+    } ();
+    return values;
+}
+
+/// size of a binary table element of the given format letter
+int
+typeSize( char type )
+{
+    switch ( type ) {
+    case 'L':
+    case 'B':
+    case 'A':
+        return 1;
+    case 'I':
+        return 2;
+    case 'J':
+    case 'E':
+        return 4;
+    case 'K':
+    case 'D':
+    case 'C':
+        return 8;
+    case 'M':
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+/// decompress gzip or zlib data of a known size
+bool
+inflateBytes( const uchar * in, qint64 inSize, uchar * out, qint64 outSize )
+{
+    z_stream stream;
+    memset( & stream, 0, sizeof( z_stream ) );
+    // detect the gzip or zlib header
+    if ( inflateInit2( & stream, 15 + 32 ) != Z_OK ) {
+        return false;
+    }
+    stream.next_in = const_cast < Bytef * > ( in );
+    stream.avail_in = inSize;
+    stream.next_out = out;
+    stream.avail_out = outSize;
+    int status = inflate( & stream, Z_FINISH );
+    inflateEnd( & stream );
+    return status != Z_STREAM_ERROR && status != Z_DATA_ERROR && status != Z_MEM_ERROR
+           && stream.avail_out == 0;
+}
+
+/// undo the byte shuffling of GZIP_2, which stores the first byte of every value,
+/// then the second byte of every value, and so on
+std::vector < uchar >
+unshuffle( const std::vector < uchar > & bytes, int64_t count, int valueBytes )
+{
+    std::vector < uchar > values( bytes.size() );
+    for ( int b = 0 ; b < valueBytes ; b++ ) {
+        const uchar * in = bytes.data() + b * count;
+        for ( int64_t i = 0 ; i < count ; i++ ) {
+            values[i * valueBytes + b] = in[i];
+        }
+    }
+    return values;
+}
+
+/// read big endian integers; bytes are unsigned, as in FITS
+void
+readInts( const uchar * src, int valueBytes, int64_t count, qint64 * out )
+{
+    for ( int64_t i = 0 ; i < count ; i++ ) {
+        const uchar * val = src + i * valueBytes;
+        switch ( valueBytes ) {
+        case 1:
+            out[i] = * val;
+            break;
+        case 2:
+            out[i] = qFromBigEndian < qint16 > ( val );
+            break;
+        case 4:
+            out[i] = qFromBigEndian < qint32 > ( val );
+            break;
+        default:
+            out[i] = qFromBigEndian < qint64 > ( val );
+        }
+    }
+}
+
+/// read big endian floating point values
+void
+readReals( const uchar * src, int valueBytes, int64_t count, float * out )
+{
+    for ( int64_t i = 0 ; i < count ; i++ ) {
+        if ( valueBytes == 4 ) {
+            quint32 bits = qFromBigEndian < quint32 > ( src + i * 4 );
+            memcpy( out + i, & bits, 4 );
+        }
+        else {
+            quint64 bits = qFromBigEndian < quint64 > ( src + i * 8 );
+            double val;
+            memcpy( & val, & bits, 8 );
+            out[i] = val;
+        }
+    }
+}
+
+/// Rice decompression, as in the FITS tiled image compression convention
+/// \param in the compressed bytes
+/// \param inSize number of compressed bytes
+/// \param valueBytes size of the compressed integers (BYTEPIX)
+/// \param blockSize number of pixels coded with the same parameter
+/// \param count number of pixels to decode
+/// \param out the decoded pixels
+/// \return false if the compressed data ends too soon
+bool
+riceDecode( const uchar * in, qint64 inSize, int valueBytes, int blockSize, int64_t count,
+            qint64 * out )
+{
+    // bits per coding parameter, largest parameter, and bits per value
+    int fsBits = 5;
+    int fsMax = 25;
+    if ( valueBytes == 1 ) {
+        fsBits = 3;
+        fsMax = 6;
+    }
+    else if ( valueBytes == 2 ) {
+        fsBits = 4;
+        fsMax = 14;
+    }
+    const int bBits = 8 * valueBytes;
+    const quint32 valueMask = bBits == 32 ? 0xffffffffu : ( ( 1u << bBits ) - 1 );
+
+    // number of bits needed to represent a byte
+    static const std::vector < int > bitCount = [] () {
+        std::vector < int > counts( 256, 0 );
+        for ( int i = 1 ; i < 256 ; i++ ) {
+            counts[i] = counts[i / 2] + 1;
+        }
+        return counts;
+    } ();
+
+    if ( inSize < valueBytes + 1 ) {
+        return false;
+    }
+    const uchar * c = in;
+    const uchar * end = in + inSize;
+
+    // the first value is stored as is
+    quint32 lastPix = 0;
+    for ( int i = 0 ; i < valueBytes ; i++ ) {
+        lastPix = ( lastPix << 8 ) | * c++;
+    }
+
+    quint32 b = * c++;
+    int nBits = 8;
+    bool overrun = false;
+    auto nextByte = [&c, end, &overrun] () -> quint32 {
+        if ( c < end ) {
+            return * c++;
+        }
+        overrun = true;
+        return 0;
+    };
+    auto decodeDiff = [] ( quint32 diff ) -> quint32 {
+        return ( diff & 1 ) == 0 ? diff >> 1 : ~( diff >> 1 );
+    };
+    auto store = [&] ( int64_t i, quint32 val ) {
+        val &= valueMask;
+        if ( valueBytes == 1 ) {
+            out[i] = val;
+        }
+        else if ( valueBytes == 2 ) {
+            out[i] = static_cast < qint16 > ( val );
+        }
+        else {
+            out[i] = static_cast < qint32 > ( val );
+        }
+        lastPix = val;
+    };
+
+    for ( int64_t i = 0 ; i < count ; ) {
+        // the coding parameter of the block
+        nBits -= fsBits;
+        while ( nBits < 0 ) {
+            b = ( b << 8 ) | nextByte();
+            nBits += 8;
+        }
+        if ( overrun ) {
+            return false;
+        }
+        int fs = static_cast < int > ( b >> nBits ) - 1;
+        b &= ( 1u << nBits ) - 1;
+        int64_t blockEnd = std::min < int64_t > ( i + blockSize, count );
+
+        if ( fs < 0 ) {
+            // low entropy: all differences are zero
+            for ( ; i < blockEnd ; i++ ) {
+                store( i, lastPix );
+            }
+        }
+        else if ( fs == fsMax ) {
+            // high entropy: the differences are stored as they are
+            for ( ; i < blockEnd ; i++ ) {
+                int k = bBits - nBits;
+                quint32 diff = k < 32 ? b << k : 0;
+                for ( k -= 8 ; k >= 0 ; k -= 8 ) {
+                    b = nextByte();
+                    diff |= b << k;
+                }
+                if ( nBits > 0 ) {
+                    b = nextByte();
+                    diff |= b >> ( - k );
+                    b &= ( 1u << nBits ) - 1;
+                }
+                else {
+                    b = 0;
+                }
+                if ( overrun ) {
+                    return false;
+                }
+                store( i, decodeDiff( diff ) + lastPix );
+            }
+        }
+        else {
+            for ( ; i < blockEnd ; i++ ) {
+                // the number of leading zeros is the high part of the difference
+                // past the end of the input the zeros would never end
+                while ( b == 0 ) {
+                    nBits += 8;
+                    b = nextByte();
+                    if ( overrun ) {
+                        return false;
+                    }
+                }
+                int nZero = nBits - bitCount[b];
+                nBits -= nZero + 1;
+                b ^= 1u << nBits;
+
+                // followed by fs low bits
+                nBits -= fs;
+                while ( nBits < 0 ) {
+                    b = ( b << 8 ) | nextByte();
+                    nBits += 8;
+                }
+                if ( overrun ) {
+                    return false;
+                }
+                quint32 diff = ( static_cast < quint32 > ( nZero ) << fs ) | ( b >> nBits );
+                b &= ( 1u << nBits ) - 1;
+                store( i, decodeDiff( diff ) + lastPix );
+            }
+        }
+    }
+    return true;
+} // riceDecode
+}
+
+FitsTilePixels::Column
+FitsTilePixels::_column( const QMap < QString, QString > & keys, const QString & name )
+{
+    Column column;
+    int offset = 0;
+    int fieldCount = keys.value( "TFIELDS" ).toInt();
+    for ( int i = 1 ; i <= fieldCount ; i++ ) {
+        QString format = keys.value( QString( "TFORM%1" ).arg( i ) ).trimmed().toUpper();
+        int letter = 0;
+        while ( letter < format.size() && format[letter].isDigit() ) {
+            letter++;
+        }
+        if ( letter >= format.size() ) {
+            break;
+        }
+        int repeat = letter > 0 ? format.left( letter ).toInt() : 1;
+        char type = format[letter].toLatin1();
+        bool variable = type == 'P' || type == 'Q';
+        int width = 0;
+        if ( variable ) {
+            width = type == 'P' ? 8 : 16;
+        }
+        else if ( type == 'X' ) {
+            width = ( repeat + 7 ) / 8;
+        }
+        else {
+            width = repeat * typeSize( type );
+        }
+        if ( keys.value( QString( "TTYPE%1" ).arg( i ) ) == name ) {
+            column.offset = offset;
+            column.variable = variable;
+            column.longDescriptor = type == 'Q';
+            column.type = variable && letter + 1 < format.size() ? format[letter + 1].toLatin1() : type;
+            break;
+        }
+        offset += width;
+    }
+    return column;
+}
+
+FitsTilePixels::SharedPtr
+FitsTilePixels::create( const QString & fileName, unsigned int hdu,
+                        const QMap < QString, QString > & keys, const uchar * data,
+                        qint64 dataSize )
+{
+    if ( keys.value( "ZIMAGE" ) != "T" ) {
+        return nullptr;
+    }
+    FitsTilePixels::SharedPtr pixels = std::make_shared < FitsTilePixels > ();
+
+    QString compression = keys.value( "ZCMPTYPE" );
+    if ( compression == "RICE_1" || compression == "RICE_ONE" ) {
+        pixels-> m_compression = Compression::Rice;
+    }
+    else if ( compression == "GZIP_1" ) {
+        pixels-> m_compression = Compression::Gzip1;
+    }
+    else if ( compression == "GZIP_2" ) {
+        pixels-> m_compression = Compression::Gzip2;
+    }
+    else if ( compression == "NOCOMPRESS" ) {
+        pixels-> m_compression = Compression::None;
+    }
+    else {
+        qDebug() << "Unsupported tile compression" << compression;
+        return nullptr;
+    }
+
+    pixels-> m_bitpix = keys.value( "ZBITPIX" ).toInt();
+    int naxis = keys.value( "ZNAXIS" ).toInt();
+    if ( naxis < 2 ) {
+        return nullptr;
+    }
+    qint64 tileCount = 1;
+    for ( int i = 1 ; i <= naxis ; i++ ) {
+        int axisLength = keys.value( QString( "ZNAXIS%1" ).arg( i ) ).toInt();
+        // by default every row is a tile
+        int tileLength = keys.value( QString( "ZTILE%1" ).arg( i ), i == 1 ? QString::number( axisLength ) : "1" ).toInt();
+        if ( axisLength <= 0 || tileLength <= 0 ) {
+            return nullptr;
+        }
+        pixels-> dims.push_back( axisLength );
+        pixels-> m_tileDims.push_back( tileLength );
+        pixels-> m_tileCounts.push_back( ( axisLength + tileLength - 1 ) / tileLength );
+        tileCount *= pixels-> m_tileCounts.back();
+    }
+
+    // compression parameters
+    for ( int i = 1 ; keys.contains( QString( "ZNAME%1" ).arg( i ) ) ; i++ ) {
+        QString name = keys.value( QString( "ZNAME%1" ).arg( i ) );
+        int value = keys.value( QString( "ZVAL%1" ).arg( i ) ).toInt();
+        if ( name == "BLOCKSIZE" ) {
+            pixels-> m_blockSize = value;
+        }
+        else if ( name == "BYTEPIX" ) {
+            pixels-> m_bytePix = value;
+        }
+    }
+    if ( pixels-> m_blockSize <= 0
+         || ( pixels-> m_bytePix != 1 && pixels-> m_bytePix != 2 && pixels-> m_bytePix != 4 ) ) {
+        return nullptr;
+    }
+
+    // the binary table, a row per tile, and the heap with the compressed tiles
+    pixels-> m_rowBytes = keys.value( "NAXIS1" ).toInt();
+    qint64 rowCount = keys.value( "NAXIS2" ).toLongLong();
+    if ( rowCount != tileCount ) {
+        qWarning() << "Compressed image has" << rowCount << "tiles instead of" << tileCount;
+        return nullptr;
+    }
+    qint64 heapOffset = keys.value( "THEAP", QString::number( pixels-> m_rowBytes * rowCount ) ).toLongLong();
+    pixels-> m_table = data;
+    pixels-> m_heap = data + heapOffset;
+    pixels-> m_end = data + dataSize;
+    pixels-> m_compressedData = _column( keys, "COMPRESSED_DATA" );
+    pixels-> m_gzipData = _column( keys, "GZIP_COMPRESSED_DATA" );
+    pixels-> m_uncompressedData = _column( keys, "UNCOMPRESSED_DATA" );
+    pixels-> m_zscale = _column( keys, "ZSCALE" );
+    pixels-> m_zzero = _column( keys, "ZZERO" );
+    pixels-> m_zblank = _column( keys, "ZBLANK" );
+    if ( pixels-> m_compressedData.offset < 0 || ! pixels-> m_compressedData.variable ) {
+        return nullptr;
+    }
+
+    // quantized floating point images
+    pixels-> m_quantized = pixels-> m_bitpix < 0
+                           && ( pixels-> m_zscale.offset >= 0 || keys.contains( "ZSCALE" ) );
+    pixels-> m_zscaleKey = keys.value( "ZSCALE", "1" ).toDouble();
+    pixels-> m_zzeroKey = keys.value( "ZZERO", "0" ).toDouble();
+    QString quantize = keys.value( "ZQUANTIZ" );
+    if ( quantize == "SUBTRACTIVE_DITHER_1" ) {
+        pixels-> m_dither = Dither::Subtractive1;
+    }
+    else if ( quantize == "SUBTRACTIVE_DITHER_2" ) {
+        pixels-> m_dither = Dither::Subtractive2;
+    }
+    pixels-> m_ditherSeed = keys.value( "ZDITHER0", "1" ).toInt();
+
+    // blank pixels of integer and quantized images
+    if ( keys.contains( "ZBLANK" ) ) {
+        pixels-> m_hasBlank = true;
+        pixels-> m_blank = keys.value( "ZBLANK" ).toLongLong();
+    }
+    else if ( pixels-> m_bitpix > 0 && keys.contains( "BLANK" ) ) {
+        pixels-> m_hasBlank = true;
+        pixels-> m_blank = keys.value( "BLANK" ).toLongLong();
+    }
+    if ( pixels-> m_bitpix > 0 ) {
+        pixels-> m_bscale = keys.value( "BSCALE", "1" ).toDouble();
+        pixels-> m_bzero = keys.value( "BZERO", "0" ).toDouble();
+    }
+
+    QFileInfo fileInfo( fileName );
+    pixels-> m_cacheKey = QString( "%1/%2/%3/" ).arg( fileInfo.absoluteFilePath() )
+                              .arg( fileInfo.lastModified().toMSecsSinceEpoch() ).arg( hdu );
+    return pixels;
+} // create
+
+void
+FitsTilePixels::setCacheSize( int sizeMB )
+{
+    QMutexLocker locker( & cacheMutex );
+    tileCache.setMaxCost( sizeMB * 1024 );
+}
+
+void
+FitsTilePixels::_tileBox( int64_t index, std::vector < int > & start, std::vector < int > & size ) const
+{
+    start.resize( dims.size() );
+    size.resize( dims.size() );
+    for ( size_t i = 0 ; i < dims.size() ; i++ ) {
+        start[i] = ( index % m_tileCounts[i] ) * m_tileDims[i];
+        size[i] = std::min( m_tileDims[i], dims[i] - start[i] );
+        index /= m_tileCounts[i];
+    }
+}
+
+const uchar *
+FitsTilePixels::_heapArray( const Column & column, int64_t row, qint64 & count ) const
+{
+    count = 0;
+    if ( column.offset < 0 || ! column.variable ) {
+        return nullptr;
+    }
+    const uchar * descriptor = m_table + row * m_rowBytes + column.offset;
+    qint64 offset = 0;
+    if ( column.longDescriptor ) {
+        count = qFromBigEndian < qint64 > ( descriptor );
+        offset = qFromBigEndian < qint64 > ( descriptor + 8 );
+    }
+    else {
+        count = qFromBigEndian < qint32 > ( descriptor );
+        offset = qFromBigEndian < qint32 > ( descriptor + 4 );
+    }
+    const uchar * array = m_heap + offset;
+    if ( count < 0 || offset < 0 || array + count * typeSize( column.type ) > m_end ) {
+        qWarning() << "Compressed tile" << row << "is outside of the file";
+        count = 0;
+        return nullptr;
+    }
+    return array;
+}
+
+double
+FitsTilePixels::_tileValue( const Column & column, int64_t row, double keywordValue ) const
+{
+    if ( column.offset < 0 ) {
+        return keywordValue;
+    }
+    const uchar * val = m_table + row * m_rowBytes + column.offset;
+    switch ( column.type ) {
+    case 'D': {
+        quint64 bits = qFromBigEndian < quint64 > ( val );
+        double real;
+        memcpy( & real, & bits, 8 );
+        return real;
+    }
+    case 'E': {
+        quint32 bits = qFromBigEndian < quint32 > ( val );
+        float real;
+        memcpy( & real, & bits, 4 );
+        return real;
+    }
+    case 'I':
+        return qFromBigEndian < qint16 > ( val );
+    case 'J':
+        return qFromBigEndian < qint32 > ( val );
+    case 'K':
+        return qFromBigEndian < qint64 > ( val );
+    default:
+        return keywordValue;
+    }
+}
+
+FitsTilePixels::Tile
+FitsTilePixels::_decode( int64_t index ) const
+{
+    std::vector < int > start, size;
+    _tileBox( index, start, size );
+    int64_t count = 1;
+    for ( int length : size ) {
+        count *= length;
+    }
+    const float nan = std::numeric_limits < float >::quiet_NaN();
+    std::shared_ptr < std::vector < float > > tile = std::make_shared < std::vector < float > > ( count, nan );
+    float * out = tile-> data();
+
+    qint64 arrayCount = 0;
+    const uchar * array = _heapArray( m_compressedData, index, arrayCount );
+    qint64 arrayBytes = arrayCount * typeSize( m_compressedData.type );
+    bool decoded = false;
+
+    if ( array && arrayCount > 0 && ( m_quantized || m_bitpix > 0 ) ) {
+        // integers, either the pixels themselves or quantized floats
+        std::vector < qint64 > ints( count );
+        int valueBytes = m_quantized ? 4 : m_bitpix / 8;
+        if ( m_compression == Compression::Rice ) {
+            decoded = riceDecode( array, arrayBytes, m_bytePix, m_blockSize, count, ints.data() );
+        }
+        else if ( m_compression == Compression::None ) {
+            valueBytes = typeSize( m_compressedData.type );
+            decoded = valueBytes > 0 && arrayBytes >= count * valueBytes;
+            if ( decoded ) {
+                readInts( array, valueBytes, count, ints.data() );
+            }
+        }
+        else {
+            std::vector < uchar > bytes( count * valueBytes );
+            decoded = inflateBytes( array, arrayBytes, bytes.data(), bytes.size() );
+            if ( decoded ) {
+                if ( m_compression == Compression::Gzip2 ) {
+                    bytes = unshuffle( bytes, count, valueBytes );
+                }
+                readInts( bytes.data(), valueBytes, count, ints.data() );
+            }
+        }
+
+        if ( decoded && m_quantized ) {
+            double scale = _tileValue( m_zscale, index, m_zscaleKey );
+            double zero = _tileValue( m_zzero, index, m_zzeroKey );
+            bool hasBlank = m_hasBlank || m_zblank.offset >= 0;
+            qint64 blank = static_cast < qint64 > ( _tileValue( m_zblank, index, m_blank ) );
+            const std::vector < float > & random = randomValues();
+            int seed = ( index + m_ditherSeed - 1 ) % N_RANDOM;
+            int nextRandom = static_cast < int > ( random[seed] * 500 );
+            for ( int64_t i = 0 ; i < count ; i++ ) {
+                if ( hasBlank && ints[i] == blank ) {
+                    out[i] = nan;
+                }
+                else if ( m_dither == Dither::None ) {
+                    out[i] = ints[i] * scale + zero;
+                }
+                else if ( m_dither == Dither::Subtractive2 && ints[i] == ZERO_VALUE ) {
+                    out[i] = 0;
+                }
+                else {
+                    out[i] = ( ints[i] - random[nextRandom] + 0.5 ) * scale + zero;
+                }
+                if ( m_dither != Dither::None && ++nextRandom == N_RANDOM ) {
+                    seed = ( seed + 1 ) % N_RANDOM;
+                    nextRandom = static_cast < int > ( random[seed] * 500 );
+                }
+            }
+        }
+        else if ( decoded ) {
+            for ( int64_t i = 0 ; i < count ; i++ ) {
+                if ( m_hasBlank && ints[i] == m_blank ) {
+                    out[i] = nan;
+                }
+                else {
+                    out[i] = ints[i] * m_bscale + m_bzero;
+                }
+            }
+        }
+    }
+    else if ( array && arrayCount > 0 && m_compression != Compression::Rice ) {
+        // floating point pixels compressed losslessly
+        int valueBytes = - m_bitpix / 8;
+        if ( m_compression == Compression::None ) {
+            decoded = arrayBytes >= count * valueBytes;
+            if ( decoded ) {
+                readReals( array, valueBytes, count, out );
+            }
+        }
+        else {
+            std::vector < uchar > bytes( count * valueBytes );
+            decoded = inflateBytes( array, arrayBytes, bytes.data(), bytes.size() );
+            if ( decoded ) {
+                if ( m_compression == Compression::Gzip2 ) {
+                    bytes = unshuffle( bytes, count, valueBytes );
+                }
+                readReals( bytes.data(), valueBytes, count, out );
+            }
+        }
+    }
+    else {
+        // tiles that could not be quantized are kept as they are, or gzipped
+        int valueBytes = std::abs( m_bitpix ) / 8;
+        array = _heapArray( m_gzipData, index, arrayCount );
+        if ( array && arrayCount > 0 ) {
+            std::vector < uchar > bytes( count * valueBytes );
+            decoded = inflateBytes( array, arrayCount * typeSize( m_gzipData.type ), bytes.data(), bytes.size() );
+            if ( decoded ) {
+                readReals( bytes.data(), valueBytes, count, out );
+            }
+        }
+        else {
+            array = _heapArray( m_uncompressedData, index, arrayCount );
+            valueBytes = typeSize( m_uncompressedData.type );
+            decoded = array && arrayCount >= count && ( valueBytes == 4 || valueBytes == 8 );
+            if ( decoded ) {
+                readReals( array, valueBytes, count, out );
+            }
+        }
+    }
+
+    if ( ! decoded ) {
+        qWarning() << "Could not decompress tile" << index;
+    }
+    return tile;
+} // _decode
+
+FitsTilePixels::Tile
+FitsTilePixels::_tile( int64_t index ) const
+{
+    QString key = m_cacheKey + QString::number( index );
+    {
+        QMutexLocker locker( & cacheMutex );
+        Tile * cached = tileCache.object( key );
+        if ( cached ) {
+            return * cached;
+        }
+    }
+    Tile tile = _decode( index );
+    QMutexLocker locker( & cacheMutex );
+    tileCache.insert( key, new Tile( tile ), tile-> size() * sizeof( float ) / 1024 + 1 );
+    return tile;
+}
+
+void
+FitsTilePixels::prepare( const std::vector < Slice1D::ApplyResult > & box ) const
+{
+    // the tiles touched along every axis
+    std::vector < std::vector < int > > tileCoords( dims.size() );
+    for ( size_t i = 0 ; i < dims.size() ; i++ ) {
+        int count = i < box.size() ? ( box[i].isSingle() ? 1 : box[i].count ) : dims[i];
+        int first = i < box.size() ? box[i].start : 0;
+        int step = i < box.size() ? box[i].step : 1;
+        for ( int k = 0 ; k < count ; k++ ) {
+            int tile = ( first + k * step ) / m_tileDims[i];
+            if ( tileCoords[i].empty() || tileCoords[i].back() != tile ) {
+                tileCoords[i].push_back( tile );
+            }
+        }
+        if ( tileCoords[i].empty() ) {
+            return;
+        }
+    }
+
+    // no more tiles are decompressed than the cache can hold
+    qint64 tilePixels = 1;
+    for ( int length : m_tileDims ) {
+        tilePixels *= length;
+    }
+    qint64 tileKB = tilePixels * sizeof( float ) / 1024 + 1;
+    std::vector < int64_t > missing;
+    {
+        QMutexLocker locker( & cacheMutex );
+        int64_t capacity = tileCache.maxCost() / tileKB;
+        std::vector < size_t > k( dims.size(), 0 );
+        while ( static_cast < int64_t > ( missing.size() ) < capacity ) {
+            int64_t index = 0;
+            int64_t gridStride = 1;
+            for ( size_t i = 0 ; i < dims.size() ; i++ ) {
+                index += tileCoords[i][k[i]] * gridStride;
+                gridStride *= m_tileCounts[i];
+            }
+            if ( ! tileCache.contains( m_cacheKey + QString::number( index ) ) ) {
+                missing.push_back( index );
+            }
+
+            // next combination of tiles
+            size_t axis = 0;
+            for ( ; axis < dims.size() ; axis++ ) {
+                if ( ++k[axis] < tileCoords[axis].size() ) {
+                    break;
+                }
+                k[axis] = 0;
+            }
+            if ( axis == dims.size() ) {
+                break;
+            }
+        }
+    }
+    if ( missing.empty() ) {
+        return;
+    }
+
+    Carta::Lib::Algorithms::ParallelTasks::run( missing.size(), [this, &missing] ( int i, int ) {
+        Tile tile = _decode( missing[i] );
+        QMutexLocker locker( & cacheMutex );
+        tileCache.insert( m_cacheKey + QString::number( missing[i] ), new Tile( tile ),
+                          tile-> size() * sizeof( float ) / 1024 + 1 );
+    } );
+} // prepare
+
+void
+FitsTilePixels::readRow( int64_t offset, int64_t count, int64_t step, float * out ) const
+{
+    std::vector < int > pos( dims.size() );
+    for ( size_t i = 0 ; i < dims.size() ; i++ ) {
+        pos[i] = offset % dims[i];
+        offset /= dims[i];
+    }
+
+    // copy the pixels a tile at a time
+    std::vector < int > start, size;
+    int64_t x = pos[0];
+    int64_t i = 0;
+    while ( i < count ) {
+        int64_t index = x / m_tileDims[0];
+        int64_t gridStride = m_tileCounts[0];
+        for ( size_t a = 1 ; a < dims.size() ; a++ ) {
+            index += ( pos[a] / m_tileDims[a] ) * gridStride;
+            gridStride *= m_tileCounts[a];
+        }
+        Tile tile = _tile( index );
+        _tileBox( index, start, size );
+        int64_t inner = 0;
+        int64_t tileStride = size[0];
+        for ( size_t a = 1 ; a < dims.size() ; a++ ) {
+            inner += ( pos[a] - start[a] ) * tileStride;
+            tileStride *= size[a];
+        }
+        const float * row = tile-> data() + inner - start[0];
+        while ( i < count && x >= start[0] && x < start[0] + size[0] ) {
+            out[i++] = row[x];
+            x += step;
+        }
+    }
+} // readRow
@@ -0,0 +1,126 @@
+/**
+ *
+ **/
+
+#pragma once
+
+#include "FitsMmapRawView.h"
+#include <QMap>
+#include <QString>
+#include <memory>
+#include <vector>
+
+/// pixels of a tile compressed FITS image (ZIMAGE = T), read from the binary
+/// table in a memory mapped file
+///
+/// Tiles are decompressed when they are first read and kept, as floats, in a
+/// cache of bounded size shared by all the compressed images. Before a plane is
+/// read, all the tiles it intersects that are not cached are decompressed in
+/// parallel. RICE_1, GZIP_1, GZIP_2 and NOCOMPRESS tiles are supported, including
+/// quantized floating point images with or without subtractive dithering.
+class FitsTilePixels
+    : public FitsPixelSource
+{
+    CLASS_BOILERPLATE( FitsTilePixels );
+
+public:
+
+    /// describe the compressed image of a binary table HDU
+    /// \param fileName the FITS file, used to identify cached tiles
+    /// \param hdu index of the HDU
+    /// \param keys the header keywords and values of the HDU
+    /// \param data first byte of the table, inside the mapping
+    /// \param dataSize number of bytes of the table and its heap
+    /// \return the pixels, or nullptr if the compression is not supported
+    static FitsTilePixels::SharedPtr
+    create( const QString & fileName, unsigned int hdu, const QMap < QString, QString > & keys,
+            const uchar * data, qint64 dataSize );
+
+    /// set the size of the tile cache
+    /// \param sizeMB largest amount of decompressed pixels kept, in megabytes
+    static void
+    setCacheSize( int sizeMB );
+
+    virtual void
+    readRow( int64_t offset, int64_t count, int64_t step, float * out ) const override;
+
+    virtual void
+    prepare( const std::vector < Slice1D::ApplyResult > & box ) const override;
+
+private:
+
+    typedef std::shared_ptr < const std::vector < float > > Tile;
+
+    /// a column of the binary table
+    struct Column {
+        /// offset of the column in a row, or -1 if there is no such column
+        int offset = - 1;
+        /// format letter; for variable length arrays, the letter of the elements
+        char type = 0;
+        /// true for a P or Q variable length array descriptor
+        bool variable = false;
+        bool longDescriptor = false;
+    };
+
+    /// the cached tile, decompressing it if it is not cached
+    Tile
+    _tile( int64_t index ) const;
+
+    /// decompress a tile
+    Tile
+    _decode( int64_t index ) const;
+
+    /// first pixel and size of a tile along every axis
+    void
+    _tileBox( int64_t index, std::vector < int > & start, std::vector < int > & size ) const;
+
+    /// bytes of a variable length array of a tile, and the number of elements
+    const uchar *
+    _heapArray( const Column & column, int64_t row, qint64 & count ) const;
+
+    /// a numeric value of a tile, from a column if there is one or else a keyword
+    double
+    _tileValue( const Column & column, int64_t row, double keywordValue ) const;
+
+    static Column
+    _column( const QMap < QString, QString > & keys, const QString & name );
+
+    /// identifies the tiles of this image in the cache
+    QString m_cacheKey;
+
+    const uchar * m_table = nullptr;
+    const uchar * m_heap = nullptr;
+    const uchar * m_end = nullptr;
+    int m_rowBytes = 0;
+
+    /// ZTILEn and the number of tiles along every axis
+    std::vector < int > m_tileDims;
+    std::vector < int > m_tileCounts;
+
+    enum class Compression { Rice, Gzip1, Gzip2, None };
+    Compression m_compression = Compression::None;
+    int m_blockSize = 32;
+    int m_bytePix = 4;
+
+    /// ZBITPIX
+    int m_bitpix = 0;
+
+    enum class Dither { None, Subtractive1, Subtractive2 };
+    Dither m_dither = Dither::None;
+    int m_ditherSeed = 1;
+
+    Column m_compressedData;
+    Column m_gzipData;
+    Column m_uncompressedData;
+    Column m_zscale;
+    Column m_zzero;
+    Column m_zblank;
+
+    double m_zscaleKey = 1;
+    double m_zzeroKey = 0;
+    bool m_quantized = false;
+    bool m_hasBlank = false;
+    qint64 m_blank = 0;
+    double m_bscale = 1;
+    double m_bzero = 0;
+};
@@ -0,0 +1,556 @@
+#include "CubeFitEngine.h"
+#include "LMGaussFitter1d.h"
+#include "CartaLib/Algorithms/ParallelTasks.h"
+#include "CartaLib/IImage.h"
+#include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/Regions/Point.h"
+#include "CartaLib/Regions/RegionMask.h"
+
+#include <QDebug>
+#include <QtCore/qmath.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+//Largest amount of the cube a parallel task reads at once.
+const qint64 BLOCK_BYTES = 16 * 1024 * 1024;
+
+//Number of tasks per thread, so that threads finishing early can help the others.
+const int TASKS_PER_THREAD = 4;
+
+//Most Levenberg-Marquardt iterations for one spectrum.
+const int MAX_ITERATIONS = 100;
+
+//A fit started from a neighbouring solution is redone from a guess when its
+//residual is this much worse than the neighbour's.
+const double REFIT_RATIO = 2;
+}
+
+using Carta::Lib::Hooks::FitCubeHook;
+using Optimization::VD;
+using Optimization::Gaussian1DFitting::FitterInput;
+
+struct CubeFitEngine::Layout {
+    std::vector<int> dims;
+    //The box of the plane that is read, inclusive.
+    int x0;
+    int x1;
+    int y0;
+    int y1;
+    int channelMin;
+    int channelCount;
+    int gaussCount;
+    int polyTerms;
+    //Spectral coordinate of every channel of the cube.
+    std::vector<double> spectralValues;
+    //Which pixels of the box are used; empty if they all are.
+    std::vector<char> mask;
+
+    int paramCount() const {
+        return gaussCount * 3 + polyTerms;
+    }
+
+    //Spectral coordinate at a fractional channel of the cube.
+    double coordinate( double channel ) const {
+        int last = spectralValues.size() - 1;
+        int k = std::max( 0, std::min( static_cast<int>( std::floor( channel ) ), last - 1 ) );
+        return spectralValues[k] + ( channel - k ) * ( spectralValues[k + 1] - spectralValues[k] );
+    }
+
+    //Width of a channel in spectral coordinates, near a fractional channel.
+    double increment( double channel ) const {
+        int last = spectralValues.size() - 1;
+        int k = std::max( 0, std::min( static_cast<int>( std::floor( channel ) ), last - 1 ) );
+        return std::fabs( spectralValues[k + 1] - spectralValues[k] );
+    }
+};
+
+
+CubeFitEngine::CubeFitEngine(){
+}
+
+
+std::vector< std::vector<float> > CubeFitEngine::compute(
+        const FitCubeHook::Params& params, QString* errorMsg ){
+    std::vector< std::vector<float> > maps;
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image = params.m_dataSource;
+    if ( !image ){
+        *errorMsg = "There is no image to fit.";
+        return maps;
+    }
+    if ( image->pixelType() != Carta::Lib::Image::PixelType::Real32 ){
+        *errorMsg = "Only images of 32 bit floating point pixels can be fitted.";
+        return maps;
+    }
+    Layout layout;
+    layout.dims = image->dims();
+    int dimCount = layout.dims.size();
+    int spectralAxis = params.m_spectralAxis;
+    if ( spectralAxis < 2 || spectralAxis >= dimCount ){
+        *errorMsg = "Fitting needs a cube with a spectral axis after the two spatial axes.";
+        return maps;
+    }
+    int channels = layout.dims[spectralAxis];
+    if ( channels < 2 || static_cast<int>( params.m_spectralValues.size() ) != channels ){
+        *errorMsg = "Fitting needs the spectral coordinate of every channel.";
+        return maps;
+    }
+    if ( params.m_gaussCount < 1 || params.m_polyTerms < 0 ){
+        *errorMsg = "Please specify at least one Gaussian and a polynomial of degree 0 or more.";
+        return maps;
+    }
+    layout.gaussCount = params.m_gaussCount;
+    layout.polyTerms = params.m_polyTerms;
+    layout.spectralValues = params.m_spectralValues;
+
+    //Channel range
+    int channelMin = params.m_channelMin < 0 ? 0 : params.m_channelMin;
+    int channelMax = params.m_channelMax < 0 ? channels - 1 : params.m_channelMax;
+    channelMax = std::min( channelMax, channels - 1 );
+    layout.channelMin = channelMin;
+    layout.channelCount = channelMax - channelMin + 1;
+    if ( layout.channelCount <= layout.paramCount() ){
+        *errorMsg = "The channel range "+QString::number( params.m_channelMin )+" to "+
+                QString::number( params.m_channelMax )+" does not have enough channels to fit "+
+                QString::number( layout.paramCount() )+" parameters.";
+        return maps;
+    }
+
+    //Only the part of the plane covered by the region is read.
+    int width = layout.dims[0];
+    int height = layout.dims[1];
+    layout.x0 = 0;
+    layout.x1 = width - 1;
+    layout.y0 = 0;
+    layout.y1 = height - 1;
+    if ( params.m_regionInfo ){
+        QRectF box = params.m_regionInfo->outlineBox();
+        if ( params.m_regionInfo->typeName() == Carta::Lib::Regions::Point::TypeName ){
+            box = QRectF( box.center(), box.center() );
+        }
+        layout.x0 = std::max( qFloor( box.left() ), 0 );
+        layout.x1 = std::min( qCeil( box.right() ), width - 1 );
+        layout.y0 = std::max( qFloor( box.top() ), 0 );
+        layout.y1 = std::min( qCeil( box.bottom() ), height - 1 );
+        if ( layout.x0 > layout.x1 || layout.y0 > layout.y1 ){
+            *errorMsg = "The region does not cover any pixels of the image.";
+            return maps;
+        }
+        layout.mask = _getRegionMask( params, layout );
+    }
+
+    //Split the box into blocks of rows small enough to be read at once, and into
+    //enough of them to keep all the threads busy.  Larger blocks give the fits
+    //more neighbouring solutions to start from.
+    int boxWidth = layout.x1 - layout.x0 + 1;
+    int boxHeight = layout.y1 - layout.y0 + 1;
+    qint64 rowBytes = qint64( boxWidth ) * layout.channelCount * sizeof( float );
+    int rowsPerBlock = std::max<qint64>( 1, BLOCK_BYTES / rowBytes );
+    int taskTarget = Carta::Lib::Algorithms::ParallelTasks::threadCountMax() * TASKS_PER_THREAD;
+    rowsPerBlock = std::min( rowsPerBlock, std::max( 1, boxHeight / taskTarget ) );
+    int blockCount = ( boxHeight + rowsPerBlock - 1 ) / rowsPerBlock;
+
+    int mapCount = layout.gaussCount * 3 + 1;
+    maps.resize( mapCount );
+    for ( int i = 0; i < mapCount; i++ ){
+        maps[i].assign( qint64( width ) * height, std::numeric_limits<float>::quiet_NaN() );
+    }
+
+    std::atomic<bool> readOk( true );
+    if ( !params.m_average ){
+        Carta::Lib::Algorithms::ParallelTasks::run( blockCount, image, [&]( int block, Carta::Lib::Image::ImageInterface* handle ){
+            if ( !readOk ){
+                return;
+            }
+            int firstRow = layout.y0 + block * rowsPerBlock;
+            int lastRow = std::min( firstRow + rowsPerBlock - 1, layout.y1 );
+            if ( !_computeBlock( handle, params, layout, firstRow, lastRow, maps ) ){
+                readOk = false;
+            }
+        });
+    }
+    else {
+        //Add up the spectra block by block, then fit their mean once.
+        std::vector< std::vector<double> > blockSums( blockCount );
+        std::vector< std::vector<int> > blockCounts( blockCount );
+        Carta::Lib::Algorithms::ParallelTasks::run( blockCount, image, [&]( int block, Carta::Lib::Image::ImageInterface* handle ){
+            if ( !readOk ){
+                return;
+            }
+            int firstRow = layout.y0 + block * rowsPerBlock;
+            int lastRow = std::min( firstRow + rowsPerBlock - 1, layout.y1 );
+            if ( !_sumBlock( handle, params, layout, firstRow, lastRow,
+                    blockSums[block], blockCounts[block] ) ){
+                readOk = false;
+            }
+        });
+        if ( readOk ){
+            VD spectrum( layout.channelCount, 0 );
+            std::vector<int> counts( layout.channelCount, 0 );
+            for ( int block = 0; block < blockCount; block++ ){
+                for ( int k = 0; k < layout.channelCount; k++ ){
+                    spectrum[k] += blockSums[block][k];
+                    counts[k] += blockCounts[block][k];
+                }
+            }
+            int valid = 0;
+            for ( int k = 0; k < layout.channelCount; k++ ){
+                if ( counts[k] > 0 ){
+                    spectrum[k] /= counts[k];
+                    valid++;
+                }
+                else {
+                    spectrum[k] = std::numeric_limits<double>::quiet_NaN();
+                }
+            }
+            if ( valid <= layout.paramCount() ){
+                *errorMsg = "There is not enough data to fit.";
+                maps.clear();
+                return maps;
+            }
+            FitterInput input( spectrum );
+            input.x1 = 0;
+            input.x2 = layout.channelCount - 1;
+            input.nGaussians = layout.gaussCount;
+            input.nPolyTerms = layout.polyTerms;
+            input.precomputeRangeMinMax();
+            input.setDefaultRanges();
+            Optimization::Gaussian1DFitting::LMFitter fitter( input );
+            VD solution;
+            double rms = _fit( fitter, _guess( input ), solution );
+            if ( !_isPlausible( input, solution ) ){
+                *errorMsg = "No Gaussians could be fitted to the mean spectrum.";
+                maps.clear();
+                return maps;
+            }
+            for ( int y = layout.y0; y <= layout.y1; y++ ){
+                for ( int x = layout.x0; x <= layout.x1; x++ ){
+                    qint64 boxIndex = qint64( y - layout.y0 ) * boxWidth + x - layout.x0;
+                    if ( layout.mask.empty() || layout.mask[boxIndex] ){
+                        _setSolution( layout, solution, rms, qint64( y ) * width + x, maps );
+                    }
+                }
+            }
+        }
+    }
+    if ( !readOk ){
+        *errorMsg = "The pixels of the image could not be read.";
+        maps.clear();
+    }
+    return maps;
+}
+
+
+bool CubeFitEngine::_computeBlock( Carta::Lib::Image::ImageInterface* image,
+        const FitCubeHook::Params& params, const Layout& layout,
+        int firstRow, int lastRow, std::vector< std::vector<float> >& maps ){
+    std::vector<float> cube;
+    if ( !_readBlock( image, params, layout, firstRow, lastRow, cube ) ){
+        return false;
+    }
+    int boxWidth = layout.x1 - layout.x0 + 1;
+    qint64 planeSize = qint64( boxWidth ) * ( lastRow - firstRow + 1 );
+    qint64 maskStart = qint64( firstRow - layout.y0 ) * boxWidth;
+    int paramCount = layout.paramCount();
+    int width = layout.dims[0];
+
+    //Solutions of the spectra of the block, so that their neighbours can start
+    //from them; a NaN residual marks a spectrum that was not fitted.
+    std::vector<double> solutions( planeSize * paramCount );
+    std::vector<double> residuals( planeSize, std::numeric_limits<double>::quiet_NaN() );
+
+    VD spectrum( layout.channelCount );
+    FitterInput input( spectrum );
+    input.x1 = 0;
+    input.x2 = layout.channelCount - 1;
+    input.nGaussians = layout.gaussCount;
+    input.nPolyTerms = layout.polyTerms;
+    Optimization::Gaussian1DFitting::LMFitter fitter( input );
+    VD start;
+    VD solution;
+    VD candidate;
+    for ( qint64 p = 0; p < planeSize; p++ ){
+        if ( !layout.mask.empty() && !layout.mask[maskStart + p] ){
+            continue;
+        }
+        int valid = 0;
+        for ( int k = 0; k < layout.channelCount; k++ ){
+            spectrum[k] = cube[k * planeSize + p];
+            if ( !std::isnan( spectrum[k] ) ){
+                valid++;
+            }
+        }
+        if ( valid <= paramCount ){
+            continue;
+        }
+        input.precomputeRangeMinMax();
+        input.setDefaultRanges();
+
+        //Start from the better of the solutions to the left and above.
+        qint64 seed = -1;
+        if ( p % boxWidth > 0 && !std::isnan( residuals[p - 1] ) ){
+            seed = p - 1;
+        }
+        if ( p >= boxWidth && !std::isnan( residuals[p - boxWidth] ) &&
+                ( seed < 0 || residuals[p - boxWidth] < residuals[seed] ) ){
+            seed = p - boxWidth;
+        }
+        double rms = std::numeric_limits<double>::infinity();
+        bool plausible = false;
+        if ( seed >= 0 ){
+            start.assign( solutions.begin() + seed * paramCount,
+                    solutions.begin() + ( seed + 1 ) * paramCount );
+            rms = _fit( fitter, start, solution );
+            plausible = _isPlausible( input, solution );
+        }
+        if ( !plausible || rms > REFIT_RATIO * residuals[seed] ){
+            double guessRms = _fit( fitter, _guess( input ), candidate );
+            if ( _isPlausible( input, candidate ) && ( !plausible || guessRms < rms ) ){
+                solution.swap( candidate );
+                rms = guessRms;
+                plausible = true;
+            }
+        }
+        if ( !plausible ){
+            continue;
+        }
+        std::copy( solution.begin(), solution.end(), solutions.begin() + p * paramCount );
+        residuals[p] = rms;
+        int x = layout.x0 + p % boxWidth;
+        int y = firstRow + p / boxWidth;
+        _setSolution( layout, solution, rms, qint64( y ) * width + x, maps );
+    }
+    return true;
+}
+
+
+double CubeFitEngine::_fit( Optimization::Gaussian1DFitting::LMFitter& fitter,
+        const VD& start, VD& solution ){
+    FitterInput& input = fitter.di;
+    fitter.setInitialParams( start );
+    for ( int i = 0; i < MAX_ITERATIONS; i++ ){
+        if ( fitter.iterate() ){
+            break;
+        }
+    }
+    fitter.getResults( solution );
+    input.clampParams( solution );
+    int valid = 0;
+    for ( int x = input.x1; x <= input.x2; x++ ){
+        if ( !std::isnan( input.data[x] ) ){
+            valid++;
+        }
+    }
+    return std::sqrt( input.calculateDiffSq( solution ) / valid );
+}
+
+
+QStringList CubeFitEngine::getNames( int gaussCount ){
+    QStringList names;
+    for ( int i = 0; i < gaussCount; i++ ){
+        QString suffix = gaussCount > 1 ? "_" + QString::number( i + 1 ) : "";
+        names.append( "amplitude" + suffix );
+        names.append( "center" + suffix );
+        names.append( "fwhm" + suffix );
+    }
+    names.append( "residual" );
+    return names;
+}
+
+
+std::vector<char> CubeFitEngine::_getRegionMask( const FitCubeHook::Params& params,
+        const Layout& layout ){
+    //Pixels are inside when their centers are.
+    Carta::Lib::Regions::RegionMask::ConstSharedPtr regionMask =
+            Carta::Lib::Regions::RegionMask::get( params.m_regionInfo.get(),
+                    layout.dims[0], layout.dims[1] );
+    return regionMask->toBitmap( QRect( QPoint( layout.x0, layout.y0 ),
+            QPoint( layout.x1, layout.y1 ) ) );
+}
+
+
+QStringList CubeFitEngine::getUnits( int gaussCount, const QString& pixelUnit,
+        const QString& spectralUnit ){
+    QStringList units;
+    for ( int i = 0; i < gaussCount; i++ ){
+        units.append( pixelUnit );
+        units.append( spectralUnit );
+        units.append( spectralUnit );
+    }
+    units.append( pixelUnit );
+    return units;
+}
+
+
+VD CubeFitEngine::_guess( const FitterInput& input ){
+    VD guess( input.numParams(), 0 );
+    VD residual( input.data.begin() + input.x1, input.data.begin() + input.x2 + 1 );
+    int count = residual.size();
+
+    //A constant baseline at the median of the spectrum.
+    if ( input.nPolyTerms > 0 ){
+        VD values;
+        for ( double value : residual ){
+            if ( !std::isnan( value ) ){
+                values.push_back( value );
+            }
+        }
+        std::nth_element( values.begin(), values.begin() + values.size() / 2, values.end() );
+        double baseline = values[values.size() / 2];
+        guess[input.nGaussians * 3] = baseline;
+        for ( double& value : residual ){
+            value -= baseline;
+        }
+    }
+
+    //Each Gaussian is put on the highest peak left after taking away the ones
+    //before it, with the width of the peak at half its height.
+    for ( int i = 0; i < input.nGaussians; i++ ){
+        int peak = -1;
+        for ( int x = 0; x < count; x++ ){
+            if ( !std::isnan( residual[x] ) && ( peak < 0 || residual[x] > residual[peak] ) ){
+                peak = x;
+            }
+        }
+        if ( peak < 0 ){
+            break;
+        }
+        double half = residual[peak] / 2;
+        int left = peak;
+        while ( left > 0 && !( residual[left - 1] < half ) ){
+            left--;
+        }
+        int right = peak;
+        while ( right < count - 1 && !( residual[right + 1] < half ) ){
+            right++;
+        }
+        Optimization::Gauss1dNiceParams gauss;
+        gauss.center = input.x1 + peak;
+        gauss.amplitude = residual[peak];
+        gauss.fwhm = right - left + 1;
+        VD ugly = gauss.convertToUgly();
+        std::copy( ugly.begin(), ugly.end(), guess.begin() + i * 3 );
+        for ( int x = 0; x < count; x++ ){
+            residual[x] -= Optimization::evalGauss1d( input.x1 + x, ugly.data() );
+        }
+    }
+    return guess;
+}
+
+
+bool CubeFitEngine::_isPlausible( const FitterInput& input, const VD& solution ){
+    if ( static_cast<int>( solution.size() ) != input.numParams() ){
+        return false;
+    }
+    for ( double value : solution ){
+        if ( !std::isfinite( value ) ){
+            return false;
+        }
+    }
+    for ( int i = 0; i < input.nGaussians; i++ ){
+        double center = solution[i * 3];
+        if ( center < input.x1 || center > input.x2 || solution[i * 3 + 2] >= 0 ){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool CubeFitEngine::_readBlock( Carta::Lib::Image::ImageInterface* image,
+        const FitCubeHook::Params& params, const Layout& layout,
+        int firstRow, int lastRow, std::vector<float>& cube ){
+    int dimCount = layout.dims.size();
+    SliceND slice;
+    for ( int i = 0; i < dimCount; i++ ){
+        if ( i == 0 ){
+            slice.start( layout.x0 ).end( layout.x1 + 1 );
+        }
+        else if ( i == 1 ){
+            slice.start( firstRow ).end( lastRow + 1 );
+        }
+        else if ( i == params.m_spectralAxis ){
+            slice.start( layout.channelMin ).end( layout.channelMin + layout.channelCount );
+        }
+        else {
+            int frame = i < static_cast<int>( params.m_frames.size() ) ? params.m_frames[i] : 0;
+            frame = std::max( 0, std::min( frame, layout.dims[i] - 1 ) );
+            slice.start( frame ).end( frame + 1 );
+        }
+        slice.step( 1 );
+        if ( i < dimCount - 1 ){
+            slice.next();
+        }
+    }
+    std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> view( image->getDataSlice( slice ) );
+    if ( !view ){
+        return false;
+    }
+    int boxWidth = layout.x1 - layout.x0 + 1;
+    qint64 total = qint64( boxWidth ) * ( lastRow - firstRow + 1 ) * layout.channelCount;
+    cube.resize( total );
+    qint64 filled = 0;
+    view->forEach( BLOCK_BYTES, [&]( const char* data, int64_t count ){
+        count = std::min<int64_t>( count, total - filled );
+        std::memcpy( cube.data() + filled, data, count * sizeof( float ) );
+        filled += count;
+    });
+    return filled == total;
+}
+
+
+void CubeFitEngine::_setSolution( const Layout& layout, const VD& solution,
+        double rms, qint64 pixel, std::vector< std::vector<float> >& maps ){
+    //Gaussians are stored in the order of their centers, so that each map
+    //follows the same component across the image.
+    std::vector<int> order( layout.gaussCount );
+    for ( int i = 0; i < layout.gaussCount; i++ ){
+        order[i] = i;
+    }
+    std::sort( order.begin(), order.end(), [&solution]( int a, int b ){
+        return solution[a * 3] < solution[b * 3];
+    });
+    for ( int i = 0; i < layout.gaussCount; i++ ){
+        const double* gauss = solution.data() + order[i] * 3;
+        Optimization::Gauss1dNiceParams nice = Optimization::Gauss1dNiceParams::convert( gauss );
+        double channel = layout.channelMin + nice.center;
+        maps[i * 3][pixel] = nice.amplitude;
+        maps[i * 3 + 1][pixel] = layout.coordinate( channel );
+        maps[i * 3 + 2][pixel] = nice.fwhm * layout.increment( channel );
+    }
+    maps[layout.gaussCount * 3][pixel] = rms;
+}
+
+
+bool CubeFitEngine::_sumBlock( Carta::Lib::Image::ImageInterface* image,
+        const FitCubeHook::Params& params, const Layout& layout,
+        int firstRow, int lastRow, std::vector<double>& sums, std::vector<int>& counts ){
+    std::vector<float> cube;
+    if ( !_readBlock( image, params, layout, firstRow, lastRow, cube ) ){
+        return false;
+    }
+    int boxWidth = layout.x1 - layout.x0 + 1;
+    qint64 planeSize = qint64( boxWidth ) * ( lastRow - firstRow + 1 );
+    qint64 maskStart = qint64( firstRow - layout.y0 ) * boxWidth;
+    sums.assign( layout.channelCount, 0 );
+    counts.assign( layout.channelCount, 0 );
+    for ( int k = 0; k < layout.channelCount; k++ ){
+        const float* plane = cube.data() + k * planeSize;
+        for ( qint64 p = 0; p < planeSize; p++ ){
+            if ( std::isnan( plane[p] ) || ( !layout.mask.empty() && !layout.mask[maskStart + p] ) ){
+                continue;
+            }
+            sums[k] += plane[p];
+            counts[k]++;
+        }
+    }
+    return true;
+}
+
+
+CubeFitEngine::~CubeFitEngine(){
+}
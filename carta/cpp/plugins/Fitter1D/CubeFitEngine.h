@@ -0,0 +1,113 @@
+/**
+ * Fits Gaussians to every spectrum of a cube, in parallel.
+ */
+
+#pragma once
+
+#include "CartaLib/Hooks/FitCubeHook.h"
+#include "Gauss1d.h"
+
+#include <QStringList>
+
+#include <vector>
+
+namespace Carta {
+namespace Lib {
+namespace Image {
+class ImageInterface;
+}
+}
+}
+
+namespace Optimization {
+namespace Gaussian1DFitting {
+class LMFitter;
+}
+}
+
+class CubeFitEngine {
+
+public:
+
+    /**
+     * Returns maps of the Gaussians fitted to the spectra of a cube.  The cube is
+     * split into blocks of rows that are read, spectra and all, with one bulk read
+     * each, and the blocks are fitted in parallel.  Within a block, the fit of each
+     * spectrum starts from the solution of the spectrum to its left or above it,
+     * so neighbouring spectra that look alike converge in a few iterations; the
+     * initial guess from the spectrum itself is only used when there is no
+     * neighbouring solution or when starting from it gives a poor fit.
+     * @param params - the cube, the model to fit, and the spectra to use.  There
+     *      must be a spectral coordinate for every channel of the cube.
+     * @param errorMsg - set to a description of the problem if the cube could not
+     *      be fitted.
+     * @return - the maps named by getNames(), with the first axis of the cube
+     *      varying fastest; pixels that were not fitted are NaN.  The list is empty
+     *      if the cube could not be fitted.
+     */
+    static std::vector< std::vector<float> > compute(
+            const Carta::Lib::Hooks::FitCubeHook::Params& params, QString* errorMsg );
+
+    /**
+     * Returns the names of the maps compute() returns.
+     * @param gaussCount - the number of fitted Gaussians.
+     * @return - the amplitude, center and fwhm of each Gaussian, numbered from 1 if
+     *      there are several, followed by 'residual'.
+     */
+    static QStringList getNames( int gaussCount );
+
+    /**
+     * Returns the units of the maps compute() returns.
+     * @param gaussCount - the number of fitted Gaussians.
+     * @param pixelUnit - the unit of the pixels of the cube.
+     * @param spectralUnit - the unit of the spectral coordinates.
+     * @return - the unit of each map.
+     */
+    static QStringList getUnits( int gaussCount, const QString& pixelUnit,
+            const QString& spectralUnit );
+
+private:
+
+    //The part of the cube handled by the parallel tasks.
+    struct Layout;
+
+    //Fits the spectra of a block of rows of the cube.
+    static bool _computeBlock( Carta::Lib::Image::ImageInterface* image,
+            const Carta::Lib::Hooks::FitCubeHook::Params& params, const Layout& layout,
+            int firstRow, int lastRow, std::vector< std::vector<float> >& maps );
+
+    //Adds up the spectra of a block of rows in the region, channel by channel.
+    static bool _sumBlock( Carta::Lib::Image::ImageInterface* image,
+            const Carta::Lib::Hooks::FitCubeHook::Params& params, const Layout& layout,
+            int firstRow, int lastRow, std::vector<double>& sums, std::vector<int>& counts );
+
+    //Reads the spectra of a block of rows; the block holds one plane of the rows
+    //after the other.
+    static bool _readBlock( Carta::Lib::Image::ImageInterface* image,
+            const Carta::Lib::Hooks::FitCubeHook::Params& params, const Layout& layout,
+            int firstRow, int lastRow, std::vector<float>& cube );
+
+    //Fits the spectrum of the fitter's input starting from the given parameters and
+    //returns the rms residual; the fitter is reused from one spectrum to the next.
+    static double _fit( Optimization::Gaussian1DFitting::LMFitter& fitter,
+            const Optimization::VD& start, Optimization::VD& solution );
+
+    //Guesses the Gaussians of a spectrum from its peaks, one after the other.
+    static Optimization::VD _guess( const Optimization::Gaussian1DFitting::FitterInput& input );
+
+    //Returns whether the Gaussians of a solution are inside the fitted channels
+    //and have a finite width.
+    static bool _isPlausible( const Optimization::Gaussian1DFitting::FitterInput& input,
+            const Optimization::VD& solution );
+
+    //Stores a solution in the maps at the given pixel.
+    static void _setSolution( const Layout& layout, const Optimization::VD& solution,
+            double rms, qint64 pixel, std::vector< std::vector<float> >& maps );
+
+    //Returns which pixels of the box are inside the region.
+    static std::vector<char> _getRegionMask( const Carta::Lib::Hooks::FitCubeHook::Params& params,
+            const Layout& layout );
+
+    CubeFitEngine();
+    virtual ~CubeFitEngine();
+};
@@ -1,8 +1,16 @@
 
 #include "CartaLib/Hooks/Initialize.h"
 #include "CartaLib/Hooks/Fit1DHook.h"
+#include "CartaLib/Hooks/FitCubeHook.h"
+#include "CartaLib/IImage.h"
+#include "plugins/CasaImageLoader/CCImage.h"
+#include "plugins/CasaImageLoader/CCMetaDataInterface.h"
 #include "Gaussian1dFitService.h"
+#include "CubeFitEngine.h"
 #include "Fitter1D.h"
+
+#include <casacore/images/Images/TempImage.h>
+#include <casacore/lattices/Lattices/TiledShape.h>
 using namespace std;
 
 
@@ -25,7 +33,8 @@ Fitter1D::Fitter1D(QObject *parent) :
 std::vector<HookId> Fitter1D::getInitialHookList(){
     return {
         Carta::Lib::Hooks::Initialize::staticId,
-        Carta::Lib::Hooks::Fit1DHook::staticId
+        Carta::Lib::Hooks::Fit1DHook::staticId,
+        Carta::Lib::Hooks::FitCubeHook::staticId
     };
 }
 
@@ -75,6 +84,98 @@ void Fitter1D::_fitCurves( const Carta::Lib::Fit1DInfo& info ){
 }
 
 
+bool Fitter1D::_fitCube( Carta::Lib::Hooks::FitCubeHook& hook ){
+    Carta::Lib::Hooks::FitCubeHook::Params params = *hook.paramsPtr;
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image = params.m_dataSource;
+    if ( !image ){
+        qDebug() << "No image, cube fit returning false";
+        return false;
+    }
+
+    //The maps get the coordinate system of the cube.
+    CCImageBase * base = dynamic_cast<CCImageBase*>( image.get() );
+    CCMetaDataInterface* metaData = nullptr;
+    Carta::Lib::Image::MetaDataInterface::SharedPtr metaPtr;
+    if ( base ){
+        metaPtr = base->metaData();
+        metaData = dynamic_cast<CCMetaDataInterface*>( metaPtr.get() );
+    }
+    if ( !metaData ){
+        qWarning() << "Fitter1D: not an image created by casaimageloader...";
+        return false;
+    }
+    std::shared_ptr<casacore::CoordinateSystem> cs = metaData->getCoordinateSystem();
+
+    //Without spectral coordinates, centers and widths are in channels.
+    const std::vector<int>& dims = image->dims();
+    int dimCount = dims.size();
+    int spectralAxis = params.m_spectralAxis;
+    if ( 0 <= spectralAxis && spectralAxis < dimCount &&
+            static_cast<int>( params.m_spectralValues.size() ) != dims[spectralAxis] ){
+        params.m_spectralValues.clear();
+        for ( int i = 0; i < dims[spectralAxis]; i++ ){
+            params.m_spectralValues.push_back( i );
+        }
+        params.m_spectralUnit = "pixel";
+    }
+
+    QString errorMsg;
+    std::vector< std::vector<float> > maps = CubeFitEngine::compute( params, &errorMsg );
+    if ( maps.empty() ){
+        qWarning() << "Could not fit the cube: " << errorMsg;
+        return false;
+    }
+
+    //The maps keep all the axes of the cube, with one pixel along the axes other
+    //than the spatial ones; along the spectral axis, that pixel is at the middle
+    //of the channel range.
+    int channelMin = std::max( params.m_channelMin, 0 );
+    int channelMax = params.m_channelMax < 0 ? dims[spectralAxis] - 1 :
+            std::min( params.m_channelMax, dims[spectralAxis] - 1 );
+    casacore::IPosition shape( dimCount, 1 );
+    casacore::Vector<casacore::Float> originShift( dimCount, 0 );
+    casacore::Vector<casacore::Float> increments( dimCount, 1 );
+    casacore::Vector<casacore::Int> newShape( dimCount, 1 );
+    for ( int i = 0; i < dimCount; i++ ){
+        if ( i < 2 ){
+            shape( i ) = dims[i];
+            newShape( i ) = dims[i];
+        }
+        else if ( i == spectralAxis ){
+            originShift( i ) = ( channelMin + channelMax ) / 2.0;
+        }
+        else if ( i < static_cast<int>( params.m_frames.size() ) ){
+            originShift( i ) = params.m_frames[i];
+        }
+    }
+    casacore::CoordinateSystem mapCS = cs->subImage( originShift, increments, newShape );
+
+    QStringList names = CubeFitEngine::getNames( params.m_gaussCount );
+    QStringList units = CubeFitEngine::getUnits( params.m_gaussCount,
+            image->getPixelUnit().toStr(), params.m_spectralUnit );
+    int mapCount = maps.size();
+    for ( int i = 0; i < mapCount; i++ ){
+        casacore::TempImage<casacore::Float>* mapImage =
+                new casacore::TempImage<casacore::Float>( casacore::TiledShape( shape ), mapCS );
+        casacore::Array<casacore::Float> pixels( shape, maps[i].data(), casacore::SHARE );
+        mapImage->put( pixels );
+        try {
+            mapImage->setUnits( casacore::Unit( units[i].toStdString() ) );
+        }
+        catch( casacore::AipsError& error ){
+            qWarning() << "Fit map without a unit: " << error.getMesg().c_str();
+        }
+        mapImage->setImageInfo( base->getImageInfo() );
+
+        Carta::Lib::Hooks::FitCubeHook::FitMap fitMap;
+        fitMap.m_name = names[i];
+        fitMap.m_image = CCImage<casacore::Float>::create( mapImage );
+        hook.result.push_back( fitMap );
+    }
+    return true;
+}
+
+
 void Fitter1D::_fitResultsCB(Gaussian1dFitService::ResultsG1dFit res){
     Carta::Lib::Fit1DInfo::StatusType statusType = _getStatus( res );
     if ( statusType == Carta::Lib::Fit1DInfo::StatusType::COMPLETE ||
@@ -134,6 +235,11 @@ bool Fitter1D::handleHook(BaseHook & hookData){
          hook.result = futureResult.get();
         return true;
     }
+    else if ( hookData.is<Carta::Lib::Hooks::FitCubeHook>()){
+        Carta::Lib::Hooks::FitCubeHook & hook
+            = static_cast<Carta::Lib::Hooks::FitCubeHook &>( hookData);
+        return _fitCube( hook );
+    }
     qWarning() << "Sorry, Fitter1D doesn't know how to handle this hook";
     return false;
 }
@@ -5,6 +5,7 @@
 
 #include "CartaLib/IPlugin.h"
 #include "CartaLib/Hooks/FitResult.h"
+#include "CartaLib/Hooks/FitCubeHook.h"
 
 #include "Gaussian1dFitService.h"
 #include <QObject>
@@ -34,6 +35,9 @@ private:
     Carta::Lib::Fit1DInfo::StatusType _getStatus( Gaussian1dFitService::ResultsG1dFit res ) const;
     void _fitCurves( const Carta::Lib::Fit1DInfo& info );
 
+    //Fits every spectrum of a cube and makes images of the fitted parameters.
+    bool _fitCube( Carta::Lib::Hooks::FitCubeHook& hook );
+
     Gaussian1dFitService::Manager* m_fitter;
     Carta::Lib::Hooks::FitResult m_fitResult;
     //Gaussian1dFitService::InputParametersG1dFit m_inputParams;
@@ -8,6 +8,7 @@ TEMPLATE = lib
 CONFIG += plugin
 
 SOURCES += \
+    CubeFitEngine.cpp \
     Fitter1D.cpp \
     Gaussian1dFitService.cpp \
     Gauss1d.cpp \
@@ -15,6 +16,7 @@ SOURCES += \
     LevMar.cpp
 
 HEADERS += \
+    CubeFitEngine.h \
     Fitter1D.h \
     Gaussian1dFitService.h \
     Gauss1d.h \
@@ -30,9 +32,22 @@ INCLUDEPATH += $${GSLROOTDIR}/include
 LIBS += -L$$GSLROOTDIR/lib -lgsl -lgslcblas
 # LIBS += $$GSLROOTDIR/lib/libgslcblas.a
 # LIBS += $$GSLROOTDIR/lib/libgsl.a
+casacoreLIBS += -L$${CASACOREDIR}/lib
+casacoreLIBS += -lcasa_lattices -lcasa_tables -lcasa_scimath -lcasa_scimath_f -lcasa_mirlib
+casacoreLIBS += -lcasa_casa -llapack -lblas -ldl
+casacoreLIBS += -lcasa_images -lcasa_coordinates -lcasa_fits -lcasa_measures
+
+LIBS += $${casacoreLIBS}
+LIBS += -L$${WCSLIBDIR}/lib -lwcs
+LIBS += -L$${CFITSIODIR}/lib -lcfitsio
 LIBS += -L$$OUT_PWD/../../core/ -lcore
 LIBS += -L$$OUT_PWD/../../CartaLib/ -lCartaLib
 
+INCLUDEPATH += $${CASACOREDIR}/include
+INCLUDEPATH += $${CASACOREDIR}/include/casacore
+INCLUDEPATH += $${WCSLIBDIR}/include
+INCLUDEPATH += $${CFITSIODIR}/include
+
 DEPENDPATH += $$PWD/../../core
 
 OTHER_FILES += \
@@ -51,3 +66,8 @@ unix:macx {
 else{
     PRE_TARGETDEPS += $$OUT_PWD/../../core/libcore.so
 }
+
+unix:!macx {
+  QMAKE_RPATHDIR=$$OUT_PWD/../../../../../CARTAvis-externals/ThirdParty/casa/trunk/linux/lib
+  QMAKE_RPATHDIR+=$${WCSLIBDIR}/lib
+}
@@ -150,6 +150,69 @@ evalNGauss1dBkg( double x, int nGaussians, int poly, const VD & v )
     return evalNGauss1dBkg( x, nGaussians, poly, & ( v[0] ) );
 }
 
+/// add amplitude * exp( variance * sqr(x - center) ) at the integer positions x1..x2
+/// to out[0] .. out[x2-x1]
+///
+/// Only a handful of exponentials are computed: going out from the position nearest
+/// the center, each value is the previous one times a ratio, and the ratio itself
+/// changes by the constant factor exp( 2 * variance ) from one position to the next.
+/// The ratios are never above 1, so values too small to represent just become 0.
+inline void
+addGauss1dRange( int x1, int x2, double center, double amplitude, double variance,
+                 double * out )
+{
+    if ( ! ( variance < 0 ) || ! std::isfinite( center ) ) {
+        for ( int x = x1 ; x <= x2 ; x++ ) {
+            double dx = x - center;
+            out[x - x1] += amplitude * exp( variance * dx * dx );
+        }
+        return;
+    }
+    double nearest = std::floor( std::min( std::max( center, double (x1) ), double (x2) ) + 0.5 );
+    int x0 = std::min( int (nearest), x2 );
+    double d0 = x0 - center;
+    double q = exp( 2 * variance );
+    double v0 = amplitude * exp( variance * d0 * d0 );
+    out[x0 - x1] += v0;
+
+    // v(x+1) = v(x) * exp( variance * ( 2 * ( x - center ) + 1 ) )
+    double v = v0;
+    double r = exp( variance * ( 2 * d0 + 1 ) );
+    for ( int x = x0 + 1 ; x <= x2 ; x++ ) {
+        v *= r;
+        r *= q;
+        out[x - x1] += v;
+    }
+
+    // v(x-1) = v(x) * exp( variance * ( 1 - 2 * ( x - center ) ) )
+    v = v0;
+    r = exp( variance * ( 1 - 2 * d0 ) );
+    for ( int x = x0 - 1 ; x >= x1 ; x-- ) {
+        v *= r;
+        r *= q;
+        out[x - x1] += v;
+    }
+} // addGauss1dRange
+
+/// evaluate the sum of N gaussians + polynomial with 'poly' terms, like evalNGauss1dBkg(),
+/// at all the integer positions x1..x2, storing the results in out[0] .. out[x2-x1]
+inline void
+evalNGauss1dBkgRange( int x1, int x2, int nGaussians, int poly, const double * p,
+                      double * out )
+{
+    const double * terms = p + nGaussians * 3;
+    for ( int x = x1 ; x <= x2 ; x++ ) {
+        double sum = 0;
+        for ( int i = poly - 1 ; i >= 0 ; i-- ) {
+            sum = sum * x + terms[i];
+        }
+        out[x - x1] = sum;
+    }
+    for ( int i = 0 ; i < nGaussians ; i++ ) {
+        addGauss1dRange( x1, x2, p[i * 3 + 0], p[i * 3 + 1], p[i * 3 + 2], out );
+    }
+}
+
 namespace Gaussian1DFitting
 {
 struct NoRangeCheckPolicy {
@@ -202,16 +265,17 @@ struct FitterInput {
         if ( DoRangeCheck ) {
             if ( int ( params.size() ) != numParams() ) { LTHROW( "params.size != numParams" ); }
         }
+        modelBuffer.resize( x2 - x1 + 1 );
+        evalNGauss1dBkgRange( x1, x2, nGaussians, nPolyTerms, & params[0], & modelBuffer[0] );
         double sum = 0;
-        double fn = 0.0, yy = 0.0, d = 0.0;
+        double yy = 0.0, d = 0.0;
         for ( int x = x1 ; x <= x2 ; x++ ) {
             yy = data[x];
             if ( std::isnan( yy ) ) {
                 continue;
             }
             else {
-                fn = evalNGauss1dBkg( x, nGaussians, nPolyTerms, params );
-                d = yy - fn;
+                d = yy - modelBuffer[x - x1];
                 sum += d * d;
             }
         }
@@ -221,6 +285,10 @@ struct FitterInput {
     /// ranges for parameters (the size of this array should be nGaussians * 3 + nPolyTerms)
     std::vector < RangeParam > ranges;
 
+    /// model values between x1 and x2, kept so that calculateDiffSq() does not
+    /// allocate on every call
+    VD modelBuffer;
+
     int
     numParams() const { return nGaussians * 3 + nPolyTerms; }
 
@@ -257,6 +325,28 @@ struct FitterInput {
         }
     }
 
+    /// set the ranges of the gaussian parameters to the selected range of the data:
+    /// centers between x1 and x2, amplitudes a little beyond the data range, and
+    /// widths between a fraction of a sample and the whole range
+    /// (precomputeRangeMinMax() must be called first)
+    void
+    setDefaultRanges()
+    {
+        ranges.resize( numParams() );
+        double range12 = rangeMax - rangeMin;
+        for ( int i = 0 ; i < nGaussians ; i++ ) {
+            // center
+            ranges[i * 3 + 0].set( x1, x2 );
+
+            // amplitude
+            ranges[i * 3 + 1].set( rangeMin - 0.1 * range12, rangeMax + 0.1 * range12 );
+
+            // variance controlling term
+            ranges[i * 3 + 2].set( - 1.0 / ( 2 * 0.25 ),
+                                   - 1.0 / ( 2 * ( x2 - x1 ) * ( x2 - x1 ) ) );
+        }
+    }
+
     /// constructor
     FitterInput( const VD & arr )
         : data( arr )
@@ -229,23 +229,7 @@ Worker::doWork( InputParametersG1dFit input )
     dataInterface.nGaussians = input.nGaussians;
     dataInterface.nPolyTerms = input.poly;
     dataInterface.precomputeRangeMinMax();
-    dataInterface.ranges.resize( dataInterface.numParams() );
-    double range12 = dataInterface.rangeMax - dataInterface.rangeMin;
-    for ( int i = 0 ; i < dataInterface.nGaussians ; i++ ) {
-        // center
-        dataInterface.ranges[i * 3 + 0].set( input.left, input.right );
-
-        // amplitude
-        dataInterface.ranges[i * 3 + 1].set( dataInterface.rangeMin - 0.1 * range12,
-                                             dataInterface.rangeMax + 0.1 * range12 );
-
-        //        dataInterface.ranges[i*3+1].set( -10, 10);
-        // variance controlling term
-        dataInterface.ranges[i * 3 + 2].set( - 1.0 / ( 2 * 0.25 ),
-                                             - 1.0 /
-                                             ( 2 * ( dataInterface.x2 - dataInterface.x1 ) *
-                                               ( dataInterface.x2 - dataInterface.x1 ) ) );
-    }
+    dataInterface.setDefaultRanges();
 
     // ----------------------------------------------------------------------
     // run the heuristic fitter
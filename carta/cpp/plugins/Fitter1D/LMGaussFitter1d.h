@@ -5,11 +5,18 @@
 #include <QString>
 #include <QRectF>
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
 
 /*
  * 1d gaussian fitter for 1d data of doubles, using levenberg-marquardt
+ *
+ * The jacobian of the gaussians + polynomial model is calculated analytically, and
+ * the model is evaluated over the whole range at once into buffers that are kept
+ * between iterations, so iterating does not allocate. The fitter can be restarted
+ * with new initial parameters (and new data in the same FitterInput) to fit many
+ * curves of the same size, reusing its buffers and the lev-mar solver.
  */
 
 namespace Optimization
@@ -28,7 +35,7 @@ public:
 
     FitterInput & di;
 
-    /// set initial estimate
+    /// set initial estimate; the next iterate() starts a new fit from it
     void
     setInitialParams( const std::vector < double > & v )
     {
@@ -36,11 +43,16 @@ public:
             LTHROW( "LMGaussFitter1d::setInitialParams: bad param size" );
         }
         params = v;
+        firstTime = true;
     }
 
     std::vector < double >
     getResults();
 
+    /// copy the results into res, without allocating if it already has the right size
+    void
+    getResults( std::vector < double > & res );
+
     /// initialize stuff for iterate()
     void
     initOnce();
@@ -69,26 +81,76 @@ public:
     void
     calculateF( const double * paramsOrig, double * results )
     {
-        // TODO: is this killing performace to put constraints here? or is
-        // this the best we can do?
-        double params[numParams()];
-        for ( int i = 0 ; i < numParams() ; i++ ) { params[i] = paramsOrig[i]; }
-        constraintParameters( params );
-
-        double * p = results;
-        double f = 0.0, yy = 0.0;
-        for ( int x = di.x1 ; x <= di.x2 ; x++ ) {
-            yy = di.get( x );
-            if ( std::isnan( yy ) ) {
-                * p = 0.0;
+        // the model is evaluated with the constrained parameters
+        clamped.assign( paramsOrig, paramsOrig + numParams() );
+        constraintParameters( & clamped[0] );
+
+        evalNGauss1dBkgRange( di.x1, di.x2, di.nGaussians, di.nPolyTerms,
+                              & clamped[0], results );
+        const double * data = & di.data[di.x1];
+        int n = di.x2 - di.x1 + 1;
+        for ( int i = 0 ; i < n ; i++ ) {
+            results[i] = std::isnan( data[i] ) ? 0.0 : data[i] - results[i];
+        }
+    } // calculateF
+
+    /// callback for LevMar to calculate J
+    static
+    void
+    levmarJFunc( const double * params, double * results, void * userData )
+    {
+        LMFitter & gf = * ( static_cast < LMFitter * > ( userData ) );
+        gf.calculateJ( params, results );
+    }
+
+    /// function to compute J, the derivatives of F = data - model, row by row
+    ///
+    /// for a gaussian b * exp( c * sqr(x - a) ) with unit gaussian e the derivatives
+    /// of the model are:
+    ///   d/da = - 2 * b * c * (x - a) * e
+    ///   d/db = e
+    ///   d/dc = b * sqr(x - a) * e
+    /// and the derivative with respect to polynomial term i is x^i
+    void
+    calculateJ( const double * paramsOrig, double * results )
+    {
+        clamped.assign( paramsOrig, paramsOrig + numParams() );
+        constraintParameters( & clamped[0] );
+
+        int n = di.x2 - di.x1 + 1;
+        int np = numParams();
+        int ng = di.nGaussians;
+        unitBuffer.assign( size_t( n ) * ng, 0.0 );
+        for ( int k = 0 ; k < ng ; k++ ) {
+            addGauss1dRange( di.x1, di.x2, clamped[k * 3 + 0], 1.0, clamped[k * 3 + 2],
+                             & unitBuffer[size_t( k ) * n] );
+        }
+        const double * data = & di.data[di.x1];
+        for ( int i = 0 ; i < n ; i++ ) {
+            double * row = results + size_t( i ) * np;
+
+            // where there is no data F is 0 whatever the parameters
+            if ( std::isnan( data[i] ) ) {
+                std::fill( row, row + np, 0.0 );
+                continue;
+            }
+            double x = di.x1 + i;
+            for ( int k = 0 ; k < ng ; k++ ) {
+                double e = unitBuffer[size_t( k ) * n + i];
+                double dx = x - clamped[k * 3 + 0];
+                double b = clamped[k * 3 + 1];
+                double c = clamped[k * 3 + 2];
+                row[k * 3 + 0] = 2 * b * c * dx * e;
+                row[k * 3 + 1] = - e;
+                row[k * 3 + 2] = - b * dx * dx * e;
             }
-            else {
-                f = evalNGauss1dBkg( x, di.nGaussians, di.nPolyTerms, params );
-                * p = yy - f;
+            double xx = 1; // this is x ^ j
+            for ( int j = 0 ; j < di.nPolyTerms ; j++ ) {
+                row[ng * 3 + j] = - xx;
+                xx *= x;
             }
-            p++;
         }
-    } // calculateF
+    } // calculateJ
 
     /// callback for LevMar to constraint parameters
     static
@@ -112,9 +174,16 @@ public:
     LevMar levmar;
 
     std::vector < double > params;
+
+    /// constrained copy of the parameters being evaluated
+    std::vector < double > clamped;
+
+    /// unit gaussians over the fitted range, one after the other, for the jacobian
+    std::vector < double > unitBuffer;
 };
 
-std::vector < double > LMFitter::getResults()
+inline std::vector < double >
+LMFitter::getResults()
 {
     const double * x = levmar.getSolutionRef();
     if ( ! x ) {
@@ -129,7 +198,17 @@ std::vector < double > LMFitter::getResults()
     return res;
 }
 
-void
+inline void
+LMFitter::getResults( std::vector < double > & res )
+{
+    const double * x = levmar.getSolutionRef();
+    if ( ! x ) {
+        throw std::runtime_error( "GaussFitter1d::getResults: x = null" );
+    }
+    res.assign( x, x + numParams() );
+}
+
+inline void
 LMFitter::initOnce()
 {
     if ( ! firstTime ) {
@@ -153,11 +232,12 @@ LMFitter::initOnce()
     levmar.setStartParameters( params );
     levmar.setNumSamples( di.x2 - di.x1 + 1 );
     levmar.setFFunc( levmarFFunc, this );
+    levmar.setJFunc( levmarJFunc, this );
     levmar.setClampFunction( levmarConstraintsFunc, this );
     levmar.init();
 } // LMFitter::initOnce
 
-bool
+inline bool
 LMFitter::iterate()
 {
     initOnce();
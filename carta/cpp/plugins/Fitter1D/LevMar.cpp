@@ -22,6 +22,8 @@ protected:
         gslSolver = 0;
         userFFunc = 0;
         userFFuncData = 0;
+        userJFunc = 0;
+        userJFuncData = 0;
         userConstrainsFunc = 0;
         userConstraintsFuncData = 0;
         ns = 0;
@@ -69,7 +71,8 @@ protected:
     LevMar::FFunc userFFunc;
     void * userFFuncData;
 
-//    JFunc * m_jFunc; void * m_jFuncData;
+    LevMar::JFunc userJFunc;
+    void * userJFuncData;
     LevMar::ConstraintsFunc userConstrainsFunc;
     void * userConstraintsFuncData;
 
@@ -117,6 +120,11 @@ int
 LevMar::Impl::gslCBcalcJ( const gsl_vector * x, void * data, gsl_matrix * J )
 {
     LevMar::Impl & t = * static_cast < LevMar::Impl * > ( data );
+    // the user function fills J row by row, which needs rows without padding
+    if ( t.userJFunc && J->tda == J->size2 ) {
+        t.userJFunc( x->data, J->data, t.userJFuncData );
+        return GSL_SUCCESS;
+    }
     return t.calcJ( x, J );
 }
 
@@ -132,12 +140,12 @@ LevMar::Impl::gslCBcalcJF( const gsl_vector * x, void * data, gsl_vector * f, gs
 double
 LevMar::Impl::chiSq()
 {
+    // f1 is only scratch space between iterations
     const double * x = getSolutionRef();
-    std::vector < double > f( ns );
-    userFFunc( x, & f[0], userFFuncData );
+    userFFunc( x, f1->data, userFFuncData );
     double res = 0;
     for ( int i = 0 ; i < ns ; i++ ) {
-        res += f[i] * f[i];
+        res += f1->data[i] * f1->data[i];
     }
     return res;
 }
@@ -238,25 +246,31 @@ LevMar::Impl::init()
         throw std::runtime_error( "LevMar::reset(): userFFunc = 0!!!" );
     }
 
-    if ( gslSolver ) {
-        gsl_multifit_fdfsolver_free( gslSolver );
-    }
-    if ( f1 ) {
-        gsl_vector_free( f1 );
-    }
-    if ( f2 ) {
-        gsl_vector_free( f2 );
-    }
-    if ( xd ) {
-        gsl_vector_free( xd );
-    }
+    // the solver and the buffers only need to be allocated again when their sizes change
+    bool sameSize = gslSolver && int ( f1->size ) == ns &&
+                    xd->size == initialParameters.size();
+    if ( ! sameSize ) {
+        if ( gslSolver ) {
+            gsl_multifit_fdfsolver_free( gslSolver );
+        }
+        if ( f1 ) {
+            gsl_vector_free( f1 );
+        }
+        if ( f2 ) {
+            gsl_vector_free( f2 );
+        }
+        if ( xd ) {
+            gsl_vector_free( xd );
+        }
 
-    f1 = gsl_vector_alloc( ns );
-    f2 = gsl_vector_alloc( ns );
-    xd = gsl_vector_alloc( initialParameters.size() );
+        f1 = gsl_vector_alloc( ns );
+        f2 = gsl_vector_alloc( ns );
+        xd = gsl_vector_alloc( initialParameters.size() );
 
-    gslSolver = gsl_multifit_fdfsolver_alloc(
-        gsl_multifit_fdfsolver_lmder, ns, initialParameters.size() );
+        gslSolver = gsl_multifit_fdfsolver_alloc(
+            gsl_multifit_fdfsolver_lmder, ns, initialParameters.size() );
+    }
+    iter = 0;
 
 //    dbgHere;
 
@@ -287,6 +301,8 @@ LevMar::LevMar()
 
     impl().userFFunc = 0;
     impl().userFFuncData = 0;
+    impl().userJFunc = 0;
+    impl().userJFuncData = 0;
     impl().userConstrainsFunc = 0;
     impl().userConstraintsFuncData = 0;
     impl().ns = 0;
@@ -328,6 +344,13 @@ LevMar::setFFunc( LevMar::FFunc f, void * userData )
     impl().userFFuncData = userData;
 }
 
+void
+LevMar::setJFunc( LevMar::JFunc f, void * userData )
+{
+    impl().userJFunc = f;
+    impl().userJFuncData = userData;
+}
+
 void
 LevMar::setClampFunction( ConstraintsFunc f, void * userData )
 {
@@ -11,7 +11,7 @@
  *  initial parameters - which also tells us the number of parameters to optimize for
  *  number of data samples
  *  function for calculating F
- *  function for calculating J (finite difference used by default) -- not implemented now
+ *  function for calculating J (finite difference used by default)
  *  function for clamping parameters (no clamps used by default)
  *  extra parameter to pass to the functions (usually 'this' for c++)
  */
@@ -36,8 +36,13 @@ public:
     /// \param results is a pre-allocated buffer where the function should store the F[]
     typedef void (* FFunc)( const double * params, double * results, void * userData );
 
-    /// function for calculating J, with same parameters as function for calculating F
-//    typedef void (* JFunc)( const double * params, double * results, void * userData );
+    /// user provided function for calculating J, the derivatives of F
+    /// \param params will be the input paramaters
+    /// \param userData is supplied verbatim
+    /// \param results is a pre-allocated buffer where the function should store J,
+    /// row by row: the derivative of F[i] with respect to params[j] goes to
+    /// results[i * numParams + j]
+    typedef void (* JFunc)( const double * params, double * results, void * userData );
 
     /// user supplied constraints function
     /// \param params is the input and output
@@ -61,12 +66,17 @@ public:
     void
     setFFunc( FFunc f, void * userData = 0 );
 
-    /// set the function that calculates J
-//    void setJFunc( JFunc *);
+    /// set the function that calculates J; without one, J is calculated from F by
+    /// finite differences
+    void
+    setJFunc( JFunc f, void * userData = 0 );
+
+    /// set the function that constrains the parameters
     void
     setClampFunction( ConstraintsFunc f, void * userData = 0 );
 
-    /// call to restart the lev-mar loop
+    /// call to restart the lev-mar loop; the buffers of the previous call are
+    /// reused if the number of samples and parameters have not changed
     void
     init();
 
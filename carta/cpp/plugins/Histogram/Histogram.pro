@@ -11,6 +11,7 @@ CONFIG += plugin
 SOURCES += \
     IImageHistogram.cpp \
     ImageHistogram.cpp \
+    HistogramBase.cpp \
     Histogram1.cpp \
     ImageRegionGenerator.cpp
 
@@ -18,6 +19,7 @@ SOURCES += \
 HEADERS += \
     IImageHistogram.h \
     ImageHistogram.h \
+    HistogramBase.h \
     Histogram1.h \
     ImageRegionGenerator.h
 
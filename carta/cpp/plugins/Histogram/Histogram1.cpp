@@ -7,27 +7,27 @@
 #include <casacore/coordinates/Coordinates/SpectralCoordinate.h>
 #include <casacore/images/Regions/ImageRegion.h>
 #include <QDebug>
+#include <QJsonDocument>
 
 Histogram1::Histogram1( QObject * parent ) :
     QObject( parent )
 { }
 
-Carta::Lib::Hooks::HistogramResult Histogram1::_computeHistogram( ){
+Carta::Lib::Hooks::HistogramResult Histogram1::_computeHistogram(
+        ImageHistogram<casacore::Float>& histogram ){
     std::vector < std::pair < double, double > > data;
     QString name;
     QString unitsX = "";
     QString unitsY = "";
-    if ( m_histogram ) {
-        bool computed = m_histogram->compute();
-        if ( computed ) {
-            data = m_histogram->getData();
-            name = m_histogram->getName();
-            unitsX = m_histogram->getUnitsX();
-            unitsY = m_histogram->getUnitsY();
-        }
-        else {
-            qDebug() << "Could not generate histogram data";
-        }
+    bool computed = histogram.compute();
+    if ( computed ) {
+        data = histogram.getData();
+        name = histogram.getName();
+        unitsX = histogram.getUnitsX();
+        unitsY = histogram.getUnitsY();
+    }
+    else {
+        qDebug() << "Could not generate histogram data";
     }
 
     Carta::Lib::Hooks::HistogramResult result( name, unitsX, unitsY, data );
@@ -172,17 +172,20 @@ Histogram1::handleHook( BaseHook & hookData )
             qWarning() << "Histogram plugin: not an image created by casaimageloader...";
             return false;
         }
-        if ( !m_histogram ){
-            m_histogram.reset(new ImageHistogram < casacore::Float >());
-        }
+        //Hooks run on several compute threads at once, so each call has its own
+        //histogram; base histograms are still shared through their cache.
+        std::unique_ptr<casacore::ImageInterface<casacore::Float> > imageClone( casaImage->cloneII() );
+        ImageHistogram < casacore::Float > histogram;
         std::shared_ptr<Carta::Lib::Regions::RegionBase> regionBase = hook.paramsPtr->region;
         QString regionId = hook.paramsPtr->regionId;
         casacore::ImageRegion* imageRegion = nullptr;
+        QString regionGeometry;
         if ( regionBase ){
         	imageRegion = ImageRegionGenerator::makeRegion( casaImage, regionBase );
+        	regionGeometry = QJsonDocument( regionBase->toJson() ).toJson( QJsonDocument::Compact );
         }
-        m_histogram->setRegion( imageRegion, regionId  );
-        m_histogram->setBinCount( hook.paramsPtr->binCount );
+        histogram.setRegion( imageRegion, regionId, regionGeometry );
+        histogram.setBinCount( hook.paramsPtr->binCount );
 
         double frequencyMin = hook.paramsPtr->minFrequency;
         double frequencyMax = hook.paramsPtr->maxFrequency;
@@ -195,24 +198,24 @@ Histogram1::handleHook( BaseHook & hookData )
             if ( specAx >= 0 ) {
                 minChannel = hook.paramsPtr->minChannel;
                 maxChannel = hook.paramsPtr->maxChannel;
-                //m_histogram->setChannelRange( minChannel, maxChannel );
+                //histogram.setChannelRange( minChannel, maxChannel );
 
                 std::pair<double,double> bounds = _getFrequencyBounds( casaImage, minChannel, maxChannel, rangeUnits );
                 frequencyMin = bounds.first;
                 frequencyMax = bounds.second;
             }
-            m_histogram->setChannelRange( minChannel, maxChannel );
+            histogram.setChannelRange( minChannel, maxChannel );
         }
         else {
             std::pair<int,int> bounds = _getChannelBounds( casaImage, frequencyMin, frequencyMax, rangeUnits );
-            m_histogram-> setChannelRange( bounds.first, bounds.second );
+            histogram.setChannelRange( bounds.first, bounds.second );
         }
-        m_histogram-> setImage( casaImage->cloneII() );
         double minIntensity = hook.paramsPtr->minIntensity;
         double maxIntensity = hook.paramsPtr->maxIntensity;
-        m_histogram->setIntensityRange( minIntensity, maxIntensity );
+        histogram.setIntensityRange( minIntensity, maxIntensity );
+        histogram.setImage( imageClone.get() );
 
-        hook.result = _computeHistogram();
+        hook.result = _computeHistogram( histogram );
         hook.result.setFrequencyBounds( frequencyMin, frequencyMax );
 
         return true;
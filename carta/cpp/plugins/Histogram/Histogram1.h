@@ -32,9 +32,10 @@ public:
 private:
     /**
      * Returns histogram data in the form of (intensity,count) pairs.
+     * @param histogram - the histogram to compute.
      * @returns a vector (intensity,count) pairs.
      */
-    Carta::Lib::Hooks::HistogramResult _computeHistogram( );
+    Carta::Lib::Hooks::HistogramResult _computeHistogram( ImageHistogram<casacore::Float>& histogram );
 
     /**
      * Returns channel range for the given frequency bounds.
@@ -49,7 +50,4 @@ private:
     std::pair<double,double> _getFrequencyBounds( casacore::ImageInterface<casacore::Float>* casaImage,
             int channelMin, int channelMax, const QString& unitStr ) const;
 
-    /// Histogram implementation.
-    std::unique_ptr<ImageHistogram<casacore::Float>> m_histogram = nullptr;
-
 };
@@ -0,0 +1,96 @@
+#include "HistogramBase.h"
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+const int HistogramBase::BIN_COUNT = 65536;
+
+namespace {
+
+//A derived bin has to span at least this many base bins, so that assigning each
+//base bin to the derived bin containing its center does not skew the counts.
+const int BASE_BINS_PER_BIN_MIN = 4;
+
+//Number of base histograms kept.
+const int BASES_CACHED_MAX = 32;
+
+QMutex cacheMutex;
+QCache<QString, std::shared_ptr<const HistogramBase> > baseCache( BASES_CACHED_MAX );
+}
+
+HistogramBase::HistogramBase( double minValue, double maxValue ):
+    m_min( minValue ),
+    m_max( maxValue ),
+    m_binScale( 0 ),
+    m_counts( BIN_COUNT, 0 ){
+    if ( m_max > m_min ){
+        m_binScale = BIN_COUNT / ( m_max - m_min );
+    }
+}
+
+double HistogramBase::getMin() const {
+    return m_min;
+}
+
+double HistogramBase::getMax() const {
+    return m_max;
+}
+
+void HistogramBase::merge( const HistogramBase& other ){
+    for ( int k = 0; k < BIN_COUNT; k++ ){
+        m_counts[k] += other.m_counts[k];
+    }
+}
+
+bool HistogramBase::derive( int binCount, double minIntensity, double maxIntensity,
+        std::vector<double>& centers, std::vector<double>& counts ) const {
+    if ( binCount <= 0 || !( maxIntensity > minIntensity ) || !( m_max > m_min ) ){
+        return false;
+    }
+    double baseWidth = ( m_max - m_min ) / BIN_COUNT;
+    double binWidth = ( maxIntensity - minIntensity ) / binCount;
+    if ( binWidth < BASE_BINS_PER_BIN_MIN * baseWidth ){
+        return false;
+    }
+    centers.resize( binCount );
+    counts.assign( binCount, 0 );
+    for ( int i = 0; i < binCount; i++ ){
+        centers[i] = minIntensity + ( i + 0.5 ) * binWidth;
+    }
+
+    //Only the base bins inside the intensity range are visited.
+    int firstBase = std::max( 0, static_cast<int>( std::floor( ( minIntensity - m_min ) / baseWidth ) ) );
+    int lastBase = std::min( BIN_COUNT - 1, static_cast<int>( std::ceil( ( maxIntensity - m_min ) / baseWidth ) ) );
+    for ( int k = firstBase; k <= lastBase; k++ ){
+        if ( m_counts[k] == 0 ){
+            continue;
+        }
+        double center = m_min + ( k + 0.5 ) * baseWidth;
+        if ( center < minIntensity || center > maxIntensity ){
+            continue;
+        }
+        int bin = static_cast<int>( ( center - minIntensity ) / binWidth );
+        if ( bin >= binCount ){
+            bin = binCount - 1;
+        }
+        counts[bin] += m_counts[k];
+    }
+    return true;
+}
+
+std::shared_ptr<const HistogramBase> HistogramBase::find( const QString& key ){
+    QMutexLocker locker( &cacheMutex );
+    std::shared_ptr<const HistogramBase> base;
+    std::shared_ptr<const HistogramBase>* cached = baseCache.object( key );
+    if ( cached ){
+        base = *cached;
+    }
+    return base;
+}
+
+void HistogramBase::insert( const QString& key, std::shared_ptr<const HistogramBase> base ){
+    QMutexLocker locker( &cacheMutex );
+    baseCache.insert( key, new std::shared_ptr<const HistogramBase>( base ) );
+}
@@ -0,0 +1,119 @@
+/**
+ * A fine-grained histogram of all the pixels of an image (or of a channel range or
+ * region of it), from which histograms with fewer bins or a narrower intensity range
+ * can be derived without reading the pixels again.
+ */
+
+#pragma once
+
+#include <QString>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class HistogramBase {
+public:
+
+    /// Number of bins of a base histogram.
+    static const int BIN_COUNT;
+
+    /**
+     * Constructor.
+     * @param minValue - the smallest pixel value.
+     * @param maxValue - the largest pixel value.
+     */
+    HistogramBase( double minValue, double maxValue );
+
+    /**
+     * Count a pixel value.
+     * @param value - a finite pixel value between the smallest and largest value.
+     */
+    inline void add( double value ){
+        int bin = static_cast<int>( ( value - m_min ) * m_binScale );
+        if ( bin >= BIN_COUNT ){
+            bin = BIN_COUNT - 1;
+        }
+        else if ( bin < 0 ){
+            bin = 0;
+        }
+        m_counts[bin]++;
+    }
+
+    /**
+     * Count pixel values.
+     * @param values - finite pixel values between the smallest and largest value.
+     * @param count - the number of values.
+     */
+    template <class V>
+    void add( const V* values, size_t count ){
+        //The bins of a block of values are found in a loop the compiler can vectorize
+        //before any count is incremented.
+        const int BLOCK_SIZE = 256;
+        const double maxBin = BIN_COUNT - 1;
+        int bins[BLOCK_SIZE];
+        for ( size_t first = 0; first < count; first += BLOCK_SIZE ){
+            int blockCount = static_cast<int>( std::min<size_t>( BLOCK_SIZE, count - first ) );
+            const V* block = values + first;
+            for ( int i = 0; i < blockCount; i++ ){
+                double bin = ( block[i] - m_min ) * m_binScale;
+                bin = bin < 0 ? 0 : ( bin > maxBin ? maxBin : bin );
+                bins[i] = static_cast<int>( bin );
+            }
+            for ( int i = 0; i < blockCount; i++ ){
+                m_counts[bins[i]]++;
+            }
+        }
+    }
+
+    /**
+     * Add the counts of another base histogram.
+     * @param other - a base histogram with the same smallest and largest value.
+     */
+    void merge( const HistogramBase& other );
+
+    /**
+     * Returns the smallest pixel value.
+     * @return - the smallest pixel value.
+     */
+    double getMin() const;
+
+    /**
+     * Returns the largest pixel value.
+     * @return - the largest pixel value.
+     */
+    double getMax() const;
+
+    /**
+     * Compute a histogram from the base histogram.
+     * @param binCount - the number of bins of the histogram.
+     * @param minIntensity - the lower bound of the first bin.
+     * @param maxIntensity - the upper bound of the last bin.
+     * @param centers - set to the centers of the bins.
+     * @param counts - set to the number of pixels in each bin.
+     * @return - false if the bins are too narrow to be derived from the base
+     *      histogram, in which case the pixels have to be read again.
+     */
+    bool derive( int binCount, double minIntensity, double maxIntensity,
+            std::vector<double>& centers, std::vector<double>& counts ) const;
+
+    /**
+     * Returns a cached base histogram.
+     * @param key - identifies the image, channels and region of the histogram.
+     * @return - the base histogram or null if there is none for the key.
+     */
+    static std::shared_ptr<const HistogramBase> find( const QString& key );
+
+    /**
+     * Cache a base histogram.
+     * @param key - identifies the image, channels and region of the histogram.
+     * @param base - the base histogram.
+     */
+    static void insert( const QString& key, std::shared_ptr<const HistogramBase> base );
+
+private:
+    double m_min;
+    double m_max;
+    double m_binScale;
+    std::vector<double> m_counts;
+};
@@ -3,6 +3,7 @@
 #include <QtCore/qmath.h>
 #include "CartaLib/IImage.h"
 #include "ImageHistogram.h"
+#include "CartaLib/Algorithms/ParallelTasks.h"
 #include <casacore/images/Images/SubImage.h>
 #include <casacore/images/Regions/ImageRegion.h>
 #include <casacore/casa/version.h>
@@ -16,6 +17,29 @@
 #include "plugins/CasaImageLoader/CasaImageLoader.h"
 #include <casacore/casa/Arrays/Vector.h>
 #include <casacore/casa/BasicSL/String.h>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace {
+
+//Number of bytes of pixels read at once.
+const qint64 BATCH_BYTES = 64 * 1024 * 1024;
+
+//Number of batches per thread the pixels are split into, so threads that are given
+//batches with fewer pixels do not sit idle.
+const int TASKS_PER_THREAD = 4;
+
+//Number of bytes of pixels kept in memory between finding the range of the pixels
+//and binning them.
+const qint64 KEPT_BYTES_MAX = qint64( 512 ) * 1024 * 1024;
+}
 
 
 template <class T>
@@ -73,10 +97,206 @@ void ImageHistogram<T>::setIntensityRange( double minimumIntensity, double maxim
 	m_intensityMax = maximumIntensity;
 }
 
+template <class T>
+std::shared_ptr<const HistogramBase> ImageHistogram<T>::_computeBase() const {
+	std::shared_ptr<HistogramBase> base;
+	if ( !m_lattice ){
+		return base;
+	}
+	casacore::IPosition shape = m_lattice->shape();
+	int dims = shape.nelements();
+	if ( dims == 0 || shape.product() == 0 ){
+		return base;
+	}
+
+	//Split the pixels into batches of planes along the last axis with more than one
+	//plane (the channels of a cube, the rows of a single plane), small enough to be
+	//read at once, and into enough of them to keep all the threads busy.
+	int splitAxis = 0;
+	for ( int i = dims - 1; i > 0; i-- ){
+		if ( shape[i] > 1 ){
+			splitAxis = i;
+			break;
+		}
+	}
+	int planeCount = shape[splitAxis];
+	qint64 planeBytes = shape.product() / planeCount * sizeof( T );
+	int planesPerBatch = std::max<qint64>( 1, BATCH_BYTES / planeBytes );
+	int taskTarget = Carta::Lib::Algorithms::ParallelTasks::threadCountMax() * TASKS_PER_THREAD;
+	planesPerBatch = std::min( planesPerBatch, std::max( 1, planeCount / taskTarget ) );
+	int batchCount = ( planeCount + planesPerBatch - 1 ) / planesPerBatch;
+
+	//Reads the unmasked, finite pixels of a batch.  The lattice cannot be read from
+	//several threads at once, so reads take turns while other batches are binned.
+	bool masked = m_lattice->isMasked();
+	QMutex readMutex;
+	std::atomic<bool> readOk( true );
+	auto readBatch = [&]( int batch, std::vector<T>& values ){
+		casacore::IPosition start( dims, 0 );
+		casacore::IPosition count( shape );
+		start[splitAxis] = batch * planesPerBatch;
+		count[splitAxis] = std::min( planesPerBatch, planeCount - batch * planesPerBatch );
+		casacore::Array<T> data;
+		casacore::Array<casacore::Bool> mask;
+		try {
+			QMutexLocker locker( &readMutex );
+			m_lattice->getSlice( data, start, count, false );
+			if ( masked ){
+				m_lattice->getMaskSlice( mask, start, count, false );
+			}
+		}
+		catch( const casacore::AipsError& error ){
+			qDebug() << "Error making base histogram: "<<error.getMesg().c_str();
+			return false;
+		}
+		bool deleteData = false;
+		bool deleteMask = false;
+		const T* pixels = data.getStorage( deleteData );
+		const casacore::Bool* good = mask.nelements() > 0 ? mask.getStorage( deleteMask ) : nullptr;
+		size_t pixelCount = data.nelements();
+		values.resize( pixelCount );
+		size_t valueCount = 0;
+		if ( good ){
+			for ( size_t i = 0; i < pixelCount; i++ ){
+				values[valueCount] = pixels[i];
+				valueCount += ( good[i] && std::isfinite( pixels[i] ) ) ? 1 : 0;
+			}
+		}
+		else {
+			for ( size_t i = 0; i < pixelCount; i++ ){
+				values[valueCount] = pixels[i];
+				valueCount += std::isfinite( pixels[i] ) ? 1 : 0;
+			}
+		}
+		values.resize( valueCount );
+		data.freeStorage( pixels, deleteData );
+		if ( good ){
+			mask.freeStorage( good, deleteMask );
+		}
+		return true;
+	};
+
+	//Find the range of the pixels, keeping as many batches in memory as allowed so
+	//they do not have to be read again to be binned.
+	std::vector< std::vector<T> > keptValues( batchCount );
+	std::vector<char> kept( batchCount, 0 );
+	std::atomic<qint64> keptBytes( 0 );
+	std::vector<double> batchMin( batchCount, std::numeric_limits<double>::max() );
+	std::vector<double> batchMax( batchCount, -std::numeric_limits<double>::max() );
+	Carta::Lib::Algorithms::ParallelTasks::run( batchCount, [&]( int batch, int /*worker*/ ){
+		if ( !readOk ){
+			return;
+		}
+		std::vector<T> values;
+		if ( !readBatch( batch, values ) ){
+			readOk = false;
+			return;
+		}
+		if ( !values.empty() ){
+			T minValue = values[0];
+			T maxValue = values[0];
+			for ( T value : values ){
+				minValue = value < minValue ? value : minValue;
+				maxValue = value > maxValue ? value : maxValue;
+			}
+			batchMin[batch] = minValue;
+			batchMax[batch] = maxValue;
+		}
+		qint64 bytes = values.size() * sizeof( T );
+		if ( keptBytes.fetch_add( bytes ) + bytes <= KEPT_BYTES_MAX ){
+			keptValues[batch].swap( values );
+			kept[batch] = 1;
+		}
+		else {
+			keptBytes.fetch_sub( bytes );
+		}
+	});
+	double minValue = *std::min_element( batchMin.begin(), batchMin.end() );
+	double maxValue = *std::max_element( batchMax.begin(), batchMax.end() );
+	if ( !readOk || minValue > maxValue ){
+		return base;
+	}
+
+	//Bin the batches into a histogram for each thread, then merge them.
+	int workerCount = Carta::Lib::Algorithms::ParallelTasks::workerCountMax( batchCount );
+	std::vector< std::shared_ptr<HistogramBase> > partials( workerCount );
+	Carta::Lib::Algorithms::ParallelTasks::run( batchCount, [&]( int batch, int worker ){
+		if ( !readOk ){
+			return;
+		}
+		std::vector<T> values;
+		if ( kept[batch] ){
+			values.swap( keptValues[batch] );
+		}
+		else if ( !readBatch( batch, values ) ){
+			readOk = false;
+			return;
+		}
+		if ( !partials[worker] ){
+			partials[worker].reset( new HistogramBase( minValue, maxValue ) );
+		}
+		partials[worker]->add( values.data(), values.size() );
+	});
+	if ( readOk ){
+		//Workers that were not given any batch have no histogram.
+		for ( const std::shared_ptr<HistogramBase>& partial : partials ){
+			if ( !partial ){
+				continue;
+			}
+			if ( base ){
+				base->merge( *partial );
+			}
+			else {
+				base = partial;
+			}
+		}
+	}
+	return base;
+}
+
+template <class T>
+std::shared_ptr<const HistogramBase> ImageHistogram<T>::_getBase(){
+	std::shared_ptr<const HistogramBase> base;
+	if ( m_lattice && !m_latticeKey.isEmpty() ){
+		base = HistogramBase::find( m_latticeKey );
+		if ( !base ){
+			base = _computeBase();
+			if ( base ){
+				HistogramBase::insert( m_latticeKey, base );
+			}
+		}
+	}
+	return base;
+}
+
 template <class T>
 bool ImageHistogram<T>::compute( ){
 	bool success = true;
+	bool derived = false;
 	if ( m_histogramMaker != NULL ){
+		//Derive the histogram from the base histogram when its bins are fine enough,
+		//so changing the bin count or the intensity range does not read the pixels.
+		std::shared_ptr<const HistogramBase> base = _getBase();
+		if ( base ){
+			double minIntensity = base->getMin();
+			double maxIntensity = base->getMax();
+			if ( m_intensityMin != ALL_INTENSITIES && m_intensityMax != ALL_INTENSITIES ){
+				minIntensity = m_intensityMin;
+				maxIntensity = m_intensityMax;
+			}
+			std::vector<double> centers;
+			std::vector<double> counts;
+			derived = base->derive( m_binCount, minIntensity, maxIntensity, centers, counts );
+			if ( derived ){
+				m_xValues.assign( centers.begin(), centers.end() );
+				m_yValues.assign( counts.begin(), counts.end() );
+			}
+		}
+	}
+	if ( derived ){
+		success = true;
+	}
+	else if ( m_histogramMaker != NULL ){
 
 		//Set the number of bins.
 		m_histogramMaker->setNBins( m_binCount );
@@ -145,19 +365,31 @@ void ImageHistogram<T>::_filterByChannels( const casacore::ImageInterface<T>* im
                 casacore::ImageInterface<T>* img = new casacore::SubImage<T>( *(image), channelSlicer );
                 delete m_histogramMaker;
                 m_histogramMaker = new casacore::LatticeHistograms<casacore::Float>( *img );
+                m_lattice.reset( img->cloneML() );
 			}
 		}
 	}
 	else {
 	    delete m_histogramMaker;
 	    m_histogramMaker = new casacore::LatticeHistograms<casacore::Float>( *image );
+	    m_lattice.reset( image->cloneML() );
+	}
+	//The pixels are identified by the file they come from, so images with the same
+	//name in different directories, or a file that has been rewritten, do not share
+	//binned pixels.  Images without a file are not shared.
+	m_latticeKey = "";
+	QFileInfo fileInfo( m_image->name(false).c_str() );
+	if ( fileInfo.exists() ){
+	    m_latticeKey = QString( "%1/%2/%3/%4/%5/%6" ).arg( fileInfo.absoluteFilePath() )
+	            .arg( fileInfo.size() ).arg( fileInfo.lastModified().toMSecsSinceEpoch() )
+	            .arg( m_channelMin ).arg( m_channelMax ).arg( m_regionId + m_regionGeometry );
 	}
 }
 
 template <class T>
 void ImageHistogram<T>::setImage( const casacore::ImageInterface<T>*  val ){
     if ( val != nullptr ){
-        if ( m_image == nullptr || m_image->name(true) != val->name(true) ){
+        if ( m_image == nullptr || m_image->name(false) != val->name(false) ){
             m_image = val;
             _reset();
         }
@@ -165,11 +397,22 @@ void ImageHistogram<T>::setImage( const casacore::ImageInterface<T>*  val ){
 }
 
 template <class T>
-void ImageHistogram<T>::setRegion( casacore::ImageRegion* region, const QString& id ){
-	if ( m_region == nullptr || m_regionId != id ){
+void ImageHistogram<T>::setRegion( casacore::ImageRegion* region, const QString& id,
+        const QString& geometry ){
+	bool regionChanged = m_regionId != id || m_regionGeometry != geometry ||
+	        ( m_region == nullptr ) != ( region == nullptr );
+	if ( regionChanged ){
 		delete m_region;
 		m_region = region;
 		m_regionId = id;
+		m_regionGeometry = geometry;
+		//The pixels in the region have to be selected again.
+		if ( m_image != nullptr ){
+			_reset();
+		}
+	}
+	else {
+		delete region;
 	}
 }
 
@@ -381,6 +624,7 @@ void ImageHistogram<T>::toAscii( QTextStream& out ) const {
 
 template <class T>
 ImageHistogram<T>::~ImageHistogram() {
+	delete m_histogramMaker;
 	delete m_region;
 }
 
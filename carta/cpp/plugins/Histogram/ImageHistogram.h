@@ -2,6 +2,7 @@
 
 #include <casacore/casa/vector.h>
 #include "IImageHistogram.h"
+#include "HistogramBase.h"
 #include <QTextStream>
 
 
@@ -10,6 +11,7 @@
 namespace casacore {
     template <class T> class ImageInterface;
     template <class T> class LatticeHistograms;
+    template <class T> class MaskedLattice;
     template <class T> class SubImage;
     class ImageRegion;
 }
@@ -30,7 +32,15 @@ public:
     virtual bool compute() Q_DECL_OVERRIDE;
 
 	int getDataCount() const;
-	void setRegion(casacore::ImageRegion* region, const QString& id );
+	/**
+	 * Set the region of the histogram.
+	 * @param region - the region or nullptr for the whole image; the histogram takes
+	 *      ownership.
+	 * @param id - an identifier for the region.
+	 * @param geometry - a description of the shape and position of the region, so that
+	 *      a region that was edited is not mistaken for the one it was before.
+	 */
+	void setRegion(casacore::ImageRegion* region, const QString& id, const QString& geometry = QString() );
 	void defineLine( int index, QVector<double>& xVals, QVector<double>& yVals,
 			bool useLogY ) const;
 	void defineStepHorizontal( int index, QVector<double>& xVals, QVector<double>& yVals,
@@ -66,6 +76,10 @@ private:
 	bool _reset();
 	void _filterByChannels( const casacore::ImageInterface<T>*  image );
 
+	//Returns the base histogram of the pixels, from the cache if it was computed before.
+	std::shared_ptr<const HistogramBase> _getBase();
+	std::shared_ptr<const HistogramBase> _computeBase() const;
+
 	vector<T> m_xValues;
 	vector<T> m_yValues;
 	casacore::LatticeHistograms<T>* m_histogramMaker;
@@ -79,4 +93,9 @@ private:
 	double m_intensityMax;
 	int m_binCount;
 	QString m_regionId;
+	QString m_regionGeometry;
+
+	//The pixels the histogram is computed from and a key identifying them.
+	std::unique_ptr<casacore::MaskedLattice<T> > m_lattice;
+	QString m_latticeKey;
 };
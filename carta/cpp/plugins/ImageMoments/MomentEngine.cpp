@@ -0,0 +1,372 @@
+#include "MomentEngine.h"
+#include "CartaLib/Algorithms/ParallelTasks.h"
+#include "CartaLib/IImage.h"
+#include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/Regions/Point.h"
+#include "CartaLib/Regions/RegionMask.h"
+
+#include <QDebug>
+#include <QtCore/qmath.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+//Largest amount of the cube a parallel task reads at once.
+const qint64 BLOCK_BYTES = 16 * 1024 * 1024;
+
+//Number of tasks per thread, so that threads finishing early can help the others.
+const int TASKS_PER_THREAD = 4;
+}
+
+using Carta::Lib::Hooks::MomentsHook;
+
+struct MomentEngine::Layout {
+    std::vector<int> dims;
+    //The box of the plane that is read, inclusive.
+    int x0;
+    int x1;
+    int y0;
+    int y1;
+    int channelMin;
+    int channelCount;
+    //Spectral coordinate of each used channel, relative to the reference value.
+    std::vector<double> coordinates;
+    double reference;
+    //Width of each used channel in spectral coordinates.
+    std::vector<double> widths;
+    //Which pixels of the box are used; empty if they all are.
+    std::vector<char> mask;
+    bool median;
+};
+
+
+MomentEngine::MomentEngine(){
+}
+
+
+std::vector< std::vector<float> > MomentEngine::compute(
+        const MomentsHook::Params& params, QString* errorMsg ){
+    std::vector< std::vector<float> > maps;
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image = params.m_dataSource;
+    if ( !image ){
+        *errorMsg = "There is no image to compute moments for.";
+        return maps;
+    }
+    if ( image->pixelType() != Carta::Lib::Image::PixelType::Real32 ){
+        *errorMsg = "Moments can only be computed for images of 32 bit floating point pixels.";
+        return maps;
+    }
+    Layout layout;
+    layout.dims = image->dims();
+    int dimCount = layout.dims.size();
+    int spectralAxis = params.m_spectralAxis;
+    if ( spectralAxis < 2 || spectralAxis >= dimCount ){
+        *errorMsg = "Moments need a cube with a spectral axis after the two spatial axes.";
+        return maps;
+    }
+    int channels = layout.dims[spectralAxis];
+    if ( static_cast<int>( params.m_spectralValues.size() ) != channels ){
+        *errorMsg = "Moments need the spectral coordinate of every channel.";
+        return maps;
+    }
+    if ( params.m_moments.empty() ){
+        *errorMsg = "No moments were requested.";
+        return maps;
+    }
+
+    //Channel range
+    int channelMin = params.m_channelMin < 0 ? 0 : params.m_channelMin;
+    int channelMax = params.m_channelMax < 0 ? channels - 1 : params.m_channelMax;
+    channelMax = std::min( channelMax, channels - 1 );
+    if ( channelMin > channelMax ){
+        *errorMsg = "The channel range "+QString::number( params.m_channelMin )+" to "+
+                QString::number( params.m_channelMax )+" does not contain any channels of the image.";
+        return maps;
+    }
+    layout.channelMin = channelMin;
+    layout.channelCount = channelMax - channelMin + 1;
+
+    //Coordinates relative to the middle of the range keep the sums of the
+    //dispersion from cancelling out.
+    const std::vector<double>& values = params.m_spectralValues;
+    layout.reference = values[( channelMin + channelMax ) / 2];
+    for ( int k = channelMin; k <= channelMax; k++ ){
+        layout.coordinates.push_back( values[k] - layout.reference );
+        double width = 1;
+        if ( channels > 1 ){
+            if ( k == 0 ){
+                width = std::fabs( values[1] - values[0] );
+            }
+            else if ( k == channels - 1 ){
+                width = std::fabs( values[k] - values[k - 1] );
+            }
+            else {
+                width = std::fabs( values[k + 1] - values[k - 1] ) / 2;
+            }
+        }
+        layout.widths.push_back( width );
+    }
+
+    //Only the part of the plane covered by the region is read.
+    int width = layout.dims[0];
+    int height = layout.dims[1];
+    layout.x0 = 0;
+    layout.x1 = width - 1;
+    layout.y0 = 0;
+    layout.y1 = height - 1;
+    if ( params.m_regionInfo ){
+        QRectF box = params.m_regionInfo->outlineBox();
+        if ( params.m_regionInfo->typeName() == Carta::Lib::Regions::Point::TypeName ){
+            box = QRectF( box.center(), box.center() );
+        }
+        layout.x0 = std::max( qFloor( box.left() ), 0 );
+        layout.x1 = std::min( qCeil( box.right() ), width - 1 );
+        layout.y0 = std::max( qFloor( box.top() ), 0 );
+        layout.y1 = std::min( qCeil( box.bottom() ), height - 1 );
+        if ( layout.x0 > layout.x1 || layout.y0 > layout.y1 ){
+            *errorMsg = "The region does not cover any pixels of the image.";
+            return maps;
+        }
+        layout.mask = _getRegionMask( params, layout );
+    }
+    layout.median = std::find( params.m_moments.begin(), params.m_moments.end(),
+            MomentType::MEDIAN ) != params.m_moments.end();
+
+    //Split the box into blocks of rows small enough to be read at once, and into
+    //enough of them to keep all the threads busy.
+    int boxWidth = layout.x1 - layout.x0 + 1;
+    int boxHeight = layout.y1 - layout.y0 + 1;
+    qint64 rowBytes = qint64( boxWidth ) * layout.channelCount * sizeof( float );
+    int rowsPerBlock = std::max<qint64>( 1, BLOCK_BYTES / rowBytes );
+    int taskTarget = Carta::Lib::Algorithms::ParallelTasks::threadCountMax() * TASKS_PER_THREAD;
+    rowsPerBlock = std::min( rowsPerBlock, std::max( 1, boxHeight / taskTarget ) );
+    int blockCount = ( boxHeight + rowsPerBlock - 1 ) / rowsPerBlock;
+
+    int momentCount = params.m_moments.size();
+    maps.resize( momentCount );
+    for ( int i = 0; i < momentCount; i++ ){
+        maps[i].assign( qint64( width ) * height, std::numeric_limits<float>::quiet_NaN() );
+    }
+
+    std::atomic<bool> readOk( true );
+    Carta::Lib::Algorithms::ParallelTasks::run( blockCount, image, [&]( int block, Carta::Lib::Image::ImageInterface* handle ){
+        if ( !readOk ){
+            return;
+        }
+        std::vector<float> cube;
+        int firstRow = layout.y0 + block * rowsPerBlock;
+        int lastRow = std::min( firstRow + rowsPerBlock - 1, layout.y1 );
+        if ( !_computeBlock( handle, params, layout, firstRow, lastRow, cube, maps ) ){
+            readOk = false;
+        }
+    });
+    if ( !readOk ){
+        *errorMsg = "The pixels of the image could not be read.";
+        maps.clear();
+    }
+    return maps;
+}
+
+
+bool MomentEngine::_computeBlock( Carta::Lib::Image::ImageInterface* image,
+        const MomentsHook::Params& params, const Layout& layout,
+        int firstRow, int lastRow, std::vector<float>& cube,
+        std::vector< std::vector<float> >& maps ){
+    //Read the spectra of the rows, all at once.
+    int dimCount = layout.dims.size();
+    SliceND slice;
+    for ( int i = 0; i < dimCount; i++ ){
+        if ( i == 0 ){
+            slice.start( layout.x0 ).end( layout.x1 + 1 );
+        }
+        else if ( i == 1 ){
+            slice.start( firstRow ).end( lastRow + 1 );
+        }
+        else if ( i == params.m_spectralAxis ){
+            slice.start( layout.channelMin ).end( layout.channelMin + layout.channelCount );
+        }
+        else {
+            int frame = i < static_cast<int>( params.m_frames.size() ) ? params.m_frames[i] : 0;
+            frame = std::max( 0, std::min( frame, layout.dims[i] - 1 ) );
+            slice.start( frame ).end( frame + 1 );
+        }
+        slice.step( 1 );
+        if ( i < dimCount - 1 ){
+            slice.next();
+        }
+    }
+    std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> view( image->getDataSlice( slice ) );
+    if ( !view ){
+        return false;
+    }
+    int boxWidth = layout.x1 - layout.x0 + 1;
+    qint64 planeSize = qint64( boxWidth ) * ( lastRow - firstRow + 1 );
+    qint64 total = planeSize * layout.channelCount;
+    cube.resize( total );
+    qint64 filled = 0;
+    view->forEach( BLOCK_BYTES, [&]( const char* data, int64_t count ){
+        count = std::min<int64_t>( count, total - filled );
+        std::memcpy( cube.data() + filled, data, count * sizeof( float ) );
+        filled += count;
+    });
+    if ( filled != total ){
+        return false;
+    }
+
+    //The spatial axes come before the spectral axis and the other axes are a
+    //single frame, so the block holds one plane of the rows after the other.
+    std::vector<char> used( planeSize, 1 );
+    if ( !layout.mask.empty() ){
+        qint64 maskStart = qint64( firstRow - layout.y0 ) * boxWidth;
+        std::copy( layout.mask.begin() + maskStart, layout.mask.begin() + maskStart + planeSize,
+                used.begin() );
+    }
+    std::vector<int> counts( planeSize, 0 );
+    std::vector<double> sums( planeSize, 0 );
+    std::vector<double> integrals( planeSize, 0 );
+    std::vector<double> firstSums( planeSize, 0 );
+    std::vector<double> secondSums( planeSize, 0 );
+    std::vector<float> peaks( planeSize, -std::numeric_limits<float>::infinity() );
+    const double includeMin = params.m_includeMin;
+    const double includeMax = params.m_includeMax;
+    for ( int k = 0; k < layout.channelCount; k++ ){
+        const float* plane = cube.data() + k * planeSize;
+        const double coordinate = layout.coordinates[k];
+        const double width = layout.widths[k];
+        for ( qint64 p = 0; p < planeSize; p++ ){
+            float value = plane[p];
+            //Also rejects NaN.
+            if ( !used[p] || !( value >= includeMin && value <= includeMax ) ){
+                continue;
+            }
+            counts[p]++;
+            sums[p] += value;
+            integrals[p] += value * width;
+            firstSums[p] += value * coordinate;
+            secondSums[p] += value * coordinate * coordinate;
+            peaks[p] = std::max( peaks[p], value );
+        }
+    }
+
+    std::vector<float> medians;
+    if ( layout.median ){
+        medians.assign( planeSize, std::numeric_limits<float>::quiet_NaN() );
+        std::vector<float> spectrum;
+        for ( qint64 p = 0; p < planeSize; p++ ){
+            if ( counts[p] == 0 ){
+                continue;
+            }
+            spectrum.clear();
+            for ( int k = 0; k < layout.channelCount; k++ ){
+                float value = cube[k * planeSize + p];
+                if ( value >= includeMin && value <= includeMax ){
+                    spectrum.push_back( value );
+                }
+            }
+            int half = spectrum.size() / 2;
+            std::nth_element( spectrum.begin(), spectrum.begin() + half, spectrum.end() );
+            float median = spectrum[half];
+            if ( spectrum.size() % 2 == 0 ){
+                median = ( median + *std::max_element( spectrum.begin(), spectrum.begin() + half ) ) / 2;
+            }
+            medians[p] = median;
+        }
+    }
+
+    //Write the rows of the maps.
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    int width = layout.dims[0];
+    int momentCount = params.m_moments.size();
+    for ( int i = 0; i < momentCount; i++ ){
+        MomentType type = params.m_moments[i];
+        for ( qint64 p = 0; p < planeSize; p++ ){
+            float result = nan;
+            if ( counts[p] > 0 ){
+                double mean = sums[p] != 0 ? firstSums[p] / sums[p] : nan;
+                switch ( type ){
+                case MomentType::INTEGRATED:
+                    result = integrals[p];
+                    break;
+                case MomentType::WEIGHTED_COORD:
+                    result = layout.reference + mean;
+                    break;
+                case MomentType::WEIGHTED_DISPERSION:
+                    result = std::sqrt( std::max( secondSums[p] / sums[p] - mean * mean, 0.0 ) );
+                    if ( sums[p] == 0 ){
+                        result = nan;
+                    }
+                    break;
+                case MomentType::MAXIMUM:
+                    result = peaks[p];
+                    break;
+                case MomentType::MEDIAN:
+                    result = medians[p];
+                    break;
+                }
+            }
+            int x = layout.x0 + p % boxWidth;
+            int y = firstRow + p / boxWidth;
+            maps[i][qint64( y ) * width + x] = result;
+        }
+    }
+    return true;
+}
+
+
+QString MomentEngine::getName( MomentType type ){
+    QString name;
+    switch ( type ){
+    case MomentType::INTEGRATED:
+        name = "integrated";
+        break;
+    case MomentType::WEIGHTED_COORD:
+        name = "weighted_coord";
+        break;
+    case MomentType::WEIGHTED_DISPERSION:
+        name = "weighted_dispersion_coord";
+        break;
+    case MomentType::MAXIMUM:
+        name = "maximum";
+        break;
+    case MomentType::MEDIAN:
+        name = "median";
+        break;
+    }
+    return name;
+}
+
+
+std::vector<char> MomentEngine::_getRegionMask( const MomentsHook::Params& params,
+        const Layout& layout ){
+    //Pixels are inside when their centers are.
+    Carta::Lib::Regions::RegionMask::ConstSharedPtr regionMask =
+            Carta::Lib::Regions::RegionMask::get( params.m_regionInfo.get(),
+                    layout.dims[0], layout.dims[1] );
+    return regionMask->toBitmap( QRect( QPoint( layout.x0, layout.y0 ),
+            QPoint( layout.x1, layout.y1 ) ) );
+}
+
+
+QString MomentEngine::getUnit( MomentType type, const QString& pixelUnit, const QString& spectralUnit ){
+    QString unit = pixelUnit;
+    if ( type == MomentType::INTEGRATED ){
+        if ( pixelUnit.isEmpty() ){
+            unit = spectralUnit;
+        }
+        else if ( !spectralUnit.isEmpty() ){
+            unit = pixelUnit + "." + spectralUnit;
+        }
+    }
+    else if ( type == MomentType::WEIGHTED_COORD || type == MomentType::WEIGHTED_DISPERSION ){
+        unit = spectralUnit;
+    }
+    return unit;
+}
+
+
+MomentEngine::~MomentEngine(){
+}
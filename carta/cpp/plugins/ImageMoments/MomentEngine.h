@@ -0,0 +1,76 @@
+/**
+ * Computes moment maps of a cube in one pass over the spectra.
+ */
+
+#pragma once
+
+#include "CartaLib/Hooks/MomentsHook.h"
+
+#include <QString>
+
+#include <vector>
+
+namespace Carta {
+namespace Lib {
+namespace Image {
+class ImageInterface;
+}
+}
+}
+
+class MomentEngine {
+
+public:
+
+    typedef Carta::Lib::Hooks::MomentsHook::MomentType MomentType;
+
+    /**
+     * Returns the requested moment maps of a cube.  The cube is split into blocks
+     * of rows that are read, spectra and all, with one bulk read each, and the blocks
+     * are handled in parallel; all the moments of a block are accumulated together,
+     * so every pixel of the cube is read only once.
+     * @param params - the cube, the moments to compute, and the pixels to use.  There
+     *      must be a spectral coordinate for every channel of the cube.
+     * @param errorMsg - set to a description of the problem if the moments could not
+     *      be computed.
+     * @return - a map for each requested moment, with the first axis of the cube
+     *      varying fastest; pixels without any data are NaN.  The list is empty if
+     *      the moments could not be computed.
+     */
+    static std::vector< std::vector<float> > compute(
+            const Carta::Lib::Hooks::MomentsHook::Params& params, QString* errorMsg );
+
+    /**
+     * Returns a short name for a moment, the suffix CASA's immoments uses for it.
+     * @param type - a moment.
+     * @return - the name of the moment, for example 'integrated'.
+     */
+    static QString getName( MomentType type );
+
+    /**
+     * Returns the unit of the values of a moment map.
+     * @param type - a moment.
+     * @param pixelUnit - the unit of the pixels of the cube.
+     * @param spectralUnit - the unit of the spectral coordinates.
+     * @return - the unit of the map.
+     */
+    static QString getUnit( MomentType type, const QString& pixelUnit, const QString& spectralUnit );
+
+private:
+
+    //The part of the cube handled by the parallel tasks.
+    struct Layout;
+
+    //Computes the moments of a block of rows of the cube.
+    static bool _computeBlock( Carta::Lib::Image::ImageInterface* image,
+            const Carta::Lib::Hooks::MomentsHook::Params& params, const Layout& layout,
+            int firstRow, int lastRow, std::vector<float>& cube,
+            std::vector< std::vector<float> >& maps );
+
+    //Returns which pixels of the box are inside the region.
+    static std::vector<char> _getRegionMask( const Carta::Lib::Hooks::MomentsHook::Params& params,
+            const Layout& layout );
+
+    MomentEngine();
+    virtual ~MomentEngine();
+};
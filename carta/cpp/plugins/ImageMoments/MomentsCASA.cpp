@@ -0,0 +1,134 @@
+#include "CartaLib/Hooks/Initialize.h"
+#include "CartaLib/Hooks/MomentsHook.h"
+#include "CartaLib/IImage.h"
+#include "plugins/CasaImageLoader/CCImage.h"
+#include "plugins/CasaImageLoader/CCMetaDataInterface.h"
+
+#include "MomentsCASA.h"
+#include "MomentEngine.h"
+
+#include <casacore/images/Images/TempImage.h>
+#include <casacore/lattices/Lattices/TiledShape.h>
+
+#include <QDebug>
+
+
+MomentsCASA::MomentsCASA( QObject * parent ) :
+    QObject( parent )
+{ }
+
+
+bool
+MomentsCASA::handleHook( BaseHook & hookData ){
+    if ( hookData.is < Carta::Lib::Hooks::Initialize > () ) {
+        return true;
+    }
+    else if ( hookData.is < Carta::Lib::Hooks::MomentsHook > () ) {
+        Carta::Lib::Hooks::MomentsHook & hook
+            = static_cast < Carta::Lib::Hooks::MomentsHook & > ( hookData );
+        Carta::Lib::Hooks::MomentsHook::Params params = *hook.paramsPtr;
+        std::shared_ptr<Carta::Lib::Image::ImageInterface> image = params.m_dataSource;
+        if ( !image ){
+            qDebug() << "No image, moments returning false";
+            return false;
+        }
+
+        //The maps get the coordinate system of the cube.
+        CCImageBase * base = dynamic_cast<CCImageBase*>( image.get() );
+        CCMetaDataInterface* metaData = nullptr;
+        Carta::Lib::Image::MetaDataInterface::SharedPtr metaPtr;
+        if ( base ){
+            metaPtr = base->metaData();
+            metaData = dynamic_cast<CCMetaDataInterface*>( metaPtr.get() );
+        }
+        if ( !metaData ){
+            qWarning() << "Moments plugin: not an image created by casaimageloader...";
+            return false;
+        }
+        std::shared_ptr<casacore::CoordinateSystem> cs = metaData->getCoordinateSystem();
+
+        //Without spectral coordinates, the moments are in channels.
+        const std::vector<int>& dims = image->dims();
+        int dimCount = dims.size();
+        int spectralAxis = params.m_spectralAxis;
+        if ( 0 <= spectralAxis && spectralAxis < dimCount &&
+                static_cast<int>( params.m_spectralValues.size() ) != dims[spectralAxis] ){
+            params.m_spectralValues.clear();
+            for ( int i = 0; i < dims[spectralAxis]; i++ ){
+                params.m_spectralValues.push_back( i );
+            }
+            params.m_spectralUnit = "pixel";
+        }
+
+        QString errorMsg;
+        std::vector< std::vector<float> > maps = MomentEngine::compute( params, &errorMsg );
+        if ( maps.empty() ){
+            qWarning() << "Could not compute moments: " << errorMsg;
+            return false;
+        }
+
+        //The maps keep all the axes of the cube, with one pixel along the axes other
+        //than the spatial ones; along the spectral axis, that pixel is at the middle
+        //of the channel range.
+        int channelMin = std::max( params.m_channelMin, 0 );
+        int channelMax = params.m_channelMax < 0 ? dims[spectralAxis] - 1 :
+                std::min( params.m_channelMax, dims[spectralAxis] - 1 );
+        casacore::IPosition shape( dimCount, 1 );
+        casacore::Vector<casacore::Float> originShift( dimCount, 0 );
+        casacore::Vector<casacore::Float> increments( dimCount, 1 );
+        casacore::Vector<casacore::Int> newShape( dimCount, 1 );
+        for ( int i = 0; i < dimCount; i++ ){
+            if ( i < 2 ){
+                shape( i ) = dims[i];
+                newShape( i ) = dims[i];
+            }
+            else if ( i == spectralAxis ){
+                originShift( i ) = ( channelMin + channelMax ) / 2.0;
+            }
+            else if ( i < static_cast<int>( params.m_frames.size() ) ){
+                originShift( i ) = params.m_frames[i];
+            }
+        }
+        casacore::CoordinateSystem momentCS = cs->subImage( originShift, increments, newShape );
+
+        QString pixelUnit = image->getPixelUnit().toStr();
+        int momentCount = params.m_moments.size();
+        for ( int i = 0; i < momentCount; i++ ){
+            Carta::Lib::Hooks::MomentsHook::MomentType type = params.m_moments[i];
+            casacore::TempImage<casacore::Float>* momentImage =
+                    new casacore::TempImage<casacore::Float>( casacore::TiledShape( shape ), momentCS );
+            casacore::Array<casacore::Float> pixels( shape, maps[i].data(), casacore::SHARE );
+            momentImage->put( pixels );
+            QString unit = MomentEngine::getUnit( type, pixelUnit, params.m_spectralUnit );
+            try {
+                momentImage->setUnits( casacore::Unit( unit.toStdString() ) );
+            }
+            catch( casacore::AipsError& error ){
+                qWarning() << "Moment map without a unit: " << error.getMesg().c_str();
+            }
+            momentImage->setImageInfo( base->getImageInfo() );
+
+            Carta::Lib::Hooks::MomentsHook::Moment moment;
+            moment.m_type = type;
+            moment.m_name = MomentEngine::getName( type );
+            moment.m_image = CCImage<casacore::Float>::create( momentImage );
+            hook.result.push_back( moment );
+        }
+        return true;
+    }
+    qWarning() << "Moments doesn't know how to handle this hook";
+    return false;
+} // handleHook
+
+std::vector < HookId >
+MomentsCASA::getInitialHookList()
+{
+    return {
+               Carta::Lib::Hooks::Initialize::staticId,
+               Carta::Lib::Hooks::MomentsHook::staticId
+    };
+}
+
+MomentsCASA::~MomentsCASA() {
+
+}
@@ -0,0 +1,30 @@
+/// Plugin for generating moment maps of image cubes.
+
+#pragma once
+
+#include "CartaLib/IPlugin.h"
+#include <QObject>
+
+class MomentsCASA : public QObject, public IPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA( IID "org.cartaviewer.IPlugin" )
+    Q_INTERFACES( IPlugin )
+    ;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    MomentsCASA( QObject * parent = 0 );
+    virtual bool
+    handleHook( BaseHook & hookData ) override;
+
+    virtual std::vector < HookId >
+    getInitialHookList() override;
+
+    virtual ~MomentsCASA();
+
+
+};
@@ -8,16 +8,16 @@ TEMPLATE = lib
 CONFIG += plugin
 
 SOURCES += \
-    RegionRecordFactory.cpp \
+    PlaneSums.cpp \
+    RegionStatsEngine.cpp \
     StatisticsCASA.cpp \
-    StatisticsCASAImage.cpp \
-    StatisticsCASARegion.cpp
+    StatisticsCASAImage.cpp
 
 HEADERS += \
-    RegionRecordFactory.h \
+    PlaneSums.h \
+    RegionStatsEngine.h \
     StatisticsCASA.h \
-    StatisticsCASAImage.h \
-    StatisticsCASARegion.h
+    StatisticsCASAImage.h
 
 casacoreLIBS += -L$${CASACOREDIR}/lib
 casacoreLIBS += -lcasa_lattices -lcasa_tables -lcasa_scimath -lcasa_scimath_f -lcasa_mirlib
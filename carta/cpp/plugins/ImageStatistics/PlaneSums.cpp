@@ -0,0 +1,197 @@
+#include "PlaneSums.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+//Number of pixels in a row whose extreme values are stored together.
+const int BLOCK_SIZE = 64;
+}
+
+
+PlaneSums::PlaneSums( const float* values, const bool* mask, int strideX, int strideY,
+        int width, int height ):
+    m_width( width ),
+    m_height( height ),
+    m_blocksPerRow( ( width + BLOCK_SIZE - 1 ) / BLOCK_SIZE ){
+    size_t pixelCount = static_cast<size_t>( width ) * height;
+    size_t prefixCount = static_cast<size_t>( width + 1 ) * height;
+    m_values.resize( pixelCount );
+    m_sums.resize( prefixCount );
+    m_sumSqs.resize( prefixCount );
+    m_deviations.resize( prefixCount );
+    m_rowMeans.resize( height );
+    m_counts.resize( prefixCount );
+    m_blocks.resize( static_cast<size_t>( m_blocksPerRow ) * height );
+    const float NOT_A_NUMBER = std::numeric_limits<float>::quiet_NaN();
+    for ( int y = 0; y < height; y++ ){
+        size_t rowStart = static_cast<size_t>( y ) * width;
+        size_t prefixStart = static_cast<size_t>( y ) * ( width + 1 );
+        double sum = 0;
+        int count = 0;
+        for ( int x = 0; x < width; x++ ){
+            size_t index = static_cast<size_t>( x ) * strideX + static_cast<size_t>( y ) * strideY;
+            float value = values[index];
+            if ( ( mask && !mask[index] ) || !std::isfinite( value ) ){
+                value = NOT_A_NUMBER;
+            }
+            else {
+                sum += value;
+                count++;
+            }
+            m_values[rowStart + x] = value;
+        }
+        //Deviations are taken from the mean of the row so that they do not cancel
+        //when the spread of a span is found from them.
+        double rowMean = count > 0 ? sum / count : 0;
+        m_rowMeans[y] = rowMean;
+        //The prefix sums are compensated like the sums of a region read from the
+        //image, so both give the same statistics.
+        RegionStatsEngine::CompensatedSum prefixSum;
+        RegionStatsEngine::CompensatedSum prefixSumSq;
+        RegionStatsEngine::CompensatedSum prefixDeviations;
+        count = 0;
+        m_sums[prefixStart] = prefixSum;
+        m_sumSqs[prefixStart] = prefixSumSq;
+        m_deviations[prefixStart] = prefixDeviations;
+        m_counts[prefixStart] = 0;
+        for ( int x = 0; x < width; x++ ){
+            float value = m_values[rowStart + x];
+            if ( !std::isnan( value ) ){
+                double deviation = value - rowMean;
+                prefixSum.add( value );
+                prefixSumSq.add( static_cast<double>( value ) * value );
+                prefixDeviations.add( deviation * deviation );
+                count++;
+            }
+            m_sums[prefixStart + x + 1] = prefixSum;
+            m_sumSqs[prefixStart + x + 1] = prefixSumSq;
+            m_deviations[prefixStart + x + 1] = prefixDeviations;
+            m_counts[prefixStart + x + 1] = count;
+        }
+        for ( int b = 0; b < m_blocksPerRow; b++ ){
+            int x0 = b * BLOCK_SIZE;
+            int x1 = std::min( x0 + BLOCK_SIZE, width ) - 1;
+            _scan( y, x0, x1, m_blocks[static_cast<size_t>( y ) * m_blocksPerRow + b] );
+        }
+    }
+}
+
+
+void PlaneSums::add( const RegionStatsEngine::Span& span, RegionStatsEngine::Accumulator& accumulator ) const {
+    size_t prefixStart = static_cast<size_t>( span.y ) * ( m_width + 1 );
+    RegionStatsEngine::Accumulator spanStats;
+    spanStats.count = m_counts[prefixStart + span.x1 + 1] - m_counts[prefixStart + span.x0];
+    if ( spanStats.count == 0 ){
+        return;
+    }
+    size_t first = prefixStart + span.x0;
+    size_t last = prefixStart + span.x1 + 1;
+    spanStats.sum = _difference( m_sums[last], m_sums[first] );
+    spanStats.sumSq = _difference( m_sumSqs[last], m_sumSqs[first] );
+    //Squared deviations from the mean of the span, from those from the mean of the row.
+    double deviations = _difference( m_deviations[last], m_deviations[first] );
+    double offset = spanStats.sum / spanStats.count - m_rowMeans[span.y];
+    spanStats.m2 = std::max( deviations - spanStats.count * offset * offset, 0.0 );
+
+    //Scan the partial blocks at the ends of the span and use the stored extremes
+    //of the blocks in between.
+    BlockExtremes extremes = { 0, 0, -1, -1 };
+    auto combine = [&extremes]( const BlockExtremes& other ){
+        if ( other.minX >= 0 && ( extremes.minX < 0 || other.min < extremes.min ) ){
+            extremes.min = other.min;
+            extremes.minX = other.minX;
+        }
+        if ( other.maxX >= 0 && ( extremes.maxX < 0 || other.max > extremes.max ) ){
+            extremes.max = other.max;
+            extremes.maxX = other.maxX;
+        }
+    };
+    int firstFullBlock = ( span.x0 + BLOCK_SIZE - 1 ) / BLOCK_SIZE;
+    int lastFullBlock = ( span.x1 + 1 ) / BLOCK_SIZE - 1;
+    if ( firstFullBlock > lastFullBlock ){
+        BlockExtremes part;
+        _scan( span.y, span.x0, span.x1, part );
+        combine( part );
+    }
+    else {
+        BlockExtremes part;
+        if ( span.x0 < firstFullBlock * BLOCK_SIZE ){
+            _scan( span.y, span.x0, firstFullBlock * BLOCK_SIZE - 1, part );
+            combine( part );
+        }
+        size_t blockStart = static_cast<size_t>( span.y ) * m_blocksPerRow;
+        for ( int b = firstFullBlock; b <= lastFullBlock; b++ ){
+            combine( m_blocks[blockStart + b] );
+        }
+        if ( span.x1 >= ( lastFullBlock + 1 ) * BLOCK_SIZE ){
+            _scan( span.y, ( lastFullBlock + 1 ) * BLOCK_SIZE, span.x1, part );
+            combine( part );
+        }
+    }
+    spanStats.min = extremes.min;
+    spanStats.minX = extremes.minX;
+    spanStats.minY = span.y;
+    spanStats.max = extremes.max;
+    spanStats.maxX = extremes.maxX;
+    spanStats.maxY = span.y;
+    accumulator.merge( spanStats );
+}
+
+
+double PlaneSums::_difference( const RegionStatsEngine::CompensatedSum& last,
+        const RegionStatsEngine::CompensatedSum& first ){
+    //Knuth's two-sum keeps the rounding error of subtracting the totals, so the
+    //difference is rounded only once.
+    double total = last.total - first.total;
+    double lastPart = total + first.total;
+    double firstPart = lastPart - total;
+    double error = ( last.total - lastPart ) + ( firstPart - first.total );
+    return total + ( error + ( last.compensation - first.compensation ) );
+}
+
+
+int PlaneSums::getHeight() const {
+    return m_height;
+}
+
+
+int PlaneSums::getWidth() const {
+    return m_width;
+}
+
+
+qint64 PlaneSums::getSize() const {
+    qint64 size = m_values.size() * sizeof( float );
+    size += ( m_sums.size() + m_sumSqs.size() + m_deviations.size() ) *
+            sizeof( RegionStatsEngine::CompensatedSum );
+    size += m_rowMeans.size() * sizeof( double );
+    size += m_counts.size() * sizeof( int );
+    size += m_blocks.size() * sizeof( BlockExtremes );
+    return size;
+}
+
+
+void PlaneSums::_scan( int y, int x0, int x1, BlockExtremes& extremes ) const {
+    extremes = { 0, 0, -1, -1 };
+    const float* row = m_values.data() + static_cast<size_t>( y ) * m_width;
+    for ( int x = x0; x <= x1; x++ ){
+        float value = row[x];
+        if ( std::isnan( value ) ){
+            continue;
+        }
+        if ( extremes.minX < 0 || value < extremes.min ){
+            extremes.min = value;
+            extremes.minX = x;
+        }
+        if ( extremes.maxX < 0 || value > extremes.max ){
+            extremes.max = value;
+            extremes.maxX = x;
+        }
+    }
+}
+
+
+PlaneSums::~PlaneSums(){
+}
@@ -0,0 +1,89 @@
+/**
+ * Per-row prefix sums of an image plane, so that the statistics of a region
+ * can be computed in time proportional to its number of rows rather than its area.
+ */
+
+#pragma once
+
+#include "RegionStatsEngine.h"
+
+#include <vector>
+
+class PlaneSums {
+
+public:
+
+    /**
+     * Constructor.
+     * @param values - the pixel values of the plane.
+     * @param mask - the pixel mask of the plane; nullptr if all pixels are good.
+     * @param strideX - distance between horizontally neighbouring pixels in the arrays.
+     * @param strideY - distance between vertically neighbouring pixels in the arrays.
+     * @param width - the number of pixels along the x axis of the plane.
+     * @param height - the number of pixels along the y axis of the plane.
+     */
+    PlaneSums( const float* values, const bool* mask, int strideX, int strideY,
+            int width, int height );
+
+    /**
+     * Add the pixels of a span to the statistics.
+     * @param span - a run of pixels within the plane.
+     * @param accumulator - the statistics to add to.
+     */
+    void add( const RegionStatsEngine::Span& span, RegionStatsEngine::Accumulator& accumulator ) const;
+
+    /**
+     * Returns the number of pixels along the x axis of the plane.
+     * @return - the width of the plane.
+     */
+    int getWidth() const;
+
+    /**
+     * Returns the number of pixels along the y axis of the plane.
+     * @return - the height of the plane.
+     */
+    int getHeight() const;
+
+    /**
+     * Returns the memory held by the sums.
+     * @return - the size of the sums in bytes.
+     */
+    qint64 getSize() const;
+
+    virtual ~PlaneSums();
+
+private:
+
+    //Extreme values of a block of pixels in a row; the positions are -1 if
+    //the block has no valid pixels.
+    struct BlockExtremes {
+        float min;
+        float max;
+        int minX;
+        int maxX;
+    };
+
+    void _scan( int y, int x0, int x1, BlockExtremes& extremes ) const;
+
+    //Returns the sum of the values added between two prefix sums.
+    static double _difference( const RegionStatsEngine::CompensatedSum& last,
+            const RegionStatsEngine::CompensatedSum& first );
+
+    int m_width;
+    int m_height;
+    int m_blocksPerRow;
+
+    //Pixel values in row order; masked pixels are stored as NaN.
+    std::vector<float> m_values;
+    //Compensated prefix sums for each row, width + 1 entries per row.
+    std::vector<RegionStatsEngine::CompensatedSum> m_sums;
+    std::vector<RegionStatsEngine::CompensatedSum> m_sumSqs;
+    //Prefix sums of the squared deviations of the pixels from the mean of their row.
+    std::vector<RegionStatsEngine::CompensatedSum> m_deviations;
+    std::vector<double> m_rowMeans;
+    std::vector<int> m_counts;
+    std::vector<BlockExtremes> m_blocks;
+
+    PlaneSums( const PlaneSums& other);
+    PlaneSums& operator=( const PlaneSums& other );
+};
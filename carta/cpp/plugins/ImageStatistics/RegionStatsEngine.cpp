@@ -0,0 +1,768 @@
+#include "RegionStatsEngine.h"
+#include "PlaneSums.h"
+#include "CartaLib/Algorithms/ParallelTasks.h"
+#include "CartaLib/Regions/Ellipse.h"
+#include "CartaLib/Regions/Point.h"
+#include "CartaLib/Regions/Rectangle.h"
+#include "CartaLib/Regions/RegionMask.h"
+#include "casacore/casa/Quanta/Quantum.h"
+#include "casacore/coordinates/Coordinates/CoordinateUtil.h"
+#include "casacore/coordinates/Coordinates/DirectionCoordinate.h"
+
+#include <QCache>
+#include <QDebug>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+//Number of rows of a region handled by one parallel task.
+const int ROWS_PER_TASK = 64;
+
+//Largest plane for which prefix sums are built (about 56 bytes per pixel).
+const qint64 MAX_PLANE_PIXELS = 1024 * 1024;
+
+//Memory, in kilobytes, that the prefix sums of all images may hold together.
+const int MAX_PLANE_CACHE_KB = 128 * 1024;
+
+//The numeric statistics of a region, in the order they are listed.
+const Carta::Lib::StatInfo::StatType SCALAR_STATS[] = {
+    Carta::Lib::StatInfo::StatType::FrameCount,
+    Carta::Lib::StatInfo::StatType::Sum,
+    Carta::Lib::StatInfo::StatType::SumSq,
+    Carta::Lib::StatInfo::StatType::Min,
+    Carta::Lib::StatInfo::StatType::Max,
+    Carta::Lib::StatInfo::StatType::Mean,
+    Carta::Lib::StatInfo::StatType::Sigma,
+    Carta::Lib::StatInfo::StatType::RMS,
+    Carta::Lib::StatInfo::StatType::FluxDensity
+};
+
+//Prefix sums of the plane of an image that was most recently asked for repeatedly.
+struct CachedPlane {
+    QString key;
+    QString lastKey;
+    std::shared_ptr<const PlaneSums> sums;
+};
+
+//Cached planes by image name; the least recently used images are dropped first
+//once the planes hold more than MAX_PLANE_CACHE_KB.
+struct PlaneCache {
+    QMutex mutex;
+    QCache<QString, CachedPlane> planes { MAX_PLANE_CACHE_KB };
+};
+PlaneCache planeCache;
+}
+
+
+RegionStatsEngine::RegionStatsEngine() {
+}
+
+
+void RegionStatsEngine::Accumulator::add( const float* values, const bool* mask,
+        int stride, const Span& span ){
+    CompensatedSum spanSum;
+    CompensatedSum spanSumSq;
+    long long spanCount = 0;
+    int spanLength = span.x1 - span.x0 + 1;
+    for ( int i = 0; i < spanLength; i++ ){
+        int index = i * stride;
+        float value = values[index];
+        if ( ( mask && !mask[index] ) || !std::isfinite( value ) ){
+            continue;
+        }
+        spanSum.add( value );
+        spanSumSq.add( static_cast<double>(value) * value );
+        if ( count + spanCount == 0 || value < min ){
+            min = value;
+            minX = span.x0 + i;
+            minY = span.y;
+        }
+        if ( count + spanCount == 0 || value > max ){
+            max = value;
+            maxX = span.x0 + i;
+            maxY = span.y;
+        }
+        spanCount++;
+    }
+    if ( spanCount == 0 ){
+        return;
+    }
+
+    //Deviations from the mean of the span, found in a second pass.
+    double spanMean = spanSum.value() / spanCount;
+    double spanM2 = 0;
+    for ( int i = 0; i < spanLength; i++ ){
+        int index = i * stride;
+        float value = values[index];
+        if ( ( mask && !mask[index] ) || !std::isfinite( value ) ){
+            continue;
+        }
+        double deviation = value - spanMean;
+        spanM2 += deviation * deviation;
+    }
+    addSums( spanCount, spanSum.value(), spanSumSq.value(), spanM2 );
+}
+
+
+void RegionStatsEngine::Accumulator::addSums( long long pixelCount, double pixelSum,
+        double pixelSumSq, double pixelM2 ){
+    if ( pixelCount == 0 ){
+        return;
+    }
+    if ( count == 0 ){
+        m2 = pixelM2;
+    }
+    else {
+        //Chan et al.'s update for the deviations of the union of two sets.
+        double delta = pixelSum / pixelCount - sum / count;
+        double weight = static_cast<double>( count ) * pixelCount / ( count + pixelCount );
+        m2 += pixelM2 + delta * delta * weight;
+    }
+    m_sum.add( pixelSum );
+    m_sumSq.add( pixelSumSq );
+    sum = m_sum.value();
+    sumSq = m_sumSq.value();
+    count += pixelCount;
+}
+
+
+void RegionStatsEngine::Accumulator::merge( const Accumulator& other ){
+    if ( other.count == 0 ){
+        return;
+    }
+    if ( count == 0 || other.min < min ){
+        min = other.min;
+        minX = other.minX;
+        minY = other.minY;
+    }
+    if ( count == 0 || other.max > max ){
+        max = other.max;
+        maxX = other.maxX;
+        maxY = other.maxY;
+    }
+    addSums( other.count, other.sum, other.sumSq, other.m2 );
+}
+
+
+void RegionStatsEngine::_accumulate( const float* pixels, const bool* maskPixels,
+        int strideX, int strideY, const QRect& box,
+        const std::vector< std::vector<Span> >& regionSpans, std::vector<Accumulator>& accumulators ){
+    //Split the regions into blocks of rows and compute them in parallel.
+    struct Task {
+        int regionIndex;
+        size_t firstSpan;
+        size_t lastSpan;
+        Accumulator accumulator;
+    };
+    std::vector<Task> tasks;
+    int regionCount = regionSpans.size();
+    for ( int i = 0; i < regionCount; i++ ){
+        size_t spanCount = regionSpans[i].size();
+        for ( size_t first = 0; first < spanCount; first += ROWS_PER_TASK ){
+            tasks.push_back( { i, first, std::min( first + ROWS_PER_TASK, spanCount ), Accumulator() } );
+        }
+    }
+    Carta::Lib::Algorithms::ParallelTasks::run( tasks.size(), [&]( int taskIndex, int /*worker*/ ){
+        Task& task = tasks[taskIndex];
+        const std::vector<Span>& spans = regionSpans[task.regionIndex];
+        for ( size_t k = task.firstSpan; k < task.lastSpan; k++ ){
+            const Span& span = spans[k];
+            int offset = ( span.x0 - box.left() ) * strideX + ( span.y - box.top() ) * strideY;
+            task.accumulator.add( pixels + offset, maskPixels ? maskPixels + offset : nullptr,
+                    strideX, span );
+        }
+    });
+
+    //Merge in a fixed order so the results do not depend on scheduling.
+    for ( const Task& task : tasks ){
+        accumulators[task.regionIndex].merge( task.accumulator );
+    }
+}
+
+
+double RegionStatsEngine::_getBeamArea( const casacore::ImageInterface<casacore::Float>* image,
+        const casacore::CoordinateSystem& cs, const std::vector<int>& slice ){
+    double beamArea = 0;
+    const casacore::ImageInfo& info = image->imageInfo();
+    int directionIndex = cs.findCoordinate( casacore::Coordinate::DIRECTION );
+    if ( !info.hasBeam() || directionIndex < 0 ){
+        return beamArea;
+    }
+    casacore::GaussianBeam beam;
+    if ( info.hasMultipleBeams() ){
+        int spectralAxis = cs.spectralAxisNumber();
+        int stokesAxis = cs.polarizationAxisNumber();
+        int channel = spectralAxis >= 0 ? slice[spectralAxis] : -1;
+        int stokes = stokesAxis >= 0 ? slice[stokesAxis] : -1;
+        beam = info.restoringBeam( channel, stokes );
+    }
+    else {
+        beam = info.restoringBeam();
+    }
+    if ( !beam.isNull() ){
+        double pixelArea = _getPixelArea( cs );
+        if ( pixelArea > 0 ){
+            beamArea = beam.getArea( "rad2" ) / pixelArea;
+        }
+    }
+    return beamArea;
+}
+
+
+std::shared_ptr<const PlaneSums> RegionStatsEngine::_getPlaneSums(
+        casacore::ImageInterface<casacore::Float>* image, const std::vector<int>& slice,
+        int xAxis, int yAxis ){
+    std::shared_ptr<const PlaneSums> planeSums( nullptr );
+    //Images without a name may not be the same image the next time around.
+    QString imageName = image->name( false ).c_str();
+    if ( imageName.isEmpty() ){
+        return planeSums;
+    }
+    QString key = imageName;
+    for ( int index : slice ){
+        key = key + ":" + QString::number( index );
+    }
+
+    {
+        QMutexLocker locker( &planeCache.mutex );
+        CachedPlane* cached = planeCache.planes.object( imageName );
+        if ( cached && key == cached->key ){
+            return cached->sums;
+        }
+        if ( !cached ){
+            cached = new CachedPlane();
+            planeCache.planes.insert( imageName, cached, 1 );
+        }
+        if ( key != cached->lastKey ){
+            //Wait for a second request for the same plane, as when a region is dragged.
+            cached->lastKey = key;
+            return planeSums;
+        }
+    }
+
+    //The plane is read without holding the lock, so requests for other planes and
+    //images are not held up.
+    casacore::IPosition imageShape = image->shape();
+    int width = imageShape[xAxis];
+    int height = imageShape[yAxis];
+    if ( static_cast<qint64>( width ) * height <= MAX_PLANE_PIXELS ){
+        auto build = [&]( const float* pixels, const bool* maskPixels, int strideX, int strideY ){
+            planeSums.reset( new PlaneSums( pixels, maskPixels, strideX, strideY, width, height ) );
+        };
+        if ( _readPlane( image, slice, xAxis, yAxis, QRect( 0, 0, width, height ), build ) ){
+            //The sums replace those of the image's previous plane.
+            CachedPlane* cached = new CachedPlane();
+            cached->key = key;
+            cached->lastKey = key;
+            cached->sums = planeSums;
+            int cost = std::max( 1, static_cast<int>( planeSums->getSize() / 1024 ) );
+            QMutexLocker locker( &planeCache.mutex );
+            planeCache.planes.insert( imageName, cached, cost );
+        }
+        else {
+            planeSums.reset();
+        }
+    }
+    return planeSums;
+}
+
+
+QString RegionStatsEngine::getSpans( const Carta::Lib::Regions::RegionBase* region,
+        int width, int height, std::vector<Span>& spans ){
+    QString typeStr;
+    spans.clear();
+    if ( !region ){
+        return typeStr;
+    }
+    QString regionType = region->typeName();
+    if ( regionType == Carta::Lib::Regions::Point::TypeName ){
+        typeStr = "Point";
+    }
+    else if ( regionType == Carta::Lib::Regions::Rectangle::TypeName ){
+        typeStr = "Rectangle";
+    }
+    else if ( regionType == Carta::Lib::Regions::Ellipse::TypeName ){
+        typeStr = "Ellipse";
+    }
+    else if ( regionType == Carta::Lib::Regions::Polygon::TypeName ){
+        typeStr = "Polygon";
+    }
+    else {
+        typeStr = regionType;
+    }
+    Carta::Lib::Regions::RegionMask::ConstSharedPtr mask =
+            Carta::Lib::Regions::RegionMask::get( region, width, height );
+    spans = mask->runs();
+    return typeStr;
+}
+
+
+QList< QList<Carta::Lib::StatInfo> >
+RegionStatsEngine::getStats( casacore::ImageInterface<casacore::Float>* image,
+        const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regions,
+        const std::vector<int>& slice ){
+    int regionCount = regions.size();
+    QList< QList<Carta::Lib::StatInfo> > results;
+    for ( int i = 0; i < regionCount; i++ ){
+        results.append( QList<Carta::Lib::StatInfo>() );
+    }
+
+    casacore::IPosition imageShape = image->shape();
+    int dims = imageShape.nelements();
+    casacore::CoordinateSystem cs = image->coordinates();
+    int xAxis = -1;
+    int yAxis = -1;
+    if ( !_isInImage( imageShape, slice ) || !_getDisplayAxes( cs, &xAxis, &yAxis ) ){
+        return results;
+    }
+
+    //Rasterize the regions.
+    std::vector< std::vector<Span> > regionSpans( regionCount );
+    std::vector<QString> typeStrs( regionCount );
+    QRect dataBox = _getSpans( regions, imageShape[xAxis], imageShape[yAxis], regionSpans, &typeStrs );
+    if ( dataBox.isEmpty() ){
+        return results;
+    }
+
+    std::vector<Accumulator> accumulators( regionCount );
+    if ( !_accumulatePlane( image, slice, xAxis, yAxis, dataBox, regionSpans, true, accumulators ) ){
+        return results;
+    }
+
+    double fluxScale = _getFluxScale( image, cs, slice );
+    for ( int i = 0; i < regionCount; i++ ){
+        const Accumulator& acc = accumulators[i];
+        if ( acc.count == 0 ){
+            continue;
+        }
+        QList<Carta::Lib::StatInfo>& stats = results[i];
+        for ( Carta::Lib::StatInfo::StatType statType : SCALAR_STATS ){
+            double value = _getValue( acc, statType, fluxScale );
+            if ( !std::isnan( value ) ){
+                _insertScalar( value, statType, stats );
+            }
+        }
+
+        //Corners of the region's bounding box and extreme positions in image pixels.
+        const std::vector<Span>& spans = regionSpans[i];
+        casacore::IPosition blc( dims );
+        casacore::IPosition trc( dims );
+        for ( int k = 0; k < dims; k++ ){
+            blc[k] = slice[k];
+            trc[k] = slice[k];
+        }
+        blc[xAxis] = spans.front().x0;
+        trc[xAxis] = spans.front().x1;
+        blc[yAxis] = spans.front().y;
+        trc[yAxis] = spans.back().y;
+        for ( const Span& span : spans ){
+            blc[xAxis] = std::min<int>( blc[xAxis], span.x0 );
+            trc[xAxis] = std::max<int>( trc[xAxis], span.x1 );
+        }
+        casacore::IPosition minPos( blc );
+        minPos[xAxis] = acc.minX;
+        minPos[yAxis] = acc.minY;
+        casacore::IPosition maxPos( blc );
+        maxPos[xAxis] = acc.maxX;
+        maxPos[yAxis] = acc.maxY;
+        _insertPosition( blc, cs, Carta::Lib::StatInfo::StatType::Blc,
+                Carta::Lib::StatInfo::StatType::Blcf, stats );
+        _insertPosition( trc, cs, Carta::Lib::StatInfo::StatType::Trc,
+                Carta::Lib::StatInfo::StatType::Trcf, stats );
+        _insertPosition( minPos, cs, Carta::Lib::StatInfo::StatType::MinPos,
+                Carta::Lib::StatInfo::StatType::MinPosf, stats );
+        _insertPosition( maxPos, cs, Carta::Lib::StatInfo::StatType::MaxPos,
+                Carta::Lib::StatInfo::StatType::MaxPosf, stats );
+
+        //Put in an identifier.
+        QString blcVal = _vectorToString( blc );
+        QString trcVal = _vectorToString( trc );
+        QString idVal = typeStrs[i] + ":" + blcVal;
+        if ( blcVal != trcVal ){
+            idVal = idVal + " x " + trcVal;
+        }
+        Carta::Lib::StatInfo info( Carta::Lib::StatInfo::StatType::Name );
+        info.setValue( idVal );
+        info.setImageStat( false );
+        stats.append( info );
+    }
+    return results;
+}
+
+
+Carta::Lib::Hooks::StatisticsBatchHook::ResultType
+RegionStatsEngine::getStatColumns( casacore::ImageInterface<casacore::Float>* image,
+        const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regions,
+        const std::vector<int>& slice ){
+    Carta::Lib::Hooks::StatisticsBatchHook::ResultType columns;
+    int regionCount = regions.size();
+    for ( Carta::Lib::StatInfo::StatType statType : SCALAR_STATS ){
+        columns[statType].assign( regionCount, std::numeric_limits<double>::quiet_NaN() );
+    }
+    casacore::IPosition imageShape = image->shape();
+    casacore::CoordinateSystem cs = image->coordinates();
+    int xAxis = -1;
+    int yAxis = -1;
+    if ( !_isInImage( imageShape, slice ) || !_getDisplayAxes( cs, &xAxis, &yAxis ) ){
+        return columns;
+    }
+    std::vector< std::vector<Span> > regionSpans( regionCount );
+    QRect dataBox = _getSpans( regions, imageShape[xAxis], imageShape[yAxis], regionSpans, nullptr );
+    std::vector<Accumulator> accumulators( regionCount );
+    if ( dataBox.isEmpty() ||
+            !_accumulatePlane( image, slice, xAxis, yAxis, dataBox, regionSpans, true, accumulators ) ){
+        return columns;
+    }
+    double fluxScale = _getFluxScale( image, cs, slice );
+    for ( auto& column : columns ){
+        for ( int i = 0; i < regionCount; i++ ){
+            column.second[i] = _getValue( accumulators[i], column.first, fluxScale );
+        }
+    }
+    return columns;
+}
+
+
+Carta::Lib::Hooks::ProfileBatchHook::ResultType
+RegionStatsEngine::getProfiles( casacore::ImageInterface<casacore::Float>* image,
+        const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regions,
+        int spectralAxis, const std::vector<int>& slice,
+        Carta::Lib::ProfileInfo::AggregateType aggregateType ){
+    Carta::Lib::Hooks::ProfileBatchHook::ResultType profiles;
+    Carta::Lib::StatInfo::StatType statType = Carta::Lib::StatInfo::StatType::Mean;
+    switch ( aggregateType ){
+    case Carta::Lib::ProfileInfo::AggregateType::MEAN :
+        statType = Carta::Lib::StatInfo::StatType::Mean;
+        break;
+    case Carta::Lib::ProfileInfo::AggregateType::RMS :
+        statType = Carta::Lib::StatInfo::StatType::RMS;
+        break;
+    case Carta::Lib::ProfileInfo::AggregateType::SUM :
+        statType = Carta::Lib::StatInfo::StatType::Sum;
+        break;
+    case Carta::Lib::ProfileInfo::AggregateType::FLUX_DENSITY :
+        statType = Carta::Lib::StatInfo::StatType::FluxDensity;
+        break;
+    case Carta::Lib::ProfileInfo::AggregateType::VARIANCE :
+        statType = Carta::Lib::StatInfo::StatType::Sigma;
+        break;
+    case Carta::Lib::ProfileInfo::AggregateType::MIN :
+        statType = Carta::Lib::StatInfo::StatType::Min;
+        break;
+    case Carta::Lib::ProfileInfo::AggregateType::MAX :
+        statType = Carta::Lib::StatInfo::StatType::Max;
+        break;
+    default :
+        //A median needs all the pixels of a region rather than running sums.
+        qWarning() << "Region profiles cannot be computed in a batch with this method.";
+        return profiles;
+    }
+
+    casacore::IPosition imageShape = image->shape();
+    int dims = imageShape.nelements();
+    casacore::CoordinateSystem cs = image->coordinates();
+    int xAxis = -1;
+    int yAxis = -1;
+    if ( spectralAxis < 0 || spectralAxis >= dims || !_getDisplayAxes( cs, &xAxis, &yAxis ) ||
+            spectralAxis == xAxis || spectralAxis == yAxis ){
+        return profiles;
+    }
+    std::vector<int> planeSlice( slice );
+    planeSlice.resize( dims, 0 );
+    planeSlice[spectralAxis] = 0;
+    if ( !_isInImage( imageShape, planeSlice ) ){
+        return profiles;
+    }
+
+    //Every plane is read once, and all the regions are added up from it.
+    int regionCount = regions.size();
+    int channelCount = imageShape[spectralAxis];
+    std::vector< std::vector<Span> > regionSpans( regionCount );
+    QRect dataBox = _getSpans( regions, imageShape[xAxis], imageShape[yAxis], regionSpans, nullptr );
+    profiles.assign( regionCount, std::vector<double>( channelCount,
+            std::numeric_limits<double>::quiet_NaN() ) );
+    if ( dataBox.isEmpty() ){
+        return profiles;
+    }
+    std::vector<Accumulator> accumulators;
+    for ( int channel = 0; channel < channelCount; channel++ ){
+        planeSlice[spectralAxis] = channel;
+        accumulators.assign( regionCount, Accumulator() );
+        if ( !_accumulatePlane( image, planeSlice, xAxis, yAxis, dataBox, regionSpans, false, accumulators ) ){
+            profiles.clear();
+            return profiles;
+        }
+        double fluxScale = _getFluxScale( image, cs, planeSlice );
+        for ( int i = 0; i < regionCount; i++ ){
+            double value = _getValue( accumulators[i], statType, fluxScale );
+            if ( aggregateType == Carta::Lib::ProfileInfo::AggregateType::VARIANCE ){
+                value = value * value;
+            }
+            profiles[i][channel] = value;
+        }
+    }
+    return profiles;
+}
+
+
+bool RegionStatsEngine::_accumulatePlane( casacore::ImageInterface<casacore::Float>* image,
+        const std::vector<int>& slice, int xAxis, int yAxis, const QRect& dataBox,
+        const std::vector< std::vector<Span> >& regionSpans, bool usePlaneSums,
+        std::vector<Accumulator>& accumulators ){
+    std::shared_ptr<const PlaneSums> planeSums( nullptr );
+    if ( usePlaneSums ){
+        planeSums = _getPlaneSums( image, slice, xAxis, yAxis );
+    }
+    if ( planeSums ){
+        //Only the rows of each region are visited.  The spans are added in the same
+        //groups as when the pixels are read, so the sums come out the same.
+        int regionCount = regionSpans.size();
+        for ( int i = 0; i < regionCount; i++ ){
+            size_t spanCount = regionSpans[i].size();
+            for ( size_t first = 0; first < spanCount; first += ROWS_PER_TASK ){
+                Accumulator part;
+                size_t last = std::min( first + ROWS_PER_TASK, spanCount );
+                for ( size_t k = first; k < last; k++ ){
+                    planeSums->add( regionSpans[i][k], part );
+                }
+                accumulators[i].merge( part );
+            }
+        }
+        return true;
+    }
+    //Read the part of the plane covered by the regions in one go.
+    auto accumulate = [&]( const float* pixels, const bool* maskPixels, int strideX, int strideY ){
+        _accumulate( pixels, maskPixels, strideX, strideY, dataBox, regionSpans, accumulators );
+    };
+    return _readPlane( image, slice, xAxis, yAxis, dataBox, accumulate );
+}
+
+
+bool RegionStatsEngine::_getDisplayAxes( const casacore::CoordinateSystem& cs, int* xAxis, int* yAxis ){
+    casacore::Vector<casacore::Int> displayAxes = cs.directionAxesNumbers();
+    if ( displayAxes.nelements() < 2 || displayAxes[0] < 0 || displayAxes[1] < 0 ){
+        return false;
+    }
+    *xAxis = displayAxes[0];
+    *yAxis = displayAxes[1];
+    return true;
+}
+
+
+double RegionStatsEngine::_getFluxScale( const casacore::ImageInterface<casacore::Float>* image,
+        const casacore::CoordinateSystem& cs, const std::vector<int>& slice ){
+    double fluxScale = std::numeric_limits<double>::quiet_NaN();
+    QString brightnessUnit = image->units().getName().c_str();
+    if ( brightnessUnit.contains( "/beam", Qt::CaseInsensitive ) ){
+        double beamArea = _getBeamArea( image, cs, slice );
+        if ( beamArea > 0 ){
+            fluxScale = 1 / beamArea;
+        }
+    }
+    else if ( brightnessUnit.contains( "/pixel", Qt::CaseInsensitive ) ){
+        fluxScale = 1;
+    }
+    else {
+        //Surface brightness, such as Jy/sr or MJy/sr, is multiplied by the solid
+        //angle of a pixel.
+        int slash = brightnessUnit.lastIndexOf( "/" );
+        if ( slash >= 0 ){
+            casacore::String areaUnit = brightnessUnit.mid( slash + 1 ).trimmed().toStdString();
+            if ( casacore::UnitVal::check( areaUnit ) &&
+                    casacore::Quantity( 1, areaUnit ).isConform( casacore::Unit( "sr" ) ) ){
+                double pixelArea = _getPixelArea( cs );
+                if ( pixelArea > 0 ){
+                    fluxScale = casacore::Quantity( pixelArea, "sr" ).getValue( areaUnit );
+                }
+            }
+        }
+    }
+    return fluxScale;
+}
+
+
+double RegionStatsEngine::_getPixelArea( const casacore::CoordinateSystem& cs ){
+    double pixelArea = 0;
+    int directionIndex = cs.findCoordinate( casacore::Coordinate::DIRECTION );
+    if ( directionIndex >= 0 ){
+        const casacore::DirectionCoordinate& dirCoord = cs.directionCoordinate( directionIndex );
+        casacore::Vector<casacore::Double> increment = dirCoord.increment();
+        casacore::Vector<casacore::String> units = dirCoord.worldAxisUnits();
+        pixelArea = std::fabs(
+                casacore::Quantity( increment[0], units[0] ).getValue( "rad" ) *
+                casacore::Quantity( increment[1], units[1] ).getValue( "rad" ) );
+    }
+    return pixelArea;
+}
+
+
+QRect RegionStatsEngine::_getSpans( const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regions,
+        int width, int height, std::vector< std::vector<Span> >& regionSpans,
+        std::vector<QString>* typeStrs ){
+    QRect dataBox;
+    int regionCount = regions.size();
+    for ( int i = 0; i < regionCount; i++ ){
+        QString typeStr = getSpans( regions[i].get(), width, height, regionSpans[i] );
+        if ( typeStrs ){
+            (*typeStrs)[i] = typeStr;
+        }
+        for ( const Span& span : regionSpans[i] ){
+            dataBox |= QRect( span.x0, span.y, span.x1 - span.x0 + 1, 1 );
+        }
+    }
+    return dataBox;
+}
+
+
+double RegionStatsEngine::_getValue( const Accumulator& acc, Carta::Lib::StatInfo::StatType statType,
+        double fluxScale ){
+    double value = std::numeric_limits<double>::quiet_NaN();
+    if ( acc.count == 0 ){
+        return value;
+    }
+    double mean = acc.sum / acc.count;
+    switch ( statType ){
+    case Carta::Lib::StatInfo::StatType::FrameCount :
+        value = acc.count;
+        break;
+    case Carta::Lib::StatInfo::StatType::Sum :
+        value = acc.sum;
+        break;
+    case Carta::Lib::StatInfo::StatType::SumSq :
+        value = acc.sumSq;
+        break;
+    case Carta::Lib::StatInfo::StatType::Min :
+        value = acc.min;
+        break;
+    case Carta::Lib::StatInfo::StatType::Max :
+        value = acc.max;
+        break;
+    case Carta::Lib::StatInfo::StatType::Mean :
+        value = mean;
+        break;
+    case Carta::Lib::StatInfo::StatType::Sigma :
+        value = 0;
+        if ( acc.count > 1 ){
+            value = std::sqrt( std::max( acc.m2 / ( acc.count - 1 ), 0.0 ) );
+        }
+        break;
+    case Carta::Lib::StatInfo::StatType::RMS :
+        value = std::sqrt( acc.sumSq / acc.count );
+        break;
+    case Carta::Lib::StatInfo::StatType::FluxDensity :
+        value = acc.sum * fluxScale;
+        break;
+    default :
+        break;
+    }
+    return value;
+}
+
+
+bool RegionStatsEngine::_isInImage( const casacore::IPosition& imageShape, const std::vector<int>& slice ){
+    int dims = imageShape.nelements();
+    if ( dims != static_cast<int>( slice.size() ) ){
+        return false;
+    }
+    for ( int i = 0; i < dims; i++ ){
+        if ( slice[i] < 0 || slice[i] >= imageShape[i] ){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void RegionStatsEngine::_insertPosition( const casacore::IPosition& pos, const casacore::CoordinateSystem& cs,
+        Carta::Lib::StatInfo::StatType statType, Carta::Lib::StatInfo::StatType statTypeFormatted,
+        QList<Carta::Lib::StatInfo>& stats ){
+    Carta::Lib::StatInfo info( statType );
+    info.setValue( _vectorToString( pos ) );
+    stats.append( info );
+    try {
+        casacore::String formatted = casacore::CoordinateUtil::formatCoordinate( pos, cs );
+        Carta::Lib::StatInfo infoFormatted( statTypeFormatted );
+        infoFormatted.setValue( formatted.c_str() );
+        stats.append( infoFormatted );
+    }
+    catch( const casacore::AipsError& error ){
+        qDebug() << "Could not format position: " << error.getMesg().c_str();
+    }
+}
+
+
+void RegionStatsEngine::_insertScalar( double value, Carta::Lib::StatInfo::StatType statType,
+        QList<Carta::Lib::StatInfo>& stats ){
+    Carta::Lib::StatInfo info( statType );
+    info.setValue( QString::number( value ) );
+    info.setNumericValue( value );
+    stats.append( info );
+}
+
+
+bool RegionStatsEngine::_readPlane( casacore::ImageInterface<casacore::Float>* image,
+        const std::vector<int>& slice, int xAxis, int yAxis, const QRect& box,
+        const std::function<void(const float*, const bool*, int, int)>& use ){
+    int dims = slice.size();
+    casacore::IPosition start( dims );
+    casacore::IPosition count( dims, 1 );
+    for ( int i = 0; i < dims; i++ ){
+        start[i] = slice[i];
+    }
+    start[xAxis] = box.left();
+    start[yAxis] = box.top();
+    count[xAxis] = box.width();
+    count[yAxis] = box.height();
+    casacore::Array<casacore::Float> data;
+    casacore::Array<casacore::Bool> mask;
+    try {
+        image->getSlice( data, start, count, false );
+        if ( image->isMasked() ){
+            image->getMaskSlice( mask, start, count, false );
+        }
+    }
+    catch( const casacore::AipsError& error ){
+        qWarning() << "Could not read region pixels: " << error.getMesg().c_str();
+        return false;
+    }
+    int strideX = 1;
+    int strideY = 1;
+    for ( int i = 0; i < xAxis; i++ ){
+        strideX = strideX * count[i];
+    }
+    for ( int i = 0; i < yAxis; i++ ){
+        strideY = strideY * count[i];
+    }
+    bool deleteData = false;
+    bool deleteMask = false;
+    const casacore::Float* pixels = data.getStorage( deleteData );
+    const casacore::Bool* maskPixels = mask.nelements() > 0 ? mask.getStorage( deleteMask ) : nullptr;
+    use( pixels, maskPixels, strideX, strideY );
+    data.freeStorage( pixels, deleteData );
+    if ( maskPixels ){
+        mask.freeStorage( maskPixels, deleteMask );
+    }
+    return true;
+}
+
+
+QString RegionStatsEngine::_vectorToString( const casacore::IPosition& valArray ){
+    int elementCount = valArray.nelements();
+    QString val("[");
+    for ( int i = 0; i < elementCount; i++ ){
+        val = val + QString::number(valArray[i]);
+        if ( i < elementCount - 1 ){
+            val = val + ", ";
+        }
+    }
+    val = val + "]";
+    return val;
+}
+
+
+RegionStatsEngine::~RegionStatsEngine() {
+
+}
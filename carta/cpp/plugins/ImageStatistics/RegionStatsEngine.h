@@ -0,0 +1,211 @@
+/**
+ * Computes statistics for regions of an image plane directly from the pixel data.
+ */
+
+#pragma once
+
+#include <QList>
+#include <QRect>
+#include <QString>
+
+#include "CartaLib/Hooks/ProfileBatchHook.h"
+#include "CartaLib/Hooks/StatisticsBatchHook.h"
+#include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/Regions/RegionMask.h"
+#include "CartaLib/StatInfo.h"
+#include "casacore/images/Images/ImageInterface.h"
+
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class PlaneSums;
+
+class RegionStatsEngine {
+
+public:
+
+    /// A run of region pixels along the x axis of the plane, x0 to x1 inclusive.
+    typedef Carta::Lib::Regions::RegionMask::Run Span;
+
+    /// A sum with Neumaier's compensation for the rounding of each addition.
+    struct CompensatedSum {
+        inline void add( double value ){
+            double newTotal = total + value;
+            if ( std::fabs( total ) >= std::fabs( value ) ){
+                compensation += ( total - newTotal ) + value;
+            }
+            else {
+                compensation += ( value - newTotal ) + total;
+            }
+            total = newTotal;
+        }
+
+        inline double value() const {
+            return total + compensation;
+        }
+
+        double total = 0;
+        double compensation = 0;
+    };
+
+    /// Running statistics of a set of pixels; sums use compensated summation, and the
+    /// spread of the pixels is kept as deviations from their mean, which do not cancel.
+    class Accumulator {
+    public:
+        /**
+         * Add the unmasked, finite pixels of a span.
+         * @param values - the pixel value at the start of the span.
+         * @param mask - the pixel mask at the start of the span; nullptr if all pixels are good.
+         * @param stride - distance between neighbouring pixels of the span in the arrays.
+         * @param span - the location of the span in the image plane.
+         */
+        void add( const float* values, const bool* mask, int stride, const Span& span );
+
+        /**
+         * Add the sums of a set of pixels; their extremes are not changed.
+         * @param pixelCount - the number of pixels.
+         * @param pixelSum - the sum of the pixels.
+         * @param pixelSumSq - the sum of the squares of the pixels.
+         * @param pixelM2 - the sum of the squared deviations of the pixels from their mean.
+         */
+        void addSums( long long pixelCount, double pixelSum, double pixelSumSq, double pixelM2 );
+
+        /**
+         * Combine with the statistics of another set of pixels.
+         * @param other - statistics of pixels not yet included.
+         */
+        void merge( const Accumulator& other );
+
+        long long count = 0;
+        double sum = 0;
+        double sumSq = 0;
+        /// Sum of the squared deviations of the pixels from their mean.
+        double m2 = 0;
+        float min = 0;
+        float max = 0;
+        int minX = 0;
+        int minY = 0;
+        int maxX = 0;
+        int maxY = 0;
+
+    private:
+        CompensatedSum m_sum;
+        CompensatedSum m_sumSq;
+    };
+
+    /**
+     * Returns the statistics of the regions on the current plane of the image.
+     * @param image - a specified image.
+     * @param regions - the regions.
+     * @param slice - information about the frames that are selected on the image.
+     * @return - a list of statistics for each region; the list is empty if the region
+     *      does not cover any valid pixels.
+     */
+    static QList< QList<Carta::Lib::StatInfo> >
+    getStats( casacore::ImageInterface<casacore::Float>* image,
+            const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regions,
+            const std::vector<int>& slice );
+
+    /**
+     * Returns the statistics of many regions on the current plane of the image, a
+     * column for each statistic.  The plane is read once for all the regions.
+     * @param image - a specified image.
+     * @param regions - the regions.
+     * @param slice - information about the frames that are selected on the image.
+     * @return - the numeric statistics of the regions; NaN for regions that do not
+     *      cover any valid pixels.
+     */
+    static Carta::Lib::Hooks::StatisticsBatchHook::ResultType
+    getStatColumns( casacore::ImageInterface<casacore::Float>* image,
+            const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regions,
+            const std::vector<int>& slice );
+
+    /**
+     * Returns the profiles of many regions along the spectral axis of the image.
+     * Each plane is read once and the pixels of all the regions are added up from it.
+     * @param image - a specified image.
+     * @param regions - the regions.
+     * @param spectralAxis - the axis the profiles run along.
+     * @param slice - the frames of the axes other than the spatial and spectral axes.
+     * @param aggregateType - how the pixels of a region are combined in each plane;
+     *      the median is not supported.
+     * @return - a profile for each region; empty if they could not be computed.
+     */
+    static Carta::Lib::Hooks::ProfileBatchHook::ResultType
+    getProfiles( casacore::ImageInterface<casacore::Float>* image,
+            const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regions,
+            int spectralAxis, const std::vector<int>& slice,
+            Carta::Lib::ProfileInfo::AggregateType aggregateType );
+
+    /**
+     * Returns the pixels of a plane of the given size covered by the region; the
+     * rasterized region is cached by RegionMask.
+     * @param region - a region in pixel coordinates.
+     * @param width - the number of pixels along the x axis of the plane.
+     * @param height - the number of pixels along the y axis of the plane.
+     * @param spans - the pixels of the region, row by row (return value).
+     * @return - an identifier for the type of region.
+     */
+    static QString getSpans( const Carta::Lib::Regions::RegionBase* region,
+            int width, int height, std::vector<Span>& spans );
+
+private:
+    RegionStatsEngine();
+
+    static void _accumulate( const float* pixels, const bool* maskPixels,
+            int strideX, int strideY, const QRect& box,
+            const std::vector< std::vector<Span> >& regionSpans,
+            std::vector<Accumulator>& accumulators );
+
+    //Adds up the pixels of the regions on a plane.
+    static bool _accumulatePlane( casacore::ImageInterface<casacore::Float>* image,
+            const std::vector<int>& slice, int xAxis, int yAxis, const QRect& dataBox,
+            const std::vector< std::vector<Span> >& regionSpans, bool usePlaneSums,
+            std::vector<Accumulator>& accumulators );
+
+    static double _getBeamArea( const casacore::ImageInterface<casacore::Float>* image,
+            const casacore::CoordinateSystem& cs, const std::vector<int>& slice );
+
+    static bool _getDisplayAxes( const casacore::CoordinateSystem& cs, int* xAxis, int* yAxis );
+
+    //Returns the factor converting a sum of pixels to a flux density; NaN if the
+    //brightness unit has none.
+    static double _getFluxScale( const casacore::ImageInterface<casacore::Float>* image,
+            const casacore::CoordinateSystem& cs, const std::vector<int>& slice );
+
+    //Returns the solid angle of a pixel in steradians; 0 if there are no direction axes.
+    static double _getPixelArea( const casacore::CoordinateSystem& cs );
+
+    //Rasterizes the regions and returns the box holding all their pixels.
+    static QRect _getSpans( const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regions,
+            int width, int height, std::vector< std::vector<Span> >& regionSpans,
+            std::vector<QString>* typeStrs );
+
+    //Returns a numeric statistic of a region; NaN if it has no pixels.
+    static double _getValue( const Accumulator& acc, Carta::Lib::StatInfo::StatType statType,
+            double fluxScale );
+
+    static void _insertScalar( double value, Carta::Lib::StatInfo::StatType statType,
+            QList<Carta::Lib::StatInfo>& stats );
+    static void _insertPosition( const casacore::IPosition& pos, const casacore::CoordinateSystem& cs,
+            Carta::Lib::StatInfo::StatType statType, Carta::Lib::StatInfo::StatType statTypeFormatted,
+            QList<Carta::Lib::StatInfo>& stats );
+
+    static bool _isInImage( const casacore::IPosition& imageShape, const std::vector<int>& slice );
+
+    //Returns prefix sums of the plane when it is asked for repeatedly; nullptr otherwise.
+    static std::shared_ptr<const PlaneSums> _getPlaneSums(
+            casacore::ImageInterface<casacore::Float>* image, const std::vector<int>& slice,
+            int xAxis, int yAxis );
+
+    //Reads the pixels and mask of a box of the plane and passes them to the function.
+    static bool _readPlane( casacore::ImageInterface<casacore::Float>* image,
+            const std::vector<int>& slice, int xAxis, int yAxis, const QRect& box,
+            const std::function<void(const float*, const bool*, int, int)>& use );
+
+    static QString _vectorToString( const casacore::IPosition& valArray );
+
+    virtual ~RegionStatsEngine();
+};
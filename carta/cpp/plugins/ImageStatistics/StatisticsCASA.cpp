@@ -1,11 +1,13 @@
 #include "CartaLib/Hooks/Initialize.h"
 #include "CartaLib/Hooks/ImageStatisticsHook.h"
+#include "CartaLib/Hooks/ProfileBatchHook.h"
+#include "CartaLib/Hooks/StatisticsBatchHook.h"
 #include "CartaLib/IImage.h"
 #include "plugins/CasaImageLoader/CCImage.h"
 
 #include "StatisticsCASA.h"
 #include "StatisticsCASAImage.h"
-#include "StatisticsCASARegion.h"
+#include "RegionStatsEngine.h"
 
 #include <QDebug>
 
@@ -53,11 +55,7 @@ StatisticsCASA::handleHook( BaseHook & hookData ){
             std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> > regionInfos = hook.paramsPtr->m_regionInfos;
             //Get the vector of current plane information
             std::vector<int> slice = hook.paramsPtr->m_slice;
-            int regionCount = regionInfos.size();
-            for ( int i = 0; i < regionCount; i++ ){
-                QList<Carta::Lib::StatInfo> statResultRegion = StatisticsCASARegion::getStats( casaImage, regionInfos[i], slice );
-                statResults.append( statResultRegion );
-            }
+            statResults.append( RegionStatsEngine::getStats( casaImage, regionInfos, slice ) );
 
             imageResults.append( statResults );
 
@@ -66,6 +64,37 @@ StatisticsCASA::handleHook( BaseHook & hookData ){
 
         return true;
     }
+    else if ( hookData.is < Carta::Lib::Hooks::StatisticsBatchHook > () ) {
+        Carta::Lib::Hooks::StatisticsBatchHook & hook
+            = static_cast < Carta::Lib::Hooks::StatisticsBatchHook & > ( hookData );
+        casacore::ImageInterface<casacore::Float>* casaImage = nullptr;
+        if ( hook.paramsPtr-> m_dataSource ){
+            casaImage = cartaII2casaII_float( hook.paramsPtr-> m_dataSource );
+        }
+        if ( !casaImage ){
+            qWarning() << "Image statistics plugin: not an image created by casaimageloader...";
+            return false;
+        }
+        hook.result = RegionStatsEngine::getStatColumns( casaImage,
+                hook.paramsPtr-> m_regionInfos, hook.paramsPtr-> m_slice );
+        return true;
+    }
+    else if ( hookData.is < Carta::Lib::Hooks::ProfileBatchHook > () ) {
+        Carta::Lib::Hooks::ProfileBatchHook & hook
+            = static_cast < Carta::Lib::Hooks::ProfileBatchHook & > ( hookData );
+        casacore::ImageInterface<casacore::Float>* casaImage = nullptr;
+        if ( hook.paramsPtr-> m_dataSource ){
+            casaImage = cartaII2casaII_float( hook.paramsPtr-> m_dataSource );
+        }
+        if ( !casaImage ){
+            qWarning() << "Image statistics plugin: not an image created by casaimageloader...";
+            return false;
+        }
+        hook.result = RegionStatsEngine::getProfiles( casaImage, hook.paramsPtr-> m_regionInfos,
+                hook.paramsPtr-> m_spectralAxis, hook.paramsPtr-> m_slice,
+                hook.paramsPtr-> m_aggregateType );
+        return true;
+    }
     qWarning() << "Image statistics doesn't know how to handle this hook";
     return false;
 } // handleHook
@@ -75,7 +104,9 @@ StatisticsCASA::getInitialHookList()
 {
     return {
                Carta::Lib::Hooks::Initialize::staticId,
-               Carta::Lib::Hooks::ImageStatisticsHook::staticId
+               Carta::Lib::Hooks::ImageStatisticsHook::staticId,
+               Carta::Lib::Hooks::StatisticsBatchHook::staticId,
+               Carta::Lib::Hooks::ProfileBatchHook::staticId
     };
 }
 
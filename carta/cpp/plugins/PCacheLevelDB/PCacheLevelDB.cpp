@@ -4,6 +4,7 @@
 #include <QDir>
 #include <QJsonDocument>
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
 typedef Carta::Lib::Hooks::GetPersistentCache GetPersistentCacheHook;
 
@@ -83,6 +84,21 @@ public:
         // \todo we'll have to embed  priority into the value, e.g. first 8 bytes?
     } // setEntry
 
+    virtual void
+    setEntries( const std::vector < Entry > & entries ) override
+    {
+        if( ! p_db) return;
+        leveldb::WriteBatch batch;
+        for ( const Entry & entry : entries ) {
+            batch.Put( leveldb::Slice( entry.key.constData(), entry.key.size()),
+                       leveldb::Slice( entry.val.constData(), entry.val.size()));
+        }
+        auto status = p_db-> Write( p_writeOptions, & batch );
+        if ( ! status.ok() ) {
+            qWarning() << "batch insert failed:" << status.ToString().c_str();
+        }
+    } // setEntries
+
     static
     Carta::Lib::IPCache::SharedPtr
     getCacheSingleton( QString dirPath)
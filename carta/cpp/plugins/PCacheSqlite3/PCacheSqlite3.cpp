@@ -79,20 +79,44 @@ public:
 
         //Q_UNUSED( priority );
         QSqlQuery query( m_db );
-        //query.prepare( "INSERT OR REPLACE INTO db (key, val) VALUES ( :key, :val )" );
 
-        // add a new value "error" in the row
-        query.prepare( "INSERT INTO db (key, val, error) VALUES (:key, :val, :error)" );
+        // a row per "key" and "error"; storing the same pair again replaces its value
+        query.prepare( "INSERT OR REPLACE INTO db (key, val, error) VALUES (:key, :val, :error)" );
 
         query.bindValue( ":key", key );
         query.bindValue( ":val", val );
-        query.bindValue( ":error", error );
+        query.bindValue( ":error", _storedError( error ) );
 
         if ( ! query.exec() ) {
             qWarning() << "Insert query failed:" << query.lastError().text();
         }
     } // setEntry
 
+    virtual void
+    setEntries( const std::vector < Entry > & entries ) override
+    {
+        if ( ! m_db.isOpen() ) {
+            return;
+        }
+
+        // one transaction and one prepared statement for all rows, rather than
+        // an implicit transaction per row
+        bool transaction = m_db.transaction();
+        QSqlQuery query( m_db );
+        query.prepare( "INSERT OR REPLACE INTO db (key, val, error) VALUES (:key, :val, :error)" );
+        for ( const Entry & entry : entries ) {
+            query.bindValue( ":key", entry.key );
+            query.bindValue( ":val", entry.val );
+            query.bindValue( ":error", _storedError( entry.error ) );
+            if ( ! query.exec() ) {
+                qWarning() << "Insert query failed:" << query.lastError().text();
+            }
+        }
+        if ( transaction && ! m_db.commit() ) {
+            qWarning() << "Commit failed:" << m_db.lastError().text();
+        }
+    } // setEntries
+
     static
     Carta::Lib::IPCache::SharedPtr
     getCacheSingleton( QString dirPath)
@@ -138,6 +162,35 @@ private:
         if ( ! query.exec() ) {
             qCritical() << "Create table query failed:" << query.lastError().text();
         }
+
+        // databases written before rows were unique may hold the same "key" and
+        // "error" several times; keep the latest one, then make the pair unique
+        if ( query.exec( "SELECT name FROM sqlite_master WHERE type = 'index' AND name = 'db_key_error'" ) &&
+             ! query.next() ) {
+            bool transaction = m_db.transaction();
+            const char * uniqueQueries[] = {
+                "UPDATE db SET error = X'' WHERE error IS NULL",
+                "DELETE FROM db WHERE rowid NOT IN (SELECT MAX(rowid) FROM db GROUP BY key, error)",
+                "CREATE UNIQUE INDEX db_key_error ON db (key, error)"
+            };
+            for ( const char * uniqueQuery : uniqueQueries ) {
+                if ( ! query.exec( uniqueQuery ) ) {
+                    qCritical() << "Unique key query failed:" << query.lastError().text();
+                    break;
+                }
+            }
+            if ( transaction && ! m_db.commit() ) {
+                qCritical() << "Commit failed:" << m_db.lastError().text();
+            }
+        }
+    }
+
+    /// sqlite does not consider NULLs equal in a unique index, so a missing
+    /// "error" is stored as an empty blob
+    static QByteArray
+    _storedError( const QByteArray & error )
+    {
+        return error.isNull() ? QByteArray( "" ) : error;
     }
 
 private:
@@ -1,17 +1,13 @@
 #include "ProfileCASA.h"
 #include "plugins/CasaImageLoader/CCImage.h"
 #include "plugins/CasaImageLoader/CCMetaDataInterface.h"
+#include "plugins/CasaImageLoader/CCRegionMask.h"
 #include "CartaLib/Hooks/Initialize.h"
 #include "CartaLib/Hooks/ProfileHook.h"
 #include "CartaLib/ProfileInfo.h"
 #include "CartaLib/Regions/IRegion.h"
-#include "CartaLib/Regions/Ellipse.h"
-#include "CartaLib/Regions/Point.h"
-#include "CartaLib/Regions/Rectangle.h"
 #include "CartaLib/IImage.h"
 #include <coordinates/Coordinates/DirectionCoordinate.h>
-#include <images/Regions/WCEllipsoid.h>
-#include <images/Regions/RegionManager.h>
 #include <imageanalysis/ImageAnalysis/ImagePolarimetry.h>
 
 #include <iterator>
@@ -27,8 +23,7 @@ using namespace std;
 
 ProfileCASA::ProfileCASA(QObject *parent) :
     QObject(parent),
-    PIXEL_UNIT( "pix"),
-	RADIAN_UNIT( "rad"){
+    PIXEL_UNIT( "pix"){
 }
 
 
@@ -90,44 +85,6 @@ Carta::Lib::Hooks::ProfileResult ProfileCASA::_generateProfile( casacore::ImageI
     int stokesAxis = imagePtr->coordinates().polarizationAxisNumber();
     // qDebug() << stokesFrame << "\n" << stokesAxis << "\n" << imagePtr->ndim() << "\n" << imagePtr->shape().asStdVector();
 
-    casacore::Record regionRecord;
-    if ( regionInfo ){
-    	QString shape = regionInfo->typeName();
-    	if ( shape == "ellipse" || shape=="rectangle"){
-    		QRectF box = regionInfo->outlineBox();
-    		QPointF topLeft = box.topLeft();
-    		QPointF bottomRight = box.bottomRight();
-    		casacore::Vector<casacore::Double> x(2);
-    		casacore::Vector<casacore::Double> y(2);
-    		x[0] = topLeft.x();
-    		y[0] = topLeft.y();
-    		x[1] = bottomRight.x();
-    		y[1] = bottomRight.y();
-    		regionRecord = _getRegionRecord( shape, cSys, x, y );
-    	}
-    	else if ( shape == "Point"){
-    		casacore::Vector<casacore::Double> x(1);
-    		casacore::Vector<casacore::Double> y(1);
-    		QRectF box = regionInfo->outlineBox();
-    		x[0] = box.center().x();
-    		y[0] = box.center().y();
-    		regionRecord = _getRegionRecord( shape, cSys, x, y );
-    	}
-    	else {
-			QPolygonF regionCorners = regionInfo->outlineBox();
-			int cornerCount = regionCorners.size();
-			casacore::Vector<casacore::Double> x(cornerCount);
-			casacore::Vector<casacore::Double> y(cornerCount);
-			for ( int i = 0; i < cornerCount; i++ ){
-				QPointF corner = regionCorners.value( i );
-				x[i] = corner.x();
-				y[i] = corner.y();
-			}
-			regionRecord = _getRegionRecord( shape, cSys, x, y);
-    	}
-
-
-    }
     QString spectralType = profileInfo.getSpectralType();
     QString spectralUnit = profileInfo.getSpectralUnit();
     if ( spectralType == "Channel"){
@@ -160,6 +117,20 @@ Carta::Lib::Hooks::ProfileResult ProfileCASA::_generateProfile( casacore::ImageI
             = make_shared<casacore::SubImage<casacore::Float> > (*imagePtr->cloneII(), slicer, casacore::AxesSpecifier() );
         // qWarning() << image->shape().asStdVector();
 
+        //The pixels of the region are the ones the region statistics use.
+        casacore::Record regionRecord;
+        if ( regionInfo ){
+            casacore::ImageRegion* imageRegion = CCRegionMask::makeImageRegion(
+                    image->shape(), image->coordinates(), regionInfo.get() );
+            if ( imageRegion ){
+                regionRecord = imageRegion->toRecord( "" );
+                delete imageRegion;
+            }
+            else {
+                qWarning() << "Could not generate region profile";
+            }
+        }
+
         casa::PixelValueManipulator<casacore::Float> pvm(image, &regionRecord, "");
         casa::ImageCollapserData::AggregateType funct = _getCombineMethod( profileInfo );
         casacore::MFrequency::Types freqType = _determineRefFrame( image );
@@ -221,69 +192,6 @@ casa::ImageCollapserData::AggregateType ProfileCASA::_getCombineMethod( Carta::L
 }
 
 
-casacore::ImageRegion* ProfileCASA::_getEllipsoid(const casacore::CoordinateSystem& cSys,
-        const casacore::Vector<casacore::Double>& x, const casacore::Vector<casacore::Double>& y) const {
-    casacore::Vector<casacore::Quantity> center(2);
-    casacore::Vector<casacore::Quantity> radius(2);
-    casacore::ImageRegion* imageRegion = NULL;
-    if ( x.size() == 2 && y.size() == 2 ){
-    	bool successful0 = false;
-    	casacore::Vector<casacore::Double> world0 = _toWorld( cSys, x[0], y[0], &successful0 );
-    	bool successful1 = false;
-    	casacore::Vector<casacore::Double> world1 = _toWorld( cSys, x[1], y[1], &successful1 );
-    	if ( successful0 && successful1 ){
-			const casacore::String radUnits( RADIAN_UNIT.toStdString().c_str());
-			center[0] = casacore::Quantity(  (world0[0]+world1[0])/2, radUnits );
-			center[1] = casacore::Quantity( (world0[1]+world1[1])/2, radUnits );
-			casacore::MDirection::Types type = casacore::MDirection::N_Types;
-			int directionIndex = cSys.findCoordinate( casacore::Coordinate::DIRECTION );
-			if ( directionIndex >= 0 ){
-				casacore::uInt dirIndex = static_cast<casacore::uInt>(directionIndex);
-				type = cSys.directionCoordinate(dirIndex).directionType(true);
-
-				casacore::Vector<casacore::Double> qCenter(2);
-				qCenter[0] = center[0].getValue();
-				qCenter[1] = center[1].getValue();
-				const casacore::String angleUnits( "rad");
-				casacore::MDirection mdcenter( casacore::Quantum<casacore::Vector<casacore::Double> >(qCenter,angleUnits), type );
-
-				casacore::Vector<casacore::Double> blc_pix_x(2);
-				blc_pix_x[0] = world0[0];
-				blc_pix_x[1] = center[1].getValue();
-				casacore::MDirection mdblc_x( casacore::Quantum<casacore::Vector<casacore::Double> >(blc_pix_x,angleUnits),type );
-
-				casacore::Vector<casacore::Double> blc_pix_y(2);
-				blc_pix_y[0] = center[0].getValue();
-				blc_pix_y[1] = world0[1];
-				casacore::MDirection mdblc_y( casacore::Quantum<casacore::Vector<casacore::Double> >(blc_pix_y,angleUnits),type );
-
-				double xdistance = mdcenter.getValue( ).separation(mdblc_x.getValue( ));
-				double ydistance = mdcenter.getValue( ).separation(mdblc_y.getValue( ));
-				const float ERR = 0;
-				if ( xdistance > ERR && ydistance > ERR ){
-					radius[0] = casacore::Quantity(xdistance, radUnits );
-					radius[1] = casacore::Quantity(ydistance, radUnits );
-
-					casacore::Vector<casacore::Int> pixax(2);
-					casacore::Vector<casacore::Int> dirPixelAxis = cSys.pixelAxes(directionIndex);
-					pixax(0) = dirPixelAxis[0];
-					pixax(1) = dirPixelAxis[1];
-					casacore::WCEllipsoid ellipsoid( center, radius, casacore::IPosition(pixax), cSys);
-					imageRegion = new casacore::ImageRegion( ellipsoid );
-				}
-			}
-        }
-    	else {
-    		qDebug() << "Could not convert pixels to world coordinates";
-    	}
-    }
-    else {
-        qDebug() << "Invalid size (2) for an ellipse: "<<x.size()<<" and "<<y.size();
-    }
-    return imageRegion;
-}
-
-
 std::vector<HookId> ProfileCASA::getInitialHookList(){
     return {
         Carta::Lib::Hooks::Initialize::staticId,
@@ -292,113 +200,6 @@ std::vector<HookId> ProfileCASA::getInitialHookList(){
 }
 
 
-casacore::ImageRegion* ProfileCASA::_getPolygon(const casacore::CoordinateSystem& cSys,
-        const casacore::Vector<casacore::Double>& x, const casacore::Vector<casacore::Double>& y) const {
-    casacore::ImageRegion* polygon = NULL;
-    const casacore::String pixUnits( "pixel" );
-    casacore::RegionManager regMan;
-    int n = x.size();
-    casacore::Vector<casacore::Quantity> xvertex(n);
-    casacore::Vector<casacore::Quantity> yvertex(n);
-    for (casacore::Int k = 0; k < n; ++k) {
-        xvertex[k] = casacore::Quantity(x[k], pixUnits );
-        yvertex[k] = casacore::Quantity(y[k], pixUnits );
-    }
-    int directionIndex = cSys.findCoordinate( casacore::Coordinate::DIRECTION );
-    if ( directionIndex >= 0 ){
-        casacore::Vector<casacore::Int> dirPixelAxis = cSys.pixelAxes(directionIndex);
-        casacore::Vector<casacore::Int> pixax(2);
-        pixax(0) = dirPixelAxis[0];
-        pixax(1) = dirPixelAxis[1];
-        polygon = regMan.wpolygon(xvertex, yvertex, pixax, cSys, "abs");
-    }
-    return polygon;
-}
-
-
-casacore::Record ProfileCASA::_getRegionRecord( const QString& shape, const casacore::CoordinateSystem& cSys,
-        const casacore::Vector<casacore::Double>& x, const casacore::Vector<casacore::Double>& y) const {
-	const casacore::String radUnits( RADIAN_UNIT.toStdString().c_str());
-    const casacore::String absStr( "abs");
-    casacore::Record regionRecord;
-    casacore::Int directionIndex = cSys.findCoordinate(casacore::Coordinate::DIRECTION);
-    if ( directionIndex >= 0 ){
-        casacore::Vector<casacore::Int> dirPixelAxis = cSys.pixelAxes(directionIndex);
-        casacore::RegionManager regMan;
-        if ( shape == Carta::Lib::Regions::Rectangle::TypeName ||
-        		shape == Carta::Lib::Regions::Point::TypeName ){
-            int ptCount = x.size();
-            if ( ptCount == 2 ){
-                casacore::Vector<casacore::Quantity> blc(2);
-                casacore::Vector<casacore::Quantity> trc(2);
-                bool successful0 = false;
-                casacore::Vector<casacore::Double> w0 = _toWorld( cSys, x[0], y[0], &successful0 );
-                bool successful1 = false;
-                casacore::Vector<casacore::Double> w1 = _toWorld( cSys, x[1], y[1], &successful1 );
-                if ( successful0 && successful1 ){
-					blc(0) = casacore::Quantity(w0[0], radUnits);
-					blc(1) = casacore::Quantity(w0[1], radUnits);
-					trc(0) = casacore::Quantity(w1[0], radUnits);
-					trc(1) = casacore::Quantity(w1[1], radUnits);
-					casacore::Vector<casacore::Int> pixax(2);
-					pixax(0) = dirPixelAxis[0];
-					pixax(1) = dirPixelAxis[1];
-
-					casacore::Record* imagregRecord = regMan.wbox(blc, trc, pixax, cSys, absStr, radUnits);
-					regionRecord = *imagregRecord;
-					delete imagregRecord;
-                }
-                else {
-                	qWarning() << "Could not generate region profile";
-                }
-            }
-            else if ( ptCount == 1 ){
-                //Try a rectangle with blc=trc;
-                casacore::Vector<casacore::Quantity> blc(2);
-                casacore::Vector<casacore::Quantity> trc(2);
-                bool successful0 = false;
-                casacore::Vector<casacore::Double> w0 = _toWorld( cSys, x[0], y[0], &successful0 );
-                if ( successful0 ){
-					blc(0) = casacore::Quantity(w0[0], radUnits);
-					blc(1) = casacore::Quantity(w0[1], radUnits);
-					trc(0) = casacore::Quantity(w0[0], radUnits);
-					trc(1) = casacore::Quantity(w0[1], radUnits);
-					casacore::Vector<casacore::Int> pixax(2);
-					pixax(0) = dirPixelAxis[0];
-					pixax(1) = dirPixelAxis[1];
-
-					casacore::Record* imagregRecord = regMan.wbox(blc, trc, pixax, cSys, absStr, radUnits);
-					regionRecord=*imagregRecord;
-					delete imagregRecord;
-                }
-            }
-            else {
-            	qWarning()<<"Unrecognized point count "<<ptCount;
-            }
-        }
-        else if ( shape == Carta::Lib::Regions::Polygon::TypeName ){
-        	casacore::ImageRegion* polygon = _getPolygon( cSys, x, y );
-        	if ( polygon != NULL ){
-        		regionRecord = polygon->toRecord(casacore::String(""));
-        		delete polygon;
-        	}
-
-        }
-        else if ( shape == Carta::Lib::Regions::Ellipse::TypeName ){
-        	casacore::ImageRegion* ellipsoid = _getEllipsoid( cSys, x, y );
-            if ( ellipsoid != NULL ){
-                regionRecord = ellipsoid->toRecord("");
-                delete ellipsoid;
-            }
-        }
-        else {
-        	qDebug() << "getRegion record shape not handled: "<<shape;
-        }
-    }
-    return regionRecord;
-}
-
-
 bool ProfileCASA::handleHook(BaseHook & hookData){
     //qDebug() << "ProfileCASA plugin is handling hook #" << hookData.hookId();
     if( hookData.is<Carta::Lib::Hooks::Initialize>()) {
@@ -429,29 +230,6 @@ bool ProfileCASA::handleHook(BaseHook & hookData){
     return false;
 }
 
-casacore::Vector<casacore::Double> ProfileCASA::_toWorld( const casacore::CoordinateSystem& cSys,
-		double x, double y, bool* successful ) const {
-	int pixelCount = cSys.nPixelAxes();
-	casacore::Vector<casacore::Double> pixelPt( pixelCount, 0 );
-	casacore::Vector<casacore::Double> worldPt;
-	if ( pixelCount >= 2 ){
-		pixelPt[0] = x;
-		pixelPt[1] = y;
-		try {
-			worldPt = cSys.toWorld( pixelPt );
-			*successful = true;
-		}
-		catch( const casacore::AipsError& error ){
-			qDebug() << error.getMesg().c_str()<<" pixel=("<<x<<","<<y<<")";
-			*successful = false;
-		}
-	}
-	else {
-		*successful = false;
-	}
-	return worldPt;
-}
-
 ProfileCASA::~ProfileCASA(){
 
 }
@@ -41,15 +41,5 @@ private:
     Carta::Lib::Hooks::ProfileResult _generateProfile( casacore::ImageInterface < casacore::Float > * imagePtr,
             std::shared_ptr<Carta::Lib::Regions::RegionBase> regionInfo, Carta::Lib::ProfileInfo profileInfo ) const;
     casa::ImageCollapserData::AggregateType _getCombineMethod( Carta::Lib::ProfileInfo profileInfo ) const;
-    casacore::ImageRegion* _getEllipsoid(const casacore::CoordinateSystem& cSys,
-            const casacore::Vector<casacore::Double>& x, const casacore::Vector<casacore::Double>& y) const;
-    casacore::ImageRegion* _getPolygon(const casacore::CoordinateSystem& cSys,
-            const casacore::Vector<casacore::Double>& x, const casacore::Vector<casacore::Double>& y) const;
-    casacore::Record _getRegionRecord( const QString& shape, const casacore::CoordinateSystem& cSys,
-            const casacore::Vector<casacore::Double>& x, const casacore::Vector<casacore::Double>& y) const;
-
-    casacore::Vector<casacore::Double> _toWorld( const casacore::CoordinateSystem& cSys,
-    		double x, double y, bool* successful ) const;
     const QString PIXEL_UNIT;
-    const QString RADIAN_UNIT;
 };
@@ -78,13 +78,21 @@ RegionCASA::_getPixelVertices( const casa::AnnotationBase::Direction& corners,
     casacore::String yUnit = csys.worldAxisUnits()[dirAxes[1]];
     int cornerCount = corners.size();
 
-    std::vector<QPointF> pixelVertices( cornerCount );
+    //Convert all the vertices in one call, one column per vertex.
+    int worldCount = world.size();
+    casacore::Matrix<casacore::Double> worlds( worldCount, cornerCount );
     for (int i=0; i<cornerCount; i++) {
         world[dirAxes[0]] = xx[i].getValue(xUnit);
         world[dirAxes[1]] = xy[i].getValue(yUnit);
-        casacore::Vector<casacore::Double> pixel;
-        csys.toPixel(pixel, world);
-        pixelVertices[i]= QPointF( pixel[dirAxes[0]], pixel[dirAxes[1]] );
+        worlds.column( i ) = world;
+    }
+    casacore::Matrix<casacore::Double> pixels;
+    casacore::Vector<casacore::Bool> failures;
+    csys.toPixelMany( pixels, worlds, failures );
+
+    std::vector<QPointF> pixelVertices( cornerCount );
+    for (int i=0; i<cornerCount; i++) {
+        pixelVertices[i]= QPointF( pixels( dirAxes[0], i ), pixels( dirAxes[1], i ) );
     }
     return pixelVertices;
 }
@@ -1,6 +1,7 @@
 #include "RegionDs9.h"
 #include "ContextDs9.h"
 #include "ParserDs9.h"
+#include "StreamParserDs9.h"
 #include "plugins/CasaImageLoader/CCImage.h"
 #include "CartaLib/Hooks/Initialize.h"
 #include "CartaLib/Hooks/LoadRegion.h"
@@ -25,11 +26,20 @@ bool RegionDs9::handleHook(BaseHook & hookData){
         = static_cast<Carta::Lib::Hooks::LoadRegion &>( hookData);
         QString fileName = hook.paramsPtr->fileName;
         if ( fileName.length() > 0 ){
-            ContextDs9 context;
-            ParserDs9 parser;
-            bool result = parser.parse_file( context, fileName.toStdString());
             std::shared_ptr<Carta::Lib::Image::ImageInterface> imagePtr = hook.paramsPtr->image;
-            hook.result = context.getRegions();
+            //The streaming parser handles the shapes of large files in one pass; the
+            //grammar is only needed for files using syntax it does not handle.
+            StreamParserDs9 streamParser;
+            bool result = streamParser.parseFile( fileName, imagePtr );
+            if ( result ){
+                hook.result = streamParser.getRegions();
+            }
+            else {
+                ContextDs9 context;
+                ParserDs9 parser;
+                result = parser.parse_file( context, fileName.toStdString());
+                hook.result = context.getRegions();
+            }
             qDebug() << "Ds9 read region file result="<<result;;
             hookHandled = true;
         }
@@ -14,12 +14,14 @@ BISONSOURCES = ds9parse.y
 SOURCES += \
     RegionDs9.cpp \
     ParserDs9.cpp \
-    ContextDs9.cpp
+    ContextDs9.cpp \
+    StreamParserDs9.cpp
 
 HEADERS += \
     RegionDs9.h \
     ParserDs9.h \
     ContextDs9.h \
+    StreamParserDs9.h \
     ds9FlexLexer.h \
     ds9lex.h
 
@@ -0,0 +1,674 @@
+#include "StreamParserDs9.h"
+#include "plugins/CasaImageLoader/CCImage.h"
+#include "plugins/CasaImageLoader/CCMetaDataInterface.h"
+#include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/Regions/Ellipse.h"
+#include "CartaLib/Regions/Point.h"
+#include "CartaLib/Regions/Rectangle.h"
+#include "CartaLib/IImage.h"
+#include "casacore/casa/Quanta/Quantum.h"
+#include "casacore/coordinates/Coordinates/CoordinateSystem.h"
+#include "casacore/coordinates/Coordinates/DirectionCoordinate.h"
+#include "casacore/measures/Measures/MCDirection.h"
+#include "casacore/measures/Measures/MDirection.h"
+
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+#include <QPolygonF>
+#include <QtCore/qmath.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+
+namespace {
+
+//Returns whether the character separates the parts of a command.
+inline bool isSpace( char c ){
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool isNameChar( char c ){
+    return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) ||
+            ( c >= '0' && c <= '9' ) || c == '_';
+}
+
+//Returns whether the frame gives longitudes in hours.
+inline bool isEquatorial( int frame ){
+    return frame == casacore::MDirection::B1950 || frame == casacore::MDirection::J2000 ||
+            frame == casacore::MDirection::ICRS;
+}
+
+//Returns the frame of a ds9 sky frame keyword or -1 if it is not one.
+int getSkyFrame( const QByteArray& name ){
+    if ( name == "fk4" || name == "b1950" ){
+        return casacore::MDirection::B1950;
+    }
+    if ( name == "fk5" || name == "j2000" ){
+        return casacore::MDirection::J2000;
+    }
+    if ( name == "icrs" ){
+        return casacore::MDirection::ICRS;
+    }
+    if ( name == "galactic" ){
+        return casacore::MDirection::GALACTIC;
+    }
+    if ( name == "ecliptic" ){
+        return casacore::MDirection::ECLIPTIC;
+    }
+    if ( name == "supergalactic" ){
+        return casacore::MDirection::SUPERGAL;
+    }
+    return -1;
+}
+
+//Shapes the regions do not represent; the context of the grammar ignores them too.
+const char* IGNORED_SHAPES[] = { "annulus", "panda", "epanda", "bpanda", "line", "vector",
+        "text", "ruler", "compass", "projection", "segment", "composite" };
+}
+
+
+StreamParserDs9::StreamParserDs9( ) :
+    m_imageFrame( -1 ),
+    m_pixelScale( 0 ),
+    m_skySystem( false ),
+    m_skyHours( false ),
+    m_skyFrame( -1 ){
+}
+
+
+bool StreamParserDs9::parseFile( const QString& fileName,
+        std::shared_ptr<Carta::Lib::Image::ImageInterface> image ){
+    m_shapes.clear();
+    m_points.clear();
+    m_skyPoints.clear();
+    m_skyFrames.clear();
+    m_regions.clear();
+    _setImage( image );
+
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ){
+        qWarning() << "Could not open ds9 region file "<<fileName;
+        return false;
+    }
+    bool parsed = false;
+    qint64 size = file.size();
+    if ( size == 0 ){
+        parsed = true;
+    }
+    else {
+        //Reading the whole file is the fallback for files that cannot be mapped.
+        const char* data = reinterpret_cast<const char*>( file.map( 0, size ) );
+        QByteArray contents;
+        if ( !data ){
+            contents = file.readAll();
+            data = contents.constData();
+            size = contents.size();
+        }
+        parsed = _parseBuffer( data, data + size );
+    }
+    file.close();
+
+    if ( parsed ){
+        parsed = _convertPoints();
+    }
+    if ( parsed ){
+        _makeRegions();
+    }
+    m_shapes.clear();
+    m_points.clear();
+    m_skyPoints.clear();
+    m_skyFrames.clear();
+    return parsed;
+}
+
+
+bool StreamParserDs9::_parseBuffer( const char* begin, const char* end ){
+    const char* pos = begin;
+    while ( pos < end ){
+        //A command ends at a new line, a ';' or a '#' that starts a comment, unless
+        //these are between the parentheses of a shape or in a quoted property.
+        const char* start = pos;
+        char closing = 0;
+        int parens = 0;
+        for ( ; pos < end && *pos != '\n'; pos++ ){
+            char c = *pos;
+            if ( closing ){
+                if ( c == closing ){
+                    closing = 0;
+                }
+            }
+            else if ( parens > 0 ){
+                if ( c == '(' ){
+                    parens++;
+                }
+                else if ( c == ')' ){
+                    parens--;
+                }
+            }
+            else if ( c == '(' ){
+                parens++;
+            }
+            else if ( c == '{' ){
+                closing = '}';
+            }
+            else if ( c == '"' || c == '\'' ){
+                closing = c;
+            }
+            else if ( c == ';' || c == '#' ){
+                break;
+            }
+        }
+        if ( !_parseCommand( start, pos ) ){
+            return false;
+        }
+        if ( pos < end && *pos == '#' ){
+            while ( pos < end && *pos != '\n' ){
+                pos++;
+            }
+        }
+        pos++;
+    }
+    return true;
+}
+
+
+bool StreamParserDs9::_parseCommand( const char* begin, const char* end ){
+    while ( begin < end && isSpace( *begin ) ){
+        begin++;
+    }
+    while ( end > begin && isSpace( *( end - 1 ) ) ){
+        end--;
+    }
+    if ( begin == end ){
+        return true;
+    }
+
+    //Regions do not distinguish included shapes from excluded ones.
+    if ( *begin == '+' || *begin == '-' ){
+        begin++;
+    }
+    const char* pos = begin;
+    while ( pos < end && isNameChar( *pos ) ){
+        pos++;
+    }
+    QByteArray name = QByteArray( begin, pos - begin ).toLower();
+    if ( name.isEmpty() ){
+        return false;
+    }
+
+    //Coordinate systems and global properties.
+    if ( name == "global" ){
+        return true;
+    }
+    if ( name == "image" || name == "physical" ){
+        m_skySystem = false;
+        return true;
+    }
+    int skyFrame = getSkyFrame( name );
+    if ( skyFrame < 0 && name.startsWith( "wcs" ) && name.length() <= 4 ){
+        skyFrame = m_imageFrame;
+        if ( skyFrame < 0 ){
+            return false;
+        }
+    }
+    if ( skyFrame >= 0 ){
+        m_skySystem = true;
+        m_skyFrame = skyFrame;
+        m_skyHours = isEquatorial( skyFrame );
+        return true;
+    }
+
+    //The name of the shape, which for points may be the kind of point followed by
+    //'point'.
+    ShapeType type;
+    while ( pos < end && isSpace( *pos ) ){
+        pos++;
+    }
+    if ( name == "point" || ( end - pos >= 5 &&
+            QByteArray::fromRawData( pos, 5 ).toLower() == "point" &&
+            ( end - pos == 5 || !isNameChar( pos[5] ) ) ) ){
+        if ( name != "point" ){
+            pos += 5;
+        }
+        type = ShapeType::POINT;
+    }
+    else if ( name == "circle" || name == "circle3d" ){
+        type = ShapeType::CIRCLE;
+    }
+    else if ( name == "ellipse" ){
+        type = ShapeType::ELLIPSE;
+    }
+    else if ( name == "box" || name == "rotbox" ){
+        type = ShapeType::BOX;
+    }
+    else if ( name == "polygon" ){
+        type = ShapeType::POLYGON;
+    }
+    else {
+        for ( const char* ignored : IGNORED_SHAPES ){
+            if ( name == ignored ){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //Arguments are either in parentheses or follow the name.
+    while ( pos < end && isSpace( *pos ) ){
+        pos++;
+    }
+    const char* argEnd = end;
+    if ( pos < end && *pos == '(' ){
+        pos++;
+        argEnd = pos;
+        while ( argEnd < end && *argEnd != ')' ){
+            argEnd++;
+        }
+        if ( argEnd == end ){
+            return false;
+        }
+    }
+    std::vector<Token> args;
+    _split( pos, argEnd, args );
+    return _parseShape( type, args );
+}
+
+
+bool StreamParserDs9::_parseShape( ShapeType type, const std::vector<Token>& args ){
+    int argCount = args.size();
+    Shape shape;
+    shape.type = type;
+    shape.firstPoint = m_points.size() / 2;
+    shape.pointCount = 1;
+    shape.size[0] = 0;
+    shape.size[1] = 0;
+    shape.angle = 0;
+    bool valid = true;
+    switch ( type ){
+    case ShapeType::POINT :
+        if ( argCount != 2 ){
+            return false;
+        }
+        break;
+    case ShapeType::CIRCLE :
+        if ( argCount != 3 ){
+            return false;
+        }
+        valid = _parseLength( args[2], &shape.size[0] );
+        shape.size[1] = shape.size[0];
+        break;
+    case ShapeType::ELLIPSE :
+    case ShapeType::BOX :
+        //Annuli have more sizes; they are not regions.
+        if ( argCount > 5 ){
+            return true;
+        }
+        if ( argCount < 4 ){
+            return false;
+        }
+        valid = _parseLength( args[2], &shape.size[0] ) && _parseLength( args[3], &shape.size[1] );
+        if ( valid && argCount == 5 ){
+            valid = _parseAngle( args[4], &shape.angle );
+        }
+        break;
+    case ShapeType::POLYGON :
+        if ( argCount < 6 || argCount % 2 != 0 ){
+            return false;
+        }
+        shape.pointCount = argCount / 2;
+        break;
+    }
+    for ( int i = 0; i < shape.pointCount && valid; i++ ){
+        valid = _parsePoint( args[2 * i], args[2 * i + 1] );
+    }
+    if ( valid ){
+        m_shapes.push_back( shape );
+    }
+    return valid;
+}
+
+
+bool StreamParserDs9::_parsePoint( const Token& x, const Token& y ){
+    double xValue = 0;
+    double yValue = 0;
+    char xUnit = 0;
+    char yUnit = 0;
+    bool xNumber = _parseNumber( x, &xValue, &xUnit );
+    bool yNumber = _parseNumber( y, &yValue, &yUnit );
+
+    //Pixels of ds9 are counted from 1.
+    bool pixelUnits = xUnit == 'i' || xUnit == 'p' || yUnit == 'i' || yUnit == 'p';
+    if ( !m_skySystem || pixelUnits ){
+        if ( !xNumber || !yNumber ){
+            return false;
+        }
+        m_points.push_back( xValue - 1 );
+        m_points.push_back( yValue - 1 );
+        return true;
+    }
+
+    //Sky coordinates are kept in radians until all of them are converted.
+    if ( xNumber ){
+        if ( xUnit == 'r' ){
+            xValue = qRadiansToDegrees( xValue );
+        }
+        else if ( xUnit != 0 && xUnit != 'd' ){
+            return false;
+        }
+    }
+    else {
+        //Colons mean hours only in frames that give longitudes in hours.
+        bool hours = std::find( x.begin, x.end, 'h' ) != x.end ||
+                ( m_skyHours && std::find( x.begin, x.end, ':' ) != x.end );
+        if ( !_parseSexagesimal( x, hours, &xValue ) ){
+            return false;
+        }
+    }
+    if ( yNumber ){
+        if ( yUnit == 'r' ){
+            yValue = qRadiansToDegrees( yValue );
+        }
+        else if ( yUnit != 0 && yUnit != 'd' ){
+            return false;
+        }
+    }
+    else if ( !_parseSexagesimal( y, false, &yValue ) ){
+        return false;
+    }
+    m_skyPoints.push_back( m_points.size() / 2 );
+    m_skyFrames.push_back( m_skyFrame );
+    m_points.push_back( qDegreesToRadians( xValue ) );
+    m_points.push_back( qDegreesToRadians( yValue ) );
+    return true;
+}
+
+
+bool StreamParserDs9::_parseLength( const Token& token, double* pixels ) const {
+    double value = 0;
+    char unit = 0;
+    if ( !_parseNumber( token, &value, &unit ) ){
+        return false;
+    }
+    if ( unit == 'i' || unit == 'p' || ( unit == 0 && !m_skySystem ) ){
+        *pixels = value;
+        return true;
+    }
+    if ( m_pixelScale <= 0 ){
+        return false;
+    }
+    double radians = 0;
+    switch ( unit ){
+    case '"' :
+        radians = qDegreesToRadians( value / 3600 );
+        break;
+    case '\'' :
+        radians = qDegreesToRadians( value / 60 );
+        break;
+    case 'r' :
+        radians = value;
+        break;
+    case 0 :
+    case 'd' :
+        radians = qDegreesToRadians( value );
+        break;
+    default :
+        return false;
+    }
+    *pixels = radians / m_pixelScale;
+    return true;
+}
+
+
+bool StreamParserDs9::_parseAngle( const Token& token, double* degrees ) const {
+    double value = 0;
+    char unit = 0;
+    if ( !_parseNumber( token, &value, &unit ) ){
+        return false;
+    }
+    if ( unit == 'r' ){
+        value = qRadiansToDegrees( value );
+    }
+    else if ( unit != 0 && unit != 'd' ){
+        return false;
+    }
+    *degrees = value;
+    return true;
+}
+
+
+bool StreamParserDs9::_parseNumber( const Token& token, double* value, char* unit ){
+    const char* end = token.end;
+    *unit = 0;
+    if ( end > token.begin ){
+        char last = *( end - 1 );
+        if ( last == '"' || last == '\'' || last == 'd' || last == 'r' ||
+                last == 'i' || last == 'p' ){
+            *unit = last;
+            end--;
+        }
+    }
+    if ( end == token.begin ){
+        return false;
+    }
+    bool valid = false;
+    *value = QByteArray::fromRawData( token.begin, end - token.begin ).toDouble( &valid );
+    return valid;
+}
+
+
+bool StreamParserDs9::_parseSexagesimal( const Token& token, bool hours, double* degrees ){
+    //Sexagesimal values are written 12:34:56.7, 12h34m56.7s or -12d34m56.7s.
+    const char* pos = token.begin;
+    double sign = 1;
+    if ( pos < token.end && ( *pos == '-' || *pos == '+' ) ){
+        sign = *pos == '-' ? -1 : 1;
+        pos++;
+    }
+    double parts[3] = { 0, 0, 0 };
+    int partCount = 0;
+    while ( pos < token.end && partCount < 3 ){
+        const char* partEnd = pos;
+        while ( partEnd < token.end && ( ( *partEnd >= '0' && *partEnd <= '9' ) || *partEnd == '.' ) ){
+            partEnd++;
+        }
+        bool valid = false;
+        parts[partCount] = QByteArray::fromRawData( pos, partEnd - pos ).toDouble( &valid );
+        if ( !valid ){
+            return false;
+        }
+        partCount++;
+        if ( partEnd < token.end && *partEnd != ':' && *partEnd != 'h' && *partEnd != 'd' &&
+                *partEnd != 'm' && *partEnd != 's' ){
+            return false;
+        }
+        pos = partEnd + 1;
+    }
+    if ( partCount < 2 || pos < token.end ){
+        return false;
+    }
+    double value = sign * ( parts[0] + parts[1] / 60 + parts[2] / 3600 );
+    *degrees = hours ? value * 15 : value;
+    return true;
+}
+
+
+void StreamParserDs9::_split( const char* begin, const char* end, std::vector<Token>& args ){
+    const char* pos = begin;
+    while ( pos < end ){
+        while ( pos < end && ( isSpace( *pos ) || *pos == ',' ) ){
+            pos++;
+        }
+        const char* start = pos;
+        while ( pos < end && !isSpace( *pos ) && *pos != ',' ){
+            pos++;
+        }
+        if ( pos > start ){
+            args.push_back( { start, pos } );
+        }
+    }
+}
+
+
+void StreamParserDs9::_setImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image ){
+    m_cs.reset();
+    m_imageFrame = -1;
+    m_pixelScale = 0;
+    CCImageBase* base = dynamic_cast<CCImageBase*>( image.get() );
+    if ( !base ){
+        return;
+    }
+    Carta::Lib::Image::MetaDataInterface::SharedPtr metaPtr = base->metaData();
+    CCMetaDataInterface* metaData = dynamic_cast<CCMetaDataInterface*>( metaPtr.get() );
+    if ( !metaData ){
+        return;
+    }
+    std::shared_ptr<casacore::CoordinateSystem> cs = metaData->getCoordinateSystem();
+    casacore::Int directionIndex = cs ? cs->findCoordinate( casacore::Coordinate::DIRECTION ) : -1;
+    if ( directionIndex < 0 ){
+        return;
+    }
+    const casacore::DirectionCoordinate& dCoord = cs->directionCoordinate( directionIndex );
+    casacore::Vector<casacore::Double> increments = dCoord.increment();
+    casacore::Vector<casacore::String> units = dCoord.worldAxisUnits();
+    double xScale = casacore::Quantity( qAbs( increments[0] ), units[0] ).getValue( "rad" );
+    double yScale = casacore::Quantity( qAbs( increments[1] ), units[1] ).getValue( "rad" );
+    m_cs = cs;
+    m_imageFrame = dCoord.directionType();
+    m_pixelScale = qSqrt( xScale * yScale );
+}
+
+
+bool StreamParserDs9::_convertPoints(){
+    int pointCount = m_skyPoints.size();
+    if ( pointCount == 0 ){
+        return true;
+    }
+    if ( !m_cs ){
+        return false;
+    }
+    casacore::Int directionIndex = m_cs->findCoordinate( casacore::Coordinate::DIRECTION );
+    casacore::Vector<casacore::Int> worldAxes = m_cs->worldAxes( directionIndex );
+    casacore::Vector<casacore::Int> pixelAxes = m_cs->pixelAxes( directionIndex );
+    if ( worldAxes[0] < 0 || worldAxes[1] < 0 || pixelAxes[0] < 0 || pixelAxes[1] < 0 ){
+        return false;
+    }
+    casacore::Vector<casacore::String> units = m_cs->worldAxisUnits();
+    double xFactor = casacore::Quantity( 1, "rad" ).getValue( units[worldAxes[0]] );
+    double yFactor = casacore::Quantity( 1, "rad" ).getValue( units[worldAxes[1]] );
+
+    //Every point gets the reference values of the other axes, and points in a
+    //frame other than the image's are moved into its frame first.
+    casacore::Vector<casacore::Double> reference = m_cs->referenceValue();
+    casacore::Matrix<casacore::Double> worlds( reference.size(), pointCount );
+    std::map<int, casacore::MDirection::Convert> converters;
+    for ( int i = 0; i < pointCount; i++ ){
+        int index = m_skyPoints[i];
+        double lon = m_points[2 * index];
+        double lat = m_points[2 * index + 1];
+        int frame = m_skyFrames[i];
+        if ( frame != m_imageFrame ){
+            auto converter = converters.find( frame );
+            if ( converter == converters.end() ){
+                casacore::MDirection::Ref from( static_cast<casacore::MDirection::Types>( frame ) );
+                casacore::MDirection::Ref to( static_cast<casacore::MDirection::Types>( m_imageFrame ) );
+                converter = converters.insert( std::make_pair( frame,
+                        casacore::MDirection::Convert( from, to ) ) ).first;
+            }
+            casacore::Vector<casacore::Double> converted =
+                    converter->second( casacore::MVDirection( lon, lat ) ).getValue().get();
+            lon = converted[0];
+            lat = converted[1];
+        }
+        worlds.column( i ) = reference;
+        worlds( worldAxes[0], i ) = lon * xFactor;
+        worlds( worldAxes[1], i ) = lat * yFactor;
+    }
+
+    casacore::Matrix<casacore::Double> pixels;
+    casacore::Vector<casacore::Bool> failures;
+    m_cs->toPixelMany( pixels, worlds, failures );
+    for ( int i = 0; i < pointCount; i++ ){
+        int index = m_skyPoints[i];
+        if ( failures[i] ){
+            m_points[2 * index] = std::numeric_limits<double>::quiet_NaN();
+            m_points[2 * index + 1] = std::numeric_limits<double>::quiet_NaN();
+        }
+        else {
+            m_points[2 * index] = pixels( pixelAxes[0], i );
+            m_points[2 * index + 1] = pixels( pixelAxes[1], i );
+        }
+    }
+    return true;
+}
+
+
+void StreamParserDs9::_makeRegions(){
+    int shapeCount = m_shapes.size();
+    m_regions.reserve( shapeCount );
+    int skipCount = 0;
+    for ( int i = 0; i < shapeCount; i++ ){
+        const Shape& shape = m_shapes[i];
+        const double* points = m_points.data() + 2 * shape.firstPoint;
+        bool valid = true;
+        for ( int j = 0; j < 2 * shape.pointCount; j++ ){
+            if ( std::isnan( points[j] ) ){
+                valid = false;
+                break;
+            }
+        }
+        if ( !valid ){
+            skipCount++;
+            continue;
+        }
+        QPointF center( points[0], points[1] );
+        switch ( shape.type ){
+        case ShapeType::POINT : {
+            Carta::Lib::Regions::Point* info = new Carta::Lib::Regions::Point();
+            info->setPoint( center );
+            m_regions.push_back( info );
+        }
+        break;
+        case ShapeType::CIRCLE :
+        case ShapeType::ELLIPSE : {
+            Carta::Lib::Regions::Ellipse* info = new Carta::Lib::Regions::Ellipse();
+            info->setRadiusMajor( qMax( shape.size[0], shape.size[1] ) );
+            info->setRadiusMinor( qMin( shape.size[0], shape.size[1] ) );
+            info->setCenter( center );
+            info->setAngle( shape.angle );
+            m_regions.push_back( info );
+        }
+        break;
+        case ShapeType::BOX : {
+            Carta::Lib::Regions::Rectangle* info = new Carta::Lib::Regions::Rectangle();
+            info->setRectangle( QRectF( center.x() - shape.size[0] / 2, center.y() - shape.size[1] / 2,
+                    shape.size[0], shape.size[1] ) );
+            m_regions.push_back( info );
+        }
+        break;
+        case ShapeType::POLYGON : {
+            Carta::Lib::Regions::Polygon* info = new Carta::Lib::Regions::Polygon();
+            QPolygonF corners( shape.pointCount );
+            for ( int j = 0; j < shape.pointCount; j++ ){
+                corners[j] = QPointF( points[2 * j], points[2 * j + 1] );
+            }
+            info->setqpolyf( corners );
+            m_regions.push_back( info );
+        }
+        break;
+        }
+    }
+    if ( skipCount > 0 ){
+        qWarning() << "Skipped"<<skipCount<<"ds9 regions that are not on the image.";
+    }
+}
+
+
+std::vector<Carta::Lib::Regions::RegionBase*> StreamParserDs9::getRegions() const {
+    return m_regions;
+}
+
+
+StreamParserDs9::~StreamParserDs9(){
+}
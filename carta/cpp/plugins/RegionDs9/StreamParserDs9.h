@@ -0,0 +1,136 @@
+/**
+ * Reads ds9 region files in one pass over a memory mapped buffer, for files with
+ * many shapes.
+ */
+#pragma once
+
+#include <QString>
+#include <memory>
+#include <vector>
+
+namespace Carta {
+    namespace Lib {
+        namespace Image {
+            class ImageInterface;
+        }
+        namespace Regions {
+            class RegionBase;
+        }
+    }
+}
+
+namespace casacore {
+    class CoordinateSystem;
+}
+
+class StreamParserDs9 {
+public:
+
+    /**
+     * Constructor.
+     */
+    StreamParserDs9( );
+
+    /**
+     * Reads the regions of a ds9 file.  The file is tokenized straight from a memory
+     * mapped buffer; sky coordinates are collected while reading and converted to
+     * pixels with one call for the whole file, and the regions are made once all of
+     * the file has been read.
+     * @param fileName - the path of the region file.
+     * @param image - the image the regions belong to; needed to place regions given in
+     *      sky coordinates.
+     * @return - true if the file was read; false if it could not be opened or uses
+     *      syntax this parser does not handle, in which case no regions were made and
+     *      the file should be read with ParserDs9 instead.
+     */
+    bool parseFile( const QString& fileName,
+            std::shared_ptr<Carta::Lib::Image::ImageInterface> image );
+
+    /**
+     * Returns the regions read by parseFile(); the caller takes ownership of them.
+     * @return - the regions of the file, in the order they appear in the file.
+     */
+    std::vector<Carta::Lib::Regions::RegionBase*> getRegions() const;
+
+    virtual ~StreamParserDs9();
+
+private:
+
+    //A run of characters in the buffer.
+    struct Token {
+        const char* begin;
+        const char* end;
+    };
+
+    enum class ShapeType { CIRCLE, ELLIPSE, BOX, POLYGON, POINT };
+
+    //A shape of the file, with its points stored in m_points.
+    struct Shape {
+        ShapeType type;
+        int firstPoint;
+        int pointCount;
+        double size[2];
+        double angle;
+    };
+
+    //Reads the commands of the buffer; false on syntax the parser does not handle.
+    bool _parseBuffer( const char* begin, const char* end );
+
+    //Reads one command, such as a coordinate system or a shape.
+    bool _parseCommand( const char* begin, const char* end );
+
+    //Reads the arguments of a shape and stores it.
+    bool _parseShape( ShapeType type, const std::vector<Token>& args );
+
+    //Reads a pair of coordinates and appends them to the points.
+    bool _parsePoint( const Token& x, const Token& y );
+
+    //Reads a length and returns it in pixels.
+    bool _parseLength( const Token& token, double* pixels ) const;
+
+    //Reads an angle and returns it in degrees.
+    bool _parseAngle( const Token& token, double* degrees ) const;
+
+    //Reads a sexagesimal value, hours or degrees, and returns its degrees.
+    static bool _parseSexagesimal( const Token& token, bool hours, double* degrees );
+
+    //Reads a number followed by an optional unit character.
+    static bool _parseNumber( const Token& token, double* value, char* unit );
+
+    //Splits the arguments of a shape on commas and white space.
+    static void _split( const char* begin, const char* end, std::vector<Token>& args );
+
+    //Sets up conversions from the sky to the pixels of the image.
+    void _setImage( std::shared_ptr<Carta::Lib::Image::ImageInterface> image );
+
+    //Converts the sky points read from the file to pixels in one call.
+    bool _convertPoints();
+
+    //Makes the regions of the shapes read from the file.
+    void _makeRegions();
+
+    //The coordinate system of the image, if it has a direction coordinate.
+    std::shared_ptr<casacore::CoordinateSystem> m_cs;
+    //The frame of the image's direction coordinate, as a casacore MDirection type.
+    int m_imageFrame;
+    //The size of a pixel of the image, in radians.
+    double m_pixelScale;
+
+    //The coordinate system the file is using at the current line.
+    bool m_skySystem;
+    bool m_skyHours;
+    int m_skyFrame;
+
+    std::vector<Shape> m_shapes;
+    //Pixel coordinates of the shapes, x and y for each point.
+    std::vector<double> m_points;
+    //Points still in sky coordinates (longitude and latitude in radians), by index.
+    std::vector<int> m_skyPoints;
+    //Frame of each sky point, as a casacore MDirection type.
+    std::vector<int> m_skyFrames;
+
+    std::vector<Carta::Lib::Regions::RegionBase*> m_regions;
+
+    StreamParserDs9( const StreamParserDs9& other);
+    StreamParserDs9& operator=( const StreamParserDs9& other );
+};
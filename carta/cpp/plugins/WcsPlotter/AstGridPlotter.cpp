@@ -327,43 +327,18 @@ AstGridPlotter::plot()
     // make sure we clean up resources no matter how we exit this method
     AstGuard astGuard;
 
-    // ask AST to read in the FITS header
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wformat-zero-length"
-    AstFitsChan * fitschan = astFitsChan( NULL, NULL, "" );
-#pragma GCC diagnostic pop
-    if ( ! fitschan ) {
-        m_errorString = "astFitsChan returned null :(";
-        return false;
-    }
-    std::string stdstr = m_fitsHeader.toStdString();
-    astPutCards( fitschan, stdstr.c_str() );
-    if ( ! astOK ) {
-        qDebug() << "astPutCards() failed";
-        m_errorString = "astPutCards() failed, check logs.";
-        return false;
-    }
-
-    if ( m_carLin ) {
-        astSet( fitschan, "CarLin=1" );
+    // use the pre-parsed frameset if we were given one, otherwise ask AST to
+    // read in the FITS header
+    AstFrameSet * wcsinfo = nullptr;
+    if ( m_frameSet ) {
+        wcsinfo = static_cast < AstFrameSet * > ( astCopy( m_frameSet ) );
     }
     else {
-        astSet( fitschan, "CarLin=0" );
-    }
-
-    // try to get WCS out of the fits data
-    AstFrameSet * wcsinfo = static_cast < AstFrameSet * > ( astRead( fitschan ) );
-    if ( ! astOK ) {
-        m_errorString = "astRead() failed, check logs.";
-        return false;
-    }
-    else if ( wcsinfo == AST__NULL ) {
-        m_errorString = "No WCS found";
-        return false;
-    }
-    else if ( strcmp( astGetC( wcsinfo, "Class" ), "FrameSet" ) ) {
-        m_errorString = "check FITS header (astlib)";
-        return false;
+        wcsinfo = readFrameSet( m_fitsHeader, m_carLin, m_errorString );
+        if ( ! wcsinfo ) {
+            setlocale( LC_NUMERIC, oldLocale.c_str() );
+            return false;
+        }
     }
 
     AstFrameSet* newFrame = wcsinfo; //_make2dFrame( wcsinfo );
@@ -544,7 +519,6 @@ AstGridPlotter::plot()
 
     plot = (AstPlot *) astAnnul( plot );
     wcsinfo = (AstFrameSet *) astAnnul( wcsinfo );
-    fitschan = (AstFitsChan *) astAnnul( fitschan );
 
     // Restore previous numeric locale
 
@@ -561,6 +535,66 @@ AstGridPlotter::setFitsHeader( const QString & hdr )
     return true;
 }
 
+void
+AstGridPlotter::setFrameSet( AstFrameSet * frameSet )
+{
+    m_frameSet = frameSet;
+}
+
+AstFrameSet *
+AstGridPlotter::readFrameSet( const QString & hdr, bool carLin, QString & error )
+{
+    // see plot() for why we need to override the numeric locale
+    std::string oldLocale = setlocale( LC_NUMERIC, "C" );
+    astClearStatus;
+
+    AstFrameSet * result = nullptr;
+    astBegin;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-zero-length"
+    AstFitsChan * fitschan = astFitsChan( NULL, NULL, "" );
+#pragma GCC diagnostic pop
+    if ( ! fitschan ) {
+        error = "astFitsChan returned null :(";
+    }
+    else {
+        std::string stdstr = hdr.toStdString();
+        astPutCards( fitschan, stdstr.c_str() );
+        if ( ! astOK ) {
+            qDebug() << "astPutCards() failed";
+            error = "astPutCards() failed, check logs.";
+        }
+        else {
+            astSet( fitschan, carLin ? "CarLin=1" : "CarLin=0" );
+
+            // try to get WCS out of the fits data
+            AstFrameSet * wcsinfo = static_cast < AstFrameSet * > ( astRead( fitschan ) );
+            if ( ! astOK ) {
+                error = "astRead() failed, check logs.";
+            }
+            else if ( wcsinfo == AST__NULL ) {
+                error = "No WCS found";
+            }
+            else if ( strcmp( astGetC( wcsinfo, "Class" ), "FrameSet" ) ) {
+                error = "check FITS header (astlib)";
+            }
+            else {
+                // keep the frameset alive past astEnd, the caller owns it now
+                astExport( wcsinfo );
+                result = wcsinfo;
+            }
+        }
+    }
+
+    astEnd;
+    if ( ! astOK ) {
+        astClearStatus;
+    }
+    setlocale( LC_NUMERIC, oldLocale.c_str() );
+    return result;
+}
+
 void
 AstGridPlotter::setCarLin( bool flag )
 {
@@ -49,6 +49,17 @@ public:
     bool
     setFitsHeader( const QString & hdr );
 
+    /// use an already parsed frameset instead of parsing the FITS header in plot()
+    /// the plotter does not take ownership, and the frameset is not modified
+    void
+    setFrameSet( AstFrameSet * frameSet );
+
+    /// parse the raw FITS header into an AST frameset, which is exported from
+    /// the current AST context and owned by the caller (release with astAnnul)
+    /// returns nullptr on failure and sets error
+    static AstFrameSet *
+    readFrameSet( const QString & hdr, bool carLin, QString & error );
+
     /// set whether to use the old CAR interpretation (i.e. CAR is linear)
     void
     setCarLin( bool flag );
@@ -105,6 +116,7 @@ protected:
     bool m_carLin = false;
     QString m_errorString;
     QString m_fitsHeader;
+    AstFrameSet * m_frameSet = nullptr;
     QStringList m_plotOptions;
     //QString m_system;
     QRectF m_orect, m_irect;
@@ -6,6 +6,8 @@
 #include "AstWcsGridRenderService.h"
 #include "FitsHeaderExtractor.h"
 #include "CartaLib/LinearMap.h"
+#include <QCache>
+#include <QCryptographicHash>
 #include <QPainter>
 #include <QTime>
 #include <set>
@@ -28,6 +30,26 @@ struct AstWcsGridRenderService::Pimpl
     // fits header from the input image
     QStringList fitsHeader;
 
+    // fits header in the form AST wants it (concatenated cards)
+    QString astHeader;
+
+    // AST frameset parsed from a fits header, annulled when evicted from the cache
+    struct CachedFrameSet {
+        AstFrameSet * frameSet = nullptr;
+        ~CachedFrameSet() {
+            if ( frameSet ) {
+                astAnnul( frameSet );
+            }
+        }
+    };
+
+    // parsed framesets, keyed by the fits header they were parsed from, so that
+    // switching between images does not re-parse the header every time
+    QCache < QString, CachedFrameSet > frameSetCache { 10 };
+
+    // recently rendered grids, keyed by image rect, output rect and options
+    QCache < QString, VG::VGList > vgCache { 20 };
+
     // current sky CS
     Carta::Lib::KnownSkyCS knownSkyCS = Carta::Lib::KnownSkyCS::J2000;
 
@@ -45,6 +67,27 @@ struct AstWcsGridRenderService::Pimpl
 
     // last submitted job id
     IWcsGridRenderService::JobId lastSubmittedJobId = 0;
+
+    /// returns the parsed frameset for the current header (owned by the cache),
+    /// or nullptr if AST could not parse it
+    AstFrameSet *
+    frameSet()
+    {
+        CachedFrameSet * cached = frameSetCache.object( astHeader );
+        if ( ! cached ) {
+            QString error;
+            AstFrameSet * fs = AstGridPlotter::readFrameSet( astHeader, false, error );
+            if ( ! fs ) {
+                qWarning() << "Could not parse fits header:" << error;
+                return nullptr;
+            }
+            astExempt( fs );
+            cached = new CachedFrameSet;
+            cached-> frameSet = fs;
+            frameSetCache.insert( astHeader, cached );
+        }
+        return cached-> frameSet;
+    }
 };
 
 AstWcsGridRenderService::AstWcsGridRenderService()
@@ -105,6 +148,7 @@ AstWcsGridRenderService::setInputImage( Carta::Lib::Image::ImageInterface::Share
             auto len = header.length();
             std::sort(&header[0],&header[len-2]);
             m().fitsHeader = header;
+            m().astHeader = _getFitsHeaderforAst( m().fitsHeader );
         }
     }
 } // setInputImage
@@ -173,6 +217,17 @@ AstWcsGridRenderService::renderNow()
         return;
     }
 
+    // reuse a previously rendered grid if nothing that affects the plot changed,
+    // only the pens need to be brought up to date
+    QString vgKey = _getVGCacheKey();
+    if ( VG::VGList * cached = m().vgCache.object( vgKey ) ) {
+        m_vgc = VG::VGComposer( * cached );
+        m_vgValid = true;
+        _updatePenEntries();
+        emit done( m_vgc.vgList(), m().lastSubmittedJobId );
+        return;
+    }
+
     m_vgValid = true;
 
     // local helper - element to integer
@@ -236,7 +291,8 @@ AstWcsGridRenderService::renderNow()
 
     sgp.setInputRect( m_imgRect );
     sgp.setOutputRect( m_outRect );
-    sgp.setFitsHeader( _getFitsHeaderforAst(m().fitsHeader) );
+    sgp.setFitsHeader( m().astHeader );
+    sgp.setFrameSet( m().frameSet() );
     sgp.setOutputVGComposer( & m_vgc );
 
 //    sgp.setPlotOption( "tol=0.001" ); // this can slow down the grid rendering!!!
@@ -337,6 +393,9 @@ AstWcsGridRenderService::renderNow()
     if( ! plotSuccess) {
         qWarning() << "Grid rendering error:" << sgp.getError();
     }
+    else {
+        m().vgCache.insert( vgKey, new VG::VGList( m_vgc.vgList() ) );
+    }
 
     //qDebug() << "Grid rendered in " << t.elapsed() / 1000.0 << "s";
 
@@ -544,6 +603,54 @@ AstWcsGridRenderService::setPen( Carta::Lib::IWcsGridRenderService::Element e, c
     }
 } // setPen
 
+void
+AstWcsGridRenderService::_updatePenEntries()
+{
+    // the pen and brush entries are always at the same place in the list,
+    // so this works for any list produced by renderNow()
+    for ( Element e = Element::BorderLines; e != Element::__count; ++e ) {
+        int ind = static_cast < int > ( e );
+        int penIndex = m().penEntries[ind];
+        if ( penIndex >= 0 ) {
+            m_vgc.set < VGE::StoreIndexedPen > ( penIndex, ind, m().pens[ind] );
+        }
+    }
+    int brushIndex = m().dimBrushIndex;
+    if ( brushIndex >= 0 ) {
+        const QPen & dimPen = m().pens[static_cast < int > ( Element::MarginDim )];
+        m_vgc.set < VGE::StoreIndexedBrush > ( brushIndex, 0, dimPen.brush() );
+    }
+}
+
+QString
+AstWcsGridRenderService::_getVGCacheKey()
+{
+    auto rectKey = [] ( const QRectF & r ) {
+        return QString( "%1,%2,%3,%4" ).arg( r.left(), 0, 'g', 17 ).arg( r.top(), 0, 'g', 17 )
+               .arg( r.width(), 0, 'g', 17 ).arg( r.height(), 0, 'g', 17 );
+    };
+
+    QStringList options;
+    options << m().astHeader
+            << QString( "%1x%2" ).arg( m_outSize.width() ).arg( m_outSize.height() )
+            << QString::number( m_gridDensity, 'g', 17 )
+            << QString::number( m_tickLength, 'g', 17 )
+            << QString( "%1%2%3%4" ).arg( m_gridLines ).arg( m_axes ).arg( m_ticks )
+               .arg( m_internalLabels )
+            << _getSystem()
+            << QString::number( Carta::Lib::AxisDisplayInfo::isCelestialPlane( m_axisDisplayInfos ) )
+            << _setDisplayLabelOptionforAst();
+    for ( const Pimpl::FontInfo & fontInfo : m().fonts ) {
+        options << QString( "%1:%2" ).arg( fontInfo.first ).arg( fontInfo.second );
+    }
+
+    // a full hash, since a collision would draw the grid of another image
+    QByteArray optionsHash = QCryptographicHash::hash( options.join( ";" ).toUtf8(),
+                                                       QCryptographicHash::Sha1 );
+    return rectKey( m_imgRect ) + "|" + rectKey( m_outRect ) + "|"
+           + QString( optionsHash.toHex() );
+}
+
 
 void AstWcsGridRenderService::setAxisLabelInfo( int axisIndex, const Carta::Lib::AxisLabelInfo& labelInfo ){
     CARTA_ASSERT( axisIndex == 0 || axisIndex == 1 );
@@ -108,6 +108,10 @@ private:
     QString _getDisplayLocation( const Carta::Lib::AxisLabelInfo::Locations& labelLocation ) const;
 
     QString _getSystem();
+    //Bring the pen and margin brush entries of the current VG list up to date.
+    void _updatePenEntries();
+    //Key identifying the current grid in the VG cache.
+    QString _getVGCacheKey();
     //Don't draw tick marks.
     void _turnOffTicks(WcsPlotterPluginNS::AstGridPlotter* sgp);
     //Don't label a particular axis
@@ -13,6 +13,7 @@ SUBDIRS += ConversionIntensity
 SUBDIRS += ConversionIntensity/Test.pro
 SUBDIRS += ImageAnalysis
 SUBDIRS += ImageStatistics
+SUBDIRS += ImageMoments
 SUBDIRS += RegionCASA
 SUBDIRS += RegionDs9
 SUBDIRS += ProfileCASA
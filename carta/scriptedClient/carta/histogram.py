@@ -333,3 +333,21 @@ class Histogram(CartaView):
                                      width=width, height=height,
                                      aspectRatioMode=aspectRatioMode)
         return result
+
+    def getHistogramData(self):
+        """
+        Get the (value,count) pairs of the histograms that have been
+        computed.
+
+        Returns
+        -------
+        BinaryMessage
+            The pairs of all histograms in `values`; `header["names"]` and
+            `header["lengths"]` give the name and number of pairs of each
+            histogram, in order.
+            A list with error information if the histograms could not be
+            obtained.
+        """
+        result = self.con.cmdBinary("getHistogramData",
+                                    histogramView=self.getId())
+        return result
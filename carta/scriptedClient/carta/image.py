@@ -564,6 +564,119 @@ class Image(CartaView):
                                      x=x, y=y)
         return result
 
+    def getImageData(self, start=[], count=[]):
+        """
+        Get the pixel values of a block of the image at full precision.
+
+        Parameters
+        ----------
+        start: list
+            The first pixel of the block along each image axis; missing
+            axes start at 0.
+        count: list
+            The number of pixels of the block along each image axis;
+            missing axes and negative counts extend to the end of the axis.
+
+        Returns
+        -------
+        BinaryMessage
+            The pixel values in `values`, with the first axis varying
+            fastest, and the size of the block in `header["shape"]`.
+            A list with error information if the values could not be
+            obtained, including when the block has more than 16777216
+            pixels; larger blocks have to be fetched in parts.
+        """
+        result = self.con.cmdBinary("getImageData", imageView=self.getId(),
+                                    start=start, count=count)
+        return result
+
+    def getSpectralProfileData(self, x, y):
+        """
+        Get the spectral profile through a pixel at the current Stokes
+        frame.
+
+        Parameters
+        ----------
+        x: integer
+            The x value of the pixel.
+        y: integer
+            The y value of the pixel.
+
+        Returns
+        -------
+        BinaryMessage
+            The pixel value in each channel in `values`.
+            A list with error information if the profile could not be
+            obtained.
+        """
+        result = self.con.cmdBinary("getSpectralProfileData",
+                                    imageView=self.getId(), x=x, y=y)
+        return result
+
+    def getRegionStatsData(self):
+        """
+        Get the region statistics of the images at the current frames.
+
+        Returns
+        -------
+        BinaryMessage
+            A table of statistics in `values`, row by row. The header
+            names the statistic in each column in `header["columns"]` and
+            gives the [image, set] of each row in `header["rows"]`; set 0
+            holds the image statistics and set r + 1 those of region r.
+            A list with error information if the statistics could not be
+            obtained.
+        """
+        result = self.con.cmdBinary("getRegionStatsData",
+                                    imageView=self.getId())
+        return result
+
+    def getRegionStatsColumns(self):
+        """
+        Get the statistics of all the regions of the image at the current
+        frames. The regions are computed together, so this is much faster
+        than getting their statistics one at a time for large region
+        catalogues.
+
+        Returns
+        -------
+        BinaryMessage
+            The statistics in `values`, column by column, with one value
+            per region in each column. The header names the statistic in
+            each column in `header["columns"]`; a value is NaN if the
+            region does not cover any valid pixels.
+            A list with error information if the statistics could not be
+            obtained.
+        """
+        result = self.con.cmdBinary("getRegionStatsColumns",
+                                    imageView=self.getId())
+        return result
+
+    def getRegionProfilesData(self, statistic="mean"):
+        """
+        Get the spectral profiles of all the regions of the image at the
+        current Stokes frame. Each channel is read once for all of the
+        regions.
+
+        Parameters
+        ----------
+        statistic: string
+            How the pixels of a region are combined in each channel: one of
+            "mean", "sum", "flux", "rms", "variance", "min", or "max".
+
+        Returns
+        -------
+        BinaryMessage
+            The profiles in `values`, region by region; the header gives
+            the number of regions and channels in `header["shape"]`.
+            A list with error information if the profiles could not be
+            obtained.
+        """
+        result = self.con.cmdBinary("getRegionProfilesData",
+                                    imageView=self.getId(),
+                                    statistic=statistic)
+        return result
+
     def getPixelUnits(self):
         """
         Get the units of the pixels in the currently loaded image.
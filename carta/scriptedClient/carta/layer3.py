@@ -1,7 +1,10 @@
 #!/usr/bin/env python
 # -*- coding: utf-8 -*-
 
+import array
 import json
+import struct
+import sys
 from layer2 import TagMessage, TagMessageSocket
 
 class JsonMessage:
@@ -86,6 +89,47 @@ class JsonMessage:
         """
         return JsonMessage(json.dumps(kwargs))
 
+class BinaryMessage:
+    """
+    Binary message holder: a JSON header describing an array of numbers,
+    followed by the numbers as little endian doubles.
+
+    Parameters
+    ----------
+    header: dict
+        Describes the values; "shape" holds the size of each dimension of
+        the array, with the first dimension varying fastest for image data
+        and the last one varying fastest otherwise.
+    values: array.array
+        The numbers, as an array of type 'd'.
+    """
+    def __init__(self, header, values):
+        self.header = header
+        self.values = values
+
+    @staticmethod
+    def fromTagMessage(tm):
+        """
+        Construct a BinaryMessage from a TagMessage with a "binary" tag.
+
+        Parameters
+        ----------
+        tm: TagMessage
+
+        Returns
+        -------
+        A BinaryMessage representation of the TagMessage.
+        """
+        if tm.tag != "binary":
+            raise NameError("tag message does not have 'binary' as tag")
+        headerSize = struct.unpack_from("<q", tm.data)[0]
+        header = json.loads(str(tm.data[8:8 + headerSize]))
+        values = array.array('d')
+        values.fromstring(str(tm.data[8 + headerSize:]))
+        if sys.byteorder != 'little':
+            values.byteswap()
+        return BinaryMessage(header, values)
+
 class JsonSocket:
     """
     A socket wrapper that allows sending and receiving of JsonMessages.
@@ -5,7 +5,7 @@ import socket
 import json
 
 from layer2 import TagMessage, TagMessageSocket
-from layer3 import JsonMessage
+from layer3 import JsonMessage, BinaryMessage
 
 class TagConnector:
     """
@@ -90,3 +90,106 @@ class TagConnector:
         except KeyError:
             returnValue = j['error']
         return returnValue
+
+    def cmdBinary(self, cmd, ** kwargs):
+        """
+        Send a tag message for a command that returns an array of numbers.
+
+        Parameters
+        ----------
+        cmd: string
+            The name of the command to send.
+        kwargs: dict
+            The arguments to the command, if any.
+
+        Returns
+        -------
+        BinaryMessage or list
+            The header and values of the result, or a list with error
+            information if the command failed.
+        """
+        self.tagMessageSocket.send(
+            JsonMessage.fromKW(cmd=cmd, args=kwargs).toTagMessage())
+        tm = self.tagMessageSocket.receive()
+        if tm.tag == "binary":
+            return BinaryMessage.fromTagMessage(tm)
+        result = JsonMessage.fromTagMessage(tm)
+        j = json.loads(str(result.jsonString))
+        try:
+            returnValue = j['result']
+        except KeyError:
+            returnValue = j['error']
+        return returnValue
+
+    def cmdBatch(self, commands):
+        """
+        Send a list of commands in a single message and return the result of
+        each of them. The commands are run in order on the C++ side, and a
+        command that fails does not stop the ones after it.
+
+        Parameters
+        ----------
+        commands: list
+            (cmd, kwargs) pairs, where cmd is the name of a command and
+            kwargs a dict of its arguments.
+
+        Returns
+        -------
+        list
+            One entry per command, in the same order. Each entry is the list
+            the command returned, or a list with error information if it
+            failed. Commands returning arrays of numbers give a BinaryMessage.
+        """
+        batch = [{'cmd': cmd, 'args': kwargs} for cmd, kwargs in commands]
+        result = self.cmdTagList("batch", commands=batch)
+        returnValue = []
+        for entry in result:
+            if 'result' in entry:
+                value = entry['result']
+            else:
+                value = entry['error']
+            if isinstance(value, dict):
+                values = value.pop('values')
+                value = BinaryMessage(value, [float('nan') if v is None
+                                              else v for v in values])
+            returnValue.append(value)
+        return returnValue
+
+    def cmdPipeline(self, commands):
+        """
+        Send several commands without waiting for their results in between,
+        then collect the results. Each command is tagged with a request id
+        that the C++ side copies into its reply.
+
+        Parameters
+        ----------
+        commands: list
+            (cmd, kwargs) pairs, where cmd is the name of a command and
+            kwargs a dict of its arguments.
+
+        Returns
+        -------
+        list
+            One entry per command, in the same order, as returned by
+            cmdTagList, or by cmdBinary for commands returning arrays of
+            numbers.
+        """
+        for requestId, (cmd, kwargs) in enumerate(commands):
+            self.tagMessageSocket.send(
+                JsonMessage.fromKW(cmd=cmd, args=kwargs,
+                                   id=requestId).toTagMessage())
+        returnValue = [None] * len(commands)
+        for _ in commands:
+            tm = self.tagMessageSocket.receive()
+            if tm.tag == "binary":
+                bm = BinaryMessage.fromTagMessage(tm)
+                returnValue[bm.header.pop('id')] = bm
+                continue
+            result = JsonMessage.fromTagMessage(tm)
+            j = json.loads(str(result.jsonString))
+            try:
+                value = j['result']
+            except KeyError:
+                value = j['error']
+            returnValue[j['id']] = value
+        return returnValue